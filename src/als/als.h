@@ -15,6 +15,29 @@
 #pragma warning(disable: 26495)     // "member variable is uninitialized. Always initialize a member variable" ; Disabling because it really dislikes my type punning AST trick
 #pragma warning(disable: 6385)      // "reading invalid data from array" ; Disabling because it dislikes mp_ variables
 
+// Allocation counting for the compile report (see report.h). The hooks are defined out here so that the common headers
+//	stay standalone.
+
+#include <stddef.h>
+
+enum ALLOCK
+{
+	ALLOCK_PoolBucket,
+	ALLOCK_ArrayGrow,
+	ALLOCK_HashGrow,
+	ALLOCK_StringGrow,
+
+	ALLOCK_Max,
+	ALLOCK_Nil = -1
+};
+
+void countAlloc(ALLOCK allock, size_t cByte);
+
+#define ALS_COMMON_ALLOC_OnAllocBucket(cByte)	countAlloc(ALLOCK_PoolBucket, cByte)
+#define ALS_COMMON_ARRAY_OnGrow(cByte)			countAlloc(ALLOCK_ArrayGrow, cByte)
+#define ALS_COMMON_HASH_OnGrow(cByte)			countAlloc(ALLOCK_HashGrow, cByte)
+#define ALS_COMMON_STRING_OnGrow(cByte)			countAlloc(ALLOCK_StringGrow, cByte)
+
 #include "macro.h"
 #include "common.h"
 
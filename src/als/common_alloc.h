@@ -35,12 +35,46 @@
 #endif
 #endif
 
+// Called with the size of every bucket a DynamicPoolAllocator allocates. Define it before including to count them.
+
+#ifndef ALS_COMMON_ALLOC_OnAllocBucket
+#define ALS_COMMON_ALLOC_OnAllocBucket(cByte)
+#endif
+
+#include <stdint.h>		// For uintptr_t
+#include <stdlib.h>		// For aligned allocation of DynamicPoolAllocator buckets
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
 namespace _Als_Helper
 {
-    inline constexpr int max(int a, int b)
+    inline constexpr size_t max(size_t a, size_t b)
     {
         return a > b ? a : b;
     }
+
+    inline constexpr bool isPow2(size_t n)
+    {
+        return n != 0 && (n & (n - 1)) == 0;
+    }
+
+    inline constexpr size_t alignUp(size_t n, size_t alignment)
+    {
+        return (n + alignment - 1) & ~(alignment - 1);
+    }
+
+    inline constexpr size_t nextPow2(size_t n)
+    {
+        size_t result = 1;
+        while (result < n)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
 }
 
 // General purpose fixed-capacity pool allocator
@@ -95,9 +129,11 @@ T * allocate(FixedPoolAllocator<T, Capacity> * pAlloc)
 
     if (pAlloc->pFree)
     {
-        // Store result
+        // Store result and advance the free-list. Advance before zeroing, since the free-list
+        //  link lives inside of the slot we are handing out.
 
         result = reinterpret_cast<T *>(pAlloc->pFree);
+        pAlloc->pFree = pAlloc->pFree->pNext;
 
         // Zero initialize result
         // NOTE: It kinda sucks that this is required for the way that I am using this allocator in
@@ -106,10 +142,6 @@ T * allocate(FixedPoolAllocator<T, Capacity> * pAlloc)
         //  anything that doesn't work when zero-initialized should require an init(..) function.
 
         memset(result, 0, sizeof(T));
-
-        // Advance the free-list
-
-        pAlloc->pFree = pAlloc->pFree->pNext;
     }
 
     return result;
@@ -211,126 +243,112 @@ bool debug_hasCycle(FixedPoolAllocator<T, Capacity> * pAlloc)
 // General purpose dynamic-capacity pool allocator. Uses a linked list of
 //  fixed pool allocators underneath the hood
 
-// TODO: Come up with a better bookkeeping strategy to determine which bucket a released pointer comes from.
-//  Currently, we iterate over every bucket and check the memory address ranges to find the right one.
-//  To make this cheaper, we only do it after a bunch of items have been released and we do it all in a big
-//  batch. To make this batch faster, we need to keep the bucket list sorted by address, and also sort
-//  all of the arrays in the batch by address. We only pay these sorting costs when we allocate a new bucket
-//  or do a batch release so it isn't a *huge* deal, but surely there must be a better way!
+// Each bucket is allocated at an address that is aligned to the bucket's (power of two) size, so the
+//  bucket that owns a released item is found by masking off the low bits of the item's address. This
+//  makes release O(1) without any per-item bookkeeping. The number of items per bucket is rounded up
+//  so that the items fill all of the space that the power of two size gives us, so CapacityPerBucket
+//  is a minimum rather than an exact count.
 
-template <typename T, unsigned int CapacityPerBucket=512>
+// ItemAlignment can be raised above alignof(T) to align every item to a cache line (or any other
+//  power of two). Items are packed back to back, so sizeof(T) must be a multiple of the alignment.
+
+template <typename T, unsigned int CapacityPerBucket=512, unsigned int ItemAlignment=alignof(T)>
 struct DynamicPoolAllocator
 {
-    struct Bucket
-    {
-        FixedPoolAllocator<T, CapacityPerBucket> alloc;
-		Bucket * pNextBucket = nullptr;     // List of all buckets that we own. Sorted by memory address, low to high
-		Bucket * pNextFree = nullptr;       // Only valid for bucket on the free list
-    };
+	ALS_COMMON_ALLOC_StaticAssert(_Als_Helper::isPow2(ItemAlignment) && ItemAlignment >= alignof(T) && sizeof(T) % ItemAlignment == 0);
+
+	// NOTE (andrew) Overhead is the two bucket links before the pool, the fixed pool's free list pointer
+	//	after it, and a worst case amount of padding to keep everything aligned.
 
-    Bucket * pBuckets = nullptr;     // Linked list of all buckets
-    Bucket * pFree = nullptr;        // Linked list of just buckets w/ capacity
+	static constexpr size_t s_alignmentBucket = _Als_Helper::max(ItemAlignment, alignof(void *));
+	static constexpr size_t s_cByteBucketOverhead =
+		_Als_Helper::alignUp(2 * sizeof(void *), s_alignmentBucket) + sizeof(void *) + s_alignmentBucket;
 
-    // We need to traverse the linked list to know which bucket the released
-    //  item is in. Batch this operation to make it happen infrequently
+	static constexpr size_t s_cByteBucket = _Als_Helper::nextPow2(s_cByteBucketOverhead + size_t(CapacityPerBucket) * sizeof(T));
+	static constexpr unsigned int s_capacityPerBucket = static_cast<unsigned int>((s_cByteBucket - s_cByteBucketOverhead) / sizeof(T));
 
-	static constexpr int s_cRecentlyReleasedMax = _Als_Helper::max(16, CapacityPerBucket / 4);
+	struct Bucket
+	{
+		Bucket * pNextBucket;		// List of all buckets that we own
+		Bucket * pNextFree;			// Only valid for bucket on the free list
+		alignas(s_alignmentBucket) FixedPoolAllocator<T, s_capacityPerBucket> alloc;
+	};
 
-    T * aRecentlyReleased[s_cRecentlyReleasedMax] = { 0 };
-	int cRecentlyReleased = 0;
+	Bucket * pBuckets = nullptr;     // Linked list of all buckets
+	Bucket * pFree = nullptr;        // Linked list of just buckets w/ capacity
 };
 
-template <typename T, unsigned int CapacityPerBucket>
-void init(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
+namespace _Als_Helper
 {
-	typedef DynamicPoolAllocator<T, CapacityPerBucket> dpa;
+	inline void * allocAligned(size_t cByte, size_t alignment)
+	{
+#ifdef _MSC_VER
+		return _aligned_malloc(cByte, alignment);
+#else
+		return aligned_alloc(alignment, cByte);
+#endif
+	}
 
+	inline void freeAligned(void * p)
+	{
+#ifdef _MSC_VER
+		_aligned_free(p);
+#else
+		free(p);
+#endif
+	}
+}
+
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+void init(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc)
+{
+	pAlloc->pBuckets = nullptr;
 	pAlloc->pFree = nullptr;
 }
 
-template <typename T, unsigned int CapacityPerBucket>
-void destroy(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+void destroy(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc)
 {
+	typedef DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> dpa;
+
 	// Free all buckets
 
-	Bucket * pBucket = pAlloc->pBuckets;
+	dpa::Bucket * pBucket = pAlloc->pBuckets;
 	while (pBucket)
 	{
-		Bucket * pBucketNext = pBucket->pNextBucket;
-		delete pBucket;
+		dpa::Bucket * pBucketNext = pBucket->pNextBucket;
+		_Als_Helper::freeAligned(pBucket);
 		pBucket = pBucketNext;
 	}
+
+	pAlloc->pBuckets = nullptr;
+	pAlloc->pFree = nullptr;
 }
 
-template <typename T, unsigned int CapacityPerBucket>
-T * allocate(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+T * allocate(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc)
 {
-	typedef DynamicPoolAllocator<T, CapacityPerBucket> dpa;
+	typedef DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> dpa;
+
+	ALS_COMMON_ALLOC_StaticAssert(sizeof(dpa::Bucket) <= dpa::s_cByteBucket);
 
 	T * result = nullptr;
 
 	if (!pAlloc->pFree)
 	{
-		dpa::Bucket * pBucketNew = new dpa::Bucket;
-        init(&pBucketNew->alloc);
-
-		// Insert new bucket into bucket list maintaining sort order
+		dpa::Bucket * pBucketNew = static_cast<dpa::Bucket *>(_Als_Helper::allocAligned(dpa::s_cByteBucket, dpa::s_cByteBucket));
+		ALS_COMMON_ALLOC_Assert(pBucketNew);
+		ALS_COMMON_ALLOC_Assert((reinterpret_cast<uintptr_t>(pBucketNew) & (dpa::s_cByteBucket - 1)) == 0);
+		ALS_COMMON_ALLOC_OnAllocBucket(dpa::s_cByteBucket);
 
-        if (!pAlloc->pBuckets)
-        {
-            pAlloc->pBuckets = pBucketNew;
-        }
-        else
-        {
-            dpa::Bucket * pBucketPrev = nullptr;
-            dpa::Bucket * pBucket = pAlloc->pBuckets;
-            ALS_COMMON_ALLOC_Assert(pBucket);
+		init(&pBucketNew->alloc);
 
-            bool inserted = false;
-            while (true)
-            {
-                if (!pBucket)
-                {
-                    // We are the new tail
-
-                    ALS_COMMON_ALLOC_Assert(pBucketPrev);
-
-                    pBucketPrev->pNextBucket = pBucketNew;
-                    pBucketNew->pNextBucket = nullptr;
-
-                    break;
-                }
-                else if (pBucketNew < pBucket)
-                {
-                    pBucketNew->pNextBucket = pBucket;
-
-                    if (pBucketPrev)
-                    {
-                        // We are somewhere in the middle
-
-                        pBucketPrev->pNextBucket = pBucketNew;
-                    }
-                    else
-                    {
-                        // We are the new head
-
-                        pAlloc->pBuckets = pBucketNew;
-                    }
-
-                    break;
-                }
-                else
-                {
-                    // Still searching...
-
-                    pBucketPrev = pBucket;
-                    pBucket = pBucket->pNextBucket;
-                }
-            }
-        }
+		// Bucket order doesn't matter, so just push onto the head of both lists
 
-		// Add to free list
+		pBucketNew->pNextBucket = pAlloc->pBuckets;
+		pAlloc->pBuckets = pBucketNew;
 
+		pBucketNew->pNextFree = nullptr;
 		pAlloc->pFree = pBucketNew;
 	}
 
@@ -342,118 +360,53 @@ T * allocate(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
 		pAlloc->pFree = pAlloc->pFree->pNextFree;
 	}
 
-    return result;
+	return result;
 }
 
-template <typename T, unsigned int CapacityPerBucket = 512>
-void release(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc, T * pItem, bool forceFlushBatch=false)
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+void release(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc, T * pItem)
 {
-	typedef DynamicPoolAllocator<T, CapacityPerBucket> dpa;
-
-	ALS_COMMON_ALLOC_Verify(pAlloc->cRecentlyReleased < dpa::s_cRecentlyReleasedMax);
-	pAlloc->aRecentlyReleased[pAlloc->cRecentlyReleased] = pItem;
-	pAlloc->cRecentlyReleased++;
-
-	// Batch a bunch of releases at once to reduce the number of times we have to walk
-    //  the list of buckets
-
-	if (pAlloc->cRecentlyReleased == dpa::s_cRecentlyReleasedMax || forceFlushBatch)
-	{
-		// TODO: Faster sort algorithm. For now just use bubble sort
+	typedef DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> dpa;
 
-        for (int i = 0; i < pAlloc->cRecentlyReleased - 1; i++)
-        {
-            bool didSwap = false;
-
-            for (int j = 0; j < pAlloc->cRecentlyReleased - 1 - i; j++)
-            {
-                T ** pp0 = &pAlloc->aRecentlyReleased[j];
-                T ** pp1 = &pAlloc->aRecentlyReleased[j + 1];
-
-                if (*pp0 > *pp1)
-                {
-                    T * pTemp = *pp0;
-                    *pp0 = *pp1;
-                    *pp1 = pTemp;
-                    didSwap = true;
-                }
-            }
-
-            if (!didSwap) break;
-        }
-
-		// Iterate through all buckets
-
-		int cItemsReleased = 0;
-		dpa::Bucket * pBucket = pAlloc->pBuckets;
-		while (pBucket && cItemsReleased < dpa::s_cRecentlyReleasedMax)
-		{
-            ALS_COMMON_ALLOC_Assert(!pBucket->pNextBucket || pBucket < pBucket->pNextBucket);     // Assert that buckets are sorted low to high
+	ALS_COMMON_ALLOC_Assert(pItem);
 
-			bool isBucketFull = !pBucket->alloc.pFree;
-			bool releasedItem = false;
+	// Buckets are aligned to their size, so the owning bucket is just the item's address rounded down
 
-			T * pFpaStart = pBucket->alloc.aPool;
-			T * pFpaEnd = pBucket->alloc.aPool + CapacityPerBucket;
+	uintptr_t iByteItem = reinterpret_cast<uintptr_t>(pItem);
+	dpa::Bucket * pBucket = reinterpret_cast<dpa::Bucket *>(iByteItem & ~uintptr_t(dpa::s_cByteBucket - 1));
 
-			T * pItem =
-				(cItemsReleased < dpa::s_cRecentlyReleasedMax) ?
-				pAlloc->aRecentlyReleased[cItemsReleased] :
-				nullptr;
+	ALS_COMMON_ALLOC_Assert(pItem >= pBucket->alloc.aPool && pItem < pBucket->alloc.aPool + dpa::s_capacityPerBucket);
 
-            // Release all items that are in this bucket
+	bool isBucketFull = !pBucket->alloc.pFree;
 
-			while (pItem >= pFpaStart && pItem < pFpaEnd)
-			{
-				ALS_COMMON_ALLOC_Assert(pItem);
+	release(&pBucket->alloc, pItem);
 
-				release(&pBucket->alloc, pItem);
+	// Move bucket into free-list if necessary
 
-				releasedItem = true;
-				cItemsReleased++;
-
-				pItem =
-					(cItemsReleased < dpa::s_cRecentlyReleasedMax) ?
-					pAlloc->aRecentlyReleased[cItemsReleased] :
-					nullptr;
-			}
-
-			// Move bucket into free-list if necessary
-
-			if (isBucketFull && releasedItem)
-			{
-				pBucket->pNextFree = pAlloc->pFree;
-				pAlloc->pFree = pBucket;
-			}
-
-			pBucket = pBucket->pNextBucket;
-		}
-
-        ALS_COMMON_ALLOC_Assert(cItemsReleased == pAlloc->cRecentlyReleased);
-        pAlloc->cRecentlyReleased = 0;
+	if (isBucketFull)
+	{
+		pBucket->pNextFree = pAlloc->pFree;
+		pAlloc->pFree = pBucket;
 	}
 }
 
-template <typename T, unsigned int CapacityPerBucket = 512>
-void reinit(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+void reinit(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc)
 {
-	typedef DynamicPoolAllocator<T, CapacityPerBucket> dpa;
-
 	// Free all of our buckets
 
 	destroy(pAlloc);
 
 	// Reinitialize
 
-	memset(pAlloc, 0, sizeof(dpa));
 	init(pAlloc);
 }
 
 #if defined(ALS_DEBUG) && 1
-template <typename T, unsigned int CapacityPerBucket>
-bool debug_hasCycle(DynamicPoolAllocator<T, CapacityPerBucket> * pAlloc)
+template <typename T, unsigned int CapacityPerBucket, unsigned int ItemAlignment>
+bool debug_hasCycle(DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> * pAlloc)
 {
-	typedef DynamicPoolAllocator<T, CapacityPerBucket> dpa;
+	typedef DynamicPoolAllocator<T, CapacityPerBucket, ItemAlignment> dpa;
 
 	bool freeEndReached = false;
 	bool bucketEndReached = false;
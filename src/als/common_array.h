@@ -35,6 +35,13 @@
 #endif
 #endif
 
+// Called with the new size every time a DynamicArray or SmallArray (re)allocates its buffer. Define it before including
+//	to count them.
+
+#ifndef ALS_COMMON_ARRAY_OnGrow
+#define ALS_COMMON_ARRAY_OnGrow(cByte)
+#endif
+
 #include <stdlib.h>     // realloc for DynamicArray
 
 // Ring Buffer (not thread safe)
@@ -273,6 +280,8 @@ void ensureCapacity(DynamicArray<T> * pArray, int requestedCapacity)
 
 	pArray->pBuffer = pBufferReallocd;
 	pArray->capacity = newCapacity;
+
+	ALS_COMMON_ARRAY_OnGrow(size_t(newCapacity) * sizeof(T));
 }
 
 template <typename T>
@@ -394,6 +403,255 @@ void reverse(DynamicArray<T> * pArray)
 }
 
 
+
+// Small array with inline storage (not thread safe)
+//	Holds up to N items inside the struct before spilling to the heap. Meant for the many tiny lists
+//	(func params, call args, overloads, etc.) that almost always have 0-3 items, so that they don't
+//	each pay for a heap allocation and a pointer chase. Zero-initialized memory is a valid, empty
+//	SmallArray. Items must be safe to memcpy, since the struct itself may be memcpy'd around
+//	(e.g., when it lives in a HashMap value or a DynamicArray).
+
+template <typename T, int N>
+struct SmallArray
+{
+	ALS_COMMON_ARRAY_StaticAssert(N > 0);
+
+	union
+	{
+		T aInline[N];
+		T * pHeap;
+	};
+
+	int cItem;
+	int capacity;		// <= N means we are using aInline
+
+	static constexpr int s_cItemInline = N;
+	static constexpr float gc_growthFactor = 1.5f;
+
+	bool isInline() const
+	{
+		return this->capacity <= N;
+	}
+
+	const T& operator[] (unsigned int i) const
+	{
+		return (this->isInline()) ? this->aInline[i] : this->pHeap[i];
+	}
+
+	T& operator[] (unsigned int i)
+	{
+		return (this->isInline()) ? this->aInline[i] : this->pHeap[i];
+	}
+};
+
+template <typename T, int N>
+T * itemBuffer(SmallArray<T, N> * pArray)
+{
+	return (pArray->isInline()) ? pArray->aInline : pArray->pHeap;
+}
+
+template <typename T, int N>
+const T * itemBuffer(const SmallArray<T, N> & array)
+{
+	return (array.isInline()) ? array.aInline : array.pHeap;
+}
+
+template <typename T, int N>
+void init(SmallArray<T, N> * pArray)
+{
+	pArray->cItem = 0;
+	pArray->capacity = N;
+}
+
+template <typename T, int N>
+void dispose(SmallArray<T, N> * pArray)
+{
+	if (!pArray->isInline())
+	{
+		free(pArray->pHeap);
+	}
+
+	init(pArray);
+}
+
+template <typename T, int N>
+void reinit(SmallArray<T, N> * pArray)
+{
+	dispose(pArray);
+	init(pArray);
+}
+
+template <typename T, int N>
+void ensureCapacity(SmallArray<T, N> * pArray, int requestedCapacity)
+{
+	typedef SmallArray<T, N> sa;
+
+	int capacity = (pArray->isInline()) ? N : pArray->capacity;
+	if (requestedCapacity <= capacity) return;
+
+	int newCapacity = capacity;
+	while (newCapacity < requestedCapacity)
+	{
+		newCapacity = static_cast<int>((newCapacity * sa::gc_growthFactor) + 1.0f);       // + 1 to force round up
+	}
+
+	if (pArray->isInline())
+	{
+		T * pBufferNew = static_cast<T *>(malloc(newCapacity * sizeof(T)));
+		if (!pBufferNew)
+		{
+			ALS_COMMON_ARRAY_Assert(false);		// Malloc failed! TODO (andrew) How to handle this?
+		}
+
+		memcpy(pBufferNew, pArray->aInline, pArray->cItem * sizeof(T));
+		pArray->pHeap = pBufferNew;
+	}
+	else
+	{
+		T * pBufferReallocd = static_cast<T *>(realloc(pArray->pHeap, newCapacity * sizeof(T)));
+		if (!pBufferReallocd)
+		{
+			ALS_COMMON_ARRAY_Assert(false);		// Realloc failed! TODO (andrew) How to handle this?
+		}
+
+		pArray->pHeap = pBufferReallocd;
+	}
+
+	ALS_COMMON_ARRAY_OnGrow(size_t(newCapacity) * sizeof(T));
+
+	pArray->capacity = newCapacity;
+}
+
+template <typename T, int N>
+T * appendNew(SmallArray<T, N> * pArray)
+{
+	ensureCapacity(pArray, pArray->cItem + 1);
+	pArray->cItem++;
+
+	return itemBuffer(pArray) + pArray->cItem - 1;
+}
+
+template <typename T, int N>
+void append(SmallArray<T, N> * pArray, const T & t)
+{
+	T * pNew = appendNew(pArray);
+	*pNew = t;
+}
+
+template <typename T, int N>
+void appendMultiple(SmallArray<T, N> * pArray, const T aT[], int cT)
+{
+	ensureCapacity(pArray, pArray->cItem + cT);
+
+	T * pBuffer = itemBuffer(pArray);
+	for (int i = 0; i < cT; i++)
+	{
+		pBuffer[pArray->cItem] = aT[i];
+		pArray->cItem++;
+	}
+}
+
+template <typename T, int N>
+void insert(SmallArray<T, N> * pArray, const T & t, int i)
+{
+	ensureCapacity(pArray, pArray->cItem + 1);
+
+	T * pBuffer = itemBuffer(pArray);
+	memmove(pBuffer + i + 1, pBuffer + i, (pArray->cItem - i) * sizeof(T));
+
+	pBuffer[i] = t;
+	pArray->cItem++;
+}
+
+template <typename T, int N>
+void prepend(SmallArray<T, N> * pArray, const T & t)
+{
+	insert(pArray, t, 0);
+}
+
+template <typename T, int N>
+int indexOf(const SmallArray<T, N> & array, const T & item)
+{
+	for (int i = 0; i < array.cItem; i++)
+	{
+		if (array[i] == item) return i;
+	}
+
+	return -1;
+}
+
+template <typename T, int N>
+void removeLast(SmallArray<T, N> * pArray)
+{
+	if (pArray->cItem > 0) pArray->cItem--;
+}
+
+template <typename T, int N>
+void remove(SmallArray<T, N> * pArray, int iItem)
+{
+	// Maintains order
+
+	if (iItem >= pArray->cItem) return;
+
+	T * pDst = itemBuffer(pArray) + iItem;
+	memmove(pDst, pDst + 1, (pArray->cItem - iItem - 1) * sizeof(T));
+
+	pArray->cItem--;
+}
+
+template <typename T, int N>
+void removeAll(SmallArray<T, N> * pArray)
+{
+	pArray->cItem = 0;
+}
+
+template <typename T, int N>
+void initCopy(SmallArray<T, N> * pArray, const SmallArray<T, N> & arraySrc)
+{
+	init(pArray);
+	appendMultiple(pArray, itemBuffer(arraySrc), arraySrc.cItem);
+}
+
+template <typename T, int N>
+void reinitCopy(SmallArray<T, N> * pArray, const SmallArray<T, N> & arraySrc)
+{
+	dispose(pArray);
+	initCopy(pArray, arraySrc);
+}
+
+template <typename T, int N>
+void initMove(SmallArray<T, N> * pArray, SmallArray<T, N> * pArraySrc)
+{
+	*pArray = *pArraySrc;
+	init(pArraySrc);
+}
+
+// Moves the contents of a DynamicArray into a SmallArray. If the items fit inline they are copied
+//	and the DynamicArray's buffer is freed, otherwise we just steal the buffer.
+
+template <typename T, int N>
+void initMove(SmallArray<T, N> * pArray, DynamicArray<T> * pArraySrc)
+{
+	init(pArray);
+
+	if (pArraySrc->cItem <= N)
+	{
+		memcpy(pArray->aInline, pArraySrc->pBuffer, pArraySrc->cItem * sizeof(T));
+		pArray->cItem = pArraySrc->cItem;
+		dispose(pArraySrc);
+	}
+	else
+	{
+		pArray->pHeap = pArraySrc->pBuffer;
+		pArray->cItem = pArraySrc->cItem;
+		pArray->capacity = pArraySrc->capacity;
+
+		pArraySrc->pBuffer = nullptr;
+		pArraySrc->cItem = 0;
+		pArraySrc->capacity = 0;
+	}
+}
+
 // Fixed array (not thread safe)
 
 template <typename T, int CAPACITY>
@@ -35,6 +35,12 @@
 #endif
 #endif
 
+// Called with the new size every time a HashMap grows its buffer. Define it before including to count them.
+
+#ifndef ALS_COMMON_HASH_OnGrow
+#define ALS_COMMON_HASH_OnGrow(cByte)
+#endif
+
 #include <stdint.h>		// For uint32_t
 
 // Hash map (not thread safe)
@@ -467,7 +473,7 @@ bool remove(
 		key,
 		_ALSHASHOPK_Remove,
 		static_cast<const V*>(nullptr),	// Update
-		static_cast<V*>(nullptr),		// Lookup
+		static_cast<V**>(nullptr),		// Lookup
 		poValueRemoved,					// Remove
 		static_cast<K **>(nullptr)		// Address of found key
 	);
@@ -512,6 +518,8 @@ void growHashmap(
 
 	pHashmap->cCapacity = newCapacity;
 
+	ALS_COMMON_HASH_OnGrow(cBytesNewBuffer);
+
 	// Deal with old buffer!
 
 	if (pBufferOld)
@@ -574,11 +582,14 @@ void dispose(HashMap<K, V> * pHashmap)
 
 // Bi-directional hashmap where all keys are unique and all values are unique.
 
+// NOTE (andrew) Each side keeps its own copy of the other rather than pointing into the other map's buckets. Buckets
+//	move whenever a map grows (or hopscotch displaces them on insert), which left those pointers dangling.
+
 template <typename K, typename V>
 struct BiHashMap
 {
-	HashMap<K, V*> mapKV;
-	HashMap<V, K*> mapVK;
+	HashMap<K, V> mapKV;
+	HashMap<V, K> mapVK;
 };
 
 template <typename K, typename V>
@@ -620,14 +631,8 @@ bool insert(BiHashMap<K, V> * pBimap, const K & key, const V & value)
 
 	ALS_COMMON_HASH_Assert(!lookup(pBimap->mapVK, value));
 
-	K * pKeyInTable;
-	V * pValueInTable;
-
-	V ** ppV = insertNew(&pBimap->mapKV, key, &pKeyInTable);
-	K ** ppK = insertNew(&pBimap->mapVK, value, &pValueInTable);
-
-	*ppK = pKeyInTable;
-	*ppV = pValueInTable;
+	insert(&pBimap->mapKV, key, value);
+	insert(&pBimap->mapVK, value, key);
 
     return true;
 }
@@ -635,7 +640,7 @@ bool insert(BiHashMap<K, V> * pBimap, const K & key, const V & value)
 template <typename K, typename V>
 struct BiHashMapIter
 {
-	const HashMap<K, V *> * pMapKV;
+	const HashMap<K, V> * pMapKV;
 	int iItem;
 
 	const K * pKey;
@@ -645,7 +650,7 @@ struct BiHashMapIter
 template <typename K, typename V>
 void iterNext(BiHashMapIter<K, V> * pIter)
 {
-	typedef HashMap<K, V *> hm;
+	typedef HashMap<K, V> hm;
 
 	bool hadNext = false;
 	for (pIter->iItem += 1; pIter->iItem < pIter->pMapKV->cCapacity; pIter->iItem += 1)
@@ -654,7 +659,7 @@ void iterNext(BiHashMapIter<K, V> * pIter)
 		if (pBucket->infoBits & AlsHash::s_infoOccupiedMask)
 		{
 			pIter->pKey = &pBucket->key;
-			pIter->pValue = pBucket->value;
+			pIter->pValue = &pBucket->value;
 			hadNext = true;
 			break;
 		}
@@ -682,11 +687,7 @@ BiHashMapIter<K, V> iter(const BiHashMap<K, V> & bimap)
 template <typename K, typename V>
 V * lookupByKeyRaw(const BiHashMap<K, V> & bimap, const K & key)
 {
-	V ** ppResult = lookup(bimap.mapKV, key);
-
-	if (ppResult) return *ppResult;
-
-	return nullptr;
+	return lookup(bimap.mapKV, key);
 }
 
 template <typename K, typename V>
@@ -698,11 +699,7 @@ const V * lookupByKey(const BiHashMap<K, V> & bimap, const K & key)
 template <typename K, typename V>
 K * lookupByValueRaw(const BiHashMap<K, V> & bimap, const V & value)
 {
-	K ** ppResult = lookup(bimap.mapVK, value);
-
-	if (ppResult) return *ppResult;
-
-	return nullptr;
+	return lookup(bimap.mapVK, value);
 }
 
 template <typename K, typename V>
@@ -714,22 +711,13 @@ const K * lookupByValue(const BiHashMap<K, V> & bimap, const V & value)
 template <typename K, typename V>
 bool removeByKey(BiHashMap<K, V> * pBimap, const K & key, V * poValueRemoved=nullptr)
 {
-	V * pValueInTable;
-
-	bool result = remove(&pBimap->mapKV, key, &pValueInTable);
-
-	if (!result) return false;
+	V valueRemoved;
+	if (!remove(&pBimap->mapKV, key, &valueRemoved)) return false;
 
-	// Copy actual value before we remove it from the other table
+	ALS_COMMON_HASH_Verify(remove(&pBimap->mapVK, valueRemoved));
 
 	if (poValueRemoved)
-		*poValueRemoved = *pValueInTable;
-
-
-	// Could optimize this since we already have a pointer to the value we want to remove. But that isn't
-	//	easily exposed in the hash table API
-
-	ALS_COMMON_HASH_Verify(remove(&pBimap->mapVK, *pValueInTable));
+		*poValueRemoved = valueRemoved;
 
 	return true;
 }
@@ -737,22 +725,13 @@ bool removeByKey(BiHashMap<K, V> * pBimap, const K & key, V * poValueRemoved=nul
 template <typename K, typename V>
 bool removeByValue(BiHashMap<K, V> * pBimap, const V & value, K * poKeyRemoved=nullptr)
 {
-	K * pKeyInTable;
-
-	bool result = remove(&pBimap->mapVK, value, &pKeyInTable);
+	K keyRemoved;
+	if (!remove(&pBimap->mapVK, value, &keyRemoved)) return false;
 
-	if (!result) return false;
-
-	// Copy actual key before we remove it from the other table
+	ALS_COMMON_HASH_Verify(remove(&pBimap->mapKV, keyRemoved));
 
 	if (poKeyRemoved)
-		*poKeyRemoved = *pKeyInTable;
-
-
-	// Could optimize this since we already have a pointer to the key we want to remove. But that isn't
-	//	easily exposed in the hash table API
-
-	ALS_COMMON_HASH_Verify(remove(&pBimap->mapKV, *pKeyInTable));
+		*poKeyRemoved = keyRemoved;
 
 	return true;
 }
@@ -760,20 +739,13 @@ bool removeByValue(BiHashMap<K, V> * pBimap, const V & value, K * poKeyRemoved=n
 template <typename K, typename V>
 bool updateByKey(BiHashMap<K, V> * pBimap, const K & key, const V & value)
 {
-	K * pKeyInTable;
-	V * pValueInTableOld = lookup(&pBimap->mapKV, key, &pKeyInTable);
-	if (!pValueInTableOld) return false;
-
-	ALS_COMMON_HASH_Verify(
-		remove(&pBimap->mapVK, *pValueInTableOld)
-	);
+	V * pValueOld = lookup(pBimap->mapKV, key);
+	if (!pValueOld) return false;
 
-	V * pValueInTableNew;
-	insert(&pBimap->mapVK, value, pKeyInTable, &pValueInTableNew);
+	ALS_COMMON_HASH_Verify(remove(&pBimap->mapVK, *pValueOld));
+	insert(&pBimap->mapVK, value, key);
 
-	ALS_COMMON_HASH_Verify(
-		update(&pBimap->mapKV, key, pValueInTableNew)
-	);
+	*pValueOld = value;
 
 	return true;
 }
@@ -781,20 +753,13 @@ bool updateByKey(BiHashMap<K, V> * pBimap, const K & key, const V & value)
 template <typename K, typename V>
 bool updateByValue(BiHashMap<K, V> * pBimap, const V & value, const K & key)
 {
-	V * pValueInTable;
-	K * pKeyInTableOld = lookup(&pBimap->mapVK, value, &pValueInTable);
-	if (!pKeyInTableOld) return false;
+	K * pKeyOld = lookup(pBimap->mapVK, value);
+	if (!pKeyOld) return false;
 
-	ALS_COMMON_HASH_Verify(
-		remove(&pBimap->mapKV, *pKeyInTableOld)
-	);
-
-	K * pKeyInTableNew;
-	insert(&pBimap->mapKV, key, pValueInTable, &pKeyInTableNew);
+	ALS_COMMON_HASH_Verify(remove(&pBimap->mapKV, *pKeyOld));
+	insert(&pBimap->mapKV, key, value);
 
-	ALS_COMMON_HASH_Verify(
-		update(&pBimap->mapVK, value, pKeyInTableNew)
-	);
+	*pKeyOld = key;
 
 	return true;
 }
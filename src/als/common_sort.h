@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stdint.h>     // For uint32_t
+#include <string.h>     // For memcpy
+
 template <typename T>
 void bubbleSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
 {
@@ -22,4 +25,369 @@ void bubbleSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
 
         if (!didSwap) break;
     }
-}
\ No newline at end of file
+}
+
+template <typename T>
+void insertionSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
+{
+    for (int i = 1; i < cItem; i++)
+    {
+        T item = pBuffer[i];
+
+        int j = i - 1;
+        while (j >= 0 && pfnCompare(pBuffer[j], item) > 0)
+        {
+            pBuffer[j + 1] = pBuffer[j];
+            j--;
+        }
+
+        pBuffer[j + 1] = item;
+    }
+}
+
+namespace _Als_Helper
+{
+    static const int s_cItemInsertionSortMax = 24;
+    static const int s_cItemNintherMin = 128;
+    static const int s_cMovePartialInsertionSortMax = 8;
+
+    template <typename T>
+    void swap(T * pT0, T * pT1)
+    {
+        T temp = *pT0;
+        *pT0 = *pT1;
+        *pT1 = temp;
+    }
+
+    // Insertion sort that gives up after a handful of moves. Used to cheaply finish off ranges that
+    //  look nearly sorted. Returns true if the range ended up sorted.
+
+    template <typename T>
+    bool tryPartialInsertionSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
+    {
+        int cMove = 0;
+        for (int i = 1; i < cItem; i++)
+        {
+            if (pfnCompare(pBuffer[i - 1], pBuffer[i]) <= 0)
+                continue;
+
+            T item = pBuffer[i];
+
+            int j = i - 1;
+            while (j >= 0 && pfnCompare(pBuffer[j], item) > 0)
+            {
+                pBuffer[j + 1] = pBuffer[j];
+                j--;
+            }
+
+            pBuffer[j + 1] = item;
+
+            cMove += i - 1 - j;
+            if (cMove > s_cMovePartialInsertionSortMax) return false;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    void siftDown(T * pBuffer, int iRoot, int cItem, int (*pfnCompare)(const T &, const T &))
+    {
+        while (true)
+        {
+            int iChild = 2 * iRoot + 1;
+            if (iChild >= cItem) return;
+
+            if (iChild + 1 < cItem && pfnCompare(pBuffer[iChild], pBuffer[iChild + 1]) < 0)
+            {
+                iChild++;
+            }
+
+            if (pfnCompare(pBuffer[iRoot], pBuffer[iChild]) >= 0) return;
+
+            swap(pBuffer + iRoot, pBuffer + iChild);
+            iRoot = iChild;
+        }
+    }
+
+    template <typename T>
+    void heapSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
+    {
+        for (int i = cItem / 2 - 1; i >= 0; i--)
+        {
+            siftDown(pBuffer, i, cItem, pfnCompare);
+        }
+
+        for (int i = cItem - 1; i > 0; i--)
+        {
+            swap(pBuffer, pBuffer + i);
+            siftDown(pBuffer, 0, i, pfnCompare);
+        }
+    }
+
+    // Sorts the 3 items in place so that *pT1 is the median
+
+    template <typename T>
+    void sort3(T * pT0, T * pT1, T * pT2, int (*pfnCompare)(const T &, const T &))
+    {
+        if (pfnCompare(*pT1, *pT0) < 0) swap(pT0, pT1);
+        if (pfnCompare(*pT2, *pT1) < 0) swap(pT1, pT2);
+        if (pfnCompare(*pT1, *pT0) < 0) swap(pT0, pT1);
+    }
+
+    // Partitions around the pivot in pBuffer[0]. Items equal to the pivot go right.
+    //  Returns the pivot's final index, and whether we didn't need to swap anything.
+
+    template <typename T>
+    int partitionRight(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &), bool * poAlreadyPartitioned)
+    {
+        T pivot = pBuffer[0];
+
+        int iLeft = 0;
+        int iRight = cItem;
+
+        // Median-of-3 guarantees these scans stop before running off either end
+
+        while (pfnCompare(pBuffer[++iLeft], pivot) < 0) {}
+
+        if (iLeft - 1 == 0)
+        {
+            while (iLeft < iRight && pfnCompare(pBuffer[--iRight], pivot) >= 0) {}
+        }
+        else
+        {
+            while (pfnCompare(pBuffer[--iRight], pivot) >= 0) {}
+        }
+
+        *poAlreadyPartitioned = iLeft >= iRight;
+
+        while (iLeft < iRight)
+        {
+            swap(pBuffer + iLeft, pBuffer + iRight);
+            while (pfnCompare(pBuffer[++iLeft], pivot) < 0) {}
+            while (pfnCompare(pBuffer[--iRight], pivot) >= 0) {}
+        }
+
+        int iPivot = iLeft - 1;
+        pBuffer[0] = pBuffer[iPivot];
+        pBuffer[iPivot] = pivot;
+
+        return iPivot;
+    }
+
+    // Partitions around the pivot in pBuffer[0], putting items equal to the pivot on the left. Used
+    //  when the pivot equals the item just left of this range, which means everything equal to it is
+    //  already in its final spot. Returns the index of the first item greater than the pivot.
+
+    template <typename T>
+    int partitionLeft(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
+    {
+        T pivot = pBuffer[0];
+
+        int iLeft = 0;
+        int iRight = cItem;
+
+        while (pfnCompare(pivot, pBuffer[--iRight]) < 0) {}
+
+        if (iRight + 1 == cItem)
+        {
+            while (iLeft < iRight && pfnCompare(pivot, pBuffer[++iLeft]) >= 0) {}
+        }
+        else
+        {
+            while (pfnCompare(pivot, pBuffer[++iLeft]) >= 0) {}
+        }
+
+        while (iLeft < iRight)
+        {
+            swap(pBuffer + iLeft, pBuffer + iRight);
+            while (pfnCompare(pivot, pBuffer[--iRight]) < 0) {}
+            while (pfnCompare(pivot, pBuffer[++iLeft]) >= 0) {}
+        }
+
+        pBuffer[0] = pBuffer[iRight];
+        pBuffer[iRight] = pivot;
+
+        return iRight + 1;
+    }
+
+    template <typename T>
+    void introSortRecurse(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &), int cBadPartitionAllowed, bool isLeftmost)
+    {
+        while (true)
+        {
+            if (cItem < s_cItemInsertionSortMax)
+            {
+                insertionSort(pBuffer, cItem, pfnCompare);
+                return;
+            }
+
+            // Choose pivot as median of 3 (or pseudomedian of 9 for big ranges) and move it to the front
+
+            int iMid = cItem / 2;
+            if (cItem > s_cItemNintherMin)
+            {
+                sort3(pBuffer, pBuffer + iMid, pBuffer + cItem - 1, pfnCompare);
+                sort3(pBuffer + 1, pBuffer + iMid - 1, pBuffer + cItem - 2, pfnCompare);
+                sort3(pBuffer + 2, pBuffer + iMid + 1, pBuffer + cItem - 3, pfnCompare);
+                sort3(pBuffer + iMid - 1, pBuffer + iMid, pBuffer + iMid + 1, pfnCompare);
+                swap(pBuffer, pBuffer + iMid);
+            }
+            else
+            {
+                sort3(pBuffer + iMid, pBuffer, pBuffer + cItem - 1, pfnCompare);
+            }
+
+            // Lots of items equal to the pivot. Everything equal to the item before our range is already
+            //  sorted, so partition those out and only keep going on the right.
+
+            if (!isLeftmost && pfnCompare(pBuffer[-1], pBuffer[0]) >= 0)
+            {
+                int iStart = partitionLeft(pBuffer, cItem, pfnCompare);
+                pBuffer += iStart;
+                cItem -= iStart;
+                continue;
+            }
+
+            bool alreadyPartitioned;
+            int iPivot = partitionRight(pBuffer, cItem, pfnCompare, &alreadyPartitioned);
+
+            int cLeft = iPivot;
+            int cRight = cItem - iPivot - 1;
+            bool isHighlyUnbalanced = cLeft < cItem / 8 || cRight < cItem / 8;
+
+            if (isHighlyUnbalanced)
+            {
+                // Too many bad partitions means we're probably up against an adversarial pattern. Fall
+                //  back to heapsort to keep the worst case at n log n.
+
+                cBadPartitionAllowed--;
+                if (cBadPartitionAllowed <= 0)
+                {
+                    heapSort(pBuffer, cItem, pfnCompare);
+                    return;
+                }
+
+                // Break up the pattern by swapping a few items around
+
+                if (cLeft >= s_cItemInsertionSortMax)
+                {
+                    swap(pBuffer, pBuffer + cLeft / 4);
+                    swap(pBuffer + iPivot - 1, pBuffer + iPivot - cLeft / 4);
+                }
+
+                if (cRight >= s_cItemInsertionSortMax)
+                {
+                    swap(pBuffer + iPivot + 1, pBuffer + iPivot + 1 + cRight / 4);
+                    swap(pBuffer + cItem - 1, pBuffer + cItem - cRight / 4);
+                }
+            }
+            else if (alreadyPartitioned)
+            {
+                // Input is likely already (nearly) sorted. Try to finish both sides cheaply.
+
+                if (tryPartialInsertionSort(pBuffer, cLeft, pfnCompare) &&
+                    tryPartialInsertionSort(pBuffer + iPivot + 1, cRight, pfnCompare))
+                {
+                    return;
+                }
+            }
+
+            // Recurse into the left, loop on the right
+
+            introSortRecurse(pBuffer, cLeft, pfnCompare, cBadPartitionAllowed, isLeftmost);
+
+            pBuffer += iPivot + 1;
+            cItem = cRight;
+            isLeftmost = false;
+        }
+    }
+
+    inline int log2Floor(unsigned int n)
+    {
+        int result = 0;
+        while (n >>= 1)
+        {
+            result++;
+        }
+
+        return result;
+    }
+}
+
+// Pattern-defeating introsort. Quicksort that detects (nearly) sorted input, breaks up patterns that
+//  would make it go quadratic, and falls back to heapsort if that still isn't enough. Not stable.
+
+template <typename T>
+void introSort(T * pBuffer, int cItem, int (*pfnCompare)(const T &, const T &))
+{
+    if (cItem < 2) return;
+
+    _Als_Helper::introSortRecurse(pBuffer, cItem, pfnCompare, _Als_Helper::log2Floor(cItem), true);
+}
+
+// LSD radix sort on a 32 bit key, one byte per pass. Stable. Requires a scratch buffer with room
+//  for cItem items. Passes where every key has the same byte are skipped, so small keys (e.g., ids
+//  that haven't gotten very big) only cost a pass or two.
+
+template <typename T>
+void radixSort(T * pBuffer, T * pScratch, int cItem, uint32_t (*pfnKey)(const T &))
+{
+    if (cItem < 2) return;
+
+    static const int s_cBucket = 256;
+    static const int s_cPass = 4;
+
+    // Build histograms for every pass up front so we only read the keys once here
+
+    int aaCount[s_cPass][s_cBucket];
+    memset(aaCount, 0, sizeof(aaCount));
+
+    for (int i = 0; i < cItem; i++)
+    {
+        uint32_t key = pfnKey(pBuffer[i]);
+        for (int iPass = 0; iPass < s_cPass; iPass++)
+        {
+            aaCount[iPass][(key >> (iPass * 8)) & 0xFF]++;
+        }
+    }
+
+    T * pSrc = pBuffer;
+    T * pDst = pScratch;
+
+    for (int iPass = 0; iPass < s_cPass; iPass++)
+    {
+        int * aCount = aaCount[iPass];
+
+        // Skip pass if every item lands in the same bucket
+
+        uint32_t byteFirst = (pfnKey(pSrc[0]) >> (iPass * 8)) & 0xFF;
+        if (aCount[byteFirst] == cItem)
+            continue;
+
+        // Convert counts to starting offsets
+
+        int iStart = 0;
+        for (int iBucket = 0; iBucket < s_cBucket; iBucket++)
+        {
+            int count = aCount[iBucket];
+            aCount[iBucket] = iStart;
+            iStart += count;
+        }
+
+        for (int i = 0; i < cItem; i++)
+        {
+            uint32_t byte = (pfnKey(pSrc[i]) >> (iPass * 8)) & 0xFF;
+            pDst[aCount[byte]] = pSrc[i];
+            aCount[byte]++;
+        }
+
+        T * pTemp = pSrc;
+        pSrc = pDst;
+        pDst = pTemp;
+    }
+
+    if (pSrc != pBuffer)
+    {
+        memcpy(pBuffer, pSrc, cItem * sizeof(T));
+    }
+}
@@ -35,6 +35,12 @@
 #endif
 #endif
 
+// Called with the new size every time a String (re)allocates its buffer. Define it before including to count them.
+
+#ifndef ALS_COMMON_STRING_OnGrow
+#define ALS_COMMON_STRING_OnGrow(cByte)
+#endif
+
 // A fairly dumb string implementation
 
 struct String
@@ -86,6 +92,8 @@ inline void ensureCapacity(String * pStr, int requestedCapacity)
 	}
 
 	pStr->capacity = newCapacity;
+
+	ALS_COMMON_STRING_OnGrow(size_t(actualRequestCapacity) * sizeof(char));
 }
 
 inline void init(String * pStr)
@@ -19,55 +19,48 @@ FuncId funcid(const AstNode & node)
 	}
 }
 
-void walkAst(
-	MeekCtx * pCtx,
-	AstNode * pNodeSubtreeRoot,
-	AstWalkVisitPreFn visitPreorderFn,
-	AstWalkHookFn hookFn,
-	AstWalkVisitPostFn visitPostorderFn,
-	void * pContext)
+bool isExternFunc(const AstNode & node)
 {
-	Assert(pNodeSubtreeRoot);
-	Assert(visitPreorderFn);
-	Assert(visitPostorderFn);
+	return node.astk == ASTK_FuncDefnStmt && !DownConst(&node, FuncDefnStmt)->pBodyStmt;
+}
 
-#if DEBUG
-	{
-		int iLine = getStartLine(*pCtx, pNodeSubtreeRoot->astid);
-		if (iLine == 20)
-		{
-			bool brk = true;
-		}
-	}
-#endif
+AstWalkStep walkStep(AstNode * pNode, int iStep)
+{
+	// NOTE (andrew) Each node kind is a small state machine. iStep counts how many children/hooks we've
+	//	already produced for this node. The order here defines the walk order, so it must match what the
+	//	visitors expect (e.g., bytecode emission depends on lhs being visited before rhs).
 
-	bool shouldVisitChildren = visitPreorderFn(pNodeSubtreeRoot, pContext);
-	if (!shouldVisitChildren)
-		return;
+	AstWalkStep step;
+	step.awstepk = AWSTEPK_Done;
+	step.pChild = nullptr;
+
+	auto child = [&step](AstNode * pChild) { step.awstepk = AWSTEPK_Child; step.pChild = pChild; };
+	auto hook = [&step](AWHK awhk) { step.awstepk = AWSTEPK_Hook; step.awhk = awhk; };
 
-	if (category(pNodeSubtreeRoot->astk) == ASTCATK_Error)
+	if (category(pNode->astk) == ASTCATK_Error)
 	{
-		AstErr * pErr = DownErr(pNodeSubtreeRoot);
-		for (int iChild = 0; iChild < pErr->apChildren.cItem; iChild++)
-		{
-			walkAst(pCtx, pErr->apChildren[iChild], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-		}
+		AstErr * pErr = DownErr(pNode);
+		if (iStep < pErr->apChildren.cItem) child(pErr->apChildren[iStep]);
+		return step;
 	}
 
-	switch (pNodeSubtreeRoot->astk)
+	switch (pNode->astk)
 	{
 		case ASTK_UnopExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, UnopExpr);
-			walkAst(pCtx, pNode->pExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, UnopExpr);
+			if (iStep == 0) child(pExpr->pExpr);
 		} break;
 
 		case ASTK_BinopExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, BinopExpr);
-			walkAst(pCtx, pNode->pLhsExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_BinopPostFirstOperand, pContext);
-			walkAst(pCtx, pNode->pRhsExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, BinopExpr);
+			switch (iStep)
+			{
+				case 0: child(pExpr->pLhsExpr); break;
+				case 1: hook(AWHK_BinopPostFirstOperand); break;
+				case 2: child(pExpr->pRhsExpr); break;
+			}
 		} break;
 
 		case ASTK_LiteralExpr:
@@ -75,135 +68,130 @@ void walkAst(
 
 		case ASTK_GroupExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, GroupExpr);
-			walkAst(pCtx, pNode->pExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, GroupExpr);
+			if (iStep == 0) child(pExpr->pExpr);
 		} break;
 
 		case ASTK_SymbolExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, SymbolExpr);
-			if (pNode->symbexprk == SYMBEXPRK_MemberVar)
-			{
-				walkAst(pCtx, pNode->memberData.pOwner, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pExpr = Down(pNode, SymbolExpr);
+			if (iStep == 0 && pExpr->symbexprk == SYMBEXPRK_MemberVar) child(pExpr->memberData.pOwner);
 		} break;
 
 		case ASTK_PointerDereferenceExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, PointerDereferenceExpr);
-			walkAst(pCtx, pNode->pPointerExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, PointerDereferenceExpr);
+			if (iStep == 0) child(pExpr->pPointerExpr);
 		} break;
 
 		case ASTK_ArrayAccessExpr:
 		{
 			// NOTE (andrew) in foo[bar], this evaluates foo, then bar
 
-			auto * pNode = Down(pNodeSubtreeRoot, ArrayAccessExpr);
-			walkAst(pCtx, pNode->pArrayExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			walkAst(pCtx, pNode->pSubscriptExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, ArrayAccessExpr);
+			switch (iStep)
+			{
+				case 0: child(pExpr->pArrayExpr); break;
+				case 1: child(pExpr->pSubscriptExpr); break;
+			}
 		} break;
 
 		case ASTK_FuncCallExpr:
 		{
 			// NOTE (andrew) in foo(bar, baz), this evaluates foo, then bar, then baz.
 
-			auto * pNode = Down(pNodeSubtreeRoot, FuncCallExpr);
-			walkAst(pCtx, pNode->pFunc, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-
-			for (int iArg = 0; iArg < pNode->apArgs.cItem; iArg++)
-			{
-				walkAst(pCtx, pNode->apArgs[iArg], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pExpr = Down(pNode, FuncCallExpr);
+			if (iStep == 0)							child(pExpr->pFunc);
+			else if (iStep - 1 < pExpr->apArgs.cItem)	child(pExpr->apArgs[iStep - 1]);
 		} break;
 
 		case ASTK_FuncLiteralExpr:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, FuncLiteralExpr);
-			walkAst(pCtx, Up(pNode->pParamsReturnsGrp), visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_FuncPostFormalReturnVardecls, pContext);
-			walkAst(pCtx, pNode->pBodyStmt, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pExpr = Down(pNode, FuncLiteralExpr);
+			switch (iStep)
+			{
+				case 0: child(Up(pExpr->pParamsReturnsGrp)); break;
+				case 1: hook(AWHK_FuncPostFormalReturnVardecls); break;
+				case 2: child(pExpr->pBodyStmt); break;
+			}
 		} break;
 
 		case ASTK_ExprStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, ExprStmt);
-			walkAst(pCtx, pNode->pExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pStmt = Down(pNode, ExprStmt);
+			if (iStep == 0) child(pStmt->pExpr);
 		} break;
 
 		case ASTK_AssignStmt:
 		{
 			// NOTE (andrew) in foo = bar, this evaluates foo, then bar.
 
-			auto * pNode = Down(pNodeSubtreeRoot, AssignStmt);
-			walkAst(pCtx, pNode->pLhsExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_AssignPostLhs, pContext);
-			walkAst(pCtx, pNode->pRhsExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pStmt = Down(pNode, AssignStmt);
+			switch (iStep)
+			{
+				case 0: child(pStmt->pLhsExpr); break;
+				case 1: hook(AWHK_AssignPostLhs); break;
+				case 2: child(pStmt->pRhsExpr); break;
+			}
 		} break;
 
 		case ASTK_VarDeclStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, VarDeclStmt);
-			if (pNode->pInitExpr)
-			{
-				walkAst(pCtx, pNode->pInitExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pStmt = Down(pNode, VarDeclStmt);
+			if (iStep == 0 && pStmt->pInitExpr) child(pStmt->pInitExpr);
 		} break;
 
 		case ASTK_FuncDefnStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, FuncDefnStmt);
-			walkAst(pCtx, Up(pNode->pParamsReturnsGrp), visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_FuncPostFormalReturnVardecls, pContext);
-			walkAst(pCtx, pNode->pBodyStmt, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pStmt = Down(pNode, FuncDefnStmt);
+			switch (iStep)
+			{
+				case 0: child(Up(pStmt->pParamsReturnsGrp)); break;
+				case 1: hook(AWHK_FuncPostFormalReturnVardecls); break;
+				case 2: if (pStmt->pBodyStmt) child(pStmt->pBodyStmt); break;
+			}
 		} break;
 
 		case ASTK_StructDefnStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, StructDefnStmt);
-			for (int iVarDecl = 0; iVarDecl < pNode->apVarDeclStmt.cItem; iVarDecl++)
-			{
-				walkAst(pCtx, pNode->apVarDeclStmt[iVarDecl], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pStmt = Down(pNode, StructDefnStmt);
+			if (iStep < pStmt->apVarDeclStmt.cItem) child(pStmt->apVarDeclStmt[iStep]);
 		} break;
 
 		case ASTK_IfStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, IfStmt);
-			walkAst(pCtx, pNode->pCondExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_IfPostCondition, pContext);
-			walkAst(pCtx, pNode->pThenStmt, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-
-			if (pNode->pElseStmt)
+			auto * pStmt = Down(pNode, IfStmt);
+			switch (iStep)
 			{
-				hookFn(Up(pNode), AWHK_IfPreElse, pContext);
-				walkAst(pCtx, pNode->pElseStmt, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+				case 0: child(pStmt->pCondExpr); break;
+				case 1: hook(AWHK_IfPostCondition); break;
+				case 2: child(pStmt->pThenStmt); break;
+				case 3: if (pStmt->pElseStmt) hook(AWHK_IfPreElse); break;
+				case 4: child(pStmt->pElseStmt); break;
 			}
 		} break;
 
 		case ASTK_WhileStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, WhileStmt);
-			walkAst(pCtx, pNode->pCondExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			hookFn(Up(pNode), AWHK_WhilePostCondition, pContext);
-			walkAst(pCtx, pNode->pBodyStmt, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pStmt = Down(pNode, WhileStmt);
+			switch (iStep)
+			{
+				case 0: child(pStmt->pCondExpr); break;
+				case 1: hook(AWHK_WhilePostCondition); break;
+				case 2: child(pStmt->pBodyStmt); break;
+			}
 		} break;
 
 		case ASTK_BlockStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, BlockStmt);
-			for (int iStmt = 0; iStmt < pNode->apStmts.cItem; iStmt++)
-			{
-				walkAst(pCtx, pNode->apStmts[iStmt], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pStmt = Down(pNode, BlockStmt);
+			if (iStep < pStmt->apStmts.cItem) child(pStmt->apStmts[iStep]);
 		} break;
 
 		case ASTK_ReturnStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, ReturnStmt);
-			if (pNode->pExpr)
-			{
-				walkAst(pCtx, pNode->pExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pStmt = Down(pNode, ReturnStmt);
+			if (iStep == 0 && pStmt->pExpr) child(pStmt->pExpr);
 		} break;
 
 		case ASTK_BreakStmt:
@@ -214,35 +202,117 @@ void walkAst(
 
 		case ASTK_PrintStmt:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, PrintStmt);
-			walkAst(pCtx, pNode->pExpr, visitPreorderFn, hookFn, visitPostorderFn, pContext);
+			auto * pStmt = Down(pNode, PrintStmt);
+			if (iStep == 0) child(pStmt->pExpr);
 		} break;
 
 		case ASTK_ParamsReturnsGrp:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, ParamsReturnsGrp);
-			for (int iParam = 0; iParam < pNode->apParamVarDecls.cItem; iParam++)
-			{
-				walkAst(pCtx, pNode->apParamVarDecls[iParam], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			auto * pGrp = Down(pNode, ParamsReturnsGrp);
+			int cParam = pGrp->apParamVarDecls.cItem;
+			if (iStep < cParam)											child(pGrp->apParamVarDecls[iStep]);
+			else if (iStep - cParam < pGrp->apReturnVarDecls.cItem)		child(pGrp->apReturnVarDecls[iStep - cParam]);
+		} break;
+
+		case ASTK_Program:
+		{
+			auto * pProgram = Down(pNode, Program);
+			if (iStep < pProgram->apNodes.cItem) child(pProgram->apNodes[iStep]);
+		} break;
+	}
+
+	return step;
+}
+
+struct AstWalkVisitorDynamic
+{
+	AstWalkVisitPreFn visitPreorderFn;
+	AstWalkHookFn hookFn;
+	AstWalkVisitPostFn visitPostorderFn;
+	void * pContext;
+
+	bool visitPreorder(AstNode * pNode)			{ return visitPreorderFn(pNode, pContext); }
+	void hook(AstNode * pNode, AWHK awhk)		{ hookFn(pNode, awhk, pContext); }
+	void visitPostorder(AstNode * pNode)		{ visitPostorderFn(pNode, pContext); }
+};
+
+void walkAst(
+	MeekCtx * pCtx,
+	AstNode * pNodeSubtreeRoot,
+	AstWalkVisitPreFn visitPreorderFn,
+	AstWalkHookFn hookFn,
+	AstWalkVisitPostFn visitPostorderFn,
+	void * pContext)
+{
+	Assert(visitPreorderFn);
+	Assert(hookFn);
+	Assert(visitPostorderFn);
+
+	AstWalkVisitorDynamic visitor;
+	visitor.visitPreorderFn = visitPreorderFn;
+	visitor.hookFn = hookFn;
+	visitor.visitPostorderFn = visitPostorderFn;
+	visitor.pContext = pContext;
+
+	walkAstIterative(pNodeSubtreeRoot, &visitor);
+}
+
+// Postorder, since walkStep(..) is still reading a node's lists of children until all of them have been visited
+
+static void visitDisposePostorder(AstNode * pNode, void * pContext)
+{
+	if (isErrorNode(*pNode))
+	{
+		dispose(&DownErr(pNode)->apChildren);
+		return;
+	}
 
-			for (int iParam = 0; iParam < pNode->apReturnVarDecls.cItem; iParam++)
+	switch (pNode->astk)
+	{
+		case ASTK_SymbolExpr:
+		{
+			auto * pExpr = Down(pNode, SymbolExpr);
+			if (pExpr->symbexprk == SYMBEXPRK_Unresolved)
 			{
-				walkAst(pCtx, pNode->apReturnVarDecls[iParam], visitPreorderFn, hookFn, visitPostorderFn, pContext);
+				dispose(&pExpr->unresolvedData.aCandidates);
 			}
 		} break;
 
+		case ASTK_FuncCallExpr:
+		{
+			dispose(&Down(pNode, FuncCallExpr)->apArgs);
+		} break;
+
+		case ASTK_StructDefnStmt:
+		{
+			dispose(&Down(pNode, StructDefnStmt)->apVarDeclStmt);
+		} break;
+
+		case ASTK_BlockStmt:
+		{
+			dispose(&Down(pNode, BlockStmt)->apStmts);
+		} break;
+
+		case ASTK_ParamsReturnsGrp:
+		{
+			auto * pGrp = Down(pNode, ParamsReturnsGrp);
+			dispose(&pGrp->apParamVarDecls);
+			dispose(&pGrp->apReturnVarDecls);
+		} break;
+
 		case ASTK_Program:
 		{
-			auto * pNode = Down(pNodeSubtreeRoot, Program);
-			for (int iNode = 0; iNode < pNode->apNodes.cItem; iNode++)
-			{
-				walkAst(pCtx, pNode->apNodes[iNode], visitPreorderFn, hookFn, visitPostorderFn, pContext);
-			}
+			dispose(&Down(pNode, Program)->apNodes);
 		} break;
+
+		default:
+			break;
 	}
+}
 
-	visitPostorderFn(pNodeSubtreeRoot, pContext);
+void disposeAst(AstNode * pNodeSubtreeRoot)
+{
+	walkAstStatic<&visitPreNoOp, &visitHookNoOp, &visitDisposePostorder>(pNodeSubtreeRoot, nullptr);
 }
 
 f32 floatValue(AstLiteralExpr * pLiteralExpr)
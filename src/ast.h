@@ -135,6 +135,7 @@ struct AstParamsReturnsGrp
 {
 	DynamicArray<AstNode *> apParamVarDecls;
 	DynamicArray<AstNode *> apReturnVarDecls;
+	SCOPEID scopeid;		// Scope introduced by the owning func defn/literal. Owns the params.
 };
 
 
@@ -267,15 +268,12 @@ enum SYMBEXPRK
 
 struct AstSymbolExpr
 {
-	SYMBEXPRK symbexprk;
-
 	Lexeme ident;
 
 	union
 	{
 		struct UUnresolvedData
 		{
-			bool ignoreVars;
 			DynamicArray<SymbolInfo> aCandidates;		// Candidates set by resolve pass. Parent node is responsible for choosing the correct candidate.
 		} unresolvedData;
 
@@ -292,10 +290,15 @@ struct AstSymbolExpr
 
 		struct UFuncData
 		{
-			DynamicArray<TypeId> aTypidDisambig;			// Disambiguating typeid's supplied by the programmer
+			// NOTE: Disambiguating typeid's supplied by the programmer are cold, so they live in
+			//	AstDecorations::typidDisambigDecoration instead of here.
+
 			NULLABLE AstFuncDefnStmt * pDefnCached;		// Set in resolve pass. Not a child node.
 		} funcData;
 	};
+
+	SYMBEXPRK symbexprk;
+	bool ignoreVars;		// Only valid if SYMBEXPRK_Unresolved
 };
 #if 0
 static constexpr uint s_nodeSizeDebug = sizeof(AstSymbolExpr);
@@ -315,15 +318,14 @@ struct AstArrayAccessExpr
 struct AstFuncCallExpr
 {
 	AstNode * pFunc;
-	DynamicArray<AstNode *> apArgs;		// Args are EXPR
+	SmallArray<AstNode *, 2> apArgs;		// Args are EXPR
 };
 
 struct AstFuncLiteralExpr
 {
-	AstParamsReturnsGrp * pParamsReturnsGrp;
+	AstParamsReturnsGrp * pParamsReturnsGrp;		// Also holds the scope introduced by this func literal
 	AstNode * pBodyStmt;
 
-	SCOPEID scopeid;		// Scope introduced by this func defn
 	FuncId funcid;
 
 #if 0
@@ -379,6 +381,7 @@ struct AstVarDeclStmt
 	VARSEQID varseqid;
 	TypeId typidDefn;
 	VARDECLK vardeclk;
+	u32 byteOffset;			// Offset within the owning scope (or struct). Set in resolve pass.
 };
 
 struct AstStructDefnStmt
@@ -387,6 +390,8 @@ struct AstStructDefnStmt
 	DynamicArray<AstNode *> apVarDeclStmt;
 	SCOPEID scopeid;        // Scope introduced by this struct defn
 	TypeId typidDefn;
+
+	// NOTE: Explicit layouts are rare, so they live in AstDecorations::structLayoutDecoration
 };
 #if 0
 	static constexpr uint s_nodeSizeDebug = sizeof(AstStructDefnStmt);
@@ -396,10 +401,9 @@ struct AstFuncDefnStmt
 {
 	ScopedIdentifier ident;
 
-	AstParamsReturnsGrp * pParamsReturnsGrp;
+	AstParamsReturnsGrp * pParamsReturnsGrp;		// Also holds the scope introduced by this func defn
 
-	AstNode * pBodyStmt;
-	SCOPEID scopeid;        // Scope introduced by this func defn
+	NULLABLE AstNode * pBodyStmt;					// Null for an extern func, whose body is a host func. See host_func.h
 	TypeId typidDefn;
 	FuncId funcid;
 };
@@ -511,13 +515,9 @@ struct AstNode
 	};
 };
 
-// TODO: try to make this true again:
-
-// StaticAssert(sizeof(AstNode) <= 64);		// Goal: Make it so each AstNode fits in a cache line.
+StaticAssert(sizeof(AstNode) == 64);		// Goal: Make it so each AstNode fits in a cache line.
 											//  For any additional per-node data that isn't "hot", use decorator tables. See ast_decorate.h/.cpp
-											// TODO: Make sure we have an option for our allocator to align these to cache lines!
-											//  (have dynamic allocator allocate an extra 64 bytes and point the "actual" buffer to
-											//  an aligned spot?
+											//  The parser's pool allocator aligns these to cache lines.
 
 #if 0
 static constexpr uint s_nodeSizeDebug = sizeof(AstNode);
@@ -525,6 +525,7 @@ static constexpr uint s_nodeSizeDebug = sizeof(AstNode);
 
 
 FuncId funcid(const AstNode & node);
+bool isExternFunc(const AstNode & node);
 
 
 // Walking AST
@@ -549,6 +550,115 @@ inline bool visitPreNoOp(AstNode * pNode, void * pCtx) { return true; }
 inline void visitPostNoOp(AstNode * pNode, void * pCtx) { }
 inline void visitHookNoOp(AstNode * pNode, AWHK awhk, void * pCtx) { }
 
+// NOTE (andrew) The walk is iterative, using an explicit stack of frames instead of the native stack,
+//	so deeply nested trees (e.g., long generated a + b + c + ... chains) can't overflow the native stack.
+//	Each frame remembers how far into its node's children/hooks it has gotten. See walkStep(..)
+
+// Ast Walk Step Kind
+
+enum AWSTEPK : u8
+{
+	AWSTEPK_Child,
+	AWSTEPK_Hook,
+	AWSTEPK_Done
+};
+
+struct AstWalkStep
+{
+	AWSTEPK awstepk;
+
+	union
+	{
+		AstNode * pChild;		// AWSTEPK_Child
+		AWHK awhk;				// AWSTEPK_Hook
+	};
+};
+
+struct AstWalkFrame
+{
+	AstNode * pNode;
+	int iStep;
+};
+
+AstWalkStep walkStep(AstNode * pNode, int iStep);
+
+// TVisitor must provide visitPreorder(AstNode *) -> bool, hook(AstNode *, AWHK) and visitPostorder(AstNode *).
+//	Returning false from visitPreorder skips the node's children and its postorder visit.
+
+template <typename TVisitor>
+void walkAstIterative(AstNode * pNodeSubtreeRoot, TVisitor * pVisitor)
+{
+	static const int s_cFrameInitial = 64;
+
+	Assert(pNodeSubtreeRoot);
+
+	if (!pVisitor->visitPreorder(pNodeSubtreeRoot))
+		return;
+
+	DynamicArray<AstWalkFrame> aFrame;
+	init(&aFrame);
+	Defer(dispose(&aFrame));
+	ensureCapacity(&aFrame, s_cFrameInitial);
+
+	append(&aFrame, AstWalkFrame{ pNodeSubtreeRoot, 0 });
+
+	while (aFrame.cItem > 0)
+	{
+		AstWalkFrame * pFrame = &aFrame[aFrame.cItem - 1];
+		AstWalkStep step = walkStep(pFrame->pNode, pFrame->iStep);
+		pFrame->iStep++;
+
+		switch (step.awstepk)
+		{
+			case AWSTEPK_Child:
+			{
+				Assert(step.pChild);
+
+				// NOTE (andrew) pFrame is invalid after this append
+
+				if (pVisitor->visitPreorder(step.pChild))
+				{
+					append(&aFrame, AstWalkFrame{ step.pChild, 0 });
+				}
+			} break;
+
+			case AWSTEPK_Hook:
+			{
+				pVisitor->hook(pFrame->pNode, step.awhk);
+			} break;
+
+			case AWSTEPK_Done:
+			{
+				AstNode * pNode = pFrame->pNode;
+				removeLast(&aFrame);
+				pVisitor->visitPostorder(pNode);
+			} break;
+		}
+	}
+}
+
+// Visitor functions known at compile time. Calls to them are direct (and inlinable) rather than through
+//	function pointers. Prefer this over walkAst(..) for hot passes.
+
+template <AstWalkVisitPreFn VisitPreorderFn, AstWalkHookFn HookFn, AstWalkVisitPostFn VisitPostorderFn>
+struct AstWalkVisitorStatic
+{
+	void * pContext;
+
+	bool visitPreorder(AstNode * pNode)			{ return VisitPreorderFn(pNode, pContext); }
+	void hook(AstNode * pNode, AWHK awhk)		{ HookFn(pNode, awhk, pContext); }
+	void visitPostorder(AstNode * pNode)		{ VisitPostorderFn(pNode, pContext); }
+};
+
+template <AstWalkVisitPreFn VisitPreorderFn, AstWalkHookFn HookFn, AstWalkVisitPostFn VisitPostorderFn>
+void walkAstStatic(AstNode * pNodeSubtreeRoot, void * pContext)
+{
+	AstWalkVisitorStatic<VisitPreorderFn, HookFn, VisitPostorderFn> visitor;
+	visitor.pContext = pContext;
+
+	walkAstIterative(pNodeSubtreeRoot, &visitor);
+}
+
 void walkAst(
 	MeekCtx * pCtx,
 	AstNode * pNodeSubtreeRoot,
@@ -557,6 +667,11 @@ void walkAst(
 	AstWalkVisitPostFn visitPostorderFn,
 	void * pContext);
 
+// Frees what every node in the subtree owns, e.g., its lists of child nodes. The nodes themselves belong to the
+//	allocators of the parser that made them.
+
+void disposeAst(AstNode * pNodeSubtreeRoot);
+
 // TODO: other "value" functions
 // TODO: move to literal.h / literal.cpp ?
 
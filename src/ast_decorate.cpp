@@ -4,6 +4,31 @@
 void init(AstDecorations * astDecorations)
 {
 	init(&astDecorations->startEndDecoration);
+	init(&astDecorations->typidDisambigDecoration);
+	init(&astDecorations->structLayoutDecoration);
+}
+
+void dispose(AstDecorations * astDecorations)
+{
+	auto & aDecTypidDisambig = astDecorations->typidDisambigDecoration.table;
+	for (int iDec = 0; iDec < aDecTypidDisambig.cItem; iDec++)
+	{
+		if (aDecTypidDisambig[iDec].isSet)
+		{
+			dispose(&aDecTypidDisambig[iDec].decoration);
+		}
+	}
+
+	dispose(&astDecorations->startEndDecoration);
+	dispose(&astDecorations->typidDisambigDecoration);
+	dispose(&astDecorations->structLayoutDecoration);
+}
+
+void appendDecorations(AstDecorations * astDecorations, const AstDecorations & astDecsSrc, ASTID astidOffset)
+{
+	appendDecorations(&astDecorations->startEndDecoration, astDecsSrc.startEndDecoration, astidOffset);
+	appendDecorations(&astDecorations->typidDisambigDecoration, astDecsSrc.typidDisambigDecoration, astidOffset);
+	appendDecorations(&astDecorations->structLayoutDecoration, astDecsSrc.structLayoutDecoration, astidOffset);
 }
 
 StartEndIndices getStartEnd(const AstDecorations & astDecs, ASTID astid, bool * poSuccess)
@@ -51,3 +76,17 @@ int getStartLine(const MeekCtx & ctx, ASTID astid)
 
 	return lineFromI(*ctx.scanner, startEnd.iStart);
 }
+
+DynamicArray<TypeId> getTypidDisambig(const AstDecorations & astDecs, ASTID astid)
+{
+	return getDecoration(astDecs.typidDisambigDecoration, astid);
+}
+
+STRUCTLAYOUTK getStructLayout(const AstDecorations & astDecs, ASTID astid)
+{
+	const auto & decTable = astDecs.structLayoutDecoration;
+	if (static_cast<uint>(decTable.table.cItem) <= astid || !decTable.table[astid].isSet)
+		return STRUCTLAYOUTK_Nil;
+
+	return decTable.table[astid].decoration;
+}
@@ -4,6 +4,7 @@
 #include "global_context.h"
 #include "id_def.h"
 #include "token.h"
+#include "type.h"
 
 // Lookaside table for per-ast node information that we aren't storing on the AST itself
 
@@ -25,6 +26,12 @@ inline void init(AstDecorationTable<T> * pDecTable)
 	init(&pDecTable->table);
 }
 
+template<typename T>
+inline void dispose(AstDecorationTable<T> * pDecTable)
+{
+	dispose(&pDecTable->table);
+}
+
 template<typename T>
 void decorate(AstDecorationTable<T> * pDecTable, ASTID astid, T decoration)
 {
@@ -40,6 +47,23 @@ void decorate(AstDecorationTable<T> * pDecTable, ASTID astid, T decoration)
 	pDecTable->table[astid].decoration = decoration;
 }
 
+// Appends decorations that were made for astids starting at 0 (e.g., by a parser working on part of the program),
+//	so that they apply to the astids starting at astidOffset instead
+
+template<typename T>
+void appendDecorations(AstDecorationTable<T> * pDecTable, const AstDecorationTable<T> & decTableSrc, ASTID astidOffset)
+{
+	Assert(static_cast<uint>(pDecTable->table.cItem) <= astidOffset);
+
+	while (static_cast<uint>(pDecTable->table.cItem) < astidOffset)
+	{
+		auto * pDecoration = appendNew(&pDecTable->table);
+		pDecoration->isSet = false;
+	}
+
+	appendMultiple(&pDecTable->table, decTableSrc.table.pBuffer, decTableSrc.table.cItem);
+}
+
 template<typename T>
 T getDecoration(const AstDecorationTable<T> & decTable, ASTID astid, bool * poSuccess=nullptr)
 {
@@ -63,10 +87,24 @@ T getDecoration(const AstDecorationTable<T> & decTable, ASTID astid, bool * poSu
 struct AstDecorations
 {
 	AstDecorationTable<StartEndIndices> startEndDecoration;
+
+	// Disambiguating typeid's on SYMBEXPRK_Func symbol exprs. Type resolution pokes into the
+	//	buffer, which stays put even when this table grows.
+
+	AstDecorationTable<DynamicArray<TypeId>> typidDisambigDecoration;
+
+	// Layouts that struct defns ask for explicitly. Most structs don't, and use TypeTable::structlayoutkDefault.
+
+	AstDecorationTable<STRUCTLAYOUTK> structLayoutDecoration;
 };
 
 void init(AstDecorations * astDecorations);
+void dispose(AstDecorations * astDecorations);
+void appendDecorations(AstDecorations * astDecorations, const AstDecorations & astDecsSrc, ASTID astidOffset);
 
 StartEndIndices getStartEnd(const AstDecorations & astDecs, ASTID astid, bool * poSuccess=nullptr);
 StartEndIndices getStartEnd(const AstDecorations & astDecs, ASTID astidStartStart, ASTID astidEndEnd, bool * poSuccess=nullptr);
 int getStartLine(const MeekCtx & ctx, ASTID astid);
+
+DynamicArray<TypeId> getTypidDisambig(const AstDecorations & astDecs, ASTID astid);
+STRUCTLAYOUTK getStructLayout(const AstDecorations & astDecs, ASTID astid);
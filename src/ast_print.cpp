@@ -64,9 +64,14 @@ void printTabs(DebugPrintCtx * pCtx, int level, bool printArrows, bool skipAfter
 
 void printChildren(DebugPrintCtx * pCtx, const DynamicArray<AstNode *> & apChildren, int level, const char * label, bool setSkipOnLastChild)
 {
-	for (int i = 0; i < apChildren.cItem; i++)
+	printChildren(pCtx, apChildren.pBuffer, apChildren.cItem, level, label, setSkipOnLastChild);
+}
+
+void printChildren(DebugPrintCtx * pCtx, AstNode * const * apChildren, int cChild, int level, const char * label, bool setSkipOnLastChild)
+{
+	for (int i = 0; i < cChild; i++)
 	{
-		bool isLastChild = i == apChildren.cItem - 1;
+		bool isLastChild = i == cChild - 1;
 		bool shouldSetSkip = setSkipOnLastChild && isLastChild;
 
 		println();
@@ -584,7 +589,7 @@ void debugPrintSubAst(DebugPrintCtx * pCtx, const AstNode & node, int level, boo
 
 			debugPrintSubAst(pCtx, *pExpr->pFunc, levelNext, noArgs);
 
-			printChildren(pCtx, pExpr->apArgs, levelNext, "arg", true);
+			printChildren(pCtx, itemBuffer(pExpr->apArgs), pExpr->apArgs.cItem, levelNext, "arg", true);
 		} break;
 
 		case ASTK_FuncLiteralExpr:
@@ -717,7 +722,7 @@ void debugPrintSubAst(DebugPrintCtx * pCtx, const AstNode & node, int level, boo
 		{
 			auto * pStmt = DownConst(&node, FuncDefnStmt);
 
-			print("(func defn)");
+			print((pStmt->pBodyStmt) ? "(func defn)" : "(extern func defn)");
 
 			println();
 			printTabs(pCtx, levelNext, false, false);
@@ -738,9 +743,12 @@ void debugPrintSubAst(DebugPrintCtx * pCtx, const AstNode & node, int level, boo
 				pStmt->pParamsReturnsGrp->apParamVarDecls,
 				pStmt->pParamsReturnsGrp->apParamVarDecls,
 				levelNext,
-				false);
+				!pStmt->pBodyStmt);
 
-			debugPrintSubAst(pCtx, *pStmt->pBodyStmt, levelNext, true);
+			if (pStmt->pBodyStmt)
+			{
+				debugPrintSubAst(pCtx, *pStmt->pBodyStmt, levelNext, true);
+			}
 		} break;
 
 		case ASTK_BlockStmt:
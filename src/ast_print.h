@@ -32,6 +32,7 @@ void setSkip(DebugPrintCtx * pCtx, int level, bool skip);
 void printTabs(DebugPrintCtx * pCtx, int level, bool printArrows, bool skipAfterArrow);
 
 void printChildren(DebugPrintCtx * pCtx, const DynamicArray<AstNode *> & apChildren, int level, const char * label, bool setSkipOnLastChild);
+void printChildren(DebugPrintCtx * pCtx, AstNode * const * apChildren, int cChild, int level, const char * label, bool setSkipOnLastChild);
 
 void printErrChildren(DebugPrintCtx * pCtx, const AstErr & node, int level);
 
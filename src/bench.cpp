@@ -0,0 +1,1612 @@
+#include "bench.h"
+
+#include "bytecode.h"
+#include "bytecode_verify.h"
+#include "embed.h"
+#include "global_context.h"
+#include "interp.h"
+#include "parallel.h"
+#include "parse.h"
+#include "print.h"
+#include "program_gen.h"
+#include "report.h"
+#include "resolve.h"
+#include "scan.h"
+#include "symbol.h"
+#include "type.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+
+// Phases in the order they run. Parse includes scanning, since the parser scans as it goes, so scan is also timed on
+//	its own to tell the two apart.
+
+static const PHASEK c_aPhasekBench[] =
+{
+	PHASEK_Scan,
+	PHASEK_Parse,
+	PHASEK_ResolveTypes,
+	PHASEK_ComputeOffsets,
+	PHASEK_Resolve,
+	PHASEK_Emit,
+	PHASEK_Verify,
+};
+
+// Each size is this much bigger than the last, so there are a couple of points per decade
+
+static const double s_sizeStep = 3.1623;
+
+// Stop growing once a compile takes longer than this, since the next one would take at least s_sizeStep times as long
+
+static const s64 s_nsCompileBudget = 30LL * 1000 * 1000 * 1000;
+
+// Growth exponent above which a phase gets flagged, i.e., a phase whose time went up by more than size ^ this. Phases
+//	that took less than s_nsGrowthMin are too noisy to say either way.
+
+static const double s_growthFlagged = 1.25;
+static const s64 s_nsGrowthMin = 1000 * 1000;
+
+struct BenchRun
+{
+	int cLine;
+	int cByte;
+	int cFunc;
+	bool succeeded;
+	CompileReport report;
+};
+
+// Caller inits pBuilder with pCtx after init(pCtx, ..) and disposes it
+
+static bool tryCompileForBench(char * pText, int cByte, MeekCtx * pCtx, BytecodeBuilder * pBuilder, NULLABLE CompileReport * pReport)
+{
+	// Scanning on its own is only interesting if someone is looking at the timings
+
+	if (pReport)
+	{
+		Scanner scanner;
+		init(&scanner, pText, cByte);
+		Defer(dispose(&scanner));
+
+		beginPhase(pReport, PHASEK_Scan);
+		while (consumeToken(&scanner) != TOKENK_Eof)
+			;
+		endPhase(pReport, PHASEK_Scan);
+	}
+
+	MeekCtx & ctx = *pCtx;
+	ctx.pReport = pReport;
+
+	// Sequential, like main with s_pipelined off, so each phase's time is its own
+
+	ctx.parser->scansAhead = false;
+
+	bool success;
+
+	beginPhase(pReport, PHASEK_Parse);
+	ctx.rootNode = parseProgram(ctx.parser, &success);
+	endPhase(pReport, PHASEK_Parse);
+
+	if (!success)
+	{
+		reportScanAndParseErrors(*ctx.parser);
+		return false;
+	}
+
+	beginPhase(pReport, PHASEK_ResolveTypes);
+	success = tryResolveAllTypes(ctx.typeTable);
+	endPhase(pReport, PHASEK_ResolveTypes);
+
+	if (!success)
+	{
+		print("Unable to resolve some types\n");
+		return false;
+	}
+
+	beginPhase(pReport, PHASEK_ComputeOffsets);
+	computeScopedVariableOffsets(&ctx, ctx.parser->pScopeGlobal);
+	endPhase(pReport, PHASEK_ComputeOffsets);
+
+	ResolvePass resolvePass;
+	init(&resolvePass, &ctx);
+	Defer(dispose(&resolvePass));
+
+	beginPhase(pReport, PHASEK_Resolve);
+	doResolvePass(&resolvePass, ctx.rootNode);
+	endPhase(pReport, PHASEK_Resolve);
+
+	if (resolvePass.hadError)
+		return false;
+
+	beginPhase(pReport, PHASEK_Emit);
+	compileBytecode(pBuilder);
+	endPhase(pReport, PHASEK_Emit);
+
+	beginPhase(pReport, PHASEK_Verify);
+	success = tryVerifyBytecode(&pBuilder->bytecodeProgram, *ctx.typeTable);
+	endPhase(pReport, PHASEK_Verify);
+
+	return success;
+}
+
+static double growthExponent(s64 ns0, s64 ns1, int cLine0, int cLine1)
+{
+	return log(double(ns1) / double(ns0)) / log(double(cLine1) / double(cLine0));
+}
+
+static void printBenchRun(const BenchRun & run, NULLABLE const BenchRun * pRunPrev)
+{
+	printfmt(
+		"%d lines, %.2f MB, %d funcs\n",
+		run.cLine,
+		double(run.cByte) / (1024.0 * 1024.0),
+		run.cFunc);
+
+	printfmt("  %-16s %10s %12s %10s %8s\n", "Phase", "Wall ms", "Klines/s", "MB/s", "Growth");
+
+	for (int iPhasek = 0; iPhasek < ArrayLen(c_aPhasekBench); iPhasek++)
+	{
+		PHASEK phasek = c_aPhasekBench[iPhasek];
+		const CompileReport::Phase & phase = run.report.mpPhasekPhase[phasek];
+		if (!phase.isRecorded)
+			continue;
+
+		double sWall = Max(double(phase.nsWall) / 1e9, 1e-9);
+
+		char aChGrowth[32] = "-";
+		bool isFlagged = false;
+		if (pRunPrev)
+		{
+			s64 nsPrev = pRunPrev->report.mpPhasekPhase[phasek].nsWall;
+			if (nsPrev >= s_nsGrowthMin && phase.nsWall >= s_nsGrowthMin)
+			{
+				double growth = growthExponent(nsPrev, phase.nsWall, pRunPrev->cLine, run.cLine);
+				snprintf(aChGrowth, sizeof(aChGrowth), "%.2f", growth);
+				isFlagged = growth > s_growthFlagged;
+			}
+		}
+
+		printfmt(
+			"  %-16s %10.2f %12.1f %10.2f %8s%s\n",
+			strFromPhasek(phasek),
+			double(phase.nsWall) / 1e6,
+			double(run.cLine) / sWall / 1000.0,
+			double(run.cByte) / sWall / (1024.0 * 1024.0),
+			aChGrowth,
+			(isFlagged) ? "  <- superlinear" : "");
+	}
+
+	println();
+}
+
+// Growth from the first run where the phase took long enough to measure, to the last run. Returns false if any phase
+//	got flagged.
+
+static bool printBenchScaling(const DynamicArray<BenchRun *> & apRun)
+{
+	print("Scaling (time ~ lines ^ growth)\n");
+
+	bool isAnyFlagged = false;
+
+	for (int iPhasek = 0; iPhasek < ArrayLen(c_aPhasekBench); iPhasek++)
+	{
+		PHASEK phasek = c_aPhasekBench[iPhasek];
+
+		const BenchRun * pRunFirst = nullptr;
+		const BenchRun * pRunLast = apRun[apRun.cItem - 1];
+		for (int iRun = 0; iRun < apRun.cItem; iRun++)
+		{
+			if (apRun[iRun]->report.mpPhasekPhase[phasek].nsWall >= s_nsGrowthMin)
+			{
+				pRunFirst = apRun[iRun];
+				break;
+			}
+		}
+
+		if (!pRunFirst || pRunFirst == pRunLast)
+		{
+			printfmt("  %-16s %8s\n", strFromPhasek(phasek), "-");
+			continue;
+		}
+
+		double growth = growthExponent(
+							pRunFirst->report.mpPhasekPhase[phasek].nsWall,
+							pRunLast->report.mpPhasekPhase[phasek].nsWall,
+							pRunFirst->cLine,
+							pRunLast->cLine);
+
+		bool isFlagged = growth > s_growthFlagged;
+		isAnyFlagged = isAnyFlagged || isFlagged;
+
+		printfmt(
+			"  %-16s %8.2f  (%d to %d lines)%s\n",
+			strFromPhasek(phasek),
+			growth,
+			pRunFirst->cLine,
+			pRunLast->cLine,
+			(isFlagged) ? "  <- superlinear" : "");
+	}
+
+	return !isAnyFlagged;
+}
+
+bool runCompileBenchmark(const ProgramGenParams & paramsShape, int cLineMin, int cLineMax)
+{
+	Assert(cLineMin > 0 && cLineMin <= cLineMax);
+
+	// Funcs are the only thing that scales with size, so see how many lines one of them comes to
+
+	static const int s_cFuncCalibrate = 64;
+
+	ProgramGenParams params = paramsShape;
+	double cLinePerFunc;
+	{
+		String strCalibrate;
+		init(&strCalibrate);
+		Defer(dispose(&strCalibrate));
+
+		params.cFunc = 0;
+		int cLineFixed = generateProgram(params, &strCalibrate);
+
+		strCalibrate.cChar = 0;
+		params.cFunc = s_cFuncCalibrate;
+		int cLine = generateProgram(params, &strCalibrate);
+
+		cLinePerFunc = Max(double(cLine - cLineFixed) / s_cFuncCalibrate, 1.0);
+	}
+
+	DynamicArray<BenchRun *> apRun;
+	init(&apRun);
+	Defer(
+		for (int iRun = 0; iRun < apRun.cItem; iRun++)
+		{
+			delete apRun[iRun];
+		}
+		dispose(&apRun);
+	);
+
+	String strProgram;
+	init(&strProgram);
+	Defer(dispose(&strProgram));
+
+	bool success = true;
+
+	for (double cLineTarget = cLineMin; cLineTarget <= cLineMax * 1.001; cLineTarget *= s_sizeStep)
+	{
+		int cFunc = static_cast<int>(cLineTarget / cLinePerFunc + 0.5);
+		params.cFunc = Max(cFunc, 1);
+
+		strProgram.cChar = 0;
+
+		BenchRun * pRun = new BenchRun;
+		ClearStruct(pRun);
+		pRun->cFunc = params.cFunc;
+		pRun->cLine = generateProgram(params, &strProgram);
+		pRun->cByte = strProgram.cChar;
+
+		MeekCtx ctx;
+		init(&ctx, strProgram.pBuffer, strProgram.cChar);
+		Defer(dispose(&ctx));
+
+		BytecodeBuilder bytecodeBuilder;
+		init(&bytecodeBuilder, &ctx);
+		Defer(dispose(&bytecodeBuilder));
+
+		init(&pRun->report);
+		pRun->succeeded = tryCompileForBench(strProgram.pBuffer, strProgram.cChar, &ctx, &bytecodeBuilder, &pRun->report);
+
+		if (!pRun->succeeded)
+		{
+			printfmt("Compiling the %d line program failed, stopping\n", pRun->cLine);
+			delete pRun;
+			success = false;
+			break;
+		}
+
+		printBenchRun(*pRun, (apRun.cItem > 0) ? apRun[apRun.cItem - 1] : nullptr);
+		append(&apRun, pRun);
+
+		s64 nsCompile = nsWallNow() - pRun->report.nsWallStart;
+		if (nsCompile > s_nsCompileBudget)
+		{
+			printfmt("That took %.1f s, stopping\n", double(nsCompile) / 1e9);
+			break;
+		}
+	}
+
+	if (apRun.cItem > 0)
+	{
+		success = printBenchScaling(apRun) && success;
+	}
+
+	return success;
+}
+
+// VM benchmark
+
+static const char * c_aPChzVmBenchProgram[] =
+{
+	"int_loop",
+	"float_kernel",
+	"nested_cond",
+	"short_circuit",
+	"globals",
+};
+
+// TODO (andrew) Add call-heavy recursion and struct field access once the bytecode builder supports calls and structs
+
+struct VmBenchResult
+{
+	bool succeeded;
+	s64 cOp;
+	s64 cDispatch;
+	s64 nsMedian;
+	s64 nsP95;
+};
+
+void init(VmBenchParams * pParams)
+{
+	pParams->pChzDir = "examples/bench/";
+	pParams->pChzBaselineFilename = "vm_bench_baseline.json";
+	pParams->cRun = 21;
+	pParams->regressionThreshold = 0.05;
+	pParams->writesBaseline = false;
+}
+
+static bool tryReadFile(const char * pChzFilename, String * poStr)
+{
+	FILE * file = fopen(pChzFilename, "rb");
+	if (!file)
+		return false;
+
+	Defer(fclose(file));
+
+	fseek(file, 0, SEEK_END);
+	long cByte = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (cByte < 0)
+		return false;
+
+	ensureCapacity(poStr, static_cast<int>(cByte));
+	poStr->cChar = static_cast<int>(fread(poStr->pBuffer, 1, cByte, file));
+	poStr->pBuffer[poStr->cChar] = '\0';
+
+	return poStr->cChar == cByte;
+}
+
+static int compareNs(const s64 & ns0, const s64 & ns1)
+{
+	return (ns0 < ns1) ? -1 : (ns0 > ns1) ? 1 : 0;
+}
+
+// Reads <pChzDir><pChzName>.meek, compiles it and loads it into poLoaded, which the caller disposes. pStrProgram and
+//	pCtx have to outlive poLoaded, since func names point into them. *poCOp is the program's "// ops: <n>" header.
+//	The caller disposes pCtx too, but only if this succeeds.
+
+static bool tryLoadVmBenchProgram(
+	const char * pChzDir,
+	const char * pChzName,
+	String * pStrProgram,
+	MeekCtx * pCtx,
+	LoadedProgram * poLoaded,
+	s64 * poCOp)
+{
+	char aChFilename[256];
+	snprintf(aChFilename, sizeof(aChFilename), "%s%s.meek", pChzDir, pChzName);
+
+	if (!tryReadFile(aChFilename, pStrProgram))
+	{
+		printfmt("Couldn't read %s\n", aChFilename);
+		return false;
+	}
+
+	static const char s_pChzOpsHeader[] = "// ops:";
+	const char * pChOps = strstr(pStrProgram->pBuffer, s_pChzOpsHeader);
+	*poCOp = (pChOps) ? atoll(pChOps + sizeof(s_pChzOpsHeader) - 1) : 0;
+
+	init(pCtx, pStrProgram->pBuffer, pStrProgram->cChar);
+
+	BytecodeBuilder bytecodeBuilder;
+	init(&bytecodeBuilder, pCtx);
+	Defer(dispose(&bytecodeBuilder));
+
+	if (!tryCompileForBench(pStrProgram->pBuffer, pStrProgram->cChar, pCtx, &bytecodeBuilder, nullptr))
+	{
+		printfmt("Couldn't compile %s\n", aChFilename);
+		dispose(pCtx);
+		return false;
+	}
+
+	if (pCtx->mainFuncid == FuncId::Nil)
+	{
+		printfmt("No main function in %s\n", aChFilename);
+		dispose(pCtx);
+		return false;
+	}
+
+	init(poLoaded, bytecodeBuilder.bytecodeProgram, pCtx);
+	return true;
+}
+
+static bool tryRunVmBenchProgram(const VmBenchParams & params, const char * pChzName, VmBenchResult * poResult)
+{
+	ClearStruct(poResult);
+
+	String strProgram;
+	init(&strProgram);
+	Defer(dispose(&strProgram));
+
+	MeekCtx ctx;
+	LoadedProgram loaded;
+	if (!tryLoadVmBenchProgram(params.pChzDir, pChzName, &strProgram, &ctx, &loaded, &poResult->cOp))
+		return false;
+
+	Defer(dispose(&ctx));
+	Defer(dispose(&loaded));
+
+	// NOTE (andrew) One interpreter for every run, reset in between, the same way a host running lots of requests
+	//	would use it. Nothing is carried over from one run to the next.
+
+	Interpreter interp;
+	init(&interp, loaded);
+	Defer(dispose(&interp));
+
+	// The first run is a warm up and isn't timed. Output is captured so it doesn't bury the results, and every run's
+	//	has to match the first's, since a program that does something different each time isn't measuring anything.
+
+	String strOutputFirst;
+	init(&strOutputFirst);
+	Defer(dispose(&strOutputFirst));
+
+	String strOutput;
+	init(&strOutput);
+	Defer(dispose(&strOutput));
+
+	DynamicArray<s64> aNs;
+	init(&aNs);
+	Defer(dispose(&aNs));
+
+	for (int iRun = 0; iRun <= params.cRun; iRun++)
+	{
+		reset(&interp);
+
+		String * pStrOutput = (iRun == 0) ? &strOutputFirst : &strOutput;
+		pStrOutput->cChar = 0;
+
+		beginPrintCapture(pStrOutput);
+		s64 nsStart = nsWallNow();
+		bool ran = interpret(&interp, loaded.funcidMain);
+		s64 ns = nsWallNow() - nsStart;
+		endPrintCapture();
+
+		if (!ran)
+		{
+			printfmt("%.*s", pStrOutput->cChar, pStrOutput->pBuffer);
+			return false;
+		}
+
+		if (iRun == 0)
+		{
+			poResult->cDispatch = interp.cDispatch;
+			continue;
+		}
+
+		if (strOutput.cChar != strOutputFirst.cChar || memcmp(strOutput.pBuffer, strOutputFirst.pBuffer, strOutput.cChar) != 0)
+		{
+			printfmt("%s printed something different on run %d than on the first run\n", pChzName, iRun);
+			return false;
+		}
+
+		append(&aNs, ns);
+	}
+
+	introSort(aNs.pBuffer, aNs.cItem, &compareNs);
+
+	int iNsP95 = static_cast<int>(ceil(aNs.cItem * 0.95)) - 1;
+	iNsP95 = Min(iNsP95, aNs.cItem - 1);
+
+	poResult->succeeded = true;
+	poResult->nsMedian = aNs[aNs.cItem / 2];
+	poResult->nsP95 = aNs[iNsP95];
+	return true;
+}
+
+// NOTE (andrew) Not a real JSON reader, it only reads back what tryWriteVmBaselineJson(..) writes
+
+static bool tryFindVmBaseline(const String & strBaseline, const char * pChzName, s64 * poNsMedian, s64 * poCDispatch)
+{
+	char aChKey[128];
+	snprintf(aChKey, sizeof(aChKey), "\"name\": \"%s\"", pChzName);
+
+	const char * pCh = strstr(strBaseline.pBuffer, aChKey);
+	if (!pCh)
+		return false;
+
+	long long nsMedian;
+	long long cDispatch;
+	int cMatch = sscanf(pCh + strlen(aChKey), ", \"nsMedian\": %lld, \"nsP95\": %*lld, \"cDispatch\": %lld", &nsMedian, &cDispatch);
+	if (cMatch != 2)
+		return false;
+
+	*poNsMedian = nsMedian;
+	*poCDispatch = cDispatch;
+	return true;
+}
+
+static bool tryWriteVmBaselineJson(const VmBenchParams & params, const VmBenchResult * aResult)
+{
+	FILE * file = fopen(params.pChzBaselineFilename, "wb");
+	if (!file)
+		return false;
+
+	Defer(fclose(file));
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"cRun\": %d,\n", params.cRun);
+	fprintf(file, "\t\"programs\": [\n");
+
+	bool isFirst = true;
+	for (int iProgram = 0; iProgram < ArrayLen(c_aPChzVmBenchProgram); iProgram++)
+	{
+		const VmBenchResult & result = aResult[iProgram];
+		if (!result.succeeded)
+			continue;
+
+		fprintf(
+			file,
+			"%s\t\t{ \"name\": \"%s\", \"nsMedian\": %lld, \"nsP95\": %lld, \"cDispatch\": %lld, \"cOp\": %lld }",
+			(isFirst) ? "" : ",\n",
+			c_aPChzVmBenchProgram[iProgram],
+			(long long)result.nsMedian,
+			(long long)result.nsP95,
+			(long long)result.cDispatch,
+			(long long)result.cOp);
+		isFirst = false;
+	}
+
+	fprintf(file, "\n\t]\n");
+	fprintf(file, "}\n");
+
+	return true;
+}
+
+bool runVmBenchmark(const VmBenchParams & params)
+{
+	Assert(params.cRun > 0);
+
+	String strBaseline;
+	init(&strBaseline);
+	Defer(dispose(&strBaseline));
+
+	bool hasBaseline = tryReadFile(params.pChzBaselineFilename, &strBaseline);
+
+	printfmt("%d runs each, ", params.cRun);
+	if (hasBaseline)
+	{
+		printfmt("comparing against %s, flagging anything %.1f%% slower\n", params.pChzBaselineFilename, params.regressionThreshold * 100.0);
+	}
+	else
+	{
+		printfmt("no baseline at %s\n", params.pChzBaselineFilename);
+	}
+
+	printfmt(
+		"%-16s %10s %10s %10s %14s %10s %8s\n",
+		"Program",
+		"Median ms",
+		"P95 ms",
+		"Mops/s",
+		"Mdispatch/s",
+		"Base ms",
+		"Change");
+
+	VmBenchResult aResult[ArrayLen(c_aPChzVmBenchProgram)];
+	bool succeeded = true;
+
+	for (int iProgram = 0; iProgram < ArrayLen(c_aPChzVmBenchProgram); iProgram++)
+	{
+		const char * pChzName = c_aPChzVmBenchProgram[iProgram];
+		VmBenchResult * pResult = &aResult[iProgram];
+
+		if (!tryRunVmBenchProgram(params, pChzName, pResult))
+		{
+			succeeded = false;
+			continue;
+		}
+
+		double sMedian = Max(double(pResult->nsMedian) / 1e9, 1e-9);
+
+		printfmt(
+			"%-16s %10.2f %10.2f %10.1f %14.1f",
+			pChzName,
+			double(pResult->nsMedian) / 1e6,
+			double(pResult->nsP95) / 1e6,
+			double(pResult->cOp) / sMedian / 1e6,
+			double(pResult->cDispatch) / sMedian / 1e6);
+
+		s64 nsMedianBaseline;
+		s64 cDispatchBaseline;
+		if (hasBaseline && tryFindVmBaseline(strBaseline, pChzName, &nsMedianBaseline, &cDispatchBaseline) && nsMedianBaseline > 0)
+		{
+			double change = double(pResult->nsMedian) / double(nsMedianBaseline) - 1.0;
+			bool isRegressed = change > params.regressionThreshold;
+			if (isRegressed)
+			{
+				succeeded = false;
+			}
+
+			printfmt(" %10.2f %+7.1f%%", double(nsMedianBaseline) / 1e6, change * 100.0);
+
+			if (isRegressed)
+			{
+				print("  <- regressed");
+			}
+
+			// Different bytecode makes the times hard to compare, so call it out
+
+			if (cDispatchBaseline != pResult->cDispatch)
+			{
+				printfmt("  (dispatches %lld -> %lld)", (long long)cDispatchBaseline, (long long)pResult->cDispatch);
+			}
+		}
+
+		println();
+	}
+
+	if (params.writesBaseline)
+	{
+		if (tryWriteVmBaselineJson(params, aResult))
+		{
+			printfmt("Wrote %s\n", params.pChzBaselineFilename);
+		}
+		else
+		{
+			printfmt("Couldn't write %s\n", params.pChzBaselineFilename);
+		}
+	}
+
+	return succeeded;
+}
+
+// VM throughput benchmark
+
+struct VmThroughputJob
+{
+	const LoadedProgram * pLoaded;
+	const String * pStrOutputExpected;
+
+	int cExecution;
+	std::atomic<int> iExecutionNext;
+	std::atomic<bool> failed;
+};
+
+static void runVmThroughputWorker(VmThroughputJob * pJob)
+{
+	// NOTE (andrew) Setting up the interpreter is part of what's being timed, since a host would need one per thread
+	//	too, but it's once per thread and each execution after that only pays for reset(..)
+
+	Interpreter interp;
+	init(&interp, *pJob->pLoaded);
+	Defer(dispose(&interp));
+
+	String strOutput;
+	init(&strOutput);
+	Defer(dispose(&strOutput));
+
+	const String & strOutputExpected = *pJob->pStrOutputExpected;
+
+	for (;;)
+	{
+		int iExecution = pJob->iExecutionNext.fetch_add(1, std::memory_order_relaxed);
+		if (iExecution >= pJob->cExecution)
+			break;
+
+		reset(&interp);
+		strOutput.cChar = 0;
+
+		beginPrintCapture(&strOutput);
+		bool ran = interpret(&interp, pJob->pLoaded->funcidMain);
+		endPrintCapture();
+
+		if (!ran ||
+			strOutput.cChar != strOutputExpected.cChar ||
+			memcmp(strOutput.pBuffer, strOutputExpected.pBuffer, strOutput.cChar) != 0)
+		{
+			pJob->failed.store(true, std::memory_order_relaxed);
+		}
+	}
+}
+
+// Runs cExecution executions of pLoaded's main spread over cThread threads, and returns how long it took, or -1 if any
+//	of them failed or printed something other than strOutputExpected
+
+static s64 nsRunVmThroughput(const LoadedProgram & loaded, const String & strOutputExpected, int cThread, int cExecution)
+{
+	VmThroughputJob job;
+	job.pLoaded = &loaded;
+	job.pStrOutputExpected = &strOutputExpected;
+	job.cExecution = cExecution;
+	job.iExecutionNext.store(0);
+	job.failed.store(false);
+
+	DynamicArray<std::thread *> apThread;
+	init(&apThread);
+	Defer(dispose(&apThread));
+
+	s64 nsStart = nsWallNow();
+
+	for (int iThread = 1; iThread < cThread; iThread++)
+	{
+		append(&apThread, new std::thread(&runVmThroughputWorker, &job));
+	}
+
+	runVmThroughputWorker(&job);
+
+	for (int iThread = 0; iThread < apThread.cItem; iThread++)
+	{
+		apThread[iThread]->join();
+		delete apThread[iThread];
+	}
+
+	s64 ns = nsWallNow() - nsStart;
+
+	return (job.failed.load()) ? -1 : ns;
+}
+
+bool runVmThroughputBenchmark(const char * pChzDir, int cExecutionPerThread)
+{
+	Assert(cExecutionPerThread > 0);
+
+	// 1, 2, 4, ... threads, and always finishing with one per core
+
+	DynamicArray<int> aCThread;
+	init(&aCThread);
+	Defer(dispose(&aCThread));
+
+	for (int cThread = 1; cThread < cWorkerMax(); cThread *= 2)
+	{
+		append(&aCThread, cThread);
+	}
+
+	append(&aCThread, cWorkerMax());
+
+	printfmt("%d executions per thread, up to %d threads\n", cExecutionPerThread, cWorkerMax());
+	printfmt("%-16s %8s %12s %12s %10s %10s\n", "Program", "Threads", "Runs/s", "Mops/s", "Speedup", "Per core");
+
+	bool succeeded = true;
+
+	for (int iProgram = 0; iProgram < ArrayLen(c_aPChzVmBenchProgram); iProgram++)
+	{
+		const char * pChzName = c_aPChzVmBenchProgram[iProgram];
+
+		String strProgram;
+		init(&strProgram);
+		Defer(dispose(&strProgram));
+
+		MeekCtx ctx;
+		LoadedProgram loaded;
+		s64 cOp;
+		if (!tryLoadVmBenchProgram(pChzDir, pChzName, &strProgram, &ctx, &loaded, &cOp))
+		{
+			succeeded = false;
+			continue;
+		}
+
+		Defer(dispose(&ctx));
+		Defer(dispose(&loaded));
+
+		// One run on its own first, to warm up and to get the output every other run has to match
+
+		String strOutputExpected;
+		init(&strOutputExpected);
+		Defer(dispose(&strOutputExpected));
+
+		{
+			Interpreter interp;
+			init(&interp, loaded);
+			Defer(dispose(&interp));
+
+			beginPrintCapture(&strOutputExpected);
+			bool ran = interpret(&interp, loaded.funcidMain);
+			endPrintCapture();
+
+			if (!ran)
+			{
+				printfmt("%.*s", strOutputExpected.cChar, strOutputExpected.pBuffer);
+				succeeded = false;
+				continue;
+			}
+		}
+
+		double runsPerSecOneThread = 0.0;
+
+		for (int iCThread = 0; iCThread < aCThread.cItem; iCThread++)
+		{
+			int cThread = aCThread[iCThread];
+			int cExecution = cExecutionPerThread * cThread;
+
+			s64 ns = nsRunVmThroughput(loaded, strOutputExpected, cThread, cExecution);
+			if (ns < 0)
+			{
+				printfmt("%-16s %8d  a run failed or printed something different than the first run\n", pChzName, cThread);
+				succeeded = false;
+				break;
+			}
+
+			double s = Max(double(ns) / 1e9, 1e-9);
+			double runsPerSec = double(cExecution) / s;
+			if (cThread == 1)
+			{
+				runsPerSecOneThread = runsPerSec;
+			}
+
+			double speedup = runsPerSec / runsPerSecOneThread;
+
+			printfmt(
+				"%-16s %8d %12.1f %12.1f %9.2fx %9.0f%%\n",
+				pChzName,
+				cThread,
+				runsPerSec,
+				runsPerSec * double(cOp) / 1e6,
+				speedup,
+				speedup / cThread * 100.0);
+		}
+	}
+
+	return succeeded;
+}
+
+// Embedding benchmark
+
+static const char s_pChzEmbedBenchSource[] =
+	"fn reserved() {}\n"
+	"\n"
+	"int g_count;\n"
+	"int g_base = 40;\n"
+	"int g_init = hostAdd(g_base, 2) * 2 - g_base;\n"
+	"\n"
+	"fn nothing() {}\n"
+	"\n"
+	"fn add(int a, int b) -> int\n"
+	"{\n"
+	"	return a + b;\n"
+	"}\n"
+	"\n"
+	"fn count() -> int\n"
+	"{\n"
+	"	g_count += 1;\n"
+	"	return g_count;\n"
+	"}\n"
+	"\n"
+	"extern fn hostAdd(int a, int b) -> int;\n"
+	"\n"
+	"fn init() -> int\n"
+	"{\n"
+	"	return g_init;\n"
+	"}\n"
+	"\n"
+	"fn loopHostAdd(int n) -> int\n"
+	"{\n"
+	"	int sum = 0;\n"
+	"	int i = 0;\n"
+	"	while i < n\n"
+	"	{\n"
+	"		sum = hostAdd(sum, 1);\n"
+	"		i += 1;\n"
+	"	}\n"
+	"	return sum;\n"
+	"}\n"
+	"\n"
+	"fn loopAdd(int n) -> int\n"
+	"{\n"
+	"	int sum = 0;\n"
+	"	int i = 0;\n"
+	"	while i < n\n"
+	"	{\n"
+	"		sum = sum + 1;\n"
+	"		i += 1;\n"
+	"	}\n"
+	"	return sum;\n"
+	"}\n";
+
+static const char s_pChzEmbedBenchSourceBad[] =
+	"fn reserved() {}\n"
+	"\n"
+	"fn bad() -> int\n"
+	"{\n"
+	"	return zz;\n"
+	"}\n";
+
+static void hostAdd(uint8_t * pArgs, void * pContext)
+{
+	s32 aArg[2];
+	memcpy(aArg, pArgs, sizeof(aArg));
+
+	s32 sum = aArg[0] + aArg[1];
+	memcpy(pArgs, &sum, sizeof(sum));
+}
+
+static void printEmbedBench(const char * pChzName, s64 ns, int cCall)
+{
+	printfmt("  %-28s %9.1f\n", pChzName, double(ns) / cCall);
+}
+
+bool runEmbedBenchmark(int cCall)
+{
+	Assert(cCall > 0);
+
+	const MEEKTYPE c_aMeektypeAdd[] = { MEEKTYPE_S32, MEEKTYPE_S32 };
+
+	MeekHostFuncs * pHostFuncs = meekCreateHostFuncs();
+	Defer(meekDestroyHostFuncs(pHostFuncs));
+
+	if (!meekRegisterHostFunc(pHostFuncs, "hostAdd", c_aMeektypeAdd, ArrayLen(c_aMeektypeAdd), MEEKTYPE_S32, &hostAdd, nullptr))
+		return false;
+
+	char * pChzErrors;
+
+	s64 nsStart = nsWallNow();
+	MeekProgram * pProgram = meekCompileProgram(
+								s_pChzEmbedBenchSource,
+								static_cast<int>(strlen(s_pChzEmbedBenchSource)),
+								pHostFuncs,
+								&pChzErrors);
+	s64 nsCompile = nsWallNow() - nsStart;
+
+	if (!pProgram)
+	{
+		printfmt("Couldn't compile the embedding benchmark:\n%s", pChzErrors);
+		meekFreeErrors(pChzErrors);
+		return false;
+	}
+
+	Defer(meekDestroyProgram(pProgram));
+
+	// A program that doesn't compile says why through the API, not on stdout
+
+	MeekProgram * pProgramBad = meekCompileProgram(
+									s_pChzEmbedBenchSourceBad,
+									static_cast<int>(strlen(s_pChzEmbedBenchSourceBad)),
+									pHostFuncs,
+									&pChzErrors);
+
+	bool reportsErrors = !pProgramBad && pChzErrors && strstr(pChzErrors, "Unresolved variable zz");
+	meekDestroyProgram(pProgramBad);
+	meekFreeErrors(pChzErrors);
+
+	if (!reportsErrors)
+	{
+		print("Compiling a bad program didn't report why\n");
+		return false;
+	}
+
+	const MEEKTYPE c_aMeektypeLoop[] = { MEEKTYPE_S32 };
+
+	const MeekFunc * pFuncNothing = meekLookupFunc(pProgram, "nothing", nullptr, 0, MEEKTYPE_Void);
+	const MeekFunc * pFuncAdd = meekLookupFunc(pProgram, "add", c_aMeektypeAdd, ArrayLen(c_aMeektypeAdd), MEEKTYPE_S32);
+	const MeekFunc * pFuncCount = meekLookupFunc(pProgram, "count", nullptr, 0, MEEKTYPE_S32);
+	const MeekFunc * pFuncInit = meekLookupFunc(pProgram, "init", nullptr, 0, MEEKTYPE_S32);
+	const MeekFunc * pFuncLoopHostAdd = meekLookupFunc(pProgram, "loopHostAdd", c_aMeektypeLoop, ArrayLen(c_aMeektypeLoop), MEEKTYPE_S32);
+	const MeekFunc * pFuncLoopAdd = meekLookupFunc(pProgram, "loopAdd", c_aMeektypeLoop, ArrayLen(c_aMeektypeLoop), MEEKTYPE_S32);
+
+	if (!pFuncNothing || !pFuncAdd || !pFuncCount || !pFuncInit || !pFuncLoopHostAdd || !pFuncLoopAdd)
+	{
+		print("Couldn't find the embedding benchmark's funcs\n");
+		return false;
+	}
+
+	nsStart = nsWallNow();
+	MeekVm * pVm = meekCreateVm(pProgram);
+	s64 nsCreateVm = nsWallNow() - nsStart;
+
+	Defer(meekDestroyVm(pVm));
+
+	printfmt("Embedding API, %d calls each\n", cCall);
+	printfmt("  %-28s %9s\n", "Benchmark", "ns/op");
+	printEmbedBench("compile", nsCompile, 1);
+	printEmbedBench("create vm", nsCreateVm, 1);
+
+	bool succeeded = true;
+
+	// g_init doesn't fold, since it calls out to the host, so it only has a value if it ran when the program was loaded
+
+	MeekValue valInit;
+	succeeded &= meekCall(pVm, pFuncInit, nullptr, 0, &valInit) && valInit.as.s32 == 44;
+
+	nsStart = nsWallNow();
+	for (int iCall = 0; iCall < cCall; iCall++)
+	{
+		succeeded &= meekCall(pVm, pFuncNothing, nullptr, 0, nullptr);
+	}
+	printEmbedBench("call nothing()", nsWallNow() - nsStart, cCall);
+
+	MeekValue aArg[2];
+	aArg[0].meektype = MEEKTYPE_S32;
+	aArg[1].meektype = MEEKTYPE_S32;
+	aArg[1].as.s32 = 1;
+
+	nsStart = nsWallNow();
+	for (int iCall = 0; iCall < cCall; iCall++)
+	{
+		aArg[0].as.s32 = iCall;
+
+		MeekValue valReturn;
+		succeeded &= meekCall(pVm, pFuncAdd, aArg, ArrayLen(aArg), &valReturn) && valReturn.as.s32 == iCall + 1;
+	}
+	printEmbedBench("call add(i, 1)", nsWallNow() - nsStart, cCall);
+
+	// count() bumps a global, so it has to have counted every call until the vm is reset, and start over after
+
+	MeekValue valCount;
+	valCount.as.s32 = 0;
+
+	nsStart = nsWallNow();
+	for (int iCall = 0; iCall < cCall; iCall++)
+	{
+		succeeded &= meekCall(pVm, pFuncCount, nullptr, 0, &valCount);
+	}
+	printEmbedBench("call count()", nsWallNow() - nsStart, cCall);
+
+	succeeded &= valCount.as.s32 == cCall;
+
+	nsStart = nsWallNow();
+	for (int iCall = 0; iCall < cCall; iCall++)
+	{
+		meekResetVm(pVm);
+	}
+	printEmbedBench("reset", nsWallNow() - nsStart, cCall);
+
+	succeeded &= meekCall(pVm, pFuncCount, nullptr, 0, &valCount) && valCount.as.s32 == 1;
+	succeeded &= meekCall(pVm, pFuncInit, nullptr, 0, &valInit) && valInit.as.s32 == 44;
+
+	// Calls out to the host. Both loops run inside one meekCall, so the difference between them is what a CallHost costs
+	//	over an add. A plain C call through a function pointer is there to compare against.
+
+	MeekValue argLoop;
+	argLoop.meektype = MEEKTYPE_S32;
+	argLoop.as.s32 = cCall;
+
+	MeekValue valLoop;
+
+	nsStart = nsWallNow();
+	succeeded &= meekCall(pVm, pFuncLoopAdd, &argLoop, 1, &valLoop) && valLoop.as.s32 == cCall;
+	printEmbedBench("meek loop, sum + 1", nsWallNow() - nsStart, cCall);
+
+	nsStart = nsWallNow();
+	succeeded &= meekCall(pVm, pFuncLoopHostAdd, &argLoop, 1, &valLoop) && valLoop.as.s32 == cCall;
+	printEmbedBench("meek loop, hostAdd(sum, 1)", nsWallNow() - nsStart, cCall);
+
+	PFNMEEKHOSTFUNC volatile pfnHostAdd = &hostAdd;
+	s32 aArgHost[2] = { 0, 1 };
+
+	nsStart = nsWallNow();
+	for (int iCall = 0; iCall < cCall; iCall++)
+	{
+		aArgHost[1] = 1;
+		pfnHostAdd(reinterpret_cast<uint8_t *>(aArgHost), nullptr);
+	}
+	printEmbedBench("c loop, hostAdd through ptr", nsWallNow() - nsStart, cCall);
+
+	succeeded &= aArgHost[0] == cCall;
+
+	if (!succeeded)
+	{
+		print("  Some calls failed or returned the wrong thing\n");
+	}
+
+	println();
+	return succeeded;
+}
+
+// als microbenchmarks
+
+static volatile s64 s_alsBenchSink;		// So the optimizer can't throw away work whose result is otherwise unused
+
+// Each benchmark repeats until it has done at least this many ops, so small sizes still take long enough to time
+
+static const s64 s_cOpAlsBenchMin = 4 * 1024 * 1024;
+
+struct AlsBench
+{
+	const char * pChzName;
+	s64 nsStart;
+	AllocCounts allocsStart;
+};
+
+struct AlsBenchNode
+{
+	s64 a;
+	s64 b;
+};
+
+static void beginAlsBench(AlsBench * pBench, const char * pChzName)
+{
+	pBench->pChzName = pChzName;
+	readAllocCounts(&pBench->allocsStart);
+	pBench->nsStart = nsWallNow();
+}
+
+static void endAlsBench(AlsBench * pBench, s64 cOp)
+{
+	s64 ns = nsWallNow() - pBench->nsStart;
+
+	AllocCounts allocs;
+	readAllocCounts(&allocs);
+
+	s64 cAlloc = 0;
+	s64 cByteAlloc = 0;
+	for (int allock = 0; allock < ALLOCK_Max; allock++)
+	{
+		cAlloc += allocs.mpAllockCAlloc[allock] - pBench->allocsStart.mpAllockCAlloc[allock];
+		cByteAlloc += allocs.mpAllockCByte[allock] - pBench->allocsStart.mpAllockCByte[allock];
+	}
+
+	s64 nsNonZero = Max(ns, 1LL);
+
+	printfmt(
+		"  %-28s %9.2f %10.1f %9lld %10.1f\n",
+		pBench->pChzName,
+		double(ns) / double(cOp),
+		double(cOp) * 1e3 / double(nsNonZero),
+		(long long)cAlloc,
+		double(cByteAlloc) / 1024.0);
+}
+
+// Distinct for every distinct i, but scattered, so consecutive keys don't land in consecutive buckets
+
+static int keyAlsBench(int i)
+{
+	return static_cast<int>(static_cast<u32>(i) * 2654435761u);
+}
+
+static u32 intHash(const int & i)
+{
+	return startHash(&i, sizeof(i));
+}
+
+static bool intEq(const int & i0, const int & i1)
+{
+	return i0 == i1;
+}
+
+static void runAlsHashBenchmarks(int cItem, int cRepeat)
+{
+	s64 cOp = s64(cItem) * cRepeat;
+	s64 sink = 0;
+	AlsBench bench;
+
+	beginAlsBench(&bench, "hash.insert");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		HashMap<int, int> hashmap;
+		init(&hashmap, &intHash, &intEq);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			insert(&hashmap, keyAlsBench(i), i);
+		}
+
+		dispose(&hashmap);
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "hash.insert (presized)");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		HashMap<int, int> hashmap;
+		init(&hashmap, &intHash, &intEq, 2 * cItem);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			insert(&hashmap, keyAlsBench(i), i);
+		}
+
+		dispose(&hashmap);
+	}
+	endAlsBench(&bench, cOp);
+
+	HashMap<int, int> hashmap;
+	init(&hashmap, &intHash, &intEq);
+	Defer(dispose(&hashmap));
+
+	for (int i = 0; i < cItem; i++)
+	{
+		insert(&hashmap, keyAlsBench(i), i);
+	}
+
+	beginAlsBench(&bench, "hash.lookup (hit)");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			sink += *lookup(hashmap, keyAlsBench(i));
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "hash.lookup (miss)");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			sink += (lookup(hashmap, keyAlsBench(cItem + i)) != nullptr);
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "hash.iterate");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (HashMapIter<int, int> it = iter(hashmap); it.pKey; iterNext(&it))
+		{
+			sink += *it.pValue;
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	BiHashMap<int, int> bimap;
+	init(&bimap, &intHash, &intEq, &intHash, &intEq);
+	Defer(dispose(&bimap));
+
+	beginAlsBench(&bench, "bihash.insert");
+	for (int i = 0; i < cItem; i++)
+	{
+		insert(&bimap, keyAlsBench(i), i);
+	}
+	endAlsBench(&bench, cItem);
+
+	beginAlsBench(&bench, "bihash.lookupByKey");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			sink += *lookupByKey(bimap, keyAlsBench(i));
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "bihash.lookupByValue");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			sink += *lookupByValue(bimap, i);
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	s_alsBenchSink += sink;
+}
+
+static void runAlsArrayBenchmarks(int cItem, int cRepeat)
+{
+	s64 cOp = s64(cItem) * cRepeat;
+	s64 sink = 0;
+	AlsBench bench;
+
+	beginAlsBench(&bench, "array.append");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		DynamicArray<int> array;
+		init(&array);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			append(&array, i);
+		}
+
+		sink += array.cItem;
+		dispose(&array);
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "array.append (presized)");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		DynamicArray<int> array;
+		init(&array);
+		ensureCapacity(&array, cItem);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			append(&array, i);
+		}
+
+		sink += array.cItem;
+		dispose(&array);
+	}
+	endAlsBench(&bench, cOp);
+
+	DynamicArray<int> array;
+	init(&array);
+	Defer(dispose(&array));
+
+	for (int i = 0; i < cItem; i++)
+	{
+		append(&array, i);
+	}
+
+	beginAlsBench(&bench, "array.iterate");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < array.cItem; i++)
+		{
+			sink += array[i];
+		}
+	}
+	endAlsBench(&bench, cOp);
+
+	// Push and pop each count as an op
+
+	Stack<int> stack;
+	init(&stack);
+	Defer(dispose(&stack));
+
+	beginAlsBench(&bench, "stack.push/pop");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			push(&stack, i);
+		}
+
+		for (int i = 0; i < cItem; i++)
+		{
+			sink += pop(&stack);
+		}
+	}
+	endAlsBench(&bench, 2 * cOp);
+
+	// Like the scanner's peek buffer, never more than a few items in it at once
+
+	RingBuffer<int, 16> rbuf;
+
+	beginAlsBench(&bench, "ringbuffer.write/read");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		for (int i = 0; i < cItem; i++)
+		{
+			int value;
+			write(&rbuf, i);
+			write(&rbuf, i + 1);
+			read(&rbuf, &value);
+			sink += value;
+			read(&rbuf, &value);
+			sink += value;
+		}
+	}
+	endAlsBench(&bench, 4 * cOp);
+
+	s_alsBenchSink += sink;
+}
+
+static void runAlsAllocBenchmarks(int cItem, int cRepeat)
+{
+	s64 cOp = s64(cItem) * cRepeat;
+	s64 sink = 0;
+	AlsBench bench;
+
+	DynamicArray<AlsBenchNode *> apNode;
+	init(&apNode);
+	Defer(dispose(&apNode));
+
+	// Allocate a whole pool, then release it in scattered order, so the free list ends up shuffled like it would be
+	//	after a while of real use. Allocate and release each count as an op.
+
+	{
+		static const unsigned int s_capacityFixed = 4096;
+
+		FixedPoolAllocator<AlsBenchNode, s_capacityFixed> * pFixed = new FixedPoolAllocator<AlsBenchNode, s_capacityFixed>;
+		Defer(delete pFixed);
+		init(pFixed);
+
+		ensureCapacity(&apNode, s_capacityFixed);
+		apNode.cItem = s_capacityFixed;
+
+		s64 cRound = Max(cOp / s_capacityFixed, 1LL);
+
+		beginAlsBench(&bench, "fixedPool.alloc/release");
+		for (s64 iRound = 0; iRound < cRound; iRound++)
+		{
+			for (unsigned int i = 0; i < s_capacityFixed; i++)
+			{
+				AlsBenchNode * pNode = allocate(pFixed);
+				pNode->a = i;
+				apNode[i] = pNode;
+			}
+
+			for (unsigned int i = 0; i < s_capacityFixed; i++)
+			{
+				unsigned int iNode = keyAlsBench(i) & (s_capacityFixed - 1);
+				sink += apNode[iNode]->a;
+				release(pFixed, apNode[iNode]);
+			}
+		}
+		endAlsBench(&bench, 2 * cRound * s_capacityFixed);
+	}
+
+	beginAlsBench(&bench, "dynamicPool.alloc");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		DynamicPoolAllocator<AlsBenchNode> pool;
+		init(&pool);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			AlsBenchNode * pNode = allocate(&pool);
+			pNode->a = i;
+			sink += pNode->a;
+		}
+
+		destroy(&pool);
+	}
+	endAlsBench(&bench, cOp);
+
+	// Keep cItem nodes alive, replacing a scattered one with a new one each op. Releases and allocates go to
+	//	different buckets, so this exercises the bucket free list rather than just one bucket's.
+
+	{
+		DynamicPoolAllocator<AlsBenchNode> pool;
+		init(&pool);
+		Defer(destroy(&pool));
+
+		ensureCapacity(&apNode, cItem);
+		apNode.cItem = cItem;
+
+		for (int i = 0; i < cItem; i++)
+		{
+			apNode[i] = allocate(&pool);
+		}
+
+		beginAlsBench(&bench, "dynamicPool.churn");
+		for (s64 iOp = 0; iOp < cOp; iOp++)
+		{
+			int iNode = static_cast<int>(static_cast<u32>(keyAlsBench(static_cast<int>(iOp))) % static_cast<u32>(cItem));
+			release(&pool, apNode[iNode]);
+
+			AlsBenchNode * pNode = allocate(&pool);
+			pNode->a = iOp;
+			sink += pNode->a;
+			apNode[iNode] = pNode;
+		}
+		endAlsBench(&bench, cOp);
+	}
+
+	s_alsBenchSink += sink;
+}
+
+static void runAlsStringBenchmarks(int cItem, int cRepeat)
+{
+	s64 cOp = s64(cItem) * cRepeat;
+	s64 sink = 0;
+	AlsBench bench;
+
+	// Short pieces, like the ones the compile report and the program generator build their output from
+
+	static const char * s_aPChzPiece[] = { "fn ", "v12", " = ", "(", "g3 + 7", ");\n", "\t", "while " };
+
+	beginAlsBench(&bench, "string.append");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		String str;
+		init(&str);
+
+		for (int i = 0; i < cItem; i++)
+		{
+			append(&str, s_aPChzPiece[i & (ArrayLen(s_aPChzPiece) - 1)]);
+		}
+
+		sink += str.cChar;
+		dispose(&str);
+	}
+	endAlsBench(&bench, cOp);
+
+	s_alsBenchSink += sink;
+}
+
+static int compareAlsBenchNode(const AlsBenchNode & node0, const AlsBenchNode & node1)
+{
+	return (node0.a < node1.a) ? -1 : (node0.a > node1.a) ? 1 : 0;
+}
+
+static u32 keyAlsBenchNode(const AlsBenchNode & node)
+{
+	return static_cast<u32>(node.a);
+}
+
+// The sorts lookupAllVars(..) picks between for varseqids, plus the bubble sort it used to use. Every repeat sorts a
+//	fresh copy of the same scrambled keys, and the copy is part of the time.
+
+static void runAlsSortBenchmarks(int cItem, int cRepeat)
+{
+	s64 cOp = s64(cItem) * cRepeat;
+	s64 sink = 0;
+	AlsBench bench;
+
+	DynamicArray<AlsBenchNode> aNodeScrambled;
+	init(&aNodeScrambled);
+	Defer(dispose(&aNodeScrambled));
+	ensureCapacity(&aNodeScrambled, cItem);
+
+	for (int i = 0; i < cItem; i++)
+	{
+		AlsBenchNode * pNode = appendNew(&aNodeScrambled);
+		pNode->a = static_cast<u32>(keyAlsBench(i));
+		pNode->b = i;
+	}
+
+	DynamicArray<AlsBenchNode> aNode;
+	init(&aNode);
+	Defer(dispose(&aNode));
+	ensureCapacity(&aNode, cItem);
+	aNode.cItem = cItem;
+
+	DynamicArray<AlsBenchNode> aNodeScratch;
+	init(&aNodeScratch);
+	Defer(dispose(&aNodeScratch));
+	ensureCapacity(&aNodeScratch, cItem);
+
+	// NOTE (andrew) Bubble sort is quadratic, so it gets as many repeats as it takes to do about as many compares as the
+	//	others do ops, and doesn't run at all past a size where one sort takes seconds
+
+	static const int s_cItemBubbleSortMax = 16 * 1024;
+
+	if (cItem <= s_cItemBubbleSortMax)
+	{
+		s64 cRepeatBubble = Max(s_cOpAlsBenchMin / (s64(cItem) * cItem / 2 + 1), 1LL);
+
+		beginAlsBench(&bench, "sort.bubble");
+		for (s64 iRepeat = 0; iRepeat < cRepeatBubble; iRepeat++)
+		{
+			memcpy(aNode.pBuffer, aNodeScrambled.pBuffer, cItem * sizeof(AlsBenchNode));
+			bubbleSort(aNode.pBuffer, cItem, &compareAlsBenchNode);
+			sink += aNode[0].b;
+		}
+		endAlsBench(&bench, s64(cItem) * cRepeatBubble);
+	}
+
+	beginAlsBench(&bench, "sort.intro");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		memcpy(aNode.pBuffer, aNodeScrambled.pBuffer, cItem * sizeof(AlsBenchNode));
+		introSort(aNode.pBuffer, cItem, &compareAlsBenchNode);
+		sink += aNode[0].b;
+	}
+	endAlsBench(&bench, cOp);
+
+	beginAlsBench(&bench, "sort.radix");
+	for (int iRepeat = 0; iRepeat < cRepeat; iRepeat++)
+	{
+		memcpy(aNode.pBuffer, aNodeScrambled.pBuffer, cItem * sizeof(AlsBenchNode));
+		radixSort(aNode.pBuffer, aNodeScratch.pBuffer, cItem, &keyAlsBenchNode);
+		sink += aNode[0].b;
+	}
+	endAlsBench(&bench, cOp);
+
+	s_alsBenchSink += sink;
+}
+
+void runAlsBenchmark(int cItem)
+{
+	Assert(cItem > 0);
+
+	startCountingAllocs();
+
+	s64 cRepeat = Max(s_cOpAlsBenchMin / cItem, 1LL);
+
+	printfmt("als microbenchmarks, %d items, %lld repeats\n", cItem, (long long)cRepeat);
+	printfmt("  %-28s %9s %10s %9s %10s\n", "Benchmark", "ns/op", "Mops/s", "Allocs", "Alloc KB");
+
+	runAlsHashBenchmarks(cItem, static_cast<int>(cRepeat));
+	runAlsArrayBenchmarks(cItem, static_cast<int>(cRepeat));
+	runAlsAllocBenchmarks(cItem, static_cast<int>(cRepeat));
+	runAlsStringBenchmarks(cItem, static_cast<int>(cRepeat));
+	runAlsSortBenchmarks(cItem, static_cast<int>(cRepeat));
+
+	println();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "als.h"
+
+struct ProgramGenParams;
+
+// Compile throughput benchmark. Generates programs shaped like paramsShape at sizes from cLineMin up to cLineMax
+//	lines (paramsShape.cFunc is ignored, it's picked to hit each size), compiles each one a phase at a time, and prints
+//	lines/sec and MB/sec for every phase. Also prints how fast each phase's time grew relative to the program, and
+//	flags phases that grew faster than linearly, since that's where the quadratic stuff hides. Every generated func
+//	names its params and locals the same way, so a name can have as many definitions as there are funcs, which is what
+//	catches symbol lookups that look at all of them. Returns false if any compile failed or any phase got flagged.
+
+bool runCompileBenchmark(const ProgramGenParams & paramsShape, int cLineMin, int cLineMax);
+
+// VM benchmark. Compiles each of the programs in examples/bench, runs it cRun times and prints the median and p95 run
+//	time, ops/sec (ops being whatever the program's "// ops: <n>" header says one run does, usually loop iterations) and
+//	bytecode dispatches/sec. Compares the medians against the baseline JSON if there is one.
+
+struct VmBenchParams
+{
+	const char * pChzDir;					// Where the programs are, ending with a slash
+	const char * pChzBaselineFilename;
+	int cRun;
+	double regressionThreshold;				// E.g., 0.05 flags anything more than 5% slower than the baseline
+	bool writesBaseline;					// Replace the baseline with this run's results
+};
+
+void init(VmBenchParams * pParams);
+
+// Returns false if any program failed to compile or run, or got slower than the baseline by more than the threshold
+
+bool runVmBenchmark(const VmBenchParams & params);
+
+// VM throughput benchmark. Loads each of the programs in examples/bench once and runs it over and over from 1, 2, 4, ...
+//	threads up to one per core, each thread with its own interpreter and cExecutionPerThread runs to do. Prints runs/sec
+//	and how it scales with the thread count. Returns false if any run failed or printed something different.
+
+bool runVmThroughputBenchmark(const char * pChzDir, int cExecutionPerThread);
+
+// Embedding benchmark. Compiles a tiny program through embed.h, calls a few funcs in it cCall times each, and prints how
+//	long each call and each reset took. Then times a loop in the program that calls a host func cCall times. Returns
+//	false if any call failed or returned the wrong thing.
+
+bool runEmbedBenchmark(int cCall);
+
+// als microbenchmarks. Times the containers and allocators that every phase sits on, with cItem items in each (run it
+//	with something that fits in cache and something that doesn't), and prints ns/op and how many allocations each made.
+//	Also times the sorts against each other, which is what laying out lots of globals comes down to.
+
+void runAlsBenchmark(int cItem);
@@ -4,8 +4,13 @@
 #include "ast_decorate.h"
 #include "error.h"
 #include "global_context.h"
+#include "host_func.h"
 #include "interp.h"
+#include "parallel.h"
+#include "parse.h"
 #include "print.h"
+#include "report.h"
+#include "resolve.h"
 
 #include <inttypes.h>
 
@@ -167,6 +172,7 @@ static const char * c_mpBcopStrName[] = {
 	"StackAlloc",
 	"StackFree",
 	"Call",
+	"CallHost",
 	"Return0",
 	"Return8",
 	"Return16",
@@ -177,6 +183,12 @@ static const char * c_mpBcopStrName[] = {
 };
 StaticAssert(ArrayLen(c_mpBcopStrName) == BCOP_Max);
 
+const char * strFromBcop(BCOP bcop)
+{
+	Assert(bcop >= 0 && bcop < BCOP_Max);
+	return c_mpBcopStrName[bcop];
+}
+
 BCOP bcopSized(SIZEDBCOP sizedBcop, int cBit)
 {
 	Assert(cBit == 8 || cBit == 16 || cBit == 32 || cBit == 64);
@@ -453,6 +465,40 @@ void init(BytecodeProgram * pBcp)
 	init(&pBcp->bytes);
 	init(&pBcp->bytecodeFuncs);
 	init(&pBcp->sourceLineNumbers);
+	pBcp->funcidGlobalInit = FuncId::Nil;
+}
+
+void dispose(BytecodeProgram * pBcp)
+{
+	dispose(&pBcp->bytes);
+	dispose(&pBcp->bytecodeFuncs);
+	dispose(&pBcp->sourceLineNumbers);
+}
+
+const BytecodeFunction * pBcfFromIByte(const BytecodeProgram & bcp, int iByte)
+{
+	// Funcs are in order of appearance, so binary search on where they start
+
+	int iBcfMin = 0;
+	int iBcfMax = bcp.bytecodeFuncs.cItem;
+	while (iBcfMin < iBcfMax)
+	{
+		int iBcfMid = iBcfMin + (iBcfMax - iBcfMin) / 2;
+		if (bcp.bytecodeFuncs[iBcfMid].iByte0 <= iByte)
+		{
+			iBcfMin = iBcfMid + 1;
+		}
+		else
+		{
+			iBcfMax = iBcfMid;
+		}
+	}
+
+	if (iBcfMin == 0)
+		return nullptr;
+
+	const BytecodeFunction & bcf = bcp.bytecodeFuncs[iBcfMin - 1];
+	return (iByte < bcf.iByte0 + bcf.cByte) ? &bcf : nullptr;
 }
 
 //void init(BytecodeFunction * pBcf, AstNode * pFuncNode)
@@ -469,6 +515,12 @@ void init(BytecodeBuilder * pBuilder, MeekCtx * pCtx)
 	init(&pBuilder->nodeCtxStack);
 }
 
+void dispose(BytecodeBuilder * pBuilder)
+{
+	dispose(&pBuilder->bytecodeProgram);
+	dispose(&pBuilder->nodeCtxStack);
+}
+
 void init(BytecodeBuilder::NodeCtx * pNodeCtx, AstNode * pNode)
 {
 	ClearStruct(pNodeCtx);
@@ -477,46 +529,282 @@ void init(BytecodeBuilder::NodeCtx * pNodeCtx, AstNode * pNode)
 	pNodeCtx->wantsChildExprAddr = false;
 }
 
+struct CompileBytecodeJob
+{
+	MeekCtx * pCtx;
+	BytecodeBuilder * aBuilderFunc;		// Indexed by FuncId
+	int * aIFuncStart;					// Indexed by top level statement, first func it contains. One extra at the end
+	s64 * mpIWorkerNsEmit;				// Time spent emitting, when it's interleaved with resolving
+};
+
+static void compileBytecodeJob(void * pJob_, int iFunc, int iWorker)
+{
+	auto * pJob = reinterpret_cast<CompileBytecodeJob *>(pJob_);
+
+	BytecodeBuilder * pBuilderFunc = &pJob->aBuilderFunc[iFunc];
+	init(pBuilderFunc, pJob->pCtx);
+	compileBytecodeFunc(pBuilderFunc, pJob->pCtx->functions[iFunc]);
+}
+
+// Emits the global initializers that don't fold into a func of their own, at the end of the program. They run in
+//	declaration order, once the image already holds every global that does fold.
+
+static void compileGlobalInit(BytecodeBuilder * pBuilder)
+{
+	MeekCtx * pCtx = pBuilder->pCtx;
+	BytecodeProgram * pBcp = &pBuilder->bytecodeProgram;
+	Scope * pScopeGlobal = pCtx->parser->pScopeGlobal;
+
+	Assert(pBcp->funcidGlobalInit == FuncId::Nil);
+
+	DynamicArray<SymbolInfo> aSymbInfo;
+	init(&aSymbInfo);
+	Defer(dispose(&aSymbInfo));
+
+	lookupAllVars(*pScopeGlobal, &aSymbInfo, FSYMBQ_IgnoreParent | FSYMBQ_SortVarseqid);
+
+	BytecodeBuilder builderInit;
+	init(&builderInit, pCtx);
+	Defer(dispose(&builderInit));
+
+	int lineLast = -1;
+	for (int iSymbInfo = 0; iSymbInfo < aSymbInfo.cItem; iSymbInfo++)
+	{
+		AstVarDeclStmt * pStmt = aSymbInfo[iSymbInfo].varData.pVarDeclStmt;
+		if (!pStmt->pInitExpr)
+			continue;
+
+		u64 bScratch;
+		if (tryFoldGlobalInit(pStmt->pInitExpr, pStmt->typidDefn, reinterpret_cast<u8 *>(&bScratch)))
+			continue;
+
+		walkAstStatic<&visitBytecodeBuilderPreorder, &visitBytecodeBuilderHook, &visitBytecodeBuilderPostOrder>(Up(pStmt), &builderInit);
+		lineLast = getStartLine(*pCtx, Up(pStmt)->astid);
+	}
+
+	if (builderInit.bytecodeProgram.bytes.cItem == 0)
+		return;
+
+	emitOp(&builderInit.bytecodeProgram, BCOP_DebugExit, lineLast);
+
+	BytecodeFunction * pBcf = appendNew(&builderInit.bytecodeProgram.bytecodeFuncs);
+	pBcf->pFuncNode = pCtx->rootNode;
+	pBcf->iByte0 = 0;
+	pBcf->cByte = builderInit.bytecodeProgram.bytes.cItem;
+	pBcf->cByteStackMax = -1;
+
+	pBcp->funcidGlobalInit = FuncId(pBcp->bytecodeFuncs.cItem);
+	linkBytecode(pBcp, &builderInit, 1);
+}
+
 void compileBytecode(BytecodeBuilder * pBuilder)
 {
 	MeekCtx * pCtx = pBuilder->pCtx;
 
-	for (int i = 0; i < pCtx->functions.cItem; i++)
+	// NOTE (andrew) Each func is emitted into its own buffer by its own builder, so funcs can be compiled in parallel.
+	//	Emission only reads the AST, scopes, and type table, which are all done being built by now. Jumps are
+	//	relative and calls go through FuncId, so the buffers are position independent and linking is just concatenation.
+
+	int cFunc = pCtx->functions.cItem;
+
+	DynamicArray<BytecodeBuilder> aBuilderFunc;
+	init(&aBuilderFunc);
+	Defer(dispose(&aBuilderFunc));
+	ensureCapacity(&aBuilderFunc, cFunc);
+	aBuilderFunc.cItem = cFunc;
+
+	CompileBytecodeJob job;
+	job.pCtx = pCtx;
+	job.aBuilderFunc = aBuilderFunc.pBuffer;
+	job.aIFuncStart = nullptr;
+	job.mpIWorkerNsEmit = nullptr;
+
+	static const int s_cFuncPerWorkerMin = 16;
+
+	beginPhase(pCtx->pReport, PHASEK_EmitFuncs);
+	parallelFor(cFunc, &compileBytecodeJob, &job, s_cFuncPerWorkerMin);
+	endPhase(pCtx->pReport, PHASEK_EmitFuncs);
+
+	beginPhase(pCtx->pReport, PHASEK_EmitLink);
+	linkBytecode(&pBuilder->bytecodeProgram, aBuilderFunc.pBuffer, cFunc);
+	compileGlobalInit(pBuilder);
+	endPhase(pCtx->pReport, PHASEK_EmitLink);
+
+	for (int iFunc = 0; iFunc < cFunc; iFunc++)
+	{
+		dispose(&aBuilderFunc[iFunc]);
+	}
+}
+
+static void compileStmtFuncsJob(void * pJob_, int iNode, int iWorker)
+{
+	auto * pJob = reinterpret_cast<CompileBytecodeJob *>(pJob_);
+
+	s64 nsStart = nsWallNow();
+
+	for (int iFunc = pJob->aIFuncStart[iNode]; iFunc < pJob->aIFuncStart[iNode + 1]; iFunc++)
 	{
-		AstNode * pNode = pCtx->functions[i];
-		AstParamsReturnsGrp * pParamsReturns = nullptr;
-		// AstNode * pBodyStmt = nullptr;
+		compileBytecodeFunc(&pJob->aBuilderFunc[iFunc], pJob->pCtx->functions[iFunc]);
+	}
+
+	pJob->mpIWorkerNsEmit[iWorker] += nsWallNow() - nsStart;
+}
+
+void resolveAndCompileBytecode(BytecodeBuilder * pBuilder, ResolvePass * pPass)
+{
+	MeekCtx * pCtx = pBuilder->pCtx;
+	Assert(pPass->pCtx == pCtx);
+
+	// NOTE (andrew) Same as doResolvePass(..) then compileBytecode(..), but a top level statement's funcs are emitted
+	//	as soon as the statement is resolved, by the worker that resolved it, instead of waiting for every other statement.
+	//	Emission only looks at the func's own nodes and scopes plus things that were final before resolve started (types,
+	//	global offsets, func ids), so nothing it reads is still being written. Statements that fail to resolve aren't
+	//	emitted at all, and nothing is linked if any did, so check pPass->hadError before using pBuilder.
+
+	auto * pProgram = Down(pCtx->rootNode, Program);
+	int cNode = pProgram->apNodes.cItem;
+	int cFunc = pCtx->functions.cItem;
+
+	// Funcs are added to the ctx as they finish parsing, so each top level statement's funcs are a contiguous run.
+	//	Find the runs by source position.
+
+	DynamicArray<int> aIFuncStart;
+	init(&aIFuncStart);
+	Defer(dispose(&aIFuncStart));
+	ensureCapacity(&aIFuncStart, cNode + 1);
 
-		if (pNode->astk == ASTK_FuncDefnStmt)
+	int iFuncNext = 0;
+	for (int iNode = 0; iNode < cNode; iNode++)
+	{
+		append(&aIFuncStart, iFuncNext);
+
+		int iTextEnd = getStartEnd(*pCtx->astDecorations, pProgram->apNodes[iNode]->astid).iEnd;
+		while (iFuncNext < cFunc && getStartEnd(*pCtx->astDecorations, pCtx->functions[iFuncNext]->astid).iEnd <= iTextEnd)
 		{
-			// auto * pStmt = Down(pNode, FuncDefnStmt);
-			// pParamsReturns = pStmt->pParamsReturnsGrp;
-			// pBodyStmt = pStmt->pBodyStmt;
+			iFuncNext++;
 		}
-		else
-		{
-			Assert(pNode->astk == ASTK_FuncLiteralExpr);
+	}
 
-			// auto * pExpr = Down(pNode, FuncLiteralExpr);
-			// pParamsReturns = pExpr->pParamsReturnsGrp;
-			// pBodyStmt = pExpr->pBodyStmt;
-		}
+	append(&aIFuncStart, iFuncNext);
+	AssertInfo(iFuncNext == cFunc, "Func outside of any top level statement?");
+
+	DynamicArray<BytecodeBuilder> aBuilderFunc;
+	init(&aBuilderFunc);
+	Defer(dispose(&aBuilderFunc));
+	ensureCapacity(&aBuilderFunc, cFunc);
+	aBuilderFunc.cItem = cFunc;
+
+	// Funcs in statements that fail to resolve are never emitted, so their builders are set up here rather than by
+	//	whoever emits them
+
+	for (int iFunc = 0; iFunc < cFunc; iFunc++)
+	{
+		init(&aBuilderFunc[iFunc], pCtx);
+	}
+
+	CompileBytecodeJob job;
+	job.pCtx = pCtx;
+	job.aBuilderFunc = aBuilderFunc.pBuffer;
+	job.aIFuncStart = aIFuncStart.pBuffer;
+
+	DynamicArray<s64> mpIWorkerNsEmit;
+	init(&mpIWorkerNsEmit);
+	Defer(dispose(&mpIWorkerNsEmit));
+	ensureCapacity(&mpIWorkerNsEmit, cWorkerMax());
+	mpIWorkerNsEmit.cItem = cWorkerMax();
+
+	for (int iWorker = 0; iWorker < mpIWorkerNsEmit.cItem; iWorker++)
+	{
+		mpIWorkerNsEmit[iWorker] = 0;
+	}
+
+	job.mpIWorkerNsEmit = mpIWorkerNsEmit.pBuffer;
+
+	doResolvePass(pPass, pCtx->rootNode, &compileStmtFuncsJob, &job);
+
+	for (int iWorker = 0; iWorker < mpIWorkerNsEmit.cItem; iWorker++)
+	{
+		addPhaseTime(pCtx->pReport, PHASEK_EmitFuncs, mpIWorkerNsEmit[iWorker]);
+	}
+
+	// Some funcs were never emitted, and a global's initializer might be one of the things that failed
+
+	if (!pPass->hadError)
+	{
+		beginPhase(pCtx->pReport, PHASEK_EmitLink);
+		linkBytecode(&pBuilder->bytecodeProgram, aBuilderFunc.pBuffer, cFunc);
+		compileGlobalInit(pBuilder);
+		endPhase(pCtx->pReport, PHASEK_EmitLink);
+	}
+
+	for (int iFunc = 0; iFunc < cFunc; iFunc++)
+	{
+		dispose(&aBuilderFunc[iFunc]);
+	}
+}
+
+void compileBytecodeFunc(BytecodeBuilder * pBuilder, AstNode * pNode)
+{
+	Assert(pBuilder->bytecodeProgram.bytes.cItem == 0);
+	Assert(pNode->astk == ASTK_FuncDefnStmt || pNode->astk == ASTK_FuncLiteralExpr);
+
+	pBuilder->funcRoot = true;
+	walkAstStatic<&visitBytecodeBuilderPreorder, &visitBytecodeBuilderHook, &visitBytecodeBuilderPostOrder>(pNode, pBuilder);
+
+	BytecodeFunction * pBcf = appendNew(&pBuilder->bytecodeProgram.bytecodeFuncs);
+	pBcf->pFuncNode = pNode;
+	pBcf->iByte0 = 0;
+	pBcf->cByte = pBuilder->bytecodeProgram.bytes.cItem;
+	pBcf->cByteStackMax = -1;
+}
+
+StringView strvFuncName(const BytecodeFunction & bcf)
+{
+	if (bcf.pFuncNode->astk == ASTK_FuncDefnStmt)
+		return Down(bcf.pFuncNode, FuncDefnStmt)->ident.lexeme.strv;
+
+	StringView strv;
+	if (bcf.pFuncNode->astk == ASTK_Program)
+	{
+		strv.pCh = "<global init>";
+		strv.cCh = 13;
+	}
+	else
+	{
+		strv.pCh = "<literal>";
+		strv.cCh = 9;
+	}
+
+	return strv;
+}
+
+void linkBytecode(BytecodeProgram * pBcp, const BytecodeBuilder aBuilderFunc[], int cBuilderFunc)
+{
+	// Size everything up front so that the concatenation never reallocates
+
+	int cByte = pBcp->bytes.cItem;
+	int cLine = pBcp->sourceLineNumbers.cItem;
+	for (int iFunc = 0; iFunc < cBuilderFunc; iFunc++)
+	{
+		cByte += aBuilderFunc[iFunc].bytecodeProgram.bytes.cItem;
+		cLine += aBuilderFunc[iFunc].bytecodeProgram.sourceLineNumbers.cItem;
+	}
+
+	ensureCapacity(&pBcp->bytes, cByte);
+	ensureCapacity(&pBcp->sourceLineNumbers, cLine);
+	ensureCapacity(&pBcp->bytecodeFuncs, pBcp->bytecodeFuncs.cItem + cBuilderFunc);
+
+	for (int iFunc = 0; iFunc < cBuilderFunc; iFunc++)
+	{
+		const BytecodeProgram & bcpFunc = aBuilderFunc[iFunc].bytecodeProgram;
+		Assert(bcpFunc.bytecodeFuncs.cItem == 1);
+
+		BytecodeFunction * pBcf = appendNew(&pBcp->bytecodeFuncs);
+		*pBcf = bcpFunc.bytecodeFuncs[0];
+		pBcf->iByte0 = pBcp->bytes.cItem;
 
-		int iByte0 = pBuilder->bytecodeProgram.bytes.cItem;
-
-		pBuilder->funcRoot = true;
-		walkAst(
-			pCtx,
-			pNode,
-			&visitBytecodeBuilderPreorder,
-			&visitBytecodeBuilderHook,
-			&visitBytecodeBuilderPostOrder,
-			pBuilder);
-
-		BytecodeFunction * pBcf = appendNew(&pBuilder->bytecodeProgram.bytecodeFuncs);
-		pBcf->pFuncNode = pNode;
-		pBcf->iByte0 = iByte0;
-		pBcf->cByte = pBuilder->bytecodeProgram.bytes.cItem - iByte0;
+		appendMultiple(&pBcp->bytes, bcpFunc.bytes.pBuffer, bcpFunc.bytes.cItem);
+		appendMultiple(&pBcp->sourceLineNumbers, bcpFunc.sourceLineNumbers.pBuffer, bcpFunc.sourceLineNumbers.cItem);
 	}
 }
 
@@ -697,13 +985,9 @@ bool visitBytecodeBuilderPreorder(AstNode * pNode, void * pBuilder_)
 			auto * pStmt = Down(pNode, VarDeclStmt);
 
 			Scope * pScope = pCtx->scopes[pStmt->ident.scopeid];
-			SymbolInfo symbInfo = lookupVarSymbol(*pScope, pStmt->ident.lexeme, FSYMBQ_IgnoreParent);
-			Assert(symbInfo.symbolk == SYMBOLK_Var);
-
-			uintptr virtualAddress = virtualAddressStart(*pScope) + symbInfo.varData.byteOffset;
 
 			emitOp(pBcp, BCOP_LoadImmediatePtr, startLine);
-			emit(pBcp, virtualAddress);
+			emit(pBcp, virtualAddress(*pScope, *pStmt));
 
 			return true;
 		}
@@ -731,15 +1015,16 @@ bool visitBytecodeBuilderPreorder(AstNode * pNode, void * pBuilder_)
 		{
 			auto * pStmt = Down(pNode, BlockStmt);
 
-			// HMM: Maybe this should only alloc/free if we don't inherit parent's scope id?
+			// NOTE (andrew) The func's body block reserves the whole frame, including every inner scope's locals.
+			//	Inner blocks don't touch the stack.
 
 			Scope * pScope = pCtx->scopes[pStmt->scopeid];
 
-			uintptr cByteLocal = cByteLocalVars(*pScope);
-			if (cByteLocal > 0)
+			uintptr cByteAlloc = cByteFrame(*pScope);
+			if (cByteAlloc > 0)
 			{
 				emitOp(pBcp, BCOP_StackAlloc, startLine);
-				emit(pBcp, cByteLocal);
+				emit(pBcp, cByteAlloc);
 			}
 
 			return true;
@@ -749,9 +1034,16 @@ bool visitBytecodeBuilderPreorder(AstNode * pNode, void * pBuilder_)
 		case ASTK_BreakStmt:
 		case ASTK_ContinueStmt:
 		case ASTK_PrintStmt:
-		case ASTK_ParamsReturnsGrp:
 			return true;
 
+		case ASTK_ParamsReturnsGrp:
+		{
+			// Params are already in place when the func starts (whoever starts it puts them there), so don't emit their
+			//	decls like locals, which would zero them. Return decls don't have anywhere to live yet.
+
+			return false;
+		}
+
 		case ASTK_Program:
 			AssertNotReached;
 			return false;
@@ -783,7 +1075,7 @@ void visitBytecodeBuilderHook(AstNode * pNode, AWHK awhk, void * pBuilder_)
 
 			auto * pStmt = Down(pNode, AssignStmt);
 			TypeId typidLhs = DownExpr(pStmt->pLhsExpr)->typidEval;
-			const Type * pTypeLhs = lookupType(*pCtx->typeTable, typidLhs);
+			Type::ComputedInfo typeInfoLhs = lookupTypeInfo(*pCtx->typeTable, typidLhs);
 
 			pNodeCtx->wantsChildExprAddr = false;
 
@@ -795,7 +1087,7 @@ void visitBytecodeBuilderHook(AstNode * pNode, AWHK awhk, void * pBuilder_)
 				case TOKENK_SlashEqual:
 				case TOKENK_PercentEqual:
 				{
-					int cBitSize = pTypeLhs->info.size * 8;
+					int cBitSize = typeInfoLhs.size * 8;
 					int cBitPtr = MeekCtx::s_cBytePtr * 8;
 
 					// TODO: I'm assuming the bytecode for the LHS put an address on the stack... is that
@@ -959,6 +1251,12 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 					} break;
 				} break;
 
+				case '!':
+				{
+					Assert(typid == TypeId::Bool);
+					emitOp(pBcp, BCOP_Not, startLine);
+				} break;
+
 				case '^':
 				{
 					Assert(isAddressable(pExpr->pExpr->astk));
@@ -994,32 +1292,32 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 
 			TypeId typidLhs = DownExpr(pExpr->pLhsExpr)->typidEval;
 			TypeId typidRhs = DownExpr(pExpr->pRhsExpr)->typidEval;
-			const Type * pTypeLhs = lookupType(*pCtx->typeTable, typidLhs);
-			const Type * pTypeRhs = lookupType(*pCtx->typeTable, typidRhs);
+			Type::ComputedInfo typeInfoLhs = lookupTypeInfo(*pCtx->typeTable, typidLhs);
+			Type::ComputedInfo typeInfoRhs = lookupTypeInfo(*pCtx->typeTable, typidRhs);
 
 			if (typidLhs != typidRhs)
 			{
 				AssertTodo;
 			}
 
-			const Type * pTypeBig = (pTypeLhs->info.size > pTypeRhs->info.size) ? pTypeLhs : pTypeRhs;
-			const Type * pTypeSmall = (pTypeLhs->info.size <= pTypeRhs->info.size) ? pTypeLhs : pTypeRhs;
+			TypeId typidBig = (typeInfoLhs.size > typeInfoRhs.size) ? typidLhs : typidRhs;
+			TypeId typidSmall = (typeInfoLhs.size <= typeInfoRhs.size) ? typidLhs : typidRhs;
 
 			bool widenLhs = false;
 			bool widenRhs = false;
-			if (pTypeBig != pTypeSmall)
+			if (typidBig != typidSmall)
 			{
-				if (pTypeLhs != pTypeBig)
+				if (typidLhs != typidBig)
 				{
-					Assert(pTypeLhs == pTypeSmall);
-					Assert(pTypeRhs == pTypeBig);
+					Assert(typidLhs == typidSmall);
+					Assert(typidRhs == typidBig);
 
 					widenLhs = true;
 				}
 				else
 				{
-					Assert(pTypeLhs == pTypeBig);
-					Assert(pTypeRhs == pTypeSmall);
+					Assert(typidLhs == typidBig);
+					Assert(typidRhs == typidSmall);
 
 					widenRhs = true;
 				}
@@ -1036,8 +1334,9 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 				AssertTodo;
 			}
 
-			// TODO: Emit float operations, unsigned vs signed div operations, etc.
+			// TODO: Emit unsigned vs signed div operations, etc.
 
+			bool isFloat = (typidBig == TypeId::F32 || typidBig == TypeId::F64);
 			bool shouldEmitNotAtEnd = false;
 
 			SIZEDBCOP sizedbcop = SIZEDBCOP_Nil;
@@ -1045,54 +1344,54 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 			{
 				case TOKENK_Plus:
 				{
-					sizedbcop = SIZEDBCOP_AddInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_AddFloat : SIZEDBCOP_AddInt;
 				} break;
 
 				case TOKENK_Minus:
 				{
-					sizedbcop = SIZEDBCOP_SubInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_SubFloat : SIZEDBCOP_SubInt;
 				} break;
 
 				case TOKENK_Star:
 				{
-					sizedbcop = SIZEDBCOP_MulInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_MulFloat : SIZEDBCOP_MulInt;
 				} break;
 
 				case TOKENK_Slash:
 				{
-					sizedbcop = SIZEDBCOP_DivSignedInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_DivFloat : SIZEDBCOP_DivSignedInt;
 				} break;
 
 				case TOKENK_EqualEqual:
 				{
-					sizedbcop = SIZEDBCOP_TestEqInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestEqFloat : SIZEDBCOP_TestEqInt;
 				} break;
 
 				case TOKENK_BangEqual:
 				{
-					sizedbcop = SIZEDBCOP_TestEqInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestEqFloat : SIZEDBCOP_TestEqInt;
 					shouldEmitNotAtEnd = true;
 				} break;
 
 				case TOKENK_Lesser:
 				{
-					sizedbcop = SIZEDBCOP_TestLtSignedInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestLtFloat : SIZEDBCOP_TestLtSignedInt;
 				} break;
 
 				case TOKENK_LesserEqual:
 				{
-					sizedbcop = SIZEDBCOP_TestLteSignedInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestLteFloat : SIZEDBCOP_TestLteSignedInt;
 				} break;
 
 				case TOKENK_Greater:
 				{
-					sizedbcop = SIZEDBCOP_TestLteSignedInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestLteFloat : SIZEDBCOP_TestLteSignedInt;
 					shouldEmitNotAtEnd = true;
 				} break;
 
 				case TOKENK_GreaterEqual:
 				{
-					sizedbcop = SIZEDBCOP_TestLtSignedInt;
+					sizedbcop = (isFloat) ? SIZEDBCOP_TestLtFloat : SIZEDBCOP_TestLtSignedInt;
 					shouldEmitNotAtEnd = true;
 				} break;
 
@@ -1113,7 +1412,7 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 
 			if (sizedbcop != SIZEDBCOP_Nil)
 			{
-				int cBitSize = pTypeBig->info.size * 8;
+				int cBitSize = lookupTypeInfo(*pCtx->typeTable, typidBig).size * 8;
 				if (cBitSize != 32) AssertTodo;
 
 				BCOP bcop = bcopSized(sizedbcop, cBitSize);
@@ -1183,21 +1482,18 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 				{
 					Assert(pNodeCtxParent);
 
-					Scope * pScope = pCtx->scopes[pExpr->varData.pDeclCached->ident.scopeid];
-					SymbolInfo symbInfo = lookupVarSymbol(*pScope, pExpr->ident, FSYMBQ_IgnoreParent);
-					Assert(symbInfo.symbolk == SYMBOLK_Var);
+					// NOTE (andrew) The binding was cached on the node during resolve, so no symbol lookup here
 
-					uintptr virtualAddress = virtualAddressStart(*pScope) + symbInfo.varData.byteOffset;
+					const AstVarDeclStmt * pDecl = pExpr->varData.pDeclCached;
+					Scope * pScope = pCtx->scopes[pDecl->ident.scopeid];
 
 					emitOp(pBcp, BCOP_LoadImmediatePtr, startLine);
-					emit(pBcp, virtualAddress);
+					emit(pBcp, virtualAddress(*pScope, *pDecl));
 
 					if (!pNodeCtxParent->wantsChildExprAddr)
 					{
 						TypeId typid = DownExpr(pNode)->typidEval;
-						const Type * pType = lookupType(*pCtx->typeTable, typid);
-
-						int cBitSize = pType->info.size * 8;
+						int cBitSize = lookupTypeInfo(*pCtx->typeTable, typid).size * 8;
 
 						AssertInfo(
 							cBitSize == 8 || cBitSize == 16 || cBitSize == 32 || cBitSize == 64,
@@ -1245,6 +1541,17 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 				{
 					Assert(pNodeCtxParent);
 
+					// NOTE (andrew) A call straight to an extern func doesn't need the FuncId on the stack, CallHost
+					//	carries it in its arg. See ASTK_FuncCallExpr below.
+
+					AstNode * pNodeParent = pNodeCtxParent->pNode;
+					if (isExternFunc(*Up(pExpr->funcData.pDefnCached)) &&
+						pNodeParent->astk == ASTK_FuncCallExpr &&
+						Down(pNodeParent, FuncCallExpr)->pFunc == pNode)
+					{
+						break;
+					}
+
 					BCOP bcop = bcopSized(SIZEDBCOP_LoadImmediate, sizeof(FuncId) * 8);
 
 					emitOp(pBcp, bcop, startLine);
@@ -1268,6 +1575,42 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 		{
 			auto * pExpr = Down(pNode, FuncCallExpr);
 
+			// Extern funcs are called in place. The args are already on top of the stack, in param order and each at its own
+			//	size, which is exactly what the host func expects. See host_func.h
+
+			if (pExpr->pFunc->astk == ASTK_SymbolExpr &&
+				Down(pExpr->pFunc, SymbolExpr)->symbexprk == SYMBEXPRK_Func &&
+				isExternFunc(*Up(Down(pExpr->pFunc, SymbolExpr)->funcData.pDefnCached)))
+			{
+				const AstFuncDefnStmt * pDefn = Down(pExpr->pFunc, SymbolExpr)->funcData.pDefnCached;
+				const FuncType * pFuncType = funcTypeFromDefnStmt(*pCtx->typeTable, *pDefn);
+				Assert(pFuncType);
+				Assert(pFuncType->paramTypids.cItem == pExpr->apArgs.cItem);
+
+#if DEBUG
+				for (int iParam = 0; iParam < pFuncType->paramTypids.cItem; iParam++)
+				{
+					Assert(
+						lookupTypeInfo(*pCtx->typeTable, pFuncType->paramTypids[iParam]).size ==
+						lookupTypeInfo(*pCtx->typeTable, DownExpr(pExpr->apArgs[iParam])->typidEval).size);
+				}
+#endif
+
+				int cByteArg;
+				int cByteReturn;
+				computeHostCallSizes(*pCtx->typeTable, *pFuncType, &cByteArg, &cByteReturn);
+
+				// The resolve pass rejects calls that don't fit, see c_cByteHostCallMax
+
+				Assert(cByteArg <= c_cByteHostCallMax && cByteReturn <= c_cByteHostCallMax);
+
+				emitOp(pBcp, BCOP_CallHost, startLine);
+				emit(pBcp, u32(pDefn->funcid));
+				emit(pBcp, u16(cByteArg));
+				emit(pBcp, u16(cByteReturn));
+				break;
+			}
+
 			/*uintptr byteOffsetFuncid = ;
 			emitOp(pBcp, BCOP_Call, startLine);
 			emit(pBcp, byteOffsetFuncid);*/
@@ -1279,7 +1622,19 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 			break;
 
 		case ASTK_ExprStmt:
-			break;
+		{
+			// Nothing wants the value, e.g., what a call returns when it's called just for what it does
+
+			auto * pStmt = Down(pNode, ExprStmt);
+			TypeId typid = DownExpr(pStmt->pExpr)->typidEval;
+
+			uintptr cByteDrop = lookupTypeInfo(*pCtx->typeTable, typid).size;
+			if (cByteDrop > 0)
+			{
+				emitOp(pBcp, BCOP_StackFree, startLine);
+				emit(pBcp, cByteDrop);
+			}
+		} break;
 
 		case ASTK_AssignStmt:
 		{
@@ -1287,8 +1642,8 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 
 			TypeId typidLhs = DownExpr(pStmt->pLhsExpr)->typidEval;
 			TypeId typidRhs = DownExpr(pStmt->pRhsExpr)->typidEval;
-			const Type * pTypeLhs = lookupType(*pCtx->typeTable, typidLhs);
-			const Type * pTypeRhs = lookupType(*pCtx->typeTable, typidRhs);
+			Type::ComputedInfo typeInfoLhs = lookupTypeInfo(*pCtx->typeTable, typidLhs);
+			Type::ComputedInfo typeInfoRhs = lookupTypeInfo(*pCtx->typeTable, typidRhs);
 
 			switch (pStmt->pAssignToken->tokenk)
 			{
@@ -1310,10 +1665,10 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 						AssertTodo;
 					}
 
-					Assert(pTypeLhs->info.size >= pTypeRhs->info.size);
+					Assert(typeInfoLhs.size >= typeInfoRhs.size);
 
 					bool widenRhs = false;
-					if (pTypeLhs->info.size > pTypeRhs->info.size)
+					if (typeInfoLhs.size > typeInfoRhs.size)
 					{
 						widenRhs = true;
 					}
@@ -1358,21 +1713,20 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 							break;
 					}
 
-					int cBitSize = pTypeLhs->info.size * 8;
+					int cBitSize = typeInfoLhs.size * 8;
 					if (cBitSize != 32) AssertTodo;
 
 					BCOP bcop = bcopSized(sizedbcop, cBitSize);
 					emitOp(pBcp, bcop, startLine);
 
 					typidRhs = typidLhs;
-					pTypeRhs = pTypeLhs;
+					typeInfoRhs = typeInfoLhs;
 
 				} // fallthrough
 
 				case TOKENK_Equal:
 				{
-					const Type * pTypeLhs = lookupType(*pCtx->typeTable, typidLhs);
-					int cBitSize = pTypeLhs->info.size * 8;
+					int cBitSize = typeInfoLhs.size * 8;
 
 					if (cBitSize != 32) AssertTodo;
 
@@ -1386,16 +1740,10 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 		{
 			auto * pStmt = Down(pNode, VarDeclStmt);
 
-			Scope * pScope = pCtx->scopes[pStmt->ident.scopeid];
-			SymbolInfo symbInfo = lookupVarSymbol(*pScope, pStmt->ident.lexeme, FSYMBQ_IgnoreParent);
-			Assert(symbInfo.symbolk == SYMBOLK_Var);
-
 			TypeId typid = pStmt->typidDefn;
-			const Type * pType = lookupType(*pCtx->typeTable, typid);
-			int cByteSize = pType->info.size;
+			int cByteSize = lookupTypeInfo(*pCtx->typeTable, typid).size;
 			int cBitSize = cByteSize * 8;
 
-			uintptr virtualAddress = virtualAddressStart(*pScope) + symbInfo.varData.byteOffset;
 			if (!pStmt->pInitExpr)
 			{
 				emitOp(
@@ -1415,8 +1763,12 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 		case ASTK_FuncDefnStmt:
 		{
 			// Temporary for testing... in reality we will emit return code here (if necessary)
+			// Extern funcs get no bytecode at all, their body is on the host
 
-			emitOp(pBcp, BCOP_DebugExit, startLine);
+			if (!isExternFunc(*pNode))
+			{
+				emitOp(pBcp, BCOP_DebugExit, startLine);
+			}
 		}
 
 		case ASTK_StructDefnStmt:
@@ -1469,20 +1821,25 @@ void visitBytecodeBuilderPostOrder(AstNode * pNode, void * pBuilder_)
 		case ASTK_BlockStmt:
 		{
 			auto * pStmt = Down(pNode, BlockStmt);
-
-			// HMM: Maybe this should only alloc/free if we don't inherit parent's scope id?
-
 			Scope * pScope = pCtx->scopes[pStmt->scopeid];
 
-			uintptr cByteLocal = cByteLocalVars(*pScope);
-			if (cByteLocal > 0)
+			uintptr cByteAlloc = cByteFrame(*pScope);
+			if (cByteAlloc > 0)
 			{
 				emitOp(pBcp, BCOP_StackFree, startLine);
-				emit(pBcp, cByteLocal);
+				emit(pBcp, cByteAlloc);
 			}
 		} break;
 
 		case ASTK_ReturnStmt:
+		{
+			// NOTE (andrew) Nothing emits calls yet, so the func being returned from is always the one the interpreter was
+			//	started on, and returning is just stopping with the return value (if any) on top of the stack. Whoever
+			//	started it reads it from there. Switch to the Return ops once calls go in.
+
+			emitOp(pBcp, BCOP_DebugExit, startLine);
+		} break;
+
 		case ASTK_BreakStmt:
 		case ASTK_ContinueStmt:
 			break;
@@ -1526,12 +1883,16 @@ void disassemble(const BytecodeProgram & bcp)
 		{
 			print(Down(pFuncNode, FuncDefnStmt)->ident.lexeme.strv);
 		}
+		else if (pFuncNode->astk == ASTK_Program)
+		{
+			print("<global init>");
+		}
 		else
 		{
 			Assert(pFuncNode->astk == ASTK_FuncLiteralExpr);
 			print("<lambda>");
 		}
-		printfmt("' (id: %u)", funcid(*pFuncNode));
+		printfmt("' (id: %d)", iFunc);
 		println();
 		print(":");
 		println();
@@ -1738,6 +2099,25 @@ void disassemble(const BytecodeProgram & bcp)
 					println();
 				} break;
 
+				case BCOP_CallHost:
+				{
+					printfmt("%08d ", iByte);
+
+					FuncId funcid = *reinterpret_cast<FuncId *>(bcp.bytes.pBuffer + iByte);
+					iByte += sizeof(FuncId);
+
+					u16 cByteArg = *reinterpret_cast<u16 *>(bcp.bytes.pBuffer + iByte);
+					iByte += sizeof(u16);
+
+					u16 cByteReturn = *reinterpret_cast<u16 *>(bcp.bytes.pBuffer + iByte);
+					iByte += sizeof(u16);
+
+					print("     |  ");
+					print(" -> ");
+					printfmt("funcid %u, %u bytes of args, %u bytes of return", u32(funcid), u32(cByteArg), u32(cByteReturn));
+					println();
+				} break;
+
 				case BCOP_Return0:
 				case BCOP_Return8:
 				case BCOP_Return16:
@@ -4,6 +4,7 @@
 #include "ast.h"
 
 struct MeekCtx;
+struct ResolvePass;
 
 // ByteCode OPeration
 
@@ -265,6 +266,15 @@ enum BCOP : u8
 
 	BCOP_Call,
 
+	// CallHost
+	//	- Reads FuncId of an extern func from bytecode, then u16 bytes of args and u16 bytes of return
+	//	- Calls the host func bound to it with a pointer to its args, which are on top of the stack
+	//	- The host func writes its return over the args, so afterwards the args are gone and the return is on top
+	//
+	//	[ arg0 | arg1			->		[ RV
+
+	BCOP_CallHost,
+
 	// Return
 	//	- Pops n-bit RV off the stack (will be restored before return finishes)
 	//	- Pops Return Address (RA) off the stack
@@ -313,6 +323,8 @@ enum BCOP : u8
 
 // extern const int gc_mpBcopCByte[];
 
+const char * strFromBcop(BCOP bcop);
+
 enum SIZEDBCOP
 {
 	SIZEDBCOP_LoadImmediate,
@@ -349,16 +361,30 @@ struct BytecodeFunction
 
 	int iByte0;
 	int cByte;
+
+	int cByteStackMax;			// Most the func ever has on the stack, including its frame. -1 until it's verified
 };
 
+StringView strvFuncName(const BytecodeFunction & bcf);
+
 struct BytecodeProgram
 {
 	DynamicArray<u8> bytes;
 	DynamicArray<BytecodeFunction> bytecodeFuncs;	// In order of appearance in bytecode
 	DynamicArray<int> sourceLineNumbers;			// In order of appearance of ops in bytecode
+
+	// Runs the global initializers that can't be folded into the globals image, see tryFoldGlobalInit(..). It comes
+	//	after every func, so it never shifts anyone's FuncId. FuncId::Nil if every initializer folds.
+
+	FuncId funcidGlobalInit;
 };
 
 void init(BytecodeProgram * pBcp);
+void dispose(BytecodeProgram * pBcp);
+
+// Func whose bytecode includes iByte, or null
+
+const BytecodeFunction * pBcfFromIByte(const BytecodeProgram & bcp, int iByte);
 
 struct BytecodeBuilder
 {
@@ -405,10 +431,14 @@ struct BytecodeBuilder
 };
 
 void init(BytecodeBuilder * pBuilder, MeekCtx * pCtx);
+void dispose(BytecodeBuilder * pBuilder);
 
 void init(BytecodeBuilder::NodeCtx * pNodeCtx, AstNode * pNode);
 
 void compileBytecode(BytecodeBuilder * pBuilder);
+void resolveAndCompileBytecode(BytecodeBuilder * pBuilder, ResolvePass * pPass);
+void compileBytecodeFunc(BytecodeBuilder * pBuilder, AstNode * pNode);
+void linkBytecode(BytecodeProgram * pBcp, const BytecodeBuilder aBuilderFunc[], int cBuilderFunc);
 void emitOp(BytecodeProgram * bcp, BCOP byteEmit, int lineNumber);
 void emit(BytecodeProgram * bcp, u8 byteEmit);
 void emit(BytecodeProgram * bcp, s8 byteEmit);
@@ -0,0 +1,543 @@
+#include "bytecode_verify.h"
+
+#include "ast.h"
+#include "bytecode.h"
+#include "host_func.h"
+#include "print.h"
+#include "type.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <string.h>
+
+// How an op leaves the func's straight line code
+
+enum FLOWK
+{
+	FLOWK_Next,				// Always goes on to the next op
+	FLOWK_Jump,				// Always jumps
+	FLOWK_Branch,			// Either goes on to the next op or jumps
+	FLOWK_End,				// Leaves the func
+
+	FLOWK_Nil = -1			// Not supported yet, reject any func that has one
+};
+
+struct OpInfo
+{
+	int cByteArg;			// Bytes of args in the bytecode right after the op
+	int cBytePop;			// Bytes popped, then...
+	int cBytePush;			// ...bytes pushed. Ops that just peek at the stack pop and push back the same bytes.
+	FLOWK flowk;
+};
+
+// For counts that depend on the op's arg rather than the op
+
+static const int c_cByteFromArg = -1;
+
+static const int c_cBytePtr = sizeof(uintptr);
+static const int c_cByteTypid = sizeof(TypeId);
+static const int c_cByteJumpArg = sizeof(s16);
+static const int c_cByteCallHostArg = sizeof(FuncId) + 2 * sizeof(u16);
+
+static const OpInfo c_mpBcopOpInfo[] =
+{
+	{ 1, 0, 1, FLOWK_Next },								// LoadImmediate8
+	{ 2, 0, 2, FLOWK_Next },								// LoadImmediate16
+	{ 4, 0, 4, FLOWK_Next },								// LoadImmediate32
+	{ 8, 0, 8, FLOWK_Next },								// LoadImmediate64
+	{ 0, 0, 1, FLOWK_Next },								// LoadTrue
+	{ 0, 0, 1, FLOWK_Next },								// LoadFalse
+	{ 0, c_cBytePtr, 1, FLOWK_Next },						// Load8
+	{ 0, c_cBytePtr, 2, FLOWK_Next },						// Load16
+	{ 0, c_cBytePtr, 4, FLOWK_Next },						// Load32
+	{ 0, c_cBytePtr, 8, FLOWK_Next },						// Load64
+	{ 0, c_cBytePtr + 1, 0, FLOWK_Next },					// Store8
+	{ 0, c_cBytePtr + 2, 0, FLOWK_Next },					// Store16
+	{ 0, c_cBytePtr + 4, 0, FLOWK_Next },					// Store32
+	{ 0, c_cBytePtr + 8, 0, FLOWK_Next },					// Store64
+	{ 0, 1, 2, FLOWK_Next },								// Duplicate8
+	{ 0, 2, 4, FLOWK_Next },								// Duplicate16
+	{ 0, 4, 8, FLOWK_Next },								// Duplicate32
+	{ 0, 8, 16, FLOWK_Next },								// Duplicate64
+	{ 0, 2, 1, FLOWK_Next },								// AddInt8
+	{ 0, 4, 2, FLOWK_Next },								// AddInt16
+	{ 0, 8, 4, FLOWK_Next },								// AddInt32
+	{ 0, 16, 8, FLOWK_Next },								// AddInt64
+	{ 0, 2, 1, FLOWK_Next },								// SubInt8
+	{ 0, 4, 2, FLOWK_Next },								// SubInt16
+	{ 0, 8, 4, FLOWK_Next },								// SubInt32
+	{ 0, 16, 8, FLOWK_Next },								// SubInt64
+	{ 0, 2, 1, FLOWK_Next },								// MulInt8
+	{ 0, 4, 2, FLOWK_Next },								// MulInt16
+	{ 0, 8, 4, FLOWK_Next },								// MulInt32
+	{ 0, 16, 8, FLOWK_Next },								// MulInt64
+	{ 0, 2, 1, FLOWK_Next },								// DivS8
+	{ 0, 4, 2, FLOWK_Next },								// DivS16
+	{ 0, 8, 4, FLOWK_Next },								// DivS32
+	{ 0, 16, 8, FLOWK_Next },								// DivS64
+	{ 0, 2, 1, FLOWK_Next },								// DivU8
+	{ 0, 4, 2, FLOWK_Next },								// DivU16
+	{ 0, 8, 4, FLOWK_Next },								// DivU32
+	{ 0, 16, 8, FLOWK_Next },								// DivU64
+	{ 0, 8, 4, FLOWK_Next },								// AddFloat32
+	{ 0, 16, 8, FLOWK_Next },								// AddFloat64
+	{ 0, 8, 4, FLOWK_Next },								// SubFloat32
+	{ 0, 16, 8, FLOWK_Next },								// SubFloat64
+	{ 0, 8, 4, FLOWK_Next },								// MulFloat32
+	{ 0, 16, 8, FLOWK_Next },								// MulFloat64
+	{ 0, 8, 4, FLOWK_Next },								// DivFloat32
+	{ 0, 16, 8, FLOWK_Next },								// DivFloat64
+	{ 0, 2, 1, FLOWK_Next },								// TestEqInt8
+	{ 0, 4, 1, FLOWK_Next },								// TestEqInt16
+	{ 0, 8, 1, FLOWK_Next },								// TestEqInt32
+	{ 0, 16, 1, FLOWK_Next },								// TestEqInt64
+	{ 0, 2, 1, FLOWK_Next },								// TestLtS8
+	{ 0, 4, 1, FLOWK_Next },								// TestLtS16
+	{ 0, 8, 1, FLOWK_Next },								// TestLtS32
+	{ 0, 16, 1, FLOWK_Next },								// TestLtS64
+	{ 0, 2, 1, FLOWK_Next },								// TestLtU8
+	{ 0, 4, 1, FLOWK_Next },								// TestLtU16
+	{ 0, 8, 1, FLOWK_Next },								// TestLtU32
+	{ 0, 16, 1, FLOWK_Next },								// TestLtU64
+	{ 0, 2, 1, FLOWK_Next },								// TestLteS8
+	{ 0, 4, 1, FLOWK_Next },								// TestLteS16
+	{ 0, 8, 1, FLOWK_Next },								// TestLteS32
+	{ 0, 16, 1, FLOWK_Next },								// TestLteS64
+	{ 0, 2, 1, FLOWK_Next },								// TestLteU8
+	{ 0, 4, 1, FLOWK_Next },								// TestLteU16
+	{ 0, 8, 1, FLOWK_Next },								// TestLteU32
+	{ 0, 16, 1, FLOWK_Next },								// TestLteU64
+	{ 0, 8, 1, FLOWK_Next },								// TestEqFloat32
+	{ 0, 16, 1, FLOWK_Next },								// TestEqFloat64
+	{ 0, 8, 1, FLOWK_Next },								// TestLtFloat32
+	{ 0, 16, 1, FLOWK_Next },								// TestLtFloat64
+	{ 0, 8, 1, FLOWK_Next },								// TestLteFloat32
+	{ 0, 16, 1, FLOWK_Next },								// TestLteFloat64
+	{ 0, 1, 1, FLOWK_Next },								// Not
+	{ 0, 1, 1, FLOWK_Next },								// NegateS8
+	{ 0, 2, 2, FLOWK_Next },								// NegateS16
+	{ 0, 4, 4, FLOWK_Next },								// NegateS32
+	{ 0, 8, 8, FLOWK_Next },								// NegateS64
+	{ 0, 4, 4, FLOWK_Next },								// NegateFloat32
+	{ 0, 8, 8, FLOWK_Next },								// NegateFloat64
+	{ c_cByteJumpArg, 0, 0, FLOWK_Jump },					// Jump
+	{ c_cByteJumpArg, 1, 0, FLOWK_Branch },					// JumpIfFalse
+	{ c_cByteJumpArg, 1, 1, FLOWK_Branch },					// JumpIfPeekFalse
+	{ c_cByteJumpArg, 1, 1, FLOWK_Branch },					// JumpIfPeekTrue
+	{ c_cBytePtr, 0, c_cByteFromArg, FLOWK_Next },			// StackAlloc
+	{ c_cBytePtr, c_cByteFromArg, 0, FLOWK_Next },			// StackFree
+	{ c_cBytePtr, 0, 0, FLOWK_Nil },						// Call
+	{ c_cByteCallHostArg, c_cByteFromArg, c_cByteFromArg, FLOWK_Next },	// CallHost
+	{ 0, 0, 0, FLOWK_End },									// Return0
+	{ 0, 1, 0, FLOWK_End },									// Return8
+	{ 0, 2, 0, FLOWK_End },									// Return16
+	{ 0, 4, 0, FLOWK_End },									// Return32
+	{ 0, 8, 0, FLOWK_End },									// Return64
+	{ c_cByteTypid, c_cByteFromArg, 0, FLOWK_Next },		// DebugPrint
+	{ 0, 0, 0, FLOWK_End },									// DebugExit
+};
+StaticAssert(ArrayLen(c_mpBcopOpInfo) == BCOP_Max);
+
+// Nothing the builder emits comes anywhere near this, so a func that needs more is garbage
+
+static const s64 s_cByteStackFuncMax = 256 * 1024 * 1024;
+
+// Size of the value DebugPrint pops, or -1 if the interpreter can't print the type
+
+static int cBytePrinted(TypeId typid)
+{
+	switch (typid)
+	{
+		case TypeId::U8:
+		case TypeId::S8:
+			return 1;
+
+		case TypeId::U16:
+		case TypeId::S16:
+			return 2;
+
+		case TypeId::U32:
+		case TypeId::S32:
+		case TypeId::F32:
+			return 4;
+
+		case TypeId::U64:
+		case TypeId::S64:
+		case TypeId::F64:
+			return 8;
+
+		default:
+			return -1;
+	}
+}
+
+static void reportVerifyError(const BytecodeProgram & bcp, const BytecodeFunction & bcf, int iByte, int iOp, const char * errFormat, ...)
+{
+	StringView strvName = strvFuncName(bcf);
+
+	printfmt("[Error: bad bytecode in '%.*s'", strvName.cCh, strvName.pCh);
+
+	if (iOp >= 0 && iOp < bcp.sourceLineNumbers.cItem)
+	{
+		printfmt(", line %d", bcp.sourceLineNumbers[iOp]);
+	}
+
+	printfmt(", byte %d]\n", iByte);
+
+	va_list arglist;
+	va_start(arglist, errFormat);
+	vprintfmt(errFormat, arglist);
+	println();
+	println();
+	va_end(arglist);
+}
+
+// Scratch space, indexed by byte within the func being verified. Reused from func to func.
+
+struct VerifyScratch
+{
+	DynamicArray<int> mpIByteIOp;			// Op index if an op starts at this byte, -1 otherwise
+	DynamicArray<s64> mpIByteCByteStack;	// Bytes on the stack when the op here starts, -1 if no path reached it yet
+	Stack<int> iBytesPending;				// Ops that were reached but haven't been followed yet
+};
+
+template <typename T>
+static void resetScratch(DynamicArray<T> * pArray, int cItem)
+{
+	ensureCapacity(pArray, cItem);
+	pArray->cItem = cItem;
+
+	for (int i = 0; i < cItem; i++)
+	{
+		(*pArray)[i] = -1;
+	}
+}
+
+// For ops whose stack use depends on their arg, how many bytes the arg says. -1 if the arg is bad.
+
+static s64 cByteFromArg(const OpInfo & opInfo, const u8 * pArg)
+{
+	if (opInfo.cByteArg == c_cByteTypid)
+	{
+		TypeId typid;
+		memcpy(&typid, pArg, sizeof(TypeId));
+		return cBytePrinted(typid);
+	}
+
+	Assert(opInfo.cByteArg == c_cBytePtr);
+
+	uintptr cByte;
+	memcpy(&cByte, pArg, sizeof(uintptr));
+	return (cByte <= uintptr(s_cByteStackFuncMax)) ? s64(cByte) : -1;
+}
+
+static bool tryVerifyFunc(
+	BytecodeProgram * pBcp,
+	const TypeTable & typeTable,
+	int iBcf,
+	int iOp0,
+	VerifyScratch * pScratch,
+	int * poCOp)
+{
+	BytecodeFunction * pBcf = &pBcp->bytecodeFuncs[iBcf];
+	const u8 * pBytes = pBcp->bytes.pBuffer + pBcf->iByte0;
+	int cByte = pBcf->cByte;
+
+	// Extern funcs have no bytecode, their body is on the host
+
+	if (isExternFunc(*pBcf->pFuncNode))
+	{
+		Assert(cByte == 0);
+
+		*poCOp = 0;
+		pBcf->cByteStackMax = 0;
+		return true;
+	}
+
+	resetScratch(&pScratch->mpIByteIOp, cByte);
+	resetScratch(&pScratch->mpIByteCByteStack, cByte);
+
+	while (!isEmpty(pScratch->iBytesPending))
+	{
+		pop(&pScratch->iBytesPending);
+	}
+
+	// Find where each op starts, so jumps can be checked against them
+
+	*poCOp = -1;
+
+	int cOp = 0;
+	for (int iByte = 0; iByte < cByte; )
+	{
+		int iOp = iOp0 + cOp;
+		pScratch->mpIByteIOp[iByte] = iOp;
+		cOp++;
+
+		u8 bcop = pBytes[iByte];
+		if (bcop >= BCOP_Max)
+		{
+			reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "Unknown op %d", bcop);
+			return false;
+		}
+
+		int cByteOp = 1 + c_mpBcopOpInfo[bcop].cByteArg;
+		if (iByte + cByteOp > cByte)
+		{
+			reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "%s is missing its args", strFromBcop(BCOP(bcop)));
+			return false;
+		}
+
+		iByte += cByteOp;
+	}
+
+	*poCOp = cOp;
+
+	if (cByte == 0)
+	{
+		reportVerifyError(*pBcp, *pBcf, pBcf->iByte0, -1, "Func has no ops");
+		return false;
+	}
+
+	// Follow every path from the top, carrying how much is on the stack. Each op only needs to be looked at once, since
+	//	every other path that reaches it has to agree with the first.
+
+	s64 cByteStackPeak = 0;
+	pScratch->mpIByteCByteStack[0] = 0;
+	push(&pScratch->iBytesPending, 0);
+
+	while (!isEmpty(pScratch->iBytesPending))
+	{
+		int iByte = pop(&pScratch->iBytesPending);
+		int iOp = pScratch->mpIByteIOp[iByte];
+		s64 cByteStack = pScratch->mpIByteCByteStack[iByte];
+
+		BCOP bcop = BCOP(pBytes[iByte]);
+		const OpInfo & opInfo = c_mpBcopOpInfo[bcop];
+		const u8 * pArg = pBytes + iByte + 1;
+
+		if (opInfo.flowk == FLOWK_Nil)
+		{
+			reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "%s isn't supported yet", strFromBcop(bcop));
+			return false;
+		}
+
+		s64 cBytePop = opInfo.cBytePop;
+		s64 cBytePush = opInfo.cBytePush;
+
+		if (bcop == BCOP_CallHost)
+		{
+			// Pops the args and pushes the return, both sized by the arg right after the FuncId
+
+			FuncId funcid;
+			u16 cByteArg;
+			u16 cByteReturn;
+			memcpy(&funcid, pArg, sizeof(FuncId));
+			memcpy(&cByteArg, pArg + sizeof(FuncId), sizeof(u16));
+			memcpy(&cByteReturn, pArg + sizeof(FuncId) + sizeof(u16), sizeof(u16));
+
+			int iBcfCallee = static_cast<int>(funcid);
+			if (iBcfCallee < 0 ||
+				iBcfCallee >= pBcp->bytecodeFuncs.cItem ||
+				!isExternFunc(*pBcp->bytecodeFuncs[iBcfCallee].pFuncNode))
+			{
+				reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "%s calls something that isn't an extern func", strFromBcop(bcop));
+				return false;
+			}
+
+			// The sizes have to be what the host func expects, or it reads and writes past what's on the stack
+
+			const AstFuncDefnStmt * pDefnCallee = Down(pBcp->bytecodeFuncs[iBcfCallee].pFuncNode, FuncDefnStmt);
+			const FuncType * pFuncTypeCallee = funcTypeFromDefnStmt(typeTable, *pDefnCallee);
+			if (!pFuncTypeCallee)
+			{
+				reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "%s calls an extern func with no type", strFromBcop(bcop));
+				return false;
+			}
+
+			int cByteArgCallee;
+			int cByteReturnCallee;
+			computeHostCallSizes(typeTable, *pFuncTypeCallee, &cByteArgCallee, &cByteReturnCallee);
+
+			if (cByteArg != cByteArgCallee || cByteReturn != cByteReturnCallee)
+			{
+				StringView strvCallee = pDefnCallee->ident.lexeme.strv;
+				reportVerifyError(
+					*pBcp,
+					*pBcf,
+					pBcf->iByte0 + iByte,
+					iOp,
+					"%s moves %d bytes of args and %d of return, but '%.*s' takes %d and returns %d",
+					strFromBcop(bcop),
+					cByteArg,
+					cByteReturn,
+					strvCallee.cCh,
+					strvCallee.pCh,
+					cByteArgCallee,
+					cByteReturnCallee);
+
+				return false;
+			}
+
+			cBytePop = cByteArg;
+			cBytePush = cByteReturn;
+		}
+		else if (cBytePop == c_cByteFromArg || cBytePush == c_cByteFromArg)
+		{
+			s64 cByteArg = cByteFromArg(opInfo, pArg);
+			if (cByteArg < 0)
+			{
+				reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "%s has a bad arg", strFromBcop(bcop));
+				return false;
+			}
+
+			if (cBytePop == c_cByteFromArg)		cBytePop = cByteArg;
+			if (cBytePush == c_cByteFromArg)	cBytePush = cByteArg;
+		}
+
+		if (cBytePop > cByteStack)
+		{
+			reportVerifyError(
+				*pBcp,
+				*pBcf,
+				pBcf->iByte0 + iByte,
+				iOp,
+				"%s can't run with %" PRId64 " bytes on the stack",
+				strFromBcop(bcop),
+				cByteStack);
+
+			return false;
+		}
+
+		// Ops pop everything before they push, so the stack is never bigger mid-op than it is before or after
+
+		s64 cByteStackAfter = cByteStack - cBytePop + cBytePush;
+		cByteStackPeak = Max(cByteStackPeak, cByteStackAfter);
+
+		if (cByteStackPeak > s_cByteStackFuncMax)
+		{
+			reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "Func needs more than %" PRId64 " bytes of stack", s_cByteStackFuncMax);
+			return false;
+		}
+
+		int aIByteNext[2];
+		int cIByteNext = 0;
+
+		int iByteFallthrough = iByte + 1 + opInfo.cByteArg;
+
+		if (opInfo.flowk == FLOWK_Next || opInfo.flowk == FLOWK_Branch)
+		{
+			aIByteNext[cIByteNext++] = iByteFallthrough;
+		}
+
+		if (opInfo.flowk == FLOWK_Jump || opInfo.flowk == FLOWK_Branch)
+		{
+			// Jumps are relative to the end of the jump's arg
+
+			s16 bytesToJump;
+			memcpy(&bytesToJump, pArg, sizeof(s16));
+			aIByteNext[cIByteNext++] = iByteFallthrough + bytesToJump;
+		}
+
+		for (int iIByteNext = 0; iIByteNext < cIByteNext; iIByteNext++)
+		{
+			int iByteNext = aIByteNext[iIByteNext];
+
+			if (iByteNext == cByte)
+			{
+				reportVerifyError(*pBcp, *pBcf, pBcf->iByte0 + iByte, iOp, "Runs off the end of the func");
+				return false;
+			}
+
+			if (iByteNext < 0 || iByteNext > cByte || pScratch->mpIByteIOp[iByteNext] < 0)
+			{
+				reportVerifyError(
+					*pBcp,
+					*pBcf,
+					pBcf->iByte0 + iByte,
+					iOp,
+					"%s goes to byte %d, which isn't the start of an op in this func",
+					strFromBcop(bcop),
+					pBcf->iByte0 + iByteNext);
+
+				return false;
+			}
+
+			s64 * pCByteStackNext = &pScratch->mpIByteCByteStack[iByteNext];
+			if (*pCByteStackNext < 0)
+			{
+				*pCByteStackNext = cByteStackAfter;
+				push(&pScratch->iBytesPending, iByteNext);
+			}
+			else if (*pCByteStackNext != cByteStackAfter)
+			{
+				reportVerifyError(
+					*pBcp,
+					*pBcf,
+					pBcf->iByte0 + iByteNext,
+					pScratch->mpIByteIOp[iByteNext],
+					"Reached with %" PRId64 " bytes on the stack from byte %d, but with %" PRId64 " from somewhere else",
+					cByteStackAfter,
+					pBcf->iByte0 + iByte,
+					*pCByteStackNext);
+
+				return false;
+			}
+		}
+	}
+
+	pBcf->cByteStackMax = static_cast<int>(cByteStackPeak);
+	return true;
+}
+
+bool tryVerifyBytecode(BytecodeProgram * pBcp, const TypeTable & typeTable)
+{
+	VerifyScratch scratch;
+	init(&scratch.mpIByteIOp);
+	init(&scratch.mpIByteCByteStack);
+	init(&scratch.iBytesPending);
+	Defer(dispose(&scratch.mpIByteIOp));
+	Defer(dispose(&scratch.mpIByteCByteStack));
+	Defer(dispose(&scratch.iBytesPending));
+
+	// NOTE (andrew) Ops are numbered across the whole program, in the same order as sourceLineNumbers
+
+	bool success = true;
+	int iOp0 = 0;
+
+	for (int iBcf = 0; iBcf < pBcp->bytecodeFuncs.cItem; iBcf++)
+	{
+		int cOp;
+		if (!tryVerifyFunc(pBcp, typeTable, iBcf, iOp0, &scratch, &cOp))
+		{
+			success = false;
+
+			// Once a func fails to decode its ops can't be counted, so later funcs' line numbers would be off
+
+			if (cOp < 0)
+				break;
+		}
+
+		iOp0 += cOp;
+	}
+
+	return success;
+}
+
+int lineFromIByte(const BytecodeProgram & bcp, int iByte)
+{
+	int iOp = 0;
+	for (int iByteOp = 0; iByteOp < bcp.bytes.cItem; iOp++)
+	{
+		u8 bcop = bcp.bytes[iByteOp];
+		if (bcop >= BCOP_Max)
+			break;
+
+		int iByteNext = iByteOp + 1 + c_mpBcopOpInfo[bcop].cByteArg;
+		if (iByte < iByteNext)
+			return (iOp < bcp.sourceLineNumbers.cItem) ? bcp.sourceLineNumbers[iOp] : -1;
+
+		iByteOp = iByteNext;
+	}
+
+	return -1;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "als.h"
+
+struct BytecodeProgram;
+struct TypeTable;
+
+// Bytecode verifier. Walks every path through each func in a linked program, working out how many bytes each op pushes
+//	and pops, and rejects the program if an op would pop more than is on the stack, a jump lands anywhere but the start
+//	of an op in the same func, two paths reach the same op with different amounts on the stack, or a func can run off
+//	its end. Records the most stack each func can use in BytecodeFunction::cByteStackMax, which is what lets the
+//	interpreter check for overflow once per func instead of on every push.
+//
+// typeTable is the one the program was compiled with, so each CallHost can be checked against its extern's FuncType.
+//
+// Prints what was wrong and returns false if the program is rejected. Run it before handing the program to interpret(..).
+
+bool tryVerifyBytecode(BytecodeProgram * pBcp, const TypeTable & typeTable);
+
+// Source line of the op that iByte is part of (the op itself or one of its args), or -1. Only for programs that passed
+//	verification. It's a scan from the start of the program, so it's for reporting errors, not for anything hot.
+
+int lineFromIByte(const BytecodeProgram & bcp, int iByte);
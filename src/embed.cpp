@@ -0,0 +1,482 @@
+#include "embed.h"
+
+#include "als.h"
+
+#include "ast.h"
+#include "bytecode.h"
+#include "bytecode_verify.h"
+#include "global_context.h"
+#include "host_func.h"
+#include "interp.h"
+#include "parse.h"
+#include "print.h"
+#include "resolve.h"
+#include "symbol.h"
+#include "type.h"
+
+#include <string.h>
+
+struct MeekParam
+{
+	MEEKTYPE meektype;
+	int byteOffset;				// Within the func's args, see virtualAddress(..)
+};
+
+struct MeekFunc
+{
+	StringView strvName;
+	FuncId funcid;
+
+	int iParamFirst;			// Into MeekProgram::aParam
+	int cParam;
+	MEEKTYPE meektypeReturn;
+
+	int cByteParam;
+	int cByteFrame;				// Locals the func's body StackAllocs, which sit between its args and its return value
+};
+
+struct MeekProgram
+{
+	char * pChSource;			// Our own copy, since the AST (and so func names) point into it
+
+	MeekCtx ctx;				// Kept around for as long as the program is, since the bytecode points into its AST
+	LoadedProgram loaded;
+	bool isLoaded;				// Only once it compiles
+
+	DynamicArray<MeekFunc> aFunc;
+	DynamicArray<MeekParam> aParam;
+};
+
+struct MeekVm
+{
+	const MeekProgram * pProgram;
+	Interpreter interp;
+};
+
+struct MeekHostFuncs
+{
+	HostFuncRegistry registry;
+};
+
+static const int c_mpMeektypeCByte[] =
+{
+	0,		// MEEKTYPE_Void
+	1,		// MEEKTYPE_S8
+	2,		// MEEKTYPE_S16
+	4,		// MEEKTYPE_S32
+	8,		// MEEKTYPE_S64
+	1,		// MEEKTYPE_U8
+	2,		// MEEKTYPE_U16
+	4,		// MEEKTYPE_U32
+	8,		// MEEKTYPE_U64
+	4,		// MEEKTYPE_F32
+	8,		// MEEKTYPE_F64
+	1,		// MEEKTYPE_Bool
+};
+StaticAssert(ArrayLen(c_mpMeektypeCByte) == MEEKTYPE_Max);
+
+static const TypeId c_mpMeektypeTypid[] =
+{
+	TypeId::Void,
+	TypeId::S8,
+	TypeId::S16,
+	TypeId::S32,
+	TypeId::S64,
+	TypeId::U8,
+	TypeId::U16,
+	TypeId::U32,
+	TypeId::U64,
+	TypeId::F32,
+	TypeId::F64,
+	TypeId::Bool,
+};
+StaticAssert(ArrayLen(c_mpMeektypeTypid) == MEEKTYPE_Max);
+
+static MEEKTYPE meektypeFromTypid(TypeId typid)
+{
+	switch (typid)
+	{
+		case TypeId::S8:	return MEEKTYPE_S8;
+		case TypeId::S16:	return MEEKTYPE_S16;
+		case TypeId::S32:	return MEEKTYPE_S32;
+		case TypeId::S64:	return MEEKTYPE_S64;
+		case TypeId::U8:	return MEEKTYPE_U8;
+		case TypeId::U16:	return MEEKTYPE_U16;
+		case TypeId::U32:	return MEEKTYPE_U32;
+		case TypeId::U64:	return MEEKTYPE_U64;
+		case TypeId::F32:	return MEEKTYPE_F32;
+		case TypeId::F64:	return MEEKTYPE_F64;
+		case TypeId::Bool:	return MEEKTYPE_Bool;
+		default:			return MEEKTYPE_Max;
+	}
+}
+
+static bool tryCompile(MeekCtx * pCtx, BytecodeBuilder * pBuilder)
+{
+	// Sequential, like the benchmarks. The passes that are worth running in parallel still do so internally.
+
+	MeekCtx & ctx = *pCtx;
+	ctx.parser->scansAhead = false;
+
+	bool success;
+	ctx.rootNode = parseProgram(ctx.parser, &success);
+
+	if (!success)
+	{
+		reportScanAndParseErrors(*ctx.parser);
+		return false;
+	}
+
+	if (!tryResolveAllTypes(ctx.typeTable))
+	{
+		print("Unable to resolve some types\n");
+		return false;
+	}
+
+	computeScopedVariableOffsets(&ctx, ctx.parser->pScopeGlobal);
+
+	ResolvePass resolvePass;
+	init(&resolvePass, &ctx);
+	Defer(dispose(&resolvePass));
+
+	doResolvePass(&resolvePass, ctx.rootNode);
+
+	if (resolvePass.hadError)
+		return false;
+
+	compileBytecode(pBuilder);
+
+	return tryVerifyBytecode(&pBuilder->bytecodeProgram, *ctx.typeTable);
+}
+
+// Adds every func the host can call to pProgram->aFunc
+
+static void buildFuncTable(MeekProgram * pProgram)
+{
+	const MeekCtx & ctx = pProgram->ctx;
+	const BytecodeProgram & bcp = pProgram->loaded.bcp;
+
+	for (int iBcf = 0; iBcf < bcp.bytecodeFuncs.cItem; iBcf++)
+	{
+		const BytecodeFunction & bcf = bcp.bytecodeFuncs[iBcf];
+		if (bcf.pFuncNode->astk != ASTK_FuncDefnStmt || isExternFunc(*bcf.pFuncNode))
+			continue;
+
+		auto * pStmt = Down(bcf.pFuncNode, FuncDefnStmt);
+
+		const FuncType * pFuncType = funcTypeFromDefnStmt(*ctx.typeTable, *pStmt);
+		if (!pFuncType || pFuncType->returnTypids.cItem > 1)
+			continue;
+
+		MEEKTYPE meektypeReturn = MEEKTYPE_Void;
+		if (pFuncType->returnTypids.cItem == 1)
+		{
+			meektypeReturn = meektypeFromTypid(pFuncType->returnTypids[0]);
+			if (meektypeReturn == MEEKTYPE_Max)
+				continue;
+		}
+
+		const DynamicArray<AstNode *> & apParamVarDecls = pStmt->pParamsReturnsGrp->apParamVarDecls;
+		int iParamFirst = pProgram->aParam.cItem;
+
+		bool isCallable = true;
+		for (int iParam = 0; iParam < apParamVarDecls.cItem; iParam++)
+		{
+			auto * pDecl = Down(apParamVarDecls[iParam], VarDeclStmt);
+
+			MeekParam param;
+			param.meektype = meektypeFromTypid(pDecl->typidDefn);
+			param.byteOffset = static_cast<int>(pDecl->byteOffset);
+
+			if (param.meektype == MEEKTYPE_Max)
+			{
+				isCallable = false;
+				break;
+			}
+
+			append(&pProgram->aParam, param);
+		}
+
+		if (!isCallable)
+		{
+			pProgram->aParam.cItem = iParamFirst;
+			continue;
+		}
+
+		const Scope & scopeFunc = *ctx.scopes[pStmt->pParamsReturnsGrp->scopeid];
+		Assert(scopeFunc.scopek == SCOPEK_FuncTopLevel);
+
+		MeekFunc * pFunc = appendNew(&pProgram->aFunc);
+		pFunc->strvName = pStmt->ident.lexeme.strv;
+		pFunc->funcid = pStmt->funcid;
+		pFunc->iParamFirst = iParamFirst;
+		pFunc->cParam = apParamVarDecls.cItem;
+		pFunc->meektypeReturn = meektypeReturn;
+		pFunc->cByteParam = static_cast<int>(scopeFunc.funcTopLevelData.cByteParam);
+		pFunc->cByteFrame = static_cast<int>(cByteFrame(scopeFunc));
+	}
+}
+
+MeekHostFuncs * meekCreateHostFuncs(void)
+{
+	auto * pHostFuncs = new MeekHostFuncs;
+	init(&pHostFuncs->registry);
+
+	return pHostFuncs;
+}
+
+void meekDestroyHostFuncs(MeekHostFuncs * pHostFuncs)
+{
+	if (!pHostFuncs)
+		return;
+
+	dispose(&pHostFuncs->registry);
+	delete pHostFuncs;
+}
+
+bool meekRegisterHostFunc(
+	MeekHostFuncs * pHostFuncs,
+	const char * pChzName,
+	const MEEKTYPE * aMeektypeParam,
+	int cParam,
+	MEEKTYPE meektypeReturn,
+	PFNMEEKHOSTFUNC pfn,
+	void * pContext)
+{
+	FuncType funcType;
+	init(&funcType);
+	Defer(dispose(&funcType));
+
+	for (int iParam = 0; iParam < cParam; iParam++)
+	{
+		if (aMeektypeParam[iParam] <= MEEKTYPE_Void || aMeektypeParam[iParam] >= MEEKTYPE_Max)
+		{
+			printfmt("Host func '%s': param %d has a bad type\n", pChzName, iParam);
+			return false;
+		}
+
+		append(&funcType.paramTypids, c_mpMeektypeTypid[aMeektypeParam[iParam]]);
+	}
+
+	if (meektypeReturn < MEEKTYPE_Void || meektypeReturn >= MEEKTYPE_Max)
+	{
+		printfmt("Host func '%s': return has a bad type\n", pChzName);
+		return false;
+	}
+
+	if (meektypeReturn != MEEKTYPE_Void)
+	{
+		append(&funcType.returnTypids, c_mpMeektypeTypid[meektypeReturn]);
+	}
+
+	return tryRegisterHostFunc(&pHostFuncs->registry, pChzName, funcType, pfn, pContext);
+}
+
+// Compiles, loads and binds pProgram's source. Whatever goes wrong is printed.
+
+static bool tryCompileAndLoad(MeekProgram * pProgram, const MeekHostFuncs * pHostFuncs)
+{
+	BytecodeBuilder bytecodeBuilder;
+	init(&bytecodeBuilder, &pProgram->ctx);
+	Defer(dispose(&bytecodeBuilder));
+
+	if (!tryCompile(&pProgram->ctx, &bytecodeBuilder))
+		return false;
+
+	init(&pProgram->loaded, bytecodeBuilder.bytecodeProgram, &pProgram->ctx);
+	pProgram->isLoaded = true;
+
+	if (!pProgram->loaded.areHostFuncsBound)
+	{
+		HostFuncRegistry registryEmpty;
+		init(&registryEmpty);
+		Defer(dispose(&registryEmpty));
+
+		const HostFuncRegistry & registry = (pHostFuncs) ? pHostFuncs->registry : registryEmpty;
+		if (!tryBindHostFuncs(&pProgram->loaded, registry, pProgram->ctx))
+			return false;
+	}
+
+	return pProgram->loaded.areGlobalsInitialized;
+}
+
+MeekProgram * meekCompileProgram(const char * pChSource, int cChSource, const MeekHostFuncs * pHostFuncs, char ** ppChzErrors)
+{
+	if (ppChzErrors)
+	{
+		*ppChzErrors = nullptr;
+	}
+
+	auto * pProgram = new MeekProgram;
+
+	pProgram->pChSource = new char[cChSource + 1];
+	memcpy(pProgram->pChSource, pChSource, cChSource);
+	pProgram->pChSource[cChSource] = '\0';
+
+	init(&pProgram->aFunc);
+	init(&pProgram->aParam);
+	init(&pProgram->ctx, pProgram->pChSource, cChSource);
+	pProgram->isLoaded = false;
+
+	// The compiler prints its errors, so they're captured here and handed back, rather than ending up on a stdout
+	//	that the host might not even have
+
+	String strErrors;
+	init(&strErrors);
+	Defer(dispose(&strErrors));
+
+	beginPrintCapture(&strErrors);
+	bool succeeded = tryCompileAndLoad(pProgram, pHostFuncs);
+	endPrintCapture();
+
+	if (!succeeded)
+	{
+		if (ppChzErrors)
+		{
+			*ppChzErrors = new char[strErrors.cChar + 1];
+			memcpy(*ppChzErrors, strErrors.pBuffer, strErrors.cChar + 1);
+		}
+
+		meekDestroyProgram(pProgram);
+		return nullptr;
+	}
+
+	buildFuncTable(pProgram);
+
+	return pProgram;
+}
+
+void meekFreeErrors(char * pChzErrors)
+{
+	delete[] pChzErrors;
+}
+
+void meekDestroyProgram(MeekProgram * pProgram)
+{
+	if (!pProgram)
+		return;
+
+	if (pProgram->isLoaded)
+	{
+		dispose(&pProgram->loaded);
+	}
+
+	dispose(&pProgram->ctx);
+	dispose(&pProgram->aFunc);
+	dispose(&pProgram->aParam);
+	delete[] pProgram->pChSource;
+	delete pProgram;
+}
+
+const MeekFunc * meekLookupFunc(
+	const MeekProgram * pProgram,
+	const char * pChzName,
+	const MEEKTYPE * aMeektypeParam,
+	int cParam,
+	MEEKTYPE meektypeReturn)
+{
+	for (int iFunc = 0; iFunc < pProgram->aFunc.cItem; iFunc++)
+	{
+		const MeekFunc & func = pProgram->aFunc[iFunc];
+		if (func.cParam != cParam || func.meektypeReturn != meektypeReturn || func.strvName != pChzName)
+			continue;
+
+		bool matches = true;
+		for (int iParam = 0; iParam < cParam; iParam++)
+		{
+			if (pProgram->aParam[func.iParamFirst + iParam].meektype != aMeektypeParam[iParam])
+			{
+				matches = false;
+				break;
+			}
+		}
+
+		if (matches)
+			return &func;
+	}
+
+	return nullptr;
+}
+
+MeekVm * meekCreateVm(const MeekProgram * pProgram)
+{
+	auto * pVm = new MeekVm;
+	pVm->pProgram = pProgram;
+	init(&pVm->interp, pProgram->loaded);
+
+	return pVm;
+}
+
+void meekDestroyVm(MeekVm * pVm)
+{
+	if (!pVm)
+		return;
+
+	dispose(&pVm->interp);
+	delete pVm;
+}
+
+bool meekCall(MeekVm * pVm, const MeekFunc * pFunc, const MeekValue * aArg, int cArg, MeekValue * poReturn)
+{
+	const MeekProgram & program = *pVm->pProgram;
+	Interpreter * pInterp = &pVm->interp;
+
+	AssertInfo(
+		pFunc >= program.aFunc.pBuffer && pFunc < program.aFunc.pBuffer + program.aFunc.cItem,
+		"Calling a func from some other program?");
+
+	if (cArg != pFunc->cParam)
+	{
+		printfmt("'%.*s' takes %d args, not %d\n", pFunc->strvName.cCh, pFunc->strvName.pCh, pFunc->cParam, cArg);
+		return false;
+	}
+
+	// Each call starts with an empty stack, and the args go where the func expects its params, see virtualAddress(..)
+
+	pInterp->pStack = pInterp->pStackBase;
+	pInterp->pStackFrame = pInterp->pStackBase;
+
+	for (int iArg = 0; iArg < cArg; iArg++)
+	{
+		const MeekParam & param = program.aParam[pFunc->iParamFirst + iArg];
+		if (aArg[iArg].meektype != param.meektype)
+		{
+			printfmt("Arg %d to '%.*s' is the wrong type\n", iArg, pFunc->strvName.cCh, pFunc->strvName.pCh);
+			return false;
+		}
+
+		memcpy(pInterp->pStackBase + param.byteOffset, &aArg[iArg].as, c_mpMeektypeCByte[param.meektype]);
+	}
+
+	pInterp->pStack += pFunc->cByteParam;
+	u8 * pStackFrameEnd = pInterp->pStack + pFunc->cByteFrame;
+
+	if (!interpret(pInterp, pFunc->funcid))
+		return false;
+
+	if (pFunc->meektypeReturn == MEEKTYPE_Void)
+		return true;
+
+	// A return stops the interpreter with its value right on top of the func's locals, see ASTK_ReturnStmt in
+	//	bytecode.cpp. Anything else means it ran off the end without returning.
+
+	int cByteReturn = c_mpMeektypeCByte[pFunc->meektypeReturn];
+	if (pInterp->pStack != pStackFrameEnd + cByteReturn)
+	{
+		printfmt("'%.*s' finished without returning anything\n", pFunc->strvName.cCh, pFunc->strvName.pCh);
+		return false;
+	}
+
+	if (poReturn)
+	{
+		poReturn->meektype = pFunc->meektypeReturn;
+		memcpy(&poReturn->as, pInterp->pStack - cByteReturn, cByteReturn);
+	}
+
+	return true;
+}
+
+void meekResetVm(MeekVm * pVm)
+{
+	reset(&pVm->interp);
+}
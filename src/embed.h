@@ -0,0 +1,159 @@
+#pragma once
+
+// Embedding API. Compile a program once, then call its funcs from the host as many times as you like. Plain C, so it
+//	can be called from anything that can call C. Hosts link against the meek static library (meek.vcxproj), which is
+//	everything but the command line driver and its benchmarks.
+//
+//	char * pChzErrors;
+//	MeekProgram * pProgram = meekCompileProgram(pChSource, cChSource, NULL, &pChzErrors);
+//	if (!pProgram)
+//		... show pChzErrors, then meekFreeErrors(pChzErrors)
+//
+//	MEEKTYPE aMeektypeParam[] = { MEEKTYPE_S32, MEEKTYPE_S32 };
+//	const MeekFunc * pFunc = meekLookupFunc(pProgram, "add", aMeektypeParam, 2, MEEKTYPE_S32);
+//
+//	MeekVm * pVm = meekCreateVm(pProgram);
+//	MeekValue aArg[2] = { { MEEKTYPE_S32 }, { MEEKTYPE_S32 } };
+//	aArg[0].as.s32 = 1;
+//	aArg[1].as.s32 = 2;
+//
+//	MeekValue valReturn;
+//	if (meekCall(pVm, pFunc, aArg, 2, &valReturn))
+//		... valReturn.as.s32 is 3
+//
+//	meekDestroyVm(pVm);
+//	meekDestroyProgram(pProgram);
+//
+// A MeekProgram never changes once it's compiled, so any number of threads can share one. A MeekVm is one thread's
+//	globals and stack, so give each thread its own. Compile errors come back from meekCompileProgram(..). Anything else
+//	that goes wrong is printed, and whatever failed returns null or false.
+//
+// Programs call back into the host through extern funcs, which the host provides when it compiles them:
+//
+//	extern fn clamp(int x, int lo, int hi) -> int;
+//
+//	static void clamp(uint8_t * pArgs, void * pContext)
+//	{
+//		int32_t a[3];
+//		memcpy(a, pArgs, sizeof(a));
+//		int32_t result = (a[0] < a[1]) ? a[1] : (a[0] > a[2]) ? a[2] : a[0];
+//		memcpy(pArgs, &result, sizeof(result));
+//	}
+//
+//	MeekHostFuncs * pHostFuncs = meekCreateHostFuncs();
+//	MEEKTYPE aMeektypeClamp[] = { MEEKTYPE_S32, MEEKTYPE_S32, MEEKTYPE_S32 };
+//	meekRegisterHostFunc(pHostFuncs, "clamp", aMeektypeClamp, 3, MEEKTYPE_S32, &clamp, NULL);
+//
+//	MeekProgram * pProgram = meekCompileProgram(pChSource, cChSource, pHostFuncs, NULL);
+//	meekDestroyHostFuncs(pHostFuncs);
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MeekProgram MeekProgram;
+typedef struct MeekFunc MeekFunc;
+typedef struct MeekVm MeekVm;
+typedef struct MeekHostFuncs MeekHostFuncs;
+
+typedef enum MEEKTYPE
+{
+	MEEKTYPE_Void,			// Only for a func's return, i.e., it doesn't return anything
+
+	MEEKTYPE_S8,
+	MEEKTYPE_S16,
+	MEEKTYPE_S32,			// int
+	MEEKTYPE_S64,
+	MEEKTYPE_U8,
+	MEEKTYPE_U16,
+	MEEKTYPE_U32,
+	MEEKTYPE_U64,
+	MEEKTYPE_F32,			// float
+	MEEKTYPE_F64,
+	MEEKTYPE_Bool,
+
+	MEEKTYPE_Max,
+} MEEKTYPE;
+
+typedef struct MeekValue
+{
+	MEEKTYPE meektype;
+
+	union
+	{
+		int8_t s8;
+		int16_t s16;
+		int32_t s32;
+		int64_t s64;
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+		float f32;
+		double f64;
+		bool b;
+	} as;
+} MeekValue;
+
+// A host func gets a pointer right into the vm's stack, where the program pushed its args: one after another in param
+//	order, each at its own size, no padding. If it returns something, it writes it starting at that same pointer, over
+//	the args. Only touch pArgs during the call.
+
+typedef void (*PFNMEEKHOSTFUNC)(uint8_t * pArgs, void * pContext);
+
+MeekHostFuncs * meekCreateHostFuncs(void);
+void meekDestroyHostFuncs(MeekHostFuncs * pHostFuncs);
+
+// Makes pfn the body of any extern fn called pChzName that takes exactly aMeektypeParam and returns meektypeReturn.
+//	pContext is handed back to pfn on every call. Returns false if there's already one with that name and params.
+
+bool meekRegisterHostFunc(
+	MeekHostFuncs * pHostFuncs,
+	const char * pChzName,
+	const MEEKTYPE * aMeektypeParam,
+	int cParam,
+	MEEKTYPE meektypeReturn,
+	PFNMEEKHOSTFUNC pfn,
+	void * pContext);
+
+// Compiles pChSource, which doesn't need to be null terminated and doesn't need to outlive the call. Every extern fn in
+//	it is bound to its host func in pHostFuncs, which can be null if there aren't any, and also doesn't need to outlive
+//	the call. Returns null if it doesn't compile, an extern has no matching host func, or a global initializer fails.
+//	If ppChzErrors isn't null, it's set to what went wrong, for you to free with meekFreeErrors(..), or to null if
+//	nothing did. Compiles don't share anything, so any number of threads can compile at once.
+
+MeekProgram * meekCompileProgram(const char * pChSource, int cChSource, const MeekHostFuncs * pHostFuncs, char ** ppChzErrors);
+void meekFreeErrors(char * pChzErrors);
+void meekDestroyProgram(MeekProgram * pProgram);
+
+// Func called pChzName that takes exactly aMeektypeParam and returns meektypeReturn, or null. Only funcs whose params
+//	and return are all primitives, with at most one return, can be called from the host, and externs can't be. Look
+//	funcs up once and hang on to them, it's a linear search.
+
+const MeekFunc * meekLookupFunc(
+	const MeekProgram * pProgram,
+	const char * pChzName,
+	const MEEKTYPE * aMeektypeParam,
+	int cParam,
+	MEEKTYPE meektypeReturn);
+
+// pProgram has to outlive the vm
+
+MeekVm * meekCreateVm(const MeekProgram * pProgram);
+void meekDestroyVm(MeekVm * pVm);
+
+// Runs pFunc with aArg, which have to match its params exactly. If it returns something and poReturn isn't null, it's
+//	written there. Globals carry over from one call to the next, until meekResetVm.
+
+bool meekCall(MeekVm * pVm, const MeekFunc * pFunc, const MeekValue * aArg, int cArg, MeekValue * poReturn);
+
+// Puts the globals back how they were before anything ran. Cheap, it's one memcpy.
+
+void meekResetVm(MeekVm * pVm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -39,6 +39,17 @@ void reportParseError(const Parser & parser, const AstNode & node, const char *
 	va_end(arglist);
 }
 
+void beginTypeError(const MeekCtx & ctx, int iText)
+{
+	printfmt("[Error: test.meek, line %d]\n", lineFromI(*ctx.scanner, iText));
+}
+
+void endTypeError()
+{
+	println();
+	println();
+}
+
 void reportIceAndExit(const char * errFormat, ...)
 {
 	print("[Internal compiler error]:\n");
@@ -3,6 +3,7 @@
 #include "als.h"
 
 struct AstNode;
+struct MeekCtx;
 struct Parser;
 struct Scanner;
 struct Token;
@@ -12,4 +13,10 @@ struct Token;
 void reportScanError(const Scanner & scanner, const Token & tokenErr, const char * errFormat, ...);
 void reportParseError(const Parser & parser, const AstNode & node, const char * errFormat, ...);
 
+// Type errors turn up once the whole program is parsed, so all we have is where in the text they are. The message is
+//	whatever gets printed between these.
+
+void beginTypeError(const MeekCtx & ctx, int iText);
+void endTypeError();
+
 void reportIceAndExit(const char * errFormat, ...);
@@ -1,37 +1,75 @@
 #include "global_context.h"
 
+#include "ast.h"
+#include "ast_decorate.h"
 #include "scan.h"
 #include "parse.h"
 #include "type.h"
 
-static Scanner g_scanner;
-static Parser g_parser;
-static TypeTable g_typeTable;
-static AstDecorations g_astDecs;
-
 void init(MeekCtx * pMeekCtx, char * pText, uint textSize)
 {
-	init(&g_scanner, pText, textSize);
-	init(&g_parser, pMeekCtx);
+	Scanner * pScanner = new Scanner;
+	Parser * pParser = new Parser;
+	TypeTable * pTypeTable = new TypeTable;
+	AstDecorations * pAstDecs = new AstDecorations;
+
+	init(pScanner, pText, textSize);
+	init(pParser, pMeekCtx);
 
 	init(&pMeekCtx->scopes);
-	Assert(pMeekCtx->scopes.cItem == g_parser.pScopeBuiltin->id);
-	Assert(pMeekCtx->scopes.cItem + 1 == g_parser.pScopeGlobal->id);
-	append(&pMeekCtx->scopes, g_parser.pScopeBuiltin);
-	append(&pMeekCtx->scopes, g_parser.pScopeGlobal);
+	Assert(pMeekCtx->scopes.cItem == pParser->pScopeBuiltin->id);
+	Assert(pMeekCtx->scopes.cItem + 1 == pParser->pScopeGlobal->id);
+	append(&pMeekCtx->scopes, pParser->pScopeBuiltin);
+	append(&pMeekCtx->scopes, pParser->pScopeGlobal);
 
-	init(&g_typeTable, pMeekCtx);
-	init(&g_astDecs);
+	init(pTypeTable, pMeekCtx);
+	init(pAstDecs);
 
 	init(&pMeekCtx->functions);
-	pMeekCtx->scanner = &g_scanner;
-	pMeekCtx->parser = &g_parser;
-	pMeekCtx->typeTable = &g_typeTable;
-	pMeekCtx->astDecorations = &g_astDecs;
+	pMeekCtx->scanner = pScanner;
+	pMeekCtx->parser = pParser;
+	pMeekCtx->typeTable = pTypeTable;
+	pMeekCtx->astDecorations = pAstDecs;
 
 	pMeekCtx->rootNode = nullptr;
 
 	pMeekCtx->mainFuncid = FuncId::Nil;
+
+	pMeekCtx->pReport = nullptr;
+}
+
+void dispose(MeekCtx * pMeekCtx)
+{
+	// Nodes and scopes go first, since the parser's allocators own them (or those of the chunks it parsed in parallel)
+
+	if (pMeekCtx->rootNode)
+	{
+		disposeAst(pMeekCtx->rootNode);
+	}
+
+	for (int iScope = SCOPEID_UserDefinedStart; iScope < pMeekCtx->scopes.cItem; iScope++)
+	{
+		dispose(pMeekCtx->scopes[iScope]);
+	}
+
+	dispose(pMeekCtx->scanner);
+	dispose(pMeekCtx->parser);
+	dispose(pMeekCtx->typeTable);
+	dispose(pMeekCtx->astDecorations);
+
+	delete pMeekCtx->scanner;
+	delete pMeekCtx->parser;
+	delete pMeekCtx->typeTable;
+	delete pMeekCtx->astDecorations;
+
+	dispose(&pMeekCtx->scopes);
+	dispose(&pMeekCtx->functions);
+
+	pMeekCtx->scanner = nullptr;
+	pMeekCtx->parser = nullptr;
+	pMeekCtx->typeTable = nullptr;
+	pMeekCtx->astDecorations = nullptr;
+	pMeekCtx->rootNode = nullptr;
 }
 
 AstNode * funcNodeFromFuncid(MeekCtx * pCtx, FuncId funcid)
@@ -6,6 +6,7 @@
 
 struct AstDecorations;
 struct AstNode;
+struct CompileReport;
 struct Scanner;
 struct Parser;
 struct Scope;
@@ -28,6 +29,8 @@ struct MeekCtx
 	DynamicArray<AstNode *> functions;
 	FuncId mainFuncid;
 
+	NULLABLE CompileReport * pReport;		// Phase timings etc., see report.h
+
 #ifdef _WIN64
 	static const int s_cBitTargetWord = 64;
 #elif WIN32
@@ -39,5 +42,8 @@ struct MeekCtx
 	static const int s_cBytePtr = (s_cBitTargetWord + 7) / 8;
 };
 
+// pText has to outlive the ctx, since tokens and the AST point into it
+
 void init(MeekCtx * pMeekCtx, char * pText, uint textSize);
+void dispose(MeekCtx * pMeekCtx);
 AstNode * funcNodeFromFuncid(MeekCtx * pCtx, FuncId funcid);
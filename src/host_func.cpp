@@ -0,0 +1,171 @@
+#include "host_func.h"
+
+#include "ast.h"
+#include "ast_decorate.h"
+#include "global_context.h"
+#include "interp.h"
+#include "print.h"
+
+#include <string.h>
+
+static bool isHostFuncTypid(TypeId typid)
+{
+	return typid >= TypeId::S8 && typid <= TypeId::Bool;
+}
+
+static bool areParamsEq(const FuncType & funcType0, const FuncType & funcType1)
+{
+	if (funcType0.paramTypids.cItem != funcType1.paramTypids.cItem)
+		return false;
+
+	for (int iParam = 0; iParam < funcType0.paramTypids.cItem; iParam++)
+	{
+		if (funcType0.paramTypids[iParam] != funcType1.paramTypids[iParam])
+			return false;
+	}
+
+	return true;
+}
+
+void init(HostFuncRegistry * pRegistry)
+{
+	init(&pRegistry->aHostFunc);
+}
+
+void dispose(HostFuncRegistry * pRegistry)
+{
+	for (int iHostFunc = 0; iHostFunc < pRegistry->aHostFunc.cItem; iHostFunc++)
+	{
+		HostFunc * pHostFunc = &pRegistry->aHostFunc[iHostFunc];
+		delete[] pHostFunc->pChzName;
+		dispose(&pHostFunc->funcType);
+	}
+
+	dispose(&pRegistry->aHostFunc);
+}
+
+bool tryRegisterHostFunc(
+	HostFuncRegistry * pRegistry,
+	const char * pChzName,
+	const FuncType & funcType,
+	PFNHOSTFUNC pfn,
+	void * pContext)
+{
+	Assert(pfn);
+
+	for (int iParam = 0; iParam < funcType.paramTypids.cItem; iParam++)
+	{
+		if (!isHostFuncTypid(funcType.paramTypids[iParam]))
+		{
+			printfmt("Host func '%s': param %d isn't an int, float or bool\n", pChzName, iParam);
+			return false;
+		}
+	}
+
+	for (int iReturn = 0; iReturn < funcType.returnTypids.cItem; iReturn++)
+	{
+		if (!isHostFuncTypid(funcType.returnTypids[iReturn]))
+		{
+			printfmt("Host func '%s': return %d isn't an int, float or bool\n", pChzName, iReturn);
+			return false;
+		}
+	}
+
+	for (int iHostFunc = 0; iHostFunc < pRegistry->aHostFunc.cItem; iHostFunc++)
+	{
+		const HostFunc & hostFunc = pRegistry->aHostFunc[iHostFunc];
+		if (strcmp(hostFunc.pChzName, pChzName) == 0 && areParamsEq(hostFunc.funcType, funcType))
+		{
+			printfmt("Host func '%s' is already registered with those params\n", pChzName);
+			return false;
+		}
+	}
+
+	int cCh = static_cast<int>(strlen(pChzName));
+
+	HostFunc * pHostFunc = appendNew(&pRegistry->aHostFunc);
+	pHostFunc->pChzName = new char[cCh + 1];
+	memcpy(pHostFunc->pChzName, pChzName, cCh + 1);
+	initCopy(&pHostFunc->funcType, funcType);
+	pHostFunc->pfn = pfn;
+	pHostFunc->pContext = pContext;
+
+	return true;
+}
+
+void computeHostCallSizes(const TypeTable & typeTable, const FuncType & funcType, int * poCByteArg, int * poCByteReturn)
+{
+	int cByteArg = 0;
+	for (int iParam = 0; iParam < funcType.paramTypids.cItem; iParam++)
+	{
+		cByteArg += lookupTypeInfo(typeTable, funcType.paramTypids[iParam]).size;
+	}
+
+	int cByteReturn = 0;
+	for (int iReturn = 0; iReturn < funcType.returnTypids.cItem; iReturn++)
+	{
+		cByteReturn += lookupTypeInfo(typeTable, funcType.returnTypids[iReturn]).size;
+	}
+
+	*poCByteArg = cByteArg;
+	*poCByteReturn = cByteReturn;
+}
+
+bool tryBindHostFuncs(LoadedProgram * pLoaded, const HostFuncRegistry & registry, const MeekCtx & ctx)
+{
+	Assert(pLoaded->mpFuncidHostCall.cItem == ctx.functions.cItem);
+
+	bool success = true;
+	bool hasExtern = false;
+
+	for (int iFunc = 0; iFunc < ctx.functions.cItem; iFunc++)
+	{
+		AstNode * pNode = ctx.functions[iFunc];
+		if (!isExternFunc(*pNode))
+			continue;
+
+		hasExtern = true;
+
+		auto * pDefn = Down(pNode, FuncDefnStmt);
+
+		const FuncType * pFuncType = funcTypeFromDefnStmt(*ctx.typeTable, *pDefn);
+		Assert(pFuncType);
+
+		const HostFunc * pHostFuncMatch = nullptr;
+		for (int iHostFunc = 0; iHostFunc < registry.aHostFunc.cItem; iHostFunc++)
+		{
+			const HostFunc & hostFunc = registry.aHostFunc[iHostFunc];
+			if (pDefn->ident.lexeme.strv == hostFunc.pChzName && funcTypeEq(hostFunc.funcType, *pFuncType))
+			{
+				pHostFuncMatch = &hostFunc;
+				break;
+			}
+		}
+
+		if (!pHostFuncMatch)
+		{
+			StringView strvName = pDefn->ident.lexeme.strv;
+			printfmt(
+				"No host func matches extern func '%.*s' (line %d)\n",
+				strvName.cCh,
+				strvName.pCh,
+				getStartLine(ctx, pNode->astid));
+
+			success = false;
+			continue;
+		}
+
+		HostCall * pHostCall = &pLoaded->mpFuncidHostCall[iFunc];
+		pHostCall->pfn = pHostFuncMatch->pfn;
+		pHostCall->pContext = pHostFuncMatch->pContext;
+	}
+
+	pLoaded->areHostFuncsBound = success;
+
+	// Global initializers might call externs, so if there are any, the initializers that don't fold had to wait until now
+
+	if (!success)
+		return false;
+
+	return !hasExtern || tryInitGlobals(pLoaded);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "als.h"
+#include "type.h"
+
+struct LoadedProgram;
+struct MeekCtx;
+
+// Host funcs
+//
+//	A program calls out to whatever is hosting it through extern funcs, which have a header and no body:
+//
+//		extern fn clamp(int x, int lo, int hi) -> int;
+//
+//	The host registers a native func with the same name and FuncType, and once the program is loaded each extern is
+//	bound to its host func, see tryBindHostFuncs(..). A call to an extern compiles to a single CallHost op.
+//
+//	The host func gets a pointer straight into the VM's stack, where the caller already pushed the args: one after
+//	another in param order, each at its own size, no padding. It writes its return (if any) starting at that same
+//	pointer, over the args. Nothing is copied on the way in or out, so a call is about as cheap as a call through a
+//	function pointer.
+//
+// NOTE (andrew) Host funcs run inside runGuarded(..). If one touches the VM's guard pages it's reported like any other
+//	fault in the VM, so don't let one hold anything that needs cleaning up while it pokes at pArgs.
+
+typedef void (*PFNHOSTFUNC)(u8 * pArgs, void * pContext);
+
+struct HostFunc
+{
+	char * pChzName;			// Our own copy
+	FuncType funcType;			// Built-in value types only, see tryRegisterHostFunc(..)
+	PFNHOSTFUNC pfn;
+	void * pContext;			// Handed back to pfn on every call
+};
+
+struct HostFuncRegistry
+{
+	DynamicArray<HostFunc> aHostFunc;
+};
+
+void init(HostFuncRegistry * pRegistry);
+void dispose(HostFuncRegistry * pRegistry);
+
+// Params and returns have to be ints, floats or bools, since every program numbers its other types differently.
+//	Overloads are fine, as long as no two host funcs share a name and params. Prints and returns false otherwise.
+
+bool tryRegisterHostFunc(
+	HostFuncRegistry * pRegistry,
+	const char * pChzName,
+	const FuncType & funcType,
+	PFNHOSTFUNC pfn,
+	void * pContext);
+
+// CallHost carries how many bytes of args and of return it moves as u16s, so that's the most either can be
+
+static const int c_cByteHostCallMax = 0xFFFF;
+
+// Bytes of args and of return a call to an extern with funcType moves, each packed at its own size
+
+void computeHostCallSizes(const TypeTable & typeTable, const FuncType & funcType, int * poCByteArg, int * poCByteReturn);
+
+// What CallHost needs to call an extern's host func
+
+struct HostCall
+{
+	PFNHOSTFUNC pfn;
+	void * pContext;
+};
+
+// Binds every extern func in the loaded program to the registered host func with its name and FuncType, then runs
+//	whatever global initializers were waiting on that, see tryInitGlobals(..). Prints each extern it can't bind and
+//	returns false if there were any, or if the initializers failed. A program with externs can't run until this
+//	succeeds, but the registry doesn't need to stick around afterwards.
+
+bool tryBindHostFuncs(LoadedProgram * pLoaded, const HostFuncRegistry & registry, const MeekCtx & ctx);
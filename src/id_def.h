@@ -60,6 +60,11 @@ enum class TypeId : u32
 
 	mFirstUserDefined,
 
+	// Typids handed out by a TypeInsertBuffer while the type table is read-only. Only meaningful to the buffer that
+	//	handed them out, and replaced with real typids when the buffer is flushed.
+
+	mFirstBuffered = 0x80'00'00'00,
+
 	Unresolved = Nil,
 
 	mFirstResolved = Void,
@@ -1,79 +1,288 @@
 #include "interp.h"
 
+#include "ast.h"
 #include "bytecode.h"
+#include "bytecode_verify.h"
 #include "global_context.h"
 #include "parse.h"
 #include "print.h"
 #include "symbol.h"
+#include "type.h"
 
 #include <inttypes.h>
 
-void init(Interpreter * pInterp, MeekCtx * pCtx)
+bool tryFoldGlobalInit(AstNode * pNode, TypeId typid, u8 * pB)
 {
-	constexpr int c_MiB = 1024 * 1024;
+	bool isNegated = false;
+	for (;;)
+	{
+		if (pNode->astk == ASTK_GroupExpr)
+		{
+			pNode = Down(pNode, GroupExpr)->pExpr;
+		}
+		else if (pNode->astk == ASTK_UnopExpr && Down(pNode, UnopExpr)->pOp->tokenk == TOKENK_Minus)
+		{
+			isNegated = !isNegated;
+			pNode = Down(pNode, UnopExpr)->pExpr;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	if (pNode->astk != ASTK_LiteralExpr)
+		return false;
+
+	auto * pExpr = Down(pNode, LiteralExpr);
+
+#define WriteFolded(type, value) \
+	do { \
+		type _value = static_cast<type>(value); \
+		memcpy(pB, &_value, sizeof(type)); } while (0)
+
+	switch (typid)
+	{
+		case TypeId::S8:
+		case TypeId::S16:
+		case TypeId::S32:
+		case TypeId::S64:
+		case TypeId::U8:
+		case TypeId::U16:
+		case TypeId::U32:
+		case TypeId::U64:
+		{
+			if (pExpr->literalk != LITERALK_Int)
+				return false;
+
+			s64 value = intValue(pExpr);
+			value = (isNegated) ? -value : value;
+
+			switch (typid)
+			{
+				case TypeId::S8:	WriteFolded(s8, value); break;
+				case TypeId::S16:	WriteFolded(s16, value); break;
+				case TypeId::S32:	WriteFolded(s32, value); break;
+				case TypeId::S64:	WriteFolded(s64, value); break;
+				case TypeId::U8:	WriteFolded(u8, value); break;
+				case TypeId::U16:	WriteFolded(u16, value); break;
+				case TypeId::U32:	WriteFolded(u32, value); break;
+				default:			WriteFolded(u64, value); break;
+			}
+		} break;
+
+		case TypeId::F32:
+		case TypeId::F64:
+		{
+			if (pExpr->literalk != LITERALK_Float)
+				return false;
+
+			double value = floatValue(pExpr);
+			value = (isNegated) ? -value : value;
+
+			if (typid == TypeId::F32)
+			{
+				WriteFolded(f32, value);
+			}
+			else
+			{
+				WriteFolded(f64, value);
+			}
+		} break;
+
+		case TypeId::Bool:
+		{
+			if (pExpr->literalk != LITERALK_Bool || isNegated)
+				return false;
+
+			WriteFolded(bool, boolValue(pExpr));
+		} break;
+
+		default:
+			return false;
+	}
+
+#undef WriteFolded
+
+	return true;
+}
+
+void init(LoadedProgram * pLoaded, const BytecodeProgram & bcp, MeekCtx * pCtx)
+{
+	initCopy(&pLoaded->bcp.bytes, bcp.bytes);
+	initCopy(&pLoaded->bcp.bytecodeFuncs, bcp.bytecodeFuncs);
+	initCopy(&pLoaded->bcp.sourceLineNumbers, bcp.sourceLineNumbers);
+	pLoaded->bcp.funcidGlobalInit = bcp.funcidGlobalInit;
+
+	pLoaded->funcidMain = pCtx->mainFuncid;
+
+	// Externs are unbound until tryBindHostFuncs(..)
+
+	int cFunc = pCtx->functions.cItem;
+
+	init(&pLoaded->mpFuncidHostCall);
+	ensureCapacity(&pLoaded->mpFuncidHostCall, cFunc);
+	pLoaded->mpFuncidHostCall.cItem = cFunc;
+	memset(pLoaded->mpFuncidHostCall.pBuffer, 0, cFunc * sizeof(HostCall));
+
+	pLoaded->areHostFuncsBound = true;
+	for (int iBcf = 0; iBcf < cFunc; iBcf++)
+	{
+		if (isExternFunc(*bcp.bytecodeFuncs[iBcf].pFuncNode))
+		{
+			pLoaded->areHostFuncsBound = false;
+			break;
+		}
+	}
+
+	// Globals start out zeroed, like locals without an initializer
 
 	Scope * pScopeGlobal = pCtx->parser->pScopeGlobal;		// TODO: put this somewhere other than parser...
+	int cByteGlobal = static_cast<int>(pScopeGlobal->globalData.cByteGlobalVariable);
+
+	init(&pLoaded->bytesGlobal);
+	ensureCapacity(&pLoaded->bytesGlobal, cByteGlobal);
+	pLoaded->bytesGlobal.cItem = cByteGlobal;
+	memset(pLoaded->bytesGlobal.pBuffer, 0, cByteGlobal);
+
+	// The ones that are just a literal are baked into the image here. Anything fancier was compiled into
+	//	bcp.funcidGlobalInit, see tryInitGlobals(..)
+
+	DynamicArray<SymbolInfo> aSymbInfo;
+	init(&aSymbInfo);
+	Defer(dispose(&aSymbInfo));
+
+	lookupAllVars(*pScopeGlobal, &aSymbInfo, FSYMBQ_IgnoreParent);
+
+	for (int iSymbInfo = 0; iSymbInfo < aSymbInfo.cItem; iSymbInfo++)
+	{
+		AstVarDeclStmt * pStmt = aSymbInfo[iSymbInfo].varData.pVarDeclStmt;
+		if (!pStmt->pInitExpr)
+			continue;
+
+		uintptr virtualAddressGlobal = virtualAddress(*pScopeGlobal, *pStmt);
+		Assert(virtualAddressGlobal + lookupTypeInfo(*pCtx->typeTable, pStmt->typidDefn).size <= uintptr(cByteGlobal));
+
+		tryFoldGlobalInit(pStmt->pInitExpr, pStmt->typidDefn, pLoaded->bytesGlobal.pBuffer + virtualAddressGlobal);
+	}
+
+	pLoaded->areGlobalsInitialized = (bcp.funcidGlobalInit == FuncId::Nil);
+
+	if (!pLoaded->areGlobalsInitialized && pLoaded->areHostFuncsBound)
+	{
+		tryInitGlobals(pLoaded);
+	}
+}
+
+void dispose(LoadedProgram * pLoaded)
+{
+	dispose(&pLoaded->bcp);
+	dispose(&pLoaded->bytesGlobal);
+	dispose(&pLoaded->mpFuncidHostCall);
+}
+
+void init(Interpreter * pInterp, const LoadedProgram & loaded)
+{
+	constexpr int c_MiB = 1024 * 1024;
+
+	pInterp->pLoaded = &loaded;
 
-	constexpr u64 cByteStack = c_MiB;
-	uintptr cByteGlobal = pScopeGlobal->globalData.cByteGlobalVariable;
+	// NOTE (andrew) This is only reserved, not committed, so it can be big. An interpreter that never goes deep only
+	//	ever uses the first chunk of it.
 
-	pInterp->pVirtualAddressSpace = new u8[cByteGlobal + cByteStack];
+	constexpr u64 cByteStack = 64 * c_MiB;
+	uintptr cByteGlobal = loaded.bytesGlobal.cItem;
+
+	init(&pInterp->memory, cByteGlobal, cByteStack);
+
+	pInterp->pVirtualAddressSpace = pInterp->memory.pBase;
 
 	pInterp->pGlobals = pInterp->pVirtualAddressSpace;
 
 	pInterp->pStackBase = pInterp->pVirtualAddressSpace + cByteGlobal;
+	pInterp->pStackMax = pInterp->pStackBase + cByteStack;
+
+	reset(pInterp);
+}
+
+void reset(Interpreter * pInterp)
+{
+	const LoadedProgram & loaded = *pInterp->pLoaded;
+	memcpy(pInterp->pGlobals, loaded.bytesGlobal.pBuffer, loaded.bytesGlobal.cItem);
+
 	pInterp->pStack = pInterp->pStackBase;
 	pInterp->pStackFrame = pInterp->pStackBase;
 
 	// NOTE: We set this in interpret(..) ... might make more sense to set it here?
 
 	pInterp->ip = nullptr;
+	pInterp->cDispatch = 0;
 }
 
 void dispose(Interpreter * pInterp)
 {
-	delete[] pInterp->pVirtualAddressSpace;
+	dispose(&pInterp->memory);
 
+	pInterp->pVirtualAddressSpace = nullptr;
+	pInterp->pGlobals = nullptr;
 	pInterp->pStackBase = nullptr;
+	pInterp->pStackMax = nullptr;
 	pInterp->pStack = nullptr;
 	pInterp->pStackFrame = nullptr;
+	pInterp->pLoaded = nullptr;
 }
 
-void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpStart)
+// Runs from pInterp->ip until DebugExit. Called through runGuarded(..), so it can stop anywhere if it touches a guard
+//	page. Don't give it anything that needs cleaning up.
+
+static void runUntilExit(void * pInterp_)
 {
-	pInterp->ip = bcp.bytes.pBuffer + iByteIpStart;
+	auto * pInterp = reinterpret_cast<Interpreter *>(pInterp_);
 
 #define ReadVarFromBytecode(type, var) \
 	do { \
-		memcpy(&var, pInterp->ip, sizeof(type)); \
-		pInterp->ip += sizeof(type); } while (0)
+		memcpy(&var, ip, sizeof(type)); \
+		ip += sizeof(type); } while (0)
 
 #define WriteBytecodeBytesToStack(type) \
 	do { \
-		memcpy(pInterp->pStack, pInterp->ip, sizeof(type)); \
-		pInterp->ip += sizeof(type); \
-		pInterp->pStack += sizeof(type); } while(0)
+		memcpy(pStack, ip, sizeof(type)); \
+		ip += sizeof(type); \
+		pStack += sizeof(type); } while(0)
 
 #define WriteVarToStack(type, var) \
 	do { \
-		memcpy(pInterp->pStack, &var, sizeof(type)); \
-		pInterp->pStack += sizeof(type); } while (0)
+		memcpy(pStack, &var, sizeof(type)); \
+		pStack += sizeof(type); } while (0)
 
 #define ReadVarFromStack(type, var) \
 	do { \
-		pInterp->pStack = pInterp->pStack - sizeof(type); \
-		memcpy(&var, pInterp->pStack, sizeof(type)); } while (0)
+		pStack = pStack - sizeof(type); \
+		memcpy(&var, pStack, sizeof(type)); } while (0)
 
 #define PeekVarFromStack(type, var) \
 	do { \
-		memcpy(&var, pInterp->pStack - sizeof(type), sizeof(type)); } while (0)
+		memcpy(&var, pStack - sizeof(type), sizeof(type)); } while (0)
 
 
+	// NOTE (andrew) Counted in a local so it can live in a register, the loop is hot enough that it matters. Same goes
+	//	for ip, pStack and the address space, which the compiler would otherwise reload from pInterp after every memcpy
+	//	since it can't tell the stack doesn't alias them. They're written back when the loop exits. ip is also written
+	//	back at the top of every op (but never read back), so if an op faults pInterp->ip is the start of that op.
+
+	s64 cDispatch = 0;
+	u8 * ip = pInterp->ip;
+	u8 * pStack = pInterp->pStack;
+	u8 * pVirtualAddressSpace = pInterp->pVirtualAddressSpace;
+
 	bool run = true;
 	while (run)
 	{
-		BCOP bcop = BCOP(*pInterp->ip);
-		pInterp->ip++;
+		pInterp->ip = ip;
+
+		BCOP bcop = BCOP(*ip);
+		ip++;
+		cDispatch++;
 
 		switch (bcop)
 		{
@@ -99,14 +308,14 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 
 			case BCOP_LoadTrue:
 			{
-				*pInterp->pStack = true;
-				pInterp->pStack++;
+				*pStack = true;
+				pStack++;
 			} break;
 
 			case BCOP_LoadFalse:
 			{
-				*pInterp->pStack = false;
-				pInterp->pStack++;
+				*pStack = false;
+				pStack++;
 			} break;
 
 
@@ -114,7 +323,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 	do { \
 		uintptr _virtAddr; \
 		ReadVarFromStack(uintptr, _virtAddr); \
-		type _value = *reinterpret_cast<type *>(pInterp->pVirtualAddressSpace + _virtAddr); \
+		type _value = *reinterpret_cast<type *>(pVirtualAddressSpace + _virtAddr); \
 		WriteVarToStack(type, _value); } while(0)
 
 			case BCOP_Load8:
@@ -145,7 +354,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 		uintptr _virtAddr; \
 		ReadVarFromStack(type, _value); \
 		ReadVarFromStack(uintptr, _virtAddr); \
-		*reinterpret_cast<type *>(pInterp->pVirtualAddressSpace + _virtAddr) = _value; } while (0)
+		*reinterpret_cast<type *>(pVirtualAddressSpace + _virtAddr) = _value; } while (0)
 
 			case BCOP_Store8:
 			{
@@ -542,7 +751,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 			{
 				s16 bytesToJump;
 				ReadVarFromBytecode(s16, bytesToJump);
-				pInterp->ip += bytesToJump;
+				ip += bytesToJump;
 			} break;
 
 			case BCOP_JumpIfFalse:
@@ -555,7 +764,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 
 				if (!boolVal)
 				{
-					pInterp->ip += bytesToJump;
+					ip += bytesToJump;
 				}
 			} break;
 
@@ -569,7 +778,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 
 				if (!boolVal)
 				{
-					pInterp->ip += bytesToJump;
+					ip += bytesToJump;
 				}
 			} break;
 
@@ -583,7 +792,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 
 				if (boolVal)
 				{
-					pInterp->ip += bytesToJump;
+					ip += bytesToJump;
 				}
 			} break;
 
@@ -592,7 +801,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 				uintptr bytesToReserve;
 				ReadVarFromBytecode(uintptr, bytesToReserve);
 
-				pInterp->pStack += bytesToReserve;
+				pStack += bytesToReserve;
 			} break;
 
 			case BCOP_StackFree:
@@ -600,7 +809,7 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 				uintptr bytesToFree;
 				ReadVarFromBytecode(uintptr, bytesToFree);
 
-				pInterp->pStack -= bytesToFree;
+				pStack -= bytesToFree;
 			} break;
 
 			case BCOP_Call:
@@ -608,6 +817,22 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 				AssertTodo;
 			} break;
 
+			case BCOP_CallHost:
+			{
+				FuncId funcid;
+				u16 cByteArg;
+				u16 cByteReturn;
+				ReadVarFromBytecode(FuncId, funcid);
+				ReadVarFromBytecode(u16, cByteArg);
+				ReadVarFromBytecode(u16, cByteReturn);
+
+				const HostCall & hostCall = pInterp->pLoaded->mpFuncidHostCall.pBuffer[static_cast<int>(funcid)];
+
+				u8 * pArgs = pStack - cByteArg;
+				hostCall.pfn(pArgs, hostCall.pContext);
+				pStack = pArgs + cByteReturn;
+			} break;
+
 			case BCOP_Return0:
 			{
 				AssertTodo;
@@ -743,21 +968,143 @@ void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpSt
 #undef ReadVarFromStack
 #undef PeekVarFromStack
 	}
+
+	pInterp->pStack = pStack;
+	pInterp->ip = ip;
+	pInterp->cDispatch = cDispatch;
+}
+
+static void reportVmFault(const Interpreter & interp, const BytecodeProgram & bcp, u8 * pFault)
+{
+	// ip is left at the start of the op that faulted
+
+	int iByte = static_cast<int>(interp.ip - bcp.bytes.pBuffer);
+	const BytecodeFunction * pBcf = pBcfFromIByte(bcp, iByte);
+	StringView strvName = (pBcf) ? strvFuncName(*pBcf) : StringView();
+
+	printfmt(
+		"%s at %.*s:%d\n",
+		(pFault >= interp.memory.pMax) ? "Stack overflow" : "Bad memory access",
+		strvName.cCh,
+		strvName.pCh,
+		lineFromIByte(bcp, iByte));
+}
+
+// interpret(..) minus checking that the program is done loading, so that tryInitGlobals(..) can use it
+
+static bool tryInterpretFunc(Interpreter * pInterp, FuncId funcid)
+{
+	const BytecodeProgram & bcp = pInterp->pLoaded->bcp;
+
+	// NOTE (andrew) Funcs are numbered in the order they're emitted, so the funcid is the index of the func's bytecode
+
+	AssertInfo((u32)funcid < (u32)bcp.bytecodeFuncs.cItem, "Interpreting a func that isn't in the program?");
+	const BytecodeFunction * pBcf = &bcp.bytecodeFuncs[(int)funcid];
+
+	AssertInfo(pBcf->cByteStackMax >= 0, "Interpreting bytecode that wasn't verified");
+
+	// NOTE (andrew) The verifier worked out the most stack the func can ever use, so a func that can't fit is caught
+	//	here before it starts. Nothing inside the loop checks pStack, anything that gets past this (e.g., deep recursion,
+	//	once there are calls) runs into the guard page above the stack instead.
+
+	if (pBcf->cByteStackMax > pInterp->pStackMax - pInterp->pStack)
+	{
+		StringView strvName = strvFuncName(*pBcf);
+		printfmt(
+			"Stack overflow: '%.*s' needs %d bytes of stack, only %d are left\n",
+			strvName.cCh,
+			strvName.pCh,
+			pBcf->cByteStackMax,
+			static_cast<int>(pInterp->pStackMax - pInterp->pStack));
+
+		return false;
+	}
+
+	pInterp->ip = bcp.bytes.pBuffer + pBcf->iByte0;
+
+	u8 * pFault;
+	if (!runGuarded(&pInterp->memory, &runUntilExit, pInterp, &pFault))
+	{
+		reportVmFault(*pInterp, bcp, pFault);
+		return false;
+	}
+
+	return true;
 }
 
-uintptr virtualAddressStart(const Scope & scope)
+bool interpret(Interpreter * pInterp, FuncId funcid)
 {
-	uintptr offset = 0;
-	Scope * pScopeParent = scope.pScopeParent;
+	if (!pInterp->pLoaded->areHostFuncsBound)
+	{
+		print("Can't run a program whose extern funcs aren't bound to host funcs\n");
+		return false;
+	}
 
-	while (pScopeParent)
+	if (!pInterp->pLoaded->areGlobalsInitialized)
 	{
-		// FIXME: This will break. Need to consider params, return values, return address, etc. all
-		//	on the stack.
+		print("Can't run a program whose globals didn't finish initializing\n");
+		return false;
+	}
+
+	return tryInterpretFunc(pInterp, funcid);
+}
+
+bool tryInitGlobals(LoadedProgram * pLoaded)
+{
+	Assert(pLoaded->areHostFuncsBound);
+
+	if (pLoaded->areGlobalsInitialized)
+		return true;
+
+	// NOTE (andrew) Runs on an interpreter of its own, which starts from the folded image, then its globals become the
+	//	image. Only has to happen once per loaded program, so reserving a whole interpreter's memory for it is fine.
+
+	Interpreter interp;
+	init(&interp, *pLoaded);
+	Defer(dispose(&interp));
+
+	if (!tryInterpretFunc(&interp, pLoaded->bcp.funcidGlobalInit))
+		return false;
 
-		offset += cByteLocalVars(*pScopeParent);
-		pScopeParent = pScopeParent->pScopeParent;
+	memcpy(pLoaded->bytesGlobal.pBuffer, interp.pGlobals, pLoaded->bytesGlobal.cItem);
+	pLoaded->areGlobalsInitialized = true;
+
+	return true;
+}
+
+uintptr virtualAddress(const Scope & scope, const AstVarDeclStmt & decl)
+{
+	if (scope.scopek == SCOPEK_Global)
+		return decl.byteOffset;
+
+	// NOTE (andrew) Nothing emits calls yet, so every func runs as the only func on the stack and its frame always starts
+	//	right after the globals: its args, which whoever starts it pushes first, then the locals its body block
+	//	StackAllocs. Inner scopes are laid out in the locals by computeFrameLayout(..)
+	//
+	// FIXME: Once there are calls this has to be relative to the frame pointer instead
+
+	const Scope * pScopeFunc = &scope;
+	while (pScopeFunc->scopek != SCOPEK_FuncTopLevel)
+	{
+		pScopeFunc = pScopeFunc->pScopeParent;
 	}
 
-	return offset;
+	const Scope * pScopeGlobal = pScopeFunc;
+	while (pScopeGlobal->scopek != SCOPEK_Global)
+	{
+		pScopeGlobal = pScopeGlobal->pScopeParent;
+	}
+
+	uintptr virtualAddressFrame = pScopeGlobal->globalData.cByteGlobalVariable;
+
+	if (decl.vardeclk == VARDECLK_Param)
+	{
+		Assert(&scope == pScopeFunc);
+		return virtualAddressFrame + decl.byteOffset;
+	}
+
+	uintptr virtualAddressLocals = virtualAddressFrame + pScopeFunc->funcTopLevelData.cByteParam;
+	uintptr byteOffsetScope = (scope.scopek == SCOPEK_FuncInner) ? scope.funcInnerData.byteOffsetFrame : 0;
+
+	return virtualAddressLocals + byteOffsetScope + decl.byteOffset;
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "als.h"
+#include "bytecode.h"
+#include "host_func.h"
 #include "id_def.h"
+#include "vm_memory.h"
 
-struct BytecodeProgram;
+struct AstVarDeclStmt;
 struct MeekCtx;
 struct Scope;
 
@@ -32,24 +35,77 @@ struct Scope;
 //	} valueAs;
 //};
 
+// Everything an interpreter needs from a compiled program. Nothing changes it once it's loaded, so any number of
+//	interpreters on any number of threads can run it at once.
+//
+// NOTE (andrew) It has its own copy of the bytecode, but func names for error messages still come from the AST (see
+//	strvFuncName(..)), so the MeekCtx has to outlive it.
+
+struct LoadedProgram
+{
+	BytecodeProgram bcp;
+	DynamicArray<u8> bytesGlobal;	// Globals as they are before anything runs. Every interpreter starts from a copy.
+	FuncId funcidMain;				// FuncId::Nil if there isn't one
+
+	DynamicArray<HostCall> mpFuncidHostCall;	// Only externs have one, see tryBindHostFuncs(..)
+	bool areHostFuncsBound;						// Trivially true if there aren't any externs
+	bool areGlobalsInitialized;					// Once bytesGlobal has every global's initial value, see tryInitGlobals(..)
+};
+
+// bcp has to have been through tryVerifyBytecode(..). If the program has any extern funcs, it also needs to go through
+//	tryBindHostFuncs(..) before it can run.
+
+void init(LoadedProgram * pLoaded, const BytecodeProgram & bcp, MeekCtx * pCtx);
+void dispose(LoadedProgram * pLoaded);
+
+// Globals whose initializer is a literal are written straight into the image, see tryFoldGlobalInit(..). The rest are
+//	compiled into bcp.funcidGlobalInit, which this runs once to finish off the image. init(..) calls this itself, unless
+//	the program has externs, in which case tryBindHostFuncs(..) calls it after binding them, since an initializer might
+//	call one. Prints and returns false if the initializers didn't run to the end, and the program won't run after that.
+
+bool tryInitGlobals(LoadedProgram * pLoaded);
+
+// Works out a global's initial value if it can be done without running anything, i.e., it's a literal, maybe negated
+//	or in parens. Writes it to pB in typid's representation, which is at most 8 bytes.
+
+bool tryFoldGlobalInit(AstNode * pNode, TypeId typid, u8 * pB);
+
+// One run of a loaded program at a time. Owns its globals and stack and nothing else, so give each thread its own.
+
 struct Interpreter
 {
-	MeekCtx * pCtx = nullptr;
+	const LoadedProgram * pLoaded = nullptr;
 
-	u8 * pVirtualAddressSpace;
+	VmMemory memory;
+	u8 * pVirtualAddressSpace;	// memory.pBase
 
 	u8 * pGlobals;
 
 	u8 * pStack;
 	u8 * pStackBase;
+	u8 * pStackMax;				// One past the end of the stack
 	u8 * pStackFrame;
 
 	u8 * ip;
+
+	s64 cDispatch = 0;			// Ops run by the last call to interpret(..)
 };
 
-void init(Interpreter * pInterp, MeekCtx * pCtx);
+void init(Interpreter * pInterp, const LoadedProgram & loaded);
 void dispose(Interpreter * pInterp);
 
-void interpret(Interpreter * pInterp, const BytecodeProgram & bcp, int iByteIpStart);
+// Puts the globals back to the loaded program's image and empties the stack, so the interpreter can be used for another
+//	run without reserving its memory again. Fine to call after a run that failed.
+
+void reset(Interpreter * pInterp);
+
+// funcid has to be a func in the loaded program, and the program has to be done loading, i.e., its externs are bound
+//	and its globals are initialized. Returns false if it couldn't run the func, i.e.,
+//	there's not enough stack left for it, or if the func ran off the end of the stack (or any other part of the
+//	interpreter's memory) partway through. Either way it prints where.
+
+bool interpret(Interpreter * pInterp, FuncId funcid);
+
+// Where a var lives in an interpreter's address space
 
-uintptr virtualAddressStart(const Scope & scope);
\ No newline at end of file
+uintptr virtualAddress(const Scope & scope, const AstVarDeclStmt & decl);
\ No newline at end of file
@@ -2,20 +2,91 @@
 
 #include "ast.h"
 #include "ast_print.h"
+#include "bench.h"
 #include "bytecode.h"
+#include "bytecode_verify.h"
 #include "error.h"
 #include "global_context.h"
+#include "host_func.h"
 #include "interp.h"
 #include "parse.h"
 #include "print.h"
+#include "program_gen.h"
+#include "report.h"
 #include "resolve.h"
 #include "scan.h"
 #include "symbol.h"
+#include "type.h"
 
 #include <stdio.h>
 
 int main()
 {
+	// Turn this on to benchmark compile throughput on generated programs instead of compiling a file, see bench.h
+
+	static const bool s_benchmarksCompile = false;
+
+	if (s_benchmarksCompile)
+	{
+		ProgramGenParams params;
+		init(&params);
+
+		bool succeeded = runCompileBenchmark(params, 1000, 1000000);
+
+		// Same again with thousands of globals. Laying them out sorts every one by varseqid, so computeOffsets is the
+		//	phase to watch. The sorts themselves are timed against each other in runAlsBenchmark(..).
+		//
+		// NOTE (andrew) Globals are cheap lines that don't grow with the program, so starting small makes the phases
+		//	that only care about funcs look superlinear. Start once funcs are most of the program.
+
+		params.cGlobal = 8192;
+		succeeded = runCompileBenchmark(params, 100000, 1000000) && succeeded;
+
+		return (succeeded) ? 0 : 1;
+	}
+
+	// Turn this on to time the interpreter on the programs in examples/bench instead, see bench.h
+
+	static const bool s_benchmarksVm = false;
+
+	if (s_benchmarksVm)
+	{
+		VmBenchParams params;
+		init(&params);
+		params.pChzDir = "W:/Meek/examples/bench/";
+
+		return (runVmBenchmark(params)) ? 0 : 1;
+	}
+
+	// Turn this on to see how the interpreter scales running those same programs from lots of threads at once
+
+	static const bool s_benchmarksVmThroughput = false;
+
+	if (s_benchmarksVmThroughput)
+	{
+		return (runVmThroughputBenchmark("W:/Meek/examples/bench/", 16)) ? 0 : 1;
+	}
+
+	// Turn this on to time calls into a program from the host through the embedding API, see embed.h
+
+	static const bool s_benchmarksEmbed = false;
+
+	if (s_benchmarksEmbed)
+	{
+		return (runEmbedBenchmark(1000000)) ? 0 : 1;
+	}
+
+	// Turn this on to time the als containers and allocators instead, once with everything in cache and once without
+
+	static const bool s_benchmarksAls = false;
+
+	if (s_benchmarksAls)
+	{
+		runAlsBenchmark(1024);
+		runAlsBenchmark(1024 * 1024);
+		return 0;
+	}
+
 	// TODO: Read file in from command line
 
 #if 1
@@ -56,15 +127,43 @@ int main()
 		return 1;
 	}
 
+	// NOTE (andrew) Pipelined overlaps scanning with parsing, and emitting bytecode with resolving. Turn it off to run
+	//	each phase to completion before starting the next, which is a lot easier to step through.
+
+	static const bool s_pipelined = true;
+
+	// Layout for structs that don't ask for one. Set this to STRUCTLAYOUTK_Reordered to minimize padding everywhere
+	//	without touching the program, see STRUCTLAYOUTK.
+
+	static const STRUCTLAYOUTK s_structlayoutkDefault = STRUCTLAYOUTK_Declared;
+
+	// Turn this on to print how long each phase took, how much memory it used, etc. and write the same as JSON
+
+	static const bool s_reportsPhases = false;
+	static const char * s_pChzReportFilename = "compile_report.json";
+
 	MeekCtx ctx;
 	init(&ctx, buffer, bytesRead);
+	ctx.typeTable->structlayoutkDefault = s_structlayoutkDefault;
+
+	CompileReport report;
+	if (s_reportsPhases)
+	{
+		init(&report);
+		ctx.pReport = &report;
+	}
 
 	AstNode * rootNode = nullptr;
 	{
 		printfmt("Parsing %s...\n", filename);
 
+		ctx.parser->scansAhead = s_pipelined;
+
 		bool success;
+
+		beginPhase(ctx.pReport, PHASEK_Parse);
 		rootNode = parseProgram(ctx.parser, &success);
+		endPhase(ctx.pReport, PHASEK_Parse);
 
 		if (!success)
 		{
@@ -90,13 +189,20 @@ int main()
 #endif
 
 	print("Running resolve pass...\n");
-	if (!tryResolveAllTypes(ctx.typeTable))
+
+	beginPhase(ctx.pReport, PHASEK_ResolveTypes);
+	bool resolvedTypes = tryResolveAllTypes(ctx.typeTable);
+	endPhase(ctx.pReport, PHASEK_ResolveTypes);
+
+	if (!resolvedTypes)
 	{
 		print("Unable to resolve some types\n");
 		return 1;
 	}
 
+	beginPhase(ctx.pReport, PHASEK_ComputeOffsets);
 	computeScopedVariableOffsets(&ctx, ctx.parser->pScopeGlobal);
+	endPhase(ctx.pReport, PHASEK_ComputeOffsets);
 
 	// TODO (andrew) Probably just eagerly insert func names into the symbol table like we do for others, and generate types pending resolution
 	//	that will poke in the typid's of the args. Then, this function could be a simple audit to make sure that there are no redefined funcs.
@@ -110,36 +216,87 @@ int main()
 
 	ResolvePass resolvePass;
 	init(&resolvePass, &ctx);
-	doResolvePass(&resolvePass, rootNode);
-
-	print("Done\n");
-	println();
-
-	print("Compiling bytecode...\n");
 
 	BytecodeBuilder bytecodeBuilder;
 	init(&bytecodeBuilder, &ctx);
 
-	compileBytecode(&bytecodeBuilder);
+	if (s_pipelined)
+	{
+		print("Compiling bytecode as it resolves...\n");
 
-	print("Done\n");
-	println();
+		beginPhase(ctx.pReport, PHASEK_Resolve);
+		resolveAndCompileBytecode(&bytecodeBuilder, &resolvePass);
+		endPhase(ctx.pReport, PHASEK_Resolve);
+
+		if (resolvePass.hadError)
+			return 1;
+
+		print("Done\n");
+		println();
+	}
+	else
+	{
+		beginPhase(ctx.pReport, PHASEK_Resolve);
+		doResolvePass(&resolvePass, rootNode);
+		endPhase(ctx.pReport, PHASEK_Resolve);
+
+		if (resolvePass.hadError)
+			return 1;
+
+		print("Done\n");
+		println();
+
+		print("Compiling bytecode...\n");
+
+		beginPhase(ctx.pReport, PHASEK_Emit);
+		compileBytecode(&bytecodeBuilder);
+		endPhase(ctx.pReport, PHASEK_Emit);
+
+		print("Done\n");
+		println();
+	}
+
+	// NOTE (andrew) The builder shouldn't ever emit something the verifier rejects, but the interpreter doesn't check
+	//	anything itself, so it's not worth finding out the hard way.
+
+	beginPhase(ctx.pReport, PHASEK_Verify);
+	bool verified = tryVerifyBytecode(&bytecodeBuilder.bytecodeProgram, *ctx.typeTable);
+	endPhase(ctx.pReport, PHASEK_Verify);
+
+	if (!verified)
+		return 1;
 
 #if 0
 	disassemble(bytecodeBuilder.bytecodeProgram);
 #else
 
-	if (ctx.mainFuncid != FuncId::Nil)
+	LoadedProgram loaded;
+	init(&loaded, bytecodeBuilder.bytecodeProgram, &ctx);
+	Defer(dispose(&loaded));
+
+	// NOTE (andrew) Nothing is hosting us from the command line, so a program with extern funcs stops here. See embed.h
+
+	HostFuncRegistry hostFuncs;
+	init(&hostFuncs);
+	Defer(dispose(&hostFuncs));
+
+	if (!tryBindHostFuncs(&loaded, hostFuncs, ctx))
+		return 1;
+
+	if (loaded.funcidMain != FuncId::Nil)
 	{
 		print("Running interpreter...\n");
 
 		Interpreter interp;
-		init(&interp, &ctx);
+		init(&interp, loaded);
+		Defer(dispose(&interp));
 
-		interpret(
-			&interp,
-			bytecodeBuilder.bytecodeProgram,
-			bytecodeBuilder.bytecodeProgram.bytecodeFuncs[(int)ctx.mainFuncid].iByte0);
+		beginPhase(ctx.pReport, PHASEK_Interpret);
+		bool ran = interpret(&interp, loaded.funcidMain);
+		endPhase(ctx.pReport, PHASEK_Interpret);
+
+		if (!ran)
+			return 1;
 
 		print("Done\n");
 		println();
@@ -151,6 +308,16 @@ int main()
 	}
 #endif
 
+	if (ctx.pReport)
+	{
+		printReport(report, ctx, &bytecodeBuilder.bytecodeProgram);
+		println();
+
+		if (!tryWriteReportJson(report, ctx, &bytecodeBuilder.bytecodeProgram, s_pChzReportFilename))
+		{
+			printfmt("Couldn't write %s\n", s_pChzReportFilename);
+		}
+	}
 
 	// DebugPrintCtx dpc;
 	// init(&dpc, &ctx);
@@ -0,0 +1,63 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <thread>
+
+int cWorkerMax()
+{
+	static const int s_cWorkerMax = Max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	return s_cWorkerMax;
+}
+
+void parallelFor(int cItem, PFNPARALLELJOB pfnJob, void * pContext, int cItemPerWorkerMin)
+{
+	Assert(cItemPerWorkerMin > 0);
+
+	if (cItem <= 0)
+		return;
+
+	int cWorker = Min(cWorkerMax(), (cItem + cItemPerWorkerMin - 1) / cItemPerWorkerMin);
+	if (cWorker <= 1)
+	{
+		for (int iItem = 0; iItem < cItem; iItem++)
+		{
+			pfnJob(pContext, iItem, 0);
+		}
+
+		return;
+	}
+
+	// NOTE (andrew) Items are handed out one at a time rather than in fixed ranges. Per-item cost varies a lot (one
+	//	huge func next to hundreds of tiny ones), and the counter is nowhere near contended at this granularity.
+
+	std::atomic<int> iItemNext(0);
+
+	auto runWorker = [&](int iWorker)
+	{
+		for (;;)
+		{
+			int iItem = iItemNext.fetch_add(1, std::memory_order_relaxed);
+			if (iItem >= cItem)
+				break;
+
+			pfnJob(pContext, iItem, iWorker);
+		}
+	};
+
+	DynamicArray<std::thread *> apThread;
+	init(&apThread);
+	Defer(dispose(&apThread));
+
+	for (int iWorker = 1; iWorker < cWorker; iWorker++)
+	{
+		append(&apThread, new std::thread(runWorker, iWorker));
+	}
+
+	runWorker(0);
+
+	for (int iThread = 0; iThread < apThread.cItem; iThread++)
+	{
+		apThread[iThread]->join();
+		delete apThread[iThread];
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "als.h"
+
+// Stupidly simple data parallelism. No persistent pool: each call spins up workers, hands out items from a shared
+//	counter, and joins before returning. Phases are coarse (one call per compiler pass), so the spin up cost is noise.
+
+typedef void (*PFNPARALLELJOB)(void * pContext, int iItem, int iWorker);
+
+int cWorkerMax();
+
+// Calls pfnJob once for every iItem in [0, cItem). The calling thread is worker 0. iWorker is in [0, cWorkerMax()) and
+//	is stable for the duration of a job, so jobs can index per-worker scratch with it. cItemPerWorkerMin keeps tiny
+//	inputs on the calling thread.
+
+void parallelFor(int cItem, PFNPARALLELJOB pfnJob, void * pContext, int cItemPerWorkerMin = 1);
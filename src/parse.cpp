@@ -2,6 +2,8 @@
 
 #include "error.h"
 #include "global_context.h"
+#include "parallel.h"
+#include "report.h"
 #include "scan.h"
 
 // Absolutely sucks that I need to use 0, 1, 2 suffixes. I tried this approach to simulate default parameters in a macro but MSVC has a bug
@@ -41,12 +43,15 @@ void init(Parser * parser, MeekCtx * pCtx)
 	init(&parser->tokenAlloc);
 	init(&parser->scopeAlloc);
 	init(&parser->apErrorNodes);
+	init(&parser->symbolIndex);
+	init(&parser->apNodeTracked);
+	init(&parser->apChunk);
 
 	parser->pScopeBuiltin = allocate(&parser->scopeAlloc);
-	init(parser->pScopeBuiltin, SCOPEID_BuiltIn, SCOPEK_BuiltIn, nullptr);
+	init(parser->pScopeBuiltin, SCOPEID_BuiltIn, SCOPEK_BuiltIn, nullptr, &parser->symbolIndex);
 
 	parser->pScopeGlobal = allocate(&parser->scopeAlloc);
-	init(parser->pScopeGlobal, SCOPEID_Global, SCOPEK_Global, parser->pScopeBuiltin);
+	init(parser->pScopeGlobal, SCOPEID_Global, SCOPEK_Global, parser->pScopeBuiltin, &parser->symbolIndex);
 
 	parser->pScopeCurrent = parser->pScopeGlobal;
 	parser->scopeidNext = SCOPEID_UserDefinedStart;
@@ -54,16 +59,9 @@ void init(Parser * parser, MeekCtx * pCtx)
 	parser->varseqidNext = VARSEQID_Start;
 }
 
-AstNode * parseProgram(Parser * parser, bool * poSuccess)
+static void parseTopLevelStmts(Parser * parser, DynamicArray<AstNode *> * papNodes)
 {
 	Scanner * scanner = parser->pCtx->scanner;
-	AstDecorations * astDecorations = parser->pCtx->astDecorations;
-
-	DynamicArray<AstNode *> apNodes;
-	init(&apNodes);
-	Defer(AssertInfo(!apNodes.pBuffer, "Should be moved into program AST node"));
-
-	StartEndIndices startEnd;
 
 	while (!isFinished(*scanner) && peekToken(scanner) != TOKENK_Eof)
 	{
@@ -79,19 +77,403 @@ AstNode * parseProgram(Parser * parser, bool * poSuccess)
 			}
 		}
 
-		if (apNodes.cItem == 0)
+		append(papNodes, pNode);
+	}
+}
+
+// Parallel parsing
+//
+//	Large programs are split into chunks at top level struct and func defns, and every chunk is parsed from scratch
+//	by its own parser, with its own ctx, allocators and tables. Each chunk numbers its nodes, scopes, funcs and vars
+//	from the start. Once they are all done, the chunks are renumbered to follow one another (in parallel, since that
+//	touches every node) and then merged into our ctx in program order (serially). The result is the same as if we
+//	had parsed the whole thing ourselves, except that error recovery can't run past the end of a chunk.
+
+struct ParseChunk
+{
+	MeekCtx ctx;
+	Scanner scanner;
+	Parser parser;
+	TypeTable typeTable;
+	AstDecorations astDecs;
+
+	DynamicArray<AstNode *> apNodeTopLevel;
+	DynamicArray<AstStructDefnStmt *> apStructDefnStmt;		// Found while renumbering. Typids are patched once the types are merged.
+
+	// Added to every id the chunk handed out
+
+	u32 astidOffset;
+	u32 scopeidOffset;
+	u32 funcidOffset;
+	u32 varseqidOffset;
+};
+
+static const int s_cByteChunkMin = 32 * 1024;
+static const int s_cChunkPerWorker = 4;		// Chunks vary in how long they take to parse, so hand out a few per worker
+
+static void init(ParseChunk * pChunk, char * pText, int iTextStart, int iTextEnd)
+{
+	MeekCtx * pCtx = &pChunk->ctx;
+
+	init(&pChunk->scanner, pText, iTextEnd);
+	pChunk->scanner.iText = iTextStart;
+
+	init(&pChunk->parser, pCtx);
+	pChunk->parser.tracksNodes = true;
+
+	init(&pCtx->scopes);
+	append(&pCtx->scopes, pChunk->parser.pScopeBuiltin);
+	append(&pCtx->scopes, pChunk->parser.pScopeGlobal);
+
+	init(&pChunk->typeTable, pCtx);
+	init(&pChunk->astDecs);
+
+	init(&pCtx->functions);
+	pCtx->scanner = &pChunk->scanner;
+	pCtx->parser = &pChunk->parser;
+	pCtx->typeTable = &pChunk->typeTable;
+	pCtx->astDecorations = &pChunk->astDecs;
+
+	pCtx->rootNode = nullptr;
+
+	pCtx->mainFuncid = FuncId::Nil;
+
+	pCtx->pReport = nullptr;
+
+	init(&pChunk->apNodeTopLevel);
+	init(&pChunk->apStructDefnStmt);
+}
+
+// Once merged, our user defined scopes and the typidDisambig lists in our decorations belong to the ctx we were merged
+//	into, as does disposing our nodes, see dispose(MeekCtx *). The rest is still ours.
+
+static void dispose(ParseChunk * pChunk)
+{
+	dispose(&pChunk->ctx.scopes);
+	dispose(&pChunk->ctx.functions);
+
+	dispose(&pChunk->scanner);
+	dispose(&pChunk->parser);
+	dispose(&pChunk->typeTable);
+
+	dispose(&pChunk->astDecs.startEndDecoration);
+	dispose(&pChunk->astDecs.typidDisambigDecoration);
+	dispose(&pChunk->astDecs.structLayoutDecoration);
+
+	dispose(&pChunk->apNodeTopLevel);
+	dispose(&pChunk->apStructDefnStmt);
+}
+
+void dispose(Parser * parser)
+{
+	for (int iChunk = 0; iChunk < parser->apChunk.cItem; iChunk++)
+	{
+		dispose(parser->apChunk[iChunk]);
+		delete parser->apChunk[iChunk];
+	}
+
+	dispose(parser->pScopeBuiltin);
+	dispose(parser->pScopeGlobal);
+	dispose(&parser->symbolIndex);
+
+	dispose(&parser->apChunk);
+	dispose(&parser->apErrorNodes);
+	dispose(&parser->apNodeTracked);
+
+	destroy(&parser->astAlloc);
+	destroy(&parser->tokenAlloc);
+	destroy(&parser->scopeAlloc);
+}
+
+// Quick token scan that only matches braces, to find where top level defns start. A chunk only starts at a defn that
+//	follows a ';' or '}' at the top level, so that we never split a var decl like "fn() -> int pfn = fn() -> int { ... };".
+//	Only returns chunks if there are at least two, in which case the scanner is caught up to the end of the text.
+
+static void findParseChunks(Scanner * scanner, DynamicArray<int> * paITextChunkStart)
+{
+	Scanner scannerPre;
+	init(&scannerPre, scanner->pText, scanner->textSize);
+	scannerPre.iText = scanner->iText;
+
+	int cByteChunkTarget = Max(s_cByteChunkMin, (scanner->textSize - scanner->iText) / (cWorkerMax() * s_cChunkPerWorker));
+
+	append(paITextChunkStart, scanner->iText);
+
+	int depth = 0;
+	TOKENK tokenkPrev = TOKENK_Nil;
+
+	for (;;)
+	{
+		Token token;
+		TOKENK tokenk = consumeToken(&scannerPre, &token);
+		if (tokenk == TOKENK_Eof)
+			break;
+
+		if (depth == 0 &&
+			(tokenk == TOKENK_Struct || tokenk == TOKENK_Fn) &&
+			(tokenkPrev == TOKENK_Semicolon || tokenkPrev == TOKENK_CloseBrace) &&
+			token.startEnd.iStart - (*paITextChunkStart)[paITextChunkStart->cItem - 1] >= cByteChunkTarget &&
+			peekToken(&scannerPre) == TOKENK_Identifier)
 		{
-			auto startEndNode = getStartEnd(*astDecorations, pNode->astid);
-			startEnd.iStart = startEndNode.iStart;
-			startEnd.iEnd = startEndNode.iEnd;
+			append(paITextChunkStart, token.startEnd.iStart);
 		}
-		else
+
+		if (tokenk == TOKENK_OpenBrace)
+		{
+			depth++;
+		}
+		else if (tokenk == TOKENK_CloseBrace && depth > 0)
+		{
+			depth--;
+		}
+
+		tokenkPrev = tokenk;
+	}
+
+	if (paITextChunkStart->cItem < 2)
+	{
+		removeAll(paITextChunkStart);
+		dispose(&scannerPre.newLineIndices);
+		return;
+	}
+
+	// NOTE (andrew) The chunks' scanners only see their own newlines, so line numbers for errors come from this scan
+
+	reinitMove(&scanner->newLineIndices, &scannerPre.newLineIndices);
+	scanner->iText = scannerPre.iText;
+	scanner->iToken += scannerPre.iToken;
+	scanner->scanexitk = scannerPre.scanexitk;
+}
+
+static void parseChunkJob(void * pParser, int iChunk, int iWorker)
+{
+	ParseChunk * pChunk = reinterpret_cast<Parser *>(pParser)->apChunk[iChunk];
+	parseTopLevelStmts(&pChunk->parser, &pChunk->apNodeTopLevel);
+}
+
+static SCOPEID scopeidRenumbered(const ParseChunk & chunk, SCOPEID scopeid)
+{
+	if (scopeid < SCOPEID_UserDefinedStart || scopeid >= SCOPEID_Max)
+		return scopeid;
+
+	return SCOPEID(scopeid + chunk.scopeidOffset);
+}
+
+static void renumberChunkJob(void * pParser, int iChunk, int iWorker)
+{
+	Parser * parser = reinterpret_cast<Parser *>(pParser);
+	ParseChunk * pChunk = parser->apChunk[iChunk];
+
+	for (int iNode = 0; iNode < pChunk->parser.apNodeTracked.cItem; iNode++)
+	{
+		AstNode * pNode = pChunk->parser.apNodeTracked[iNode];
+		if (!pNode)
+			continue;
+
+		Assert(pNode->astid == static_cast<ASTID>(iNode));
+		pNode->astid = static_cast<ASTID>(pNode->astid + pChunk->astidOffset);
+
+		switch (pNode->astk)
 		{
-			auto startEndNode = getStartEnd(*astDecorations, pNode->astid);
-			startEnd.iEnd = startEndNode.iEnd;
+			case ASTK_VarDeclStmt:
+			{
+				auto * pStmt = Down(pNode, VarDeclStmt);
+				pStmt->ident.scopeid = scopeidRenumbered(*pChunk, pStmt->ident.scopeid);
+				pStmt->varseqid = VARSEQID(pStmt->varseqid + pChunk->varseqidOffset);
+			} break;
+
+			case ASTK_StructDefnStmt:
+			{
+				auto * pStmt = Down(pNode, StructDefnStmt);
+				pStmt->ident.scopeid = scopeidRenumbered(*pChunk, pStmt->ident.scopeid);
+				pStmt->scopeid = scopeidRenumbered(*pChunk, pStmt->scopeid);
+				append(&pChunk->apStructDefnStmt, pStmt);
+			} break;
+
+			case ASTK_FuncDefnStmt:
+			{
+				auto * pStmt = Down(pNode, FuncDefnStmt);
+				pStmt->ident.scopeid = scopeidRenumbered(*pChunk, pStmt->ident.scopeid);
+				pStmt->funcid = FuncId(static_cast<u32>(pStmt->funcid) + pChunk->funcidOffset);
+			} break;
+
+			case ASTK_FuncLiteralExpr:
+			{
+				auto * pExpr = Down(pNode, FuncLiteralExpr);
+				pExpr->funcid = FuncId(static_cast<u32>(pExpr->funcid) + pChunk->funcidOffset);
+			} break;
+
+			case ASTK_ParamsReturnsGrp:
+			{
+				auto * pGrp = Down(pNode, ParamsReturnsGrp);
+				pGrp->scopeid = scopeidRenumbered(*pChunk, pGrp->scopeid);
+			} break;
+
+			case ASTK_BlockStmt:
+			{
+				auto * pStmt = Down(pNode, BlockStmt);
+				pStmt->scopeid = scopeidRenumbered(*pChunk, pStmt->scopeid);
+			} break;
+
+			default:
+				break;
 		}
+	}
+
+	DynamicArray<Scope *> & apScope = pChunk->ctx.scopes;
+	for (int iScope = SCOPEID_UserDefinedStart; iScope < apScope.cItem; iScope++)
+	{
+		Scope * pScope = apScope[iScope];
+		pScope->id = scopeidRenumbered(*pChunk, pScope->id);
+		pScope->scopeidDescendantLast = scopeidRenumbered(*pChunk, pScope->scopeidDescendantLast);
+		pScope->pSymbolIndex = &parser->symbolIndex;
 
-		append(&apNodes, pNode);
+		if (pScope->pScopeParent == pChunk->parser.pScopeGlobal)
+		{
+			pScope->pScopeParent = parser->pScopeGlobal;
+		}
+	}
+}
+
+static void mergeChunk(Parser * parser, ParseChunk * pChunk, DynamicArray<AstNode *> * papNodes)
+{
+	MeekCtx * pCtx = parser->pCtx;
+	MeekCtx * pCtxChunk = &pChunk->ctx;
+
+	Assert(pCtx->scopes.cItem == SCOPEID_UserDefinedStart + pChunk->scopeidOffset);
+	appendMultiple(&pCtx->scopes, pCtxChunk->scopes.pBuffer + SCOPEID_UserDefinedStart, pCtxChunk->scopes.cItem - SCOPEID_UserDefinedStart);
+
+	Assert(pCtx->functions.cItem == pChunk->funcidOffset);
+	appendMultiple(&pCtx->functions, pCtxChunk->functions);
+
+	appendDecorations(pCtx->astDecorations, pChunk->astDecs, static_cast<ASTID>(pChunk->astidOffset));
+
+	mergeSymbolIndex(pCtx, parser->pScopeGlobal, pChunk->parser.pScopeGlobal);
+
+	// NOTE (andrew) Structs are looked up by symbol and scope when their types are inserted, so this comes after
+	//	the scopes and symbols
+
+	DynamicArray<TypeId> aTypidMerged;
+	init(&aTypidMerged);
+	Defer(dispose(&aTypidMerged));
+
+	mergeTypes(pCtx->typeTable, pChunk->typeTable, pChunk->scopeidOffset, &aTypidMerged);
+
+	for (int iStmt = 0; iStmt < pChunk->apStructDefnStmt.cItem; iStmt++)
+	{
+		AstStructDefnStmt * pStmt = pChunk->apStructDefnStmt[iStmt];
+		pStmt->typidDefn = aTypidMerged[static_cast<int>(pStmt->typidDefn) - static_cast<int>(TypeId::mFirstUserDefined)];
+	}
+
+	mergePendingTypes(pCtx->typeTable, pChunk->typeTable, parser->pScopeGlobal);
+
+	appendMultiple(&parser->apErrorNodes, pChunk->parser.apErrorNodes);
+	appendMultiple(papNodes, pChunk->apNodeTopLevel);
+}
+
+static bool tryParseTopLevelStmtsParallel(Parser * parser, DynamicArray<AstNode *> * papNodes)
+{
+	MeekCtx * pCtx = parser->pCtx;
+	Scanner * scanner = pCtx->scanner;
+
+	if (cWorkerMax() <= 1 || scanner->textSize - scanner->iText < 2 * s_cByteChunkMin)
+		return false;
+
+	DynamicArray<int> aITextChunkStart;
+	init(&aITextChunkStart);
+	Defer(dispose(&aITextChunkStart));
+
+	beginPhase(pCtx->pReport, PHASEK_ParseSplit);
+	findParseChunks(scanner, &aITextChunkStart);
+	endPhase(pCtx->pReport, PHASEK_ParseSplit);
+
+	if (aITextChunkStart.cItem == 0)
+		return false;
+
+	beginPhase(pCtx->pReport, PHASEK_ParseChunks);
+
+	int cChunk = aITextChunkStart.cItem;
+	for (int iChunk = 0; iChunk < cChunk; iChunk++)
+	{
+		int iTextEnd = (iChunk + 1 < cChunk) ? aITextChunkStart[iChunk + 1] : scanner->textSize;
+
+		ParseChunk * pChunk = new ParseChunk;
+		init(pChunk, scanner->pText, aITextChunkStart[iChunk], iTextEnd);
+		append(&parser->apChunk, pChunk);
+	}
+
+	parallelFor(cChunk, &parseChunkJob, parser);
+
+	u32 astidNext = parser->iNode;
+	u32 scopeidNext = parser->scopeidNext;
+	u32 funcidNext = pCtx->functions.cItem;
+	u32 varseqidNext = parser->varseqidNext;
+
+	for (int iChunk = 0; iChunk < cChunk; iChunk++)
+	{
+		ParseChunk * pChunk = parser->apChunk[iChunk];
+
+		pChunk->astidOffset = astidNext;
+		pChunk->scopeidOffset = scopeidNext - SCOPEID_UserDefinedStart;
+		pChunk->funcidOffset = funcidNext;
+		pChunk->varseqidOffset = varseqidNext - VARSEQID_Start;
+
+		astidNext += pChunk->parser.iNode;
+		scopeidNext += pChunk->parser.scopeidNext - SCOPEID_UserDefinedStart;
+		funcidNext += pChunk->ctx.functions.cItem;
+		varseqidNext += pChunk->parser.varseqidNext - VARSEQID_Start;
+	}
+
+	parallelFor(cChunk, &renumberChunkJob, parser);
+
+	endPhase(pCtx->pReport, PHASEK_ParseChunks);
+	beginPhase(pCtx->pReport, PHASEK_ParseMerge);
+
+	for (int iChunk = 0; iChunk < cChunk; iChunk++)
+	{
+		mergeChunk(parser, parser->apChunk[iChunk], papNodes);
+	}
+
+	endPhase(pCtx->pReport, PHASEK_ParseMerge);
+
+	parser->iNode = astidNext;
+	parser->scopeidNext = SCOPEID(scopeidNext);
+	parser->varseqidNext = VARSEQID(varseqidNext);
+
+	return true;
+}
+
+AstNode * parseProgram(Parser * parser, bool * poSuccess)
+{
+	AstDecorations * astDecorations = parser->pCtx->astDecorations;
+
+	DynamicArray<AstNode *> apNodes;
+	init(&apNodes);
+	Defer(AssertInfo(!apNodes.pBuffer, "Should be moved into program AST node"));
+
+	if (!tryParseTopLevelStmtsParallel(parser, &apNodes))
+	{
+		Scanner * scanner = parser->pCtx->scanner;
+		bool scansAhead = parser->scansAhead && cWorkerMax() > 1;
+
+		if (scansAhead)
+		{
+			startScanAhead(scanner, parser->pCtx->pReport);
+		}
+
+		parseTopLevelStmts(parser, &apNodes);
+
+		if (scansAhead)
+		{
+			finishScanAhead(scanner);
+		}
+	}
+
+	StartEndIndices startEnd;
+	if (apNodes.cItem > 0)
+	{
+		startEnd.iStart = getStartEnd(*astDecorations, apNodes[0]->astid).iStart;
+		startEnd.iEnd = getStartEnd(*astDecorations, apNodes[apNodes.cItem - 1]->astid).iEnd;
 	}
 
 	auto * pNodeProgram = AstNew(parser, Program, startEnd);
@@ -134,9 +516,10 @@ AstNode * parseStmt(Parser * parser, PARSESTMTK parsestmtk)
 
 		return pNode;
 	}
-	else if (parsestmtk != PARSESTMTK_DoPseudoStmt && tokenkNext == TOKENK_Fn && tokenkNextNext == TOKENK_Identifier)
+	else if (parsestmtk != PARSESTMTK_DoPseudoStmt &&
+			 ((tokenkNext == TOKENK_Fn && tokenkNextNext == TOKENK_Identifier) || tokenkNext == TOKENK_Extern))
 	{
-		// Func defn
+		// Func defn (or extern func decl)
 
 		Assert(parsestmtk != PARSESTMTK_DoPseudoStmt);
 
@@ -497,6 +880,34 @@ AstNode * parseStructDefnStmt(Parser * parser)
 	Token * pTokenIdent = claimPendingToken(parser);
 	Assert(pTokenIdent->tokenk == TOKENK_Identifier);
 
+	// Parse optional layout, e.g., struct Particle packed { ... }. The layout names are not reserved words.
+
+	STRUCTLAYOUTK structlayoutk = STRUCTLAYOUTK_Nil;
+	if (tryConsumeToken(scanner, TOKENK_Identifier, ensurePendingToken(parser)))
+	{
+		Token * pTokenLayout = claimPendingToken(parser);
+		Assert(pTokenLayout->tokenk == TOKENK_Identifier);
+
+		if (pTokenLayout->lexeme.strv == "reorder")
+		{
+			structlayoutk = STRUCTLAYOUTK_Reordered;
+		}
+		else if (pTokenLayout->lexeme.strv == "packed")
+		{
+			structlayoutk = STRUCTLAYOUTK_Packed;
+		}
+		else if (pTokenLayout->lexeme.strv == "cacheline")
+		{
+			structlayoutk = STRUCTLAYOUTK_CacheLine;
+		}
+		else
+		{
+			auto * pErr = AstNewErr0Child(parser, UnexpectedTokenkErr, pTokenLayout->startEnd);
+			pErr->pErrToken = pTokenLayout;
+			return Up(pErr);
+		}
+	}
+
 	// Parse '{'
 
 	if (!tryConsumeToken(scanner, TOKENK_OpenBrace))
@@ -556,6 +967,11 @@ AstNode * parseStructDefnStmt(Parser * parser)
 	initMove(&pNode->apVarDeclStmt, &apVarDeclStmt);
 	pNode->scopeid = pScopeIntroduced->id;
 
+	if (structlayoutk != STRUCTLAYOUTK_Nil)
+	{
+		decorate(&pCtx->astDecorations->structLayoutDecoration, Up(pNode)->astid, structlayoutk);
+	}
+
 	// Insert into symbol table of enclosing scope
 
 	SymbolInfo structDefnInfo;
@@ -732,6 +1148,7 @@ AstNode * parseVarDeclStmt(
 	}
 	pNode->pInitExpr = pInitExpr;
 	pNode->vardeclk = vardeclk;
+	pNode->byteOffset = 0;
 
 	// Remember to poke in the typid once this type is resolved
 
@@ -1520,7 +1937,7 @@ AstNode * parseFuncSymbolExpr(Parser * parser)
 		auto * pNode = AstNew(parser, SymbolExpr, makeStartEnd(iStart, pTokenIdent->startEnd.iEnd));
 		pNode->ident = pTokenIdent->lexeme;
 		pNode->symbexprk = SYMBEXPRK_Unresolved;
-		pNode->unresolvedData.ignoreVars = true;
+		pNode->ignoreVars = true;
 		init(&pNode->unresolvedData.aCandidates);
 
 		return Up(pNode);
@@ -1551,11 +1968,17 @@ AstNode * parseFuncSymbolExpr(Parser * parser)
 		pNode->ident = ident;
 		pNode->symbexprk = SYMBEXPRK_Func;
 		pNode->funcData.pDefnCached = nullptr;		// Not yet resolved
-		init(&pNode->funcData.aTypidDisambig);
+
+		// NOTE: Disambiguating typeid's are cold, so they are stored in a decoration table. Reserve up front so that
+		//	the typid pointers we hand out don't move as we append.
+
+		DynamicArray<TypeId> aTypidDisambig;
+		init(&aTypidDisambig);
+		ensureCapacity(&aTypidDisambig, parseFuncHeaderParam.paramSymbolExpr.paPendingTypidParam->cItem);
 
 		for (int iTypeDisambig = 0; iTypeDisambig < parseFuncHeaderParam.paramSymbolExpr.paPendingTypidParam->cItem; iTypeDisambig++)
 		{
-			TypeId * pTypid = appendNew(&pNode->funcData.aTypidDisambig);
+			TypeId * pTypid = appendNew(&aTypidDisambig);
 			*pTypid = TypeId::Unresolved;
 
 			setPendingTypeUpdateOnResolvePtr(
@@ -1564,6 +1987,8 @@ AstNode * parseFuncSymbolExpr(Parser * parser)
 				pTypid);
 		}
 
+		decorate(&parser->pCtx->astDecorations->typidDisambigDecoration, Up(pNode)->astid, aTypidDisambig);
+
 		return Up(pNode);
 	}
 	else
@@ -1627,7 +2052,7 @@ AstNode * parseVarOrMemberVarSymbolExpr(Parser * parser, NULLABLE AstNode * pMem
 
 		pNode->symbexprk = SYMBEXPRK_Unresolved;
 		init(&pNode->unresolvedData.aCandidates);
-		pNode->unresolvedData.ignoreVars = false;
+		pNode->ignoreVars = false;
 	}
 
 	return finishParsePrimary(parser, Up(pNode));
@@ -1712,7 +2137,8 @@ ParseTypeResult tryParseType(Parser * parser)
 				registerPendingNamedType(
 					typeTable,
 					parser->pScopeCurrent,
-					pTokenIdent->lexeme);
+					pTokenIdent->lexeme,
+					pTokenIdent->startEnd.iStart);
 		}
 		else if (tokenkPeek == TOKENK_Fn)
 		{
@@ -2311,6 +2737,10 @@ AstNode * parseFuncDefnStmtOrLiteralExpr(Parser * parser, FUNCHEADERK funcheader
 
 	int iStart = peekTokenStartEnd(scanner).iStart;
 
+	// extern fn <header>; declares a func that the host provides, see host_func.h
+
+	bool isExtern = isDefn && tryConsumeToken(scanner, TOKENK_Extern);
+
 	// Parse header
 	
 	// NOTE (andrew) Push scope before parsing header so that the symbols declared in the header
@@ -2380,15 +2810,31 @@ AstNode * parseFuncDefnStmtOrLiteralExpr(Parser * parser, FUNCHEADERK funcheader
 	int iEndHeader = prevTokenStartEnd(scanner).iEnd;
 	decorate(&astDecorations->startEndDecoration, Up(pParamsReturnsUnderConstruction)->astid, StartEndIndices(iStart, iEndHeader));
 
-	// Parse { <stmts> } or do <stmt>
+	// Parse { <stmts> } or do <stmt>, or just ; for an extern
 
-	const bool pushPopScope = false;
-	AstNode * pBody = parseDoPseudoStmtOrBlockStmt(parser, pushPopScope);
+	AstNode * pBody = nullptr;
+	if (isExtern)
+	{
+		if (!tryConsumeToken(scanner, TOKENK_Semicolon))
+		{
+			auto startEndPrev = prevTokenStartEnd(scanner);
 
-	if (isErrorNode(*pBody))
+			auto * pErrExpected = AstNewErr0Child(parser, ExpectedTokenkErr, makeStartEnd(startEndPrev.iEnd + 1));
+			append(&pErrExpected->aTokenkValid, TOKENK_Semicolon);
+			pErr = UpErr(pErrExpected);
+			goto LFailCleanup;
+		}
+	}
+	else
 	{
-		pErr = UpErr(AstNewErr1Child(parser, BubbleErr, gc_startEndBubble, pBody));
-		goto LFailCleanup;
+		const bool pushPopScope = false;
+		pBody = parseDoPseudoStmtOrBlockStmt(parser, pushPopScope);
+
+		if (isErrorNode(*pBody))
+		{
+			pErr = UpErr(AstNewErr1Child(parser, BubbleErr, gc_startEndBubble, pBody));
+			goto LFailCleanup;
+		}
 	}
 
 	// Success!
@@ -2404,7 +2850,7 @@ AstNode * parseFuncDefnStmtOrLiteralExpr(Parser * parser, FUNCHEADERK funcheader
 		AstFuncDefnStmt * pNode = Down(pNodeUnderConstruction, FuncDefnStmt);
 		pNode->pBodyStmt = pBody;
 		pNode->ident.scopeid = pScopeOuter->id;
-		pNode->scopeid = pScopeInner->id;
+		pNode->pParamsReturnsGrp->scopeid = pScopeInner->id;
 		pNode->funcid = FuncId(pCtx->functions.cItem);
 
 		SymbolInfo funcDefnInfo;
@@ -2427,7 +2873,7 @@ AstNode * parseFuncDefnStmtOrLiteralExpr(Parser * parser, FUNCHEADERK funcheader
 	{
 		AstFuncLiteralExpr * pNode = Down(pNodeUnderConstruction, FuncLiteralExpr);
 		pNode->pBodyStmt = pBody;
-		pNode->scopeid = pScopeInner->id;
+		pNode->pParamsReturnsGrp->scopeid = pScopeInner->id;
 		pNode->funcid = FuncId(pCtx->functions.cItem);
 
 		registerPendingFuncType(
@@ -2451,8 +2897,8 @@ LFailCleanup:
 
 	dispose(&pParamsReturnsUnderConstruction->apParamVarDecls);
 	dispose(&pParamsReturnsUnderConstruction->apReturnVarDecls);
-	release(&parser->astAlloc, Up(pParamsReturnsUnderConstruction));
-	release(&parser->astAlloc, pNodeUnderConstruction);
+	releaseNode(parser, Up(pParamsReturnsUnderConstruction));
+	releaseNode(parser, pNodeUnderConstruction);
 
 	return Up(pErr);
 }
@@ -2508,7 +2954,7 @@ Scope * pushScope(Parser * parser, SCOPEK scopek)
 
 	Scope * pScope = allocate(&parser->scopeAlloc);
 
-	init(pScope, parser->scopeidNext, scopek, parser->pScopeCurrent);
+	init(pScope, parser->scopeidNext, scopek, parser->pScopeCurrent, &parser->symbolIndex);
 
 	Assert(pCtx->scopes.cItem == pScope->id);
 	append(&pCtx->scopes, pScope);
@@ -2525,6 +2971,10 @@ Scope * popScope(Parser * parser)
 	Assert(parser->pScopeCurrent->pScopeParent);
 
 	Scope * pScopeResult = parser->pScopeCurrent;
+
+	// Every scope pushed since this one is a descendant of it
+
+	pScopeResult->scopeidDescendantLast = SCOPEID(parser->scopeidNext - 1);
 	parser->pScopeCurrent = parser->pScopeCurrent->pScopeParent;
 
 	return pScopeResult;
@@ -2657,11 +3107,27 @@ AstNode * astNew(Parser * parser, ASTK astk, StartEndIndices startEnd)
 	pNode->astid = static_cast<ASTID>(parser->iNode);
 	parser->iNode++;
 
+	if (parser->tracksNodes)
+	{
+		Assert(parser->apNodeTracked.cItem == pNode->astid);
+		append(&parser->apNodeTracked, pNode);
+	}
+
 	decorate(&astDecorations->startEndDecoration, pNode->astid, startEnd);
 
 	return pNode;
 }
 
+void releaseNode(Parser * parser, AstNode * pNode)
+{
+	if (parser->tracksNodes)
+	{
+		parser->apNodeTracked[pNode->astid] = nullptr;
+	}
+
+	release(&parser->astAlloc, pNode);
+}
+
 AstNode * astNewErr(Parser * parser, ASTK astkErr, StartEndIndices startEnd, AstNode * pChild0, AstNode * pChild1, AstNode * pChild2)
 {
 	Assert(Implies(pChild2, pChild1));
@@ -8,6 +8,7 @@
 #include "type.h"
 
 struct MeekCtx;
+struct ParseChunk;
 
 struct BinopInfo
 {
@@ -24,7 +25,7 @@ struct Parser
 
 	// Allocators
 
-	DynamicPoolAllocator<AstNode> astAlloc;
+	DynamicPoolAllocator<AstNode, 512, 64> astAlloc;		// Cache line aligned
 	DynamicPoolAllocator<Token> tokenAlloc;
 	DynamicPoolAllocator<Scope> scopeAlloc;
 
@@ -36,6 +37,8 @@ struct Parser
 	Scope * pScopeBuiltin = nullptr;	// Parser probably shouldn't own these...
 	Scope * pScopeGlobal = nullptr;
 
+	SymbolIndex symbolIndex;			// Symbols for every scope, keyed by lexeme
+
 	// Vars
 
 	VARSEQID varseqidNext = VARSEQID_Nil;
@@ -45,12 +48,23 @@ struct Parser
 	uint iNode = 0;				// Becomes node's id
 	Token * pPendingToken = nullptr;
 
+	bool scansAhead = false;	// Scan on another thread while we parse, when the program isn't parsed in parallel chunks
+
+	bool tracksNodes = false;					// Only chunk parsers track, since their nodes get renumbered when merged
+	DynamicArray<AstNode *> apNodeTracked;		// Indexed by astid. nullptr once released.
+
 	// Error and error recovery
 
 	DynamicArray<AstNode *> apErrorNodes;
+
+	// Chunks of the program that were parsed in parallel, see parseProgram(..). Their allocators own much of the
+	//	merged AST, so they stick around as long as we do.
+
+	DynamicArray<ParseChunk *> apChunk;
 };
 
 void init(Parser * parser, MeekCtx * pCtx);
+void dispose(Parser * parser);
 void reportScanAndParseErrors(const Parser & parser);
 
 AstNode * parseProgram(Parser * parser, bool * poSuccess);
@@ -92,6 +106,7 @@ AstNode * astNew(Parser * parser, ASTK astk, StartEndIndices startEnd);
 AstNode * astNewErr(Parser * parser, ASTK astkErr, StartEndIndices startEnd, AstNode * pChild0 = nullptr, AstNode * pChild1 = nullptr, AstNode * pChild2 = nullptr);
 AstNode * astNewErr(Parser * parser, ASTK astkErr, StartEndIndices startEnd, AstNode * aPChildren[], uint cPChildren);
 AstNode * astNewErrMoveChildren(Parser * parser, ASTK astkErr, StartEndIndices startEnd, DynamicArray<AstNode *> * papChildren);
+void releaseNode(Parser * parser, AstNode * pNode);
 
 // Error handling
 
@@ -3,25 +3,79 @@
 #include <stdarg.h>
 #include <stdio.h>
 
+static thread_local String * s_pStrCapture = nullptr;
+
+// Captures that s_pStrCapture is nested in, innermost last
+
+static const int s_cCaptureOuterMax = 4;
+static thread_local String * s_apStrCaptureOuter[s_cCaptureOuterMax];
+static thread_local int s_cCaptureOuter = 0;
+
+static void appendCapture(const char * pCh, int cCh)
+{
+	ensureCapacity(s_pStrCapture, s_pStrCapture->cChar + cCh);
+
+	for (int iCh = 0; iCh < cCh; iCh++)
+	{
+		s_pStrCapture->pBuffer[s_pStrCapture->cChar + iCh] = pCh[iCh];
+	}
+
+	s_pStrCapture->cChar += cCh;
+	s_pStrCapture->pBuffer[s_pStrCapture->cChar] = '\0';
+}
+
+void beginPrintCapture(String * pStrCapture)
+{
+	if (s_pStrCapture)
+	{
+		Assert(s_cCaptureOuter < s_cCaptureOuterMax);
+		s_apStrCaptureOuter[s_cCaptureOuter] = s_pStrCapture;
+		s_cCaptureOuter++;
+	}
+
+	s_pStrCapture = pStrCapture;
+}
+
+void endPrintCapture()
+{
+	Assert(s_pStrCapture);
+
+	if (s_cCaptureOuter > 0)
+	{
+		s_cCaptureOuter--;
+		s_pStrCapture = s_apStrCaptureOuter[s_cCaptureOuter];
+	}
+	else
+	{
+		s_pStrCapture = nullptr;
+	}
+}
+
 void print(const char * pStr)
 {
-	printf("%s", pStr);
+	printfmt("%s", pStr);
 }
 
 void print(int i)
 {
-	printf("%d", i);
+	printfmt("%d", i);
 }
 
 void print(float f)
 {
 	// TODO: formatting?
 
-	printf("%f", f);
+	printfmt("%f", f);
 }
 
 void print(StringView stringView)
 {
+	if (s_pStrCapture)
+	{
+		appendCapture(stringView.pCh, stringView.cCh);
+		return;
+	}
+
 	for (int iCh = 0; iCh < stringView.cCh; iCh++)
 	{
 		putchar(stringView.pCh[iCh]);
@@ -32,18 +86,36 @@ void println()
 {
 	// TODO: CRLF on windows?
 
-	printf("\n");
+	printfmt("\n");
 }
 
 void printfmt(const char * pStrFormat, ...)
 {
 	va_list arglist;
 	va_start(arglist, pStrFormat);
-	vprintf(pStrFormat, arglist);
+	vprintfmt(pStrFormat, arglist);
 	va_end(arglist);
 }
 
 void vprintfmt(const char * pStrFormat, va_list arg)
 {
-	vprintf(pStrFormat, arg);
+	if (!s_pStrCapture)
+	{
+		vprintf(pStrFormat, arg);
+		return;
+	}
+
+	va_list argCopy;
+	va_copy(argCopy, arg);
+	int cCh = vsnprintf(nullptr, 0, pStrFormat, argCopy);
+	va_end(argCopy);
+
+	if (cCh <= 0)
+		return;
+
+	// NOTE: ensureCapacity always leaves room for the null terminator that vsnprintf writes
+
+	ensureCapacity(s_pStrCapture, s_pStrCapture->cChar + cCh);
+	vsnprintf(s_pStrCapture->pBuffer + s_pStrCapture->cChar, cCh + 1, pStrFormat, arg);
+	s_pStrCapture->cChar += cCh;
 }
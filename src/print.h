@@ -10,4 +10,10 @@ void print(float f);
 void print(StringView stringView);
 void println();
 void printfmt(const char * pStrFormat, ...);
-void vprintfmt(const char * pStrFormat, va_list arg);
\ No newline at end of file
+void vprintfmt(const char * pStrFormat, va_list arg);
+
+// Everything printed on the calling thread between these goes to pStrCapture instead of stdout. Lets work that is spread
+//	across threads report its output in a deterministic order. Captures nest, and only the innermost one gets the output.
+
+void beginPrintCapture(String * pStrCapture);
+void endPrintCapture();
\ No newline at end of file
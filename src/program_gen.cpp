@@ -0,0 +1,479 @@
+#include "program_gen.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+void init(ProgramGenParams * pParams)
+{
+	pParams->cFunc = 100;
+	pParams->cOverload = 1;
+	pParams->cExtern = 8;
+	pParams->cStruct = 0;
+	pParams->cGlobal = 32;
+	pParams->depthNest = 3;
+	pParams->cStmtPerBlock = 4;
+	pParams->cOperandPerExpr = 4;
+	pParams->seed = 1;
+}
+
+// Each func defn's body is all one type, so expressions never need conversions
+
+enum GENTYPEK
+{
+	GENTYPEK_Int,
+	GENTYPEK_Float,
+
+	GENTYPEK_Max,
+	GENTYPEK_Nil = -1
+};
+
+static const char * c_mpGentypekPChzName[] =
+{
+	"int",
+	"float",
+};
+StaticAssert(ArrayLen(c_mpGentypekPChzName) == GENTYPEK_Max);
+
+struct ProgramGen
+{
+	const ProgramGenParams * pParams;
+	String * pStr;
+
+	u32 rand;
+
+	// Current func defn. Params and locals are all named v<n>, numbered in order of declaration, so that names
+	//	never collide and the ones that are in scope are easy to pick from. Numbering starts over in each func, so
+	//	every func reuses the same names, like real code reuses i and x.
+
+	GENTYPEK gentypek;
+	DynamicArray<int> aIVarInScope;
+	int cVar;
+};
+
+static u32 nextRand(ProgramGen * pGen)
+{
+	// xorshift32
+
+	u32 x = pGen->rand;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pGen->rand = x;
+	return x;
+}
+
+static int randBelow(ProgramGen * pGen, int cMax)
+{
+	Assert(cMax > 0);
+	return static_cast<int>(nextRand(pGen) % static_cast<u32>(cMax));
+}
+
+static void appendFmt(ProgramGen * pGen, const char * pStrFormat, ...)
+{
+	va_list arg;
+	va_start(arg, pStrFormat);
+
+	va_list argCopy;
+	va_copy(argCopy, arg);
+	int cCh = vsnprintf(nullptr, 0, pStrFormat, argCopy);
+	va_end(argCopy);
+
+	if (cCh > 0)
+	{
+		// NOTE: ensureCapacity always leaves room for the null terminator that vsnprintf writes
+
+		String * pStr = pGen->pStr;
+		ensureCapacity(pStr, pStr->cChar + cCh);
+		vsnprintf(pStr->pBuffer + pStr->cChar, cCh + 1, pStrFormat, arg);
+		pStr->cChar += cCh;
+	}
+
+	va_end(arg);
+}
+
+static void appendIndent(ProgramGen * pGen, int cTab)
+{
+	for (int iTab = 0; iTab < cTab; iTab++)
+	{
+		appendFmt(pGen, "\t");
+	}
+}
+
+// Overloads alternate between int and float params, and add another param every other overload, so every overload's
+//	param list is different. Funcs and externs both do this.
+
+static GENTYPEK gentypekFromIOverload(int iOverload)
+{
+	return static_cast<GENTYPEK>(iOverload % GENTYPEK_Max);
+}
+
+static int cParamFromIOverload(int iOverload)
+{
+	return 1 + iOverload / GENTYPEK_Max;
+}
+
+// Expressions
+
+static void appendOperand(ProgramGen * pGen);
+
+static void appendLiteral(ProgramGen * pGen)
+{
+	if (pGen->gentypek == GENTYPEK_Float)
+	{
+		appendFmt(pGen, "%d.%d", randBelow(pGen, 100), randBelow(pGen, 10));
+	}
+	else
+	{
+		appendFmt(pGen, "%d", randBelow(pGen, 100));
+	}
+}
+
+// A call to one of the overloads of an extern that takes and returns this func's type. There's another overload with
+//	the same number of params of the other type (and maybe more with other counts), so resolve has to pick by the args.
+
+static void appendExternCall(ProgramGen * pGen)
+{
+	const ProgramGenParams & params = *pGen->pParams;
+
+	int cOverloadOfType = (params.cOverload + GENTYPEK_Max - pGen->gentypek) / GENTYPEK_Max;
+	if (cOverloadOfType == 0)
+	{
+		appendLiteral(pGen);
+		return;
+	}
+
+	int iOverload = randBelow(pGen, cOverloadOfType) * GENTYPEK_Max + pGen->gentypek;
+	Assert(gentypekFromIOverload(iOverload) == pGen->gentypek);
+
+	appendFmt(pGen, "h%d(", randBelow(pGen, params.cExtern));
+
+	int cParam = cParamFromIOverload(iOverload);
+	for (int iParam = 0; iParam < cParam; iParam++)
+	{
+		appendFmt(pGen, (iParam > 0) ? ", " : "");
+		appendOperand(pGen);
+	}
+
+	appendFmt(pGen, ")");
+}
+
+static void appendOperand(ProgramGen * pGen)
+{
+	// Globals alternate int, float, int, ... so only every other one is usable in a given func
+
+	int cGlobalOfType = (pGen->pParams->cGlobal + 1 - pGen->gentypek) / 2;
+
+	int roll = randBelow(pGen, 10);
+	if (roll < 6 && pGen->aIVarInScope.cItem > 0)
+	{
+		appendFmt(pGen, "v%d", pGen->aIVarInScope[randBelow(pGen, pGen->aIVarInScope.cItem)]);
+	}
+	else if (roll < 8 && cGlobalOfType > 0)
+	{
+		appendFmt(pGen, "g%d", randBelow(pGen, cGlobalOfType) * 2 + pGen->gentypek);
+	}
+	else if (roll < 9 && pGen->pParams->cExtern > 0)
+	{
+		appendExternCall(pGen);
+	}
+	else
+	{
+		appendLiteral(pGen);
+	}
+}
+
+static void appendExpr(ProgramGen * pGen, int cOperand)
+{
+	Assert(cOperand > 0);
+
+	if (cOperand == 1)
+	{
+		appendOperand(pGen);
+		return;
+	}
+
+	static const char * s_mpIPChzOp[] = { "+", "-", "*" };
+
+	int cOperandLeft = 1 + randBelow(pGen, cOperand - 1);
+	int cOperandRight = cOperand - cOperandLeft;
+
+	appendExpr(pGen, cOperandLeft);
+	appendFmt(pGen, " %s ", s_mpIPChzOp[randBelow(pGen, ArrayLen(s_mpIPChzOp))]);
+
+	if (cOperandRight > 1 && randBelow(pGen, 3) == 0)
+	{
+		appendFmt(pGen, "(");
+		appendExpr(pGen, cOperandRight);
+		appendFmt(pGen, ")");
+	}
+	else
+	{
+		appendExpr(pGen, cOperandRight);
+	}
+}
+
+static void appendCondition(ProgramGen * pGen)
+{
+	int cOperandSide = Max(1, pGen->pParams->cOperandPerExpr / 2);
+
+	appendExpr(pGen, cOperandSide);
+	appendFmt(pGen, " < ");
+	appendExpr(pGen, cOperandSide);
+
+	if (randBelow(pGen, 3) == 0)
+	{
+		appendFmt(pGen, " && !(");
+		appendOperand(pGen);
+		appendFmt(pGen, " == ");
+		appendOperand(pGen);
+		appendFmt(pGen, ")");
+	}
+}
+
+// Statements
+
+static void appendBlock(ProgramGen * pGen, int depth, int cTab);
+
+static void appendVarDecl(ProgramGen * pGen, int cTab)
+{
+	appendIndent(pGen, cTab);
+	appendFmt(pGen, "%s v%d = ", c_mpGentypekPChzName[pGen->gentypek], pGen->cVar);
+	appendExpr(pGen, pGen->pParams->cOperandPerExpr);
+	appendFmt(pGen, ";\n");
+
+	// Not in scope until after its own initializer
+
+	append(&pGen->aIVarInScope, pGen->cVar);
+	pGen->cVar++;
+}
+
+static void appendAssign(ProgramGen * pGen, int cTab)
+{
+	static const char * s_mpIPChzOp[] = { "=", "+=", "-=", "*=" };
+
+	// NOTE (andrew) The bytecode builder only does compound assignment on ints so far
+
+	int cOp = (pGen->gentypek == GENTYPEK_Int) ? ArrayLen(s_mpIPChzOp) : 1;
+
+	appendIndent(pGen, cTab);
+	appendFmt(
+		pGen,
+		"v%d %s ",
+		pGen->aIVarInScope[randBelow(pGen, pGen->aIVarInScope.cItem)],
+		s_mpIPChzOp[randBelow(pGen, cOp)]);
+	appendExpr(pGen, pGen->pParams->cOperandPerExpr);
+	appendFmt(pGen, ";\n");
+}
+
+static void appendNestedStmt(ProgramGen * pGen, int depth, int cTab)
+{
+	Assert(depth > 0);
+
+	switch (randBelow(pGen, 3))
+	{
+		case 0:
+		{
+			appendIndent(pGen, cTab);
+			appendFmt(pGen, "if ");
+			appendCondition(pGen);
+			appendFmt(pGen, "\n");
+			appendBlock(pGen, depth - 1, cTab);
+
+			if (randBelow(pGen, 2) == 0)
+			{
+				appendIndent(pGen, cTab);
+				appendFmt(pGen, "else\n");
+				appendBlock(pGen, depth - 1, cTab);
+			}
+		} break;
+
+		case 1:
+		{
+			int iVar = pGen->aIVarInScope[randBelow(pGen, pGen->aIVarInScope.cItem)];
+
+			appendIndent(pGen, cTab);
+			appendFmt(pGen, "while v%d < ", iVar);
+			appendLiteral(pGen);
+			appendFmt(pGen, "\n");
+			appendBlock(pGen, depth - 1, cTab);
+		} break;
+
+		default:
+		{
+			appendBlock(pGen, depth - 1, cTab);
+		} break;
+	}
+}
+
+static void appendBlock(ProgramGen * pGen, int depth, int cTab)
+{
+	const ProgramGenParams & params = *pGen->pParams;
+
+	appendIndent(pGen, cTab);
+	appendFmt(pGen, "{\n");
+
+	int cVarInScopePrev = pGen->aIVarInScope.cItem;
+
+	// NOTE (andrew) Every block that can nest gets at least one nested stmt, so each func actually reaches depthNest.
+	//	Any more than that are left to chance, otherwise func size would be cStmtPerBlock ^ depthNest.
+
+	int iStmtNested = (depth > 0) ? randBelow(pGen, params.cStmtPerBlock) : -1;
+
+	for (int iStmt = 0; iStmt < params.cStmtPerBlock; iStmt++)
+	{
+		bool isNested = iStmt == iStmtNested || (depth > 0 && randBelow(pGen, 4) == 0);
+
+		if (pGen->aIVarInScope.cItem == 0)
+		{
+			appendVarDecl(pGen, cTab + 1);
+		}
+		else if (isNested)
+		{
+			appendNestedStmt(pGen, depth, cTab + 1);
+		}
+		else if (randBelow(pGen, 2) == 0)
+		{
+			appendVarDecl(pGen, cTab + 1);
+		}
+		else
+		{
+			appendAssign(pGen, cTab + 1);
+		}
+	}
+
+	pGen->aIVarInScope.cItem = cVarInScopePrev;
+
+	appendIndent(pGen, cTab);
+	appendFmt(pGen, "}\n");
+}
+
+// Top level
+
+static void appendStructDefn(ProgramGen * pGen, int iStruct)
+{
+	appendFmt(pGen, "struct S%d\n{\n\tint a;\n\tfloat b;\n", iStruct);
+
+	// Refer to an earlier struct, so that there are types whose resolution depends on others
+
+	if (iStruct > 0)
+	{
+		appendFmt(pGen, "\tS%d s;\n", randBelow(pGen, iStruct));
+	}
+
+	appendFmt(pGen, "}\n\n");
+}
+
+static void appendExternDefn(ProgramGen * pGen, int iExtern, int iOverload)
+{
+	const char * pChzType = c_mpGentypekPChzName[gentypekFromIOverload(iOverload)];
+
+	appendFmt(pGen, "extern fn h%d(", iExtern);
+
+	int cParam = cParamFromIOverload(iOverload);
+	for (int iParam = 0; iParam < cParam; iParam++)
+	{
+		appendFmt(pGen, "%s%s p%d", (iParam > 0) ? ", " : "", pChzType, iParam);
+	}
+
+	appendFmt(pGen, ") -> %s;\n", pChzType);
+}
+
+static void appendFuncDefn(ProgramGen * pGen, int iFunc, int iOverload)
+{
+	const ProgramGenParams & params = *pGen->pParams;
+
+	pGen->gentypek = gentypekFromIOverload(iOverload);
+	pGen->aIVarInScope.cItem = 0;
+	pGen->cVar = 0;
+
+	int cParam = cParamFromIOverload(iOverload);
+
+	appendFmt(pGen, "fn f%d(", iFunc);
+	for (int iParam = 0; iParam < cParam; iParam++)
+	{
+		appendFmt(pGen, "%s%s v%d", (iParam > 0) ? ", " : "", c_mpGentypekPChzName[pGen->gentypek], pGen->cVar);
+		append(&pGen->aIVarInScope, pGen->cVar);
+		pGen->cVar++;
+	}
+	appendFmt(pGen, ")\n");
+
+	if (params.cStruct > 0)
+	{
+		appendFmt(pGen, "{\n\tS%d s;\n", randBelow(pGen, params.cStruct));
+		appendBlock(pGen, params.depthNest, 1);
+		appendFmt(pGen, "}\n\n");
+	}
+	else
+	{
+		appendBlock(pGen, params.depthNest, 0);
+		appendFmt(pGen, "\n");
+	}
+}
+
+int generateProgram(const ProgramGenParams & params, String * poStr)
+{
+	Assert(params.cStmtPerBlock > 0);
+	Assert(params.cOperandPerExpr > 0);
+
+	ProgramGen gen;
+	gen.pParams = &params;
+	gen.pStr = poStr;
+	gen.rand = (params.seed) ? params.seed : 1;		// xorshift gets stuck at 0
+	gen.gentypek = GENTYPEK_Int;
+	init(&gen.aIVarInScope);
+	gen.cVar = 0;
+	Defer(dispose(&gen.aIVarInScope));
+
+	int iChStart = poStr->cChar;
+
+	appendFmt(&gen, "// Generated by generateProgram(..), seed %u\n\n", params.seed);
+
+	for (int iGlobal = 0; iGlobal < params.cGlobal; iGlobal++)
+	{
+		gen.gentypek = static_cast<GENTYPEK>(iGlobal % GENTYPEK_Max);
+		appendFmt(&gen, "%s g%d = ", c_mpGentypekPChzName[gen.gentypek], iGlobal);
+		appendLiteral(&gen);
+		appendFmt(&gen, ";\n");
+	}
+
+	appendFmt(&gen, "\n");
+
+	for (int iStruct = 0; iStruct < params.cStruct; iStruct++)
+	{
+		appendStructDefn(&gen, iStruct);
+	}
+
+	if (params.cExtern > 0)
+	{
+		for (int iExtern = 0; iExtern < params.cExtern; iExtern++)
+		{
+			for (int iOverload = 0; iOverload <= params.cOverload; iOverload++)
+			{
+				appendExternDefn(&gen, iExtern, iOverload);
+			}
+		}
+
+		appendFmt(&gen, "\n");
+	}
+
+	for (int iFunc = 0; iFunc < params.cFunc; iFunc++)
+	{
+		for (int iOverload = 0; iOverload <= params.cOverload; iOverload++)
+		{
+			appendFuncDefn(&gen, iFunc, iOverload);
+		}
+	}
+
+	appendFmt(&gen, "fn main()\n{\n\tint x = %d;\n\tprint(x);\n}\n", params.cFunc);
+
+	int cLine = 0;
+	for (int iCh = iChStart; iCh < poStr->cChar; iCh++)
+	{
+		if (poStr->pBuffer[iCh] == '\n')
+		{
+			cLine++;
+		}
+	}
+
+	return cLine;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "als.h"
+
+// Synthetic Meek programs for benchmarking. Output is deterministic for a given set of params, so timings from
+//	different builds are comparable.
+//
+// NOTE (andrew) Only generates things the whole pipeline can currently handle. Funcs don't return values or call each
+//	other, since the bytecode builder doesn't support that yet, so calls all go to extern funcs instead. Struct defns
+//	trip an assert in computeScopedVariableOffsets, so cStruct should stay 0 until that's sorted out.
+
+struct ProgramGenParams
+{
+	int cFunc;					// Distinct func names, not counting main
+	int cOverload;				// Extra defns of each func and extern name, each with a different param list
+	int cExtern;				// Distinct extern func names. Func bodies call them, picking an overload by arg types.
+	int cStruct;
+	int cGlobal;
+	int depthNest;				// How deep blocks, ifs and whiles nest inside each func body
+	int cStmtPerBlock;
+	int cOperandPerExpr;
+	u32 seed;
+};
+
+void init(ProgramGenParams * pParams);
+
+// Appends the program to poStr. Returns the number of lines appended.
+
+int generateProgram(const ProgramGenParams & params, String * poStr);
@@ -0,0 +1,428 @@
+#include "report.h"
+
+#include "ast.h"
+#include "bytecode.h"
+#include "global_context.h"
+#include "parse.h"
+#include "print.h"
+#include "scan.h"
+#include "type.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+static const char * c_mpPhasekStrName[] =
+{
+	"scan",
+	"parse",
+	"parse.split",
+	"parse.chunks",
+	"parse.merge",
+	"parse.scanAhead",
+	"resolveTypes",
+	"computeOffsets",
+	"resolve",
+	"resolve.audit",
+	"resolve.stmts",
+	"resolve.flushTypes",
+	"emit",
+	"emit.funcs",
+	"emit.link",
+	"verify",
+	"interpret",
+};
+StaticAssert(ArrayLen(c_mpPhasekStrName) == PHASEK_Max);
+
+static const char * c_mpAllockStrName[] =
+{
+	"poolBuckets",
+	"arrayGrows",
+	"hashGrows",
+	"stringGrows",
+};
+StaticAssert(ArrayLen(c_mpAllockStrName) == ALLOCK_Max);
+
+const char * strFromPhasek(PHASEK phasek)
+{
+	Assert(phasek >= 0 && phasek < PHASEK_Max);
+	return c_mpPhasekStrName[phasek];
+}
+
+// Allocation counting
+//
+//	Allocations happen on every worker, so the counts are atomic. They are only bumped once there is a report (or a
+//	benchmark asks for them), so that an uninstrumented compile doesn't pay for the contention.
+
+static bool s_countsAllocs = false;
+static std::atomic<s64> s_mpAllockCAlloc[ALLOCK_Max];
+static std::atomic<s64> s_mpAllockCByte[ALLOCK_Max];
+
+void countAlloc(ALLOCK allock, size_t cByte)
+{
+	if (!s_countsAllocs)
+		return;
+
+	s_mpAllockCAlloc[allock].fetch_add(1, std::memory_order_relaxed);
+	s_mpAllockCByte[allock].fetch_add(static_cast<s64>(cByte), std::memory_order_relaxed);
+}
+
+void startCountingAllocs()
+{
+	s_countsAllocs = true;
+}
+
+void readAllocCounts(AllocCounts * poAllocs)
+{
+	for (int allock = 0; allock < ALLOCK_Max; allock++)
+	{
+		poAllocs->mpAllockCAlloc[allock] = s_mpAllockCAlloc[allock].load(std::memory_order_relaxed);
+		poAllocs->mpAllockCByte[allock] = s_mpAllockCByte[allock].load(std::memory_order_relaxed);
+	}
+}
+
+// Clocks and memory
+
+s64 nsWallNow()
+{
+	auto duration = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+static s64 nsCpuNow()
+{
+#ifdef _MSC_VER
+	FILETIME ftCreate, ftExit, ftKernel, ftUser;
+	if (!GetProcessTimes(GetCurrentProcess(), &ftCreate, &ftExit, &ftKernel, &ftUser))
+		return 0;
+
+	u64 kernel = (u64(ftKernel.dwHighDateTime) << 32) | ftKernel.dwLowDateTime;
+	u64 user = (u64(ftUser.dwHighDateTime) << 32) | ftUser.dwLowDateTime;
+	return s64(kernel + user) * 100;		// 100 ns ticks
+#else
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return s64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static s64 cBytePeakNow()
+{
+#ifdef _MSC_VER
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+
+	return s64(pmc.PeakWorkingSetSize);
+#else
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return s64(usage.ru_maxrss) * 1024;		// KB on Linux
+#endif
+}
+
+// Recording
+
+void init(CompileReport * pReport)
+{
+	ClearStruct(pReport);
+	pReport->nsWallStart = nsWallNow();
+
+	startCountingAllocs();
+}
+
+void beginPhase(CompileReport * pReport, PHASEK phasek)
+{
+	if (!pReport)
+		return;
+
+	CompileReport::Phase * pPhase = &pReport->mpPhasekPhase[phasek];
+	pPhase->nsWallStart = nsWallNow();
+	pPhase->nsCpuStart = nsCpuNow();
+	readAllocCounts(&pPhase->allocsStart);
+}
+
+void endPhase(CompileReport * pReport, PHASEK phasek)
+{
+	if (!pReport)
+		return;
+
+	CompileReport::Phase * pPhase = &pReport->mpPhasekPhase[phasek];
+	Assert(!pPhase->isSummed);
+
+	AllocCounts allocs;
+	readAllocCounts(&allocs);
+
+	pPhase->isRecorded = true;
+	pPhase->nsWall += nsWallNow() - pPhase->nsWallStart;
+	pPhase->nsCpu += nsCpuNow() - pPhase->nsCpuStart;
+	pPhase->cBytePeak = cBytePeakNow();
+
+	for (int allock = 0; allock < ALLOCK_Max; allock++)
+	{
+		pPhase->allocs.mpAllockCAlloc[allock] += allocs.mpAllockCAlloc[allock] - pPhase->allocsStart.mpAllockCAlloc[allock];
+		pPhase->allocs.mpAllockCByte[allock] += allocs.mpAllockCByte[allock] - pPhase->allocsStart.mpAllockCByte[allock];
+	}
+}
+
+void addPhaseTime(CompileReport * pReport, PHASEK phasek, s64 nsWall)
+{
+	if (!pReport)
+		return;
+
+	CompileReport::Phase * pPhase = &pReport->mpPhasekPhase[phasek];
+	pPhase->isRecorded = true;
+	pPhase->isSummed = true;
+	pPhase->nsWall += nsWall;
+}
+
+// Output
+
+struct ReportCounts
+{
+	int cToken;
+	int cNode;
+	int cScope;
+	int cFunc;
+	int cType;
+	int cTypePending;
+	int cByteBytecode;
+};
+
+static void computeCounts(const MeekCtx & ctx, const BytecodeProgram * pBcp, ReportCounts * poCounts)
+{
+	poCounts->cToken = ctx.scanner->iToken;
+	poCounts->cNode = static_cast<int>(ctx.parser->iNode);
+	poCounts->cScope = ctx.scopes.cItem;
+	poCounts->cFunc = ctx.functions.cItem;
+	poCounts->cType = ctx.typeTable->apType.cItem - static_cast<int>(TypeId::mFirstResolved);
+	poCounts->cTypePending = ctx.typeTable->typesPendingResolution.cItem;
+	poCounts->cByteBytecode = (pBcp) ? pBcp->bytes.cItem : 0;
+}
+
+static int compareBcfBySizeDescending(const BytecodeFunction & bcf0, const BytecodeFunction & bcf1)
+{
+	if (bcf0.cByte != bcf1.cByte)
+		return (bcf0.cByte > bcf1.cByte) ? -1 : 1;
+
+	return (bcf0.iByte0 < bcf1.iByte0) ? -1 : (bcf0.iByte0 > bcf1.iByte0) ? 1 : 0;
+}
+
+static double msFromNs(s64 ns)
+{
+	return double(ns) / 1000000.0;
+}
+
+static double mbFromCByte(s64 cByte)
+{
+	return double(cByte) / (1024.0 * 1024.0);
+}
+
+void printReport(const CompileReport & report, const MeekCtx & ctx, const BytecodeProgram * pBcp)
+{
+	print("Compile report\n");
+	printfmt("%-22s %10s %10s %9s %9s %9s %9s %9s %9s\n", "Phase", "Wall ms", "CPU ms", "Peak MB", "Buckets", "Arrays", "Hashes", "Strings", "Alloc MB");
+
+	for (int phasek = 0; phasek < PHASEK_Max; phasek++)
+	{
+		const CompileReport::Phase & phase = report.mpPhasekPhase[phasek];
+		if (!phase.isRecorded)
+			continue;
+
+		// Indent sub-phases under their phase
+
+		const char * pChzName = c_mpPhasekStrName[phasek];
+		const char * pChzDot = strrchr(pChzName, '.');
+		char aChName[32];
+		snprintf(aChName, sizeof(aChName), "%s%s", (pChzDot) ? "  " : "", (pChzDot) ? pChzDot + 1 : pChzName);
+
+		if (phase.isSummed)
+		{
+			printfmt("%-22s %9.2f*\n", aChName, msFromNs(phase.nsWall));
+			continue;
+		}
+
+		s64 cByteAlloc = 0;
+		for (int allock = 0; allock < ALLOCK_Max; allock++)
+		{
+			cByteAlloc += phase.allocs.mpAllockCByte[allock];
+		}
+
+		printfmt(
+			"%-22s %10.2f %10.2f %9.1f %9lld %9lld %9lld %9lld %9.1f\n",
+			aChName,
+			msFromNs(phase.nsWall),
+			msFromNs(phase.nsCpu),
+			mbFromCByte(phase.cBytePeak),
+			(long long)phase.allocs.mpAllockCAlloc[ALLOCK_PoolBucket],
+			(long long)phase.allocs.mpAllockCAlloc[ALLOCK_ArrayGrow],
+			(long long)phase.allocs.mpAllockCAlloc[ALLOCK_HashGrow],
+			(long long)phase.allocs.mpAllockCAlloc[ALLOCK_StringGrow],
+			mbFromCByte(cByteAlloc));
+	}
+
+	AllocCounts allocs;
+	readAllocCounts(&allocs);
+
+	printfmt("%-22s %10.2f\n", "total", msFromNs(nsWallNow() - report.nsWallStart));
+	print("* Summed across workers\n");
+	println();
+
+	printfmt("Peak memory: %.1f MB\n", mbFromCByte(cBytePeakNow()));
+	for (int allock = 0; allock < ALLOCK_Max; allock++)
+	{
+		printfmt(
+			"%s: %lld (%.1f MB)\n",
+			c_mpAllockStrName[allock],
+			(long long)allocs.mpAllockCAlloc[allock],
+			mbFromCByte(allocs.mpAllockCByte[allock]));
+	}
+
+	ReportCounts counts;
+	computeCounts(ctx, pBcp, &counts);
+
+	printfmt(
+		"Tokens: %d, nodes: %d, scopes: %d, funcs: %d, types: %d, pending types: %d\n",
+		counts.cToken,
+		counts.cNode,
+		counts.cScope,
+		counts.cFunc,
+		counts.cType,
+		counts.cTypePending);
+
+	if (!pBcp || pBcp->bytecodeFuncs.cItem == 0)
+		return;
+
+	int cFunc = pBcp->bytecodeFuncs.cItem;
+	printfmt("Bytecode: %d bytes in %d funcs, %d on average\n", counts.cByteBytecode, cFunc, counts.cByteBytecode / cFunc);
+
+	DynamicArray<BytecodeFunction> aBcfSorted;
+	init(&aBcfSorted);
+	Defer(dispose(&aBcfSorted));
+	appendMultiple(&aBcfSorted, pBcp->bytecodeFuncs.pBuffer, cFunc);
+	introSort(aBcfSorted.pBuffer, cFunc, &compareBcfBySizeDescending);
+
+	static const int s_cFuncLargest = 10;
+	int cFuncPrint = Min(cFunc, s_cFuncLargest);
+
+	print("Largest funcs:\n");
+	for (int iBcf = 0; iBcf < cFuncPrint; iBcf++)
+	{
+		StringView strvName = strvFuncName(aBcfSorted[iBcf]);
+		printfmt("  %-20.*s %9d\n", strvName.cCh, strvName.pCh, aBcfSorted[iBcf].cByte);
+	}
+}
+
+static void writeAllocCountsJson(FILE * file, const AllocCounts & allocs)
+{
+	fprintf(file, "{");
+	for (int allock = 0; allock < ALLOCK_Max; allock++)
+	{
+		fprintf(
+			file,
+			"%s\"%s\": { \"count\": %lld, \"bytes\": %lld }",
+			(allock > 0) ? ", " : "",
+			c_mpAllockStrName[allock],
+			(long long)allocs.mpAllockCAlloc[allock],
+			(long long)allocs.mpAllockCByte[allock]);
+	}
+	fprintf(file, "}");
+}
+
+bool tryWriteReportJson(const CompileReport & report, const MeekCtx & ctx, const BytecodeProgram * pBcp, const char * pChzFilename)
+{
+	FILE * file = fopen(pChzFilename, "wb");
+	if (!file)
+		return false;
+
+	Defer(fclose(file));
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"totalMs\": %.3f,\n", msFromNs(nsWallNow() - report.nsWallStart));
+	fprintf(file, "\t\"peakBytes\": %lld,\n", (long long)cBytePeakNow());
+
+	// Phases
+
+	fprintf(file, "\t\"phases\": [\n");
+
+	bool isFirst = true;
+	for (int phasek = 0; phasek < PHASEK_Max; phasek++)
+	{
+		const CompileReport::Phase & phase = report.mpPhasekPhase[phasek];
+		if (!phase.isRecorded)
+			continue;
+
+		fprintf(file, "%s\t\t{ \"name\": \"%s\", \"wallMs\": %.3f", (isFirst) ? "" : ",\n", c_mpPhasekStrName[phasek], msFromNs(phase.nsWall));
+		isFirst = false;
+
+		if (phase.isSummed)
+		{
+			fprintf(file, ", \"summed\": true }");
+			continue;
+		}
+
+		fprintf(file, ", \"cpuMs\": %.3f, \"peakBytes\": %lld, \"allocs\": ", msFromNs(phase.nsCpu), (long long)phase.cBytePeak);
+		writeAllocCountsJson(file, phase.allocs);
+		fprintf(file, " }");
+	}
+
+	fprintf(file, "\n\t],\n");
+
+	// Totals
+
+	AllocCounts allocs;
+	readAllocCounts(&allocs);
+
+	fprintf(file, "\t\"allocs\": ");
+	writeAllocCountsJson(file, allocs);
+	fprintf(file, ",\n");
+
+	ReportCounts counts;
+	computeCounts(ctx, pBcp, &counts);
+
+	fprintf(
+		file,
+		"\t\"counts\": { \"tokens\": %d, \"nodes\": %d, \"scopes\": %d, \"funcs\": %d, \"types\": %d, \"pendingTypes\": %d },\n",
+		counts.cToken,
+		counts.cNode,
+		counts.cScope,
+		counts.cFunc,
+		counts.cType,
+		counts.cTypePending);
+
+	// Bytecode, in func id order. Func names are identifiers, so they never need escaping. stackMax is -1 if the program
+	//	wasn't verified.
+
+	fprintf(file, "\t\"bytecode\": {\n\t\t\"bytes\": %d,\n\t\t\"funcs\": [", counts.cByteBytecode);
+
+	int cBcf = (pBcp) ? pBcp->bytecodeFuncs.cItem : 0;
+	for (int iBcf = 0; iBcf < cBcf; iBcf++)
+	{
+		const BytecodeFunction & bcf = pBcp->bytecodeFuncs[iBcf];
+		StringView strvName = strvFuncName(bcf);
+
+		fprintf(
+			file,
+			"%s\n\t\t\t{ \"name\": \"%.*s\", \"bytes\": %d, \"stackMax\": %d }",
+			(iBcf > 0) ? "," : "",
+			strvName.cCh,
+			strvName.pCh,
+			bcf.cByte,
+			bcf.cByteStackMax);
+	}
+
+	fprintf(file, "%s]\n\t}\n}\n", (cBcf > 0) ? "\n\t\t" : "");
+	return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "als.h"
+
+struct BytecodeProgram;
+struct MeekCtx;
+
+// Compile report, like -ftime-report. Off unless the driver gives the ctx a report, then the driver and each phase's
+//	entry point record how long the phase took, how big the process had gotten by the time it was done, and how many
+//	allocations were made while it ran. Sub-phases are named "<phase>.<sub-phase>" and nest inside their phase.
+
+enum PHASEK
+{
+	PHASEK_Scan,				// Scanning on its own, without parsing. Only the benchmark does this
+	PHASEK_Parse,
+	PHASEK_ParseSplit,			// Finding chunks to parse in parallel
+	PHASEK_ParseChunks,
+	PHASEK_ParseMerge,
+	PHASEK_ParseScanAhead,		// On the scanner thread
+	PHASEK_ResolveTypes,
+	PHASEK_ComputeOffsets,
+	PHASEK_Resolve,
+	PHASEK_ResolveAudit,
+	PHASEK_ResolveStmts,
+	PHASEK_ResolveFlushTypes,
+	PHASEK_Emit,
+	PHASEK_EmitFuncs,			// Summed across workers when emitting as resolve goes
+	PHASEK_EmitLink,
+	PHASEK_Verify,
+	PHASEK_Interpret,
+
+	PHASEK_Max,
+	PHASEK_Nil = -1
+};
+
+const char * strFromPhasek(PHASEK phasek);
+
+struct AllocCounts
+{
+	s64 mpAllockCAlloc[ALLOCK_Max];
+	s64 mpAllockCByte[ALLOCK_Max];
+};
+
+struct CompileReport
+{
+	struct Phase
+	{
+		bool isRecorded;
+		bool isSummed;				// Time was added up from work items, possibly on several threads at once
+
+		// NOTE (andrew) CPU time and allocations are for the whole process while the phase ran, so they count every
+		//	worker, and anything else that overlapped (e.g., parsing while the scanner thread runs).
+
+		s64 nsWall;
+		s64 nsCpu;
+		s64 cBytePeak;				// Process peak once the phase was done
+		AllocCounts allocs;
+
+		// While running
+
+		s64 nsWallStart;
+		s64 nsCpuStart;
+		AllocCounts allocsStart;
+	};
+
+	Phase mpPhasekPhase[PHASEK_Max];
+	s64 nsWallStart;
+};
+
+void init(CompileReport * pReport);
+
+// All of these do nothing if pReport is null, so callers can pass along whatever their ctx has
+
+void beginPhase(NULLABLE CompileReport * pReport, PHASEK phasek);
+void endPhase(NULLABLE CompileReport * pReport, PHASEK phasek);
+void addPhaseTime(NULLABLE CompileReport * pReport, PHASEK phasek, s64 nsWall);
+
+s64 nsWallNow();
+
+// Allocation counts for the whole process so far. Nothing is counted until a report is init'd or this is turned on.
+
+void startCountingAllocs();
+void readAllocCounts(AllocCounts * poAllocs);
+
+// Output. The JSON has the same numbers as the table, plus every func's bytecode size and stack use, for tracking regressions.
+
+void printReport(const CompileReport & report, const MeekCtx & ctx, NULLABLE const BytecodeProgram * pBcp);
+bool tryWriteReportJson(const CompileReport & report, const MeekCtx & ctx, NULLABLE const BytecodeProgram * pBcp, const char * pChzFilename);
@@ -1,15 +1,57 @@
 #include "resolve.h"
 
 #include "ast.h"
+#include "ast_decorate.h"
 #include "error.h"
 #include "global_context.h"
+#include "host_func.h"
+#include "parallel.h"
 #include "parse.h"
 #include "print.h"
+#include "report.h"
 #include "symbol.h"
 #include "type.h"
 
 #define SetBubbleIfUnresolved(typid) do { if (!isTypeResolved(typid)) (typid) = TypeId::BubbleError; } while(0)
 
+static u32 overloadSetKeyHash(const ResolvePass::OverloadSetKey & key)
+{
+	u32 hash = startHash(&key.scopeid, sizeof(key.scopeid));
+	hash = combineHash(hash, key.lexeme.hash);
+	return buildHash(&key.ignoreVars, sizeof(key.ignoreVars), hash);
+}
+
+static bool overloadSetKeyEq(const ResolvePass::OverloadSetKey & key0, const ResolvePass::OverloadSetKey & key1)
+{
+	return
+		key0.scopeid == key1.scopeid &&
+		key0.ignoreVars == key1.ignoreVars &&
+		lexemeEq(key0.lexeme, key1.lexeme);
+}
+
+static u32 overloadMatchKeyHash(const ResolvePass::OverloadMatchKey & key)
+{
+	u32 hash = overloadSetKeyHash(key.overloadSetKey);
+	return buildHash(itemBuffer(key.aTypidArg), key.aTypidArg.cItem * sizeof(TypeId), hash);
+}
+
+static bool overloadMatchKeyEq(const ResolvePass::OverloadMatchKey & key0, const ResolvePass::OverloadMatchKey & key1)
+{
+	if (!overloadSetKeyEq(key0.overloadSetKey, key1.overloadSetKey))
+		return false;
+
+	if (key0.aTypidArg.cItem != key1.aTypidArg.cItem)
+		return false;
+
+	for (int iTypid = 0; iTypid < key0.aTypidArg.cItem; iTypid++)
+	{
+		if (key0.aTypidArg[iTypid] != key1.aTypidArg[iTypid])
+			return false;
+	}
+
+	return true;
+}
+
 void init(ResolvePass * pPass, MeekCtx * pCtx)
 {
 	pPass->pCtx = pCtx;
@@ -18,17 +60,39 @@ void init(ResolvePass * pPass, MeekCtx * pCtx)
 	init(&pPass->unresolvedIdents);
 	init(&pPass->fnCtxStack);
 	init(&pPass->scopeidStack);
+	init(&pPass->overloadSets, overloadSetKeyHash, overloadSetKeyEq);
+	init(&pPass->overloadMatches, overloadMatchKeyHash, overloadMatchKeyEq);
+	init(&pPass->typeInsertBuffer, pCtx->typeTable);
 
 	pPass->hadError = false;
 	pPass->cNestedBreakable = 0;
 }
 
+void dispose(ResolvePass * pPass)
+{
+	for (auto it = iter(pPass->overloadSets); it.pValue; iterNext(&it))
+	{
+		dispose(it.pValue);
+	}
+
+	for (auto it = iter(pPass->overloadMatches); it.pKey; iterNext(&it))
+	{
+		dispose(const_cast<SmallArray<TypeId, 4> *>(&it.pKey->aTypidArg));
+	}
+
+	dispose(&pPass->unresolvedIdents);
+	dispose(&pPass->fnCtxStack);
+	dispose(&pPass->scopeidStack);
+	dispose(&pPass->overloadSets);
+	dispose(&pPass->overloadMatches);
+	dispose(&pPass->typeInsertBuffer);
+}
+
 void pushAndProcessScope(ResolvePass * pPass, SCOPEID scopeid)
 {
 	MeekCtx * pCtx = pPass->pCtx;
 
 	push(&pPass->scopeidStack, scopeid);
-	auditDuplicateSymbols(pCtx, pCtx->scopes[scopeid]);
 	computeScopedVariableOffsets(pCtx, pCtx->scopes[scopeid]);
 }
 
@@ -37,7 +101,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 	Assert(category(pNode->astk) == ASTCATK_Expr);
 
 	MeekCtx * pCtx = pPass->pCtx;
-	TypeTable * typeTable = pCtx->typeTable;
+	const TypeInsertBuffer & typeBuffer = pPass->typeInsertBuffer;
 
 	TypeId typidResult = TypeId::Unresolved;
 
@@ -64,6 +128,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 			{
 				// TODO: report error
 
+				pPass->hadError = true;
 				printfmt("Binary operator type mismatch. L: %d, R: %d\n", typidLhs, typidRhs);
 				typidResult = TypeId::TypeError;
 				goto LEndSetTypidAndReturn;
@@ -137,10 +202,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					typePtr.modTypeData.typemod.typemodk = TYPEMODK_Pointer;
 					typePtr.modTypeData.typidModified = typidExpr;
 
-					auto ensureResult = ensureInTypeTable(typeTable, &typePtr);
-					Assert(ensureResult.typeInfoComputed);
-
-					typidResult = ensureResult.typid;
+					typidResult = ensureInTypeInsertBuffer(&pPass->typeInsertBuffer, &typePtr);
 				} break;
 
 				default:
@@ -160,45 +222,65 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 				{
 					Assert(pExpr->unresolvedData.aCandidates.cItem == 0);
 
-					// Lookup all funcs matching this identifier
-
 					SCOPEID scopeidCur = peek(pPass->scopeidStack);
-					Scope * pScopeCur = pCtx->scopes[scopeidCur];
-					lookupFuncSymbol(*pScopeCur, pExpr->ident, &pExpr->unresolvedData.aCandidates);
 
-					// Lookup var matching this identifier, and slot it in where it fits
+					ResolvePass::OverloadSetKey overloadSetKey;
+					overloadSetKey.scopeid = scopeidCur;
+					overloadSetKey.lexeme = pExpr->ident;
+					overloadSetKey.ignoreVars = pExpr->ignoreVars;
 
-					if (!pExpr->unresolvedData.ignoreVars)
+					DynamicArray<SymbolInfo> * paSymbInfoOverloadSet = lookup(pPass->overloadSets, overloadSetKey);
+					if (!paSymbInfoOverloadSet)
 					{
-						SymbolInfo symbInfoVar = lookupVarSymbol(*pScopeCur, pExpr->ident);
+						paSymbInfoOverloadSet = insertNew(&pPass->overloadSets, overloadSetKey);
+						init(paSymbInfoOverloadSet);
+
+						// Lookup all funcs matching this identifier
 
-						if (symbInfoVar.symbolk != SYMBOLK_Nil)
+						Scope * pScopeCur = pCtx->scopes[scopeidCur];
+						lookupFuncSymbol(*pScopeCur, pExpr->ident, paSymbInfoOverloadSet);
+
+						// Lookup var matching this identifier, and slot it in where it fits
+
+						if (!pExpr->ignoreVars)
 						{
-							Assert(symbInfoVar.symbolk == SYMBOLK_Var);
-							SCOPEID scopeidVar = symbInfoVar.varData.pVarDeclStmt->ident.scopeid;
+							SymbolInfo symbInfoVar = lookupVarSymbol(*pScopeCur, pExpr->ident);
 
-							int iInsert = 0;
-							for (int iCandidate = 0; iCandidate < pExpr->unresolvedData.aCandidates.cItem; iCandidate++)
+							if (symbInfoVar.symbolk != SYMBOLK_Nil)
 							{
-								SymbolInfo symbInfoCandidate = pExpr->unresolvedData.aCandidates[iCandidate];
-								Assert(symbInfoCandidate.symbolk == SYMBOLK_Func);
+								Assert(symbInfoVar.symbolk == SYMBOLK_Var);
+								SCOPEID scopeidVar = symbInfoVar.varData.pVarDeclStmt->ident.scopeid;
 
-								SCOPEID scopeidFunc = symbInfoCandidate.funcData.pFuncDefnStmt->ident.scopeid;
-								
-								if (scopeidVar >= scopeidFunc)
+								int iInsert = 0;
+								for (int iCandidate = 0; iCandidate < paSymbInfoOverloadSet->cItem; iCandidate++)
 								{
-									iInsert = iCandidate;
-									break;
+									SymbolInfo symbInfoCandidate = (*paSymbInfoOverloadSet)[iCandidate];
+									Assert(symbInfoCandidate.symbolk == SYMBOLK_Func);
+
+									SCOPEID scopeidFunc = symbInfoCandidate.funcData.pFuncDefnStmt->ident.scopeid;
+								
+									if (scopeidVar >= scopeidFunc)
+									{
+										iInsert = iCandidate;
+										break;
+									}
 								}
-							}
 
-							insert(&pExpr->unresolvedData.aCandidates, symbInfoVar, iInsert);
+								insert(paSymbInfoOverloadSet, symbInfoVar, iInsert);
+							}
 						}
 					}
 
+					appendMultiple(&pExpr->unresolvedData.aCandidates, paSymbInfoOverloadSet->pBuffer, paSymbInfoOverloadSet->cItem);
+
 					if (pExpr->unresolvedData.aCandidates.cItem == 1)
 					{
 						SymbolInfo symbInfo = pExpr->unresolvedData.aCandidates[0];
+
+						// Shares a union with the data we're about to set
+
+						dispose(&pExpr->unresolvedData.aCandidates);
+
 						if (symbInfo.symbolk == SYMBOLK_Var)
 						{
 							pExpr->symbexprk = SYMBEXPRK_Var;
@@ -222,6 +304,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					}
 					else
 					{
+						pPass->hadError = true;
 						print("Unresolved variable ");
 						print(pExpr->ident.strv);
 						println();
@@ -254,11 +337,12 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 						goto LEndSetTypidAndReturn;
 					}
 
-					const Type * pOwnerType = lookupType(*typeTable, ownerTypid);
+					const Type * pOwnerType = lookupType(typeBuffer, ownerTypid);
 					Assert(pOwnerType);
 
 					if (pOwnerType->typek == TYPEK_Func)
 					{
+						pPass->hadError = true;
 						print("Trying to access data member of a function?");
 						typidResult = TypeId::TypeError;
 						goto LEndSetTypidAndReturn;
@@ -287,6 +371,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 						// Unresolved
 						// TODO: Add this to a resolve error list... don't print inline right here!
 
+						pPass->hadError = true;
 						print("Unresolved member variable ");
 						print(pExpr->ident.strv);
 						println();
@@ -316,21 +401,23 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 
 					lookupFuncSymbol(*pScopeCur, pExpr->ident, &aSymbInfoFuncCandidates);
 
+					DynamicArray<TypeId> aTypidDisambig = getTypidDisambig(*pCtx->astDecorations, pNode->astid);
+
 					AstFuncDefnStmt * pFuncDefnStmtMatch = nullptr;
 					for (int iCandidate = 0; iCandidate < aSymbInfoFuncCandidates.cItem; iCandidate++)
 					{
 						Assert(aSymbInfoFuncCandidates[iCandidate].symbolk == SYMBOLK_Func);
 
 						AstFuncDefnStmt * pCandidateDefnStmt = aSymbInfoFuncCandidates[iCandidate].funcData.pFuncDefnStmt;
-						if (pCandidateDefnStmt->pParamsReturnsGrp->apParamVarDecls.cItem != pExpr->funcData.aTypidDisambig.cItem)
+						if (pCandidateDefnStmt->pParamsReturnsGrp->apParamVarDecls.cItem != aTypidDisambig.cItem)
 						{
 							continue;
 						}
 
 						bool allArgsMatch = true;
-						for (int iParam = 0; iParam < pExpr->funcData.aTypidDisambig.cItem; iParam++)
+						for (int iParam = 0; iParam < aTypidDisambig.cItem; iParam++)
 						{
-							TypeId typidDisambig = pExpr->funcData.aTypidDisambig[iParam];
+							TypeId typidDisambig = aTypidDisambig[iParam];
 							Assert(isTypeResolved(typidDisambig));
 
 							Assert(pCandidateDefnStmt->pParamsReturnsGrp->apParamVarDecls[iParam]->astk == ASTK_VarDeclStmt);
@@ -369,6 +456,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 						// Unresolved
 						// TODO: Add this to a resolve error list... don't print inline right here!
 
+						pPass->hadError = true;
 						print("Unresolved func identifier ");
 						print(pExpr->ident.strv);
 						println();
@@ -390,11 +478,12 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 				goto LEndSetTypidAndReturn;
 			}
 
-			const Type * pTypePtr = lookupType(*typeTable, typidPtr);
+			const Type * pTypePtr = lookupType(typeBuffer, typidPtr);
 			Assert(pTypePtr);
 
 			if (!isPointerType(*pTypePtr))
 			{
+				pPass->hadError = true;
 				print("Trying to dereference a non-pointer\n");
 				typidResult = TypeId::TypeError;
 				goto LEndSetTypidAndReturn;
@@ -424,10 +513,11 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 				// TODO: report error here, but keep on chugging with the resolve... despite the incorrect subscript, we still
 				//	know what type an array access will end up as.
 
+				pPass->hadError = true;
 				print("Trying to access array with a non integer\n");
 			}
 
-			const Type * pTypeArray = lookupType(*typeTable, typidArray);
+			const Type * pTypeArray = lookupType(typeBuffer, typidArray);
 			Assert(pTypeArray);
 
 			if (!isArrayType(*pTypeArray))
@@ -436,6 +526,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 				//	How am I going to report these errors? Should I just maintain a list separate from the
 				//	fact that I am returning error TYPID's?
 
+				pPass->hadError = true;
 				print("Trying to access non-array as if it were an array...\n");
 				typidResult = TypeId::TypeError;
 				goto LEndSetTypidAndReturn;
@@ -482,7 +573,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 
 			if (pExpr->pFunc->astk != ASTK_SymbolExpr)
 			{
-				const Type * pType = lookupType(*typeTable, typidCallingExpr);
+				const Type * pType = lookupType(typeBuffer, typidCallingExpr);
 				Assert(pType);
 
 				switch (pType->typek)
@@ -492,6 +583,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					{
 						// TODO: better messaging
 
+						pPass->hadError = true;
 						print("Calling non-function as if it were a function");
 						println();
 
@@ -512,6 +604,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 
 							// TODO: better messaging
 
+							pPass->hadError = true;
 							printfmt(
 								"Calling function that expects %d arguments, but only providing %d",
 								pFuncType->paramTypids.cItem,
@@ -533,6 +626,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 								{
 									// TODO: better messaging
 
+									pPass->hadError = true;
 									print("Function call type mismatch");
 
 									typidResult = TypeId::TypeError;
@@ -579,6 +673,40 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 				{
 					Assert(pFuncSymbolExpr->symbexprk == SYMBEXPRK_Unresolved);
 
+					// NOTE (andrew) Same name, same scope, and same argument types always pick the same overload, so remember
+					//	the pick. Args that still have candidates depend on the arg expression itself, so those calls aren't memoized.
+
+					ResolvePass::OverloadMatchKey overloadMatchKey;
+					overloadMatchKey.overloadSetKey.scopeid = peek(pPass->scopeidStack);
+					overloadMatchKey.overloadSetKey.lexeme = pFuncSymbolExpr->ident;
+					overloadMatchKey.overloadSetKey.ignoreVars = pFuncSymbolExpr->ignoreVars;
+					init(&overloadMatchKey.aTypidArg);
+
+					bool isMatchKeyOwnedByMap = false;
+					Defer(if (!isMatchKeyOwnedByMap) dispose(&overloadMatchKey.aTypidArg));
+
+					bool canMemoizeMatch = true;
+					for (int iTypidArg = 0; iTypidArg < aTypidArg.cItem; iTypidArg++)
+					{
+						if (!isTypeResolved(aTypidArg[iTypidArg]))
+						{
+							canMemoizeMatch = false;
+							break;
+						}
+					}
+
+					if (canMemoizeMatch)
+					{
+						appendMultiple(&overloadMatchKey.aTypidArg, aTypidArg.pBuffer, aTypidArg.cItem);
+
+						AstNode ** ppNodeDefnclMemo = lookup(pPass->overloadMatches, overloadMatchKey);
+						if (ppNodeDefnclMemo)
+						{
+							pNodeDefnclMatch = *ppNodeDefnclMemo;
+							goto LOverloadMatched;
+						}
+					}
+
 					// TODO: Move this out to be a symbol-table related query in symbol.cpp
 
 					// NOTE (andrew) The ordering of the candidates was set by resolveExpr(..), and is important for correctness. To facilitate
@@ -613,7 +741,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 							continue;
 						}
 
-						const Type * pTypeCandidate = lookupType(*typeTable, typidCandidate);
+						const Type * pTypeCandidate = lookupType(typeBuffer, typidCandidate);
 						Assert(pTypeCandidate);
 
 						if (pTypeCandidate->typek != TYPEK_Func)
@@ -740,6 +868,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 									//	if the rest of the parameters match too! Otherwise we just
 									//	discard this func candidate from consideration anyways.
 
+									pPass->hadError = true;
 									print("Ambiguous function call ");
 									print(pFuncSymbolExpr->ident.strv);
 									typidResult = TypeId::TypeError;
@@ -799,6 +928,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					{
 						// TODO: better reporting
 
+						pPass->hadError = true;
 						print("Ambiguous function call ");
 						print(pFuncSymbolExpr->ident.strv);
 						println();
@@ -809,6 +939,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					{
 						// TODO: better reporting
 
+						pPass->hadError = true;
 						print("No func named ");
 						print(pFuncSymbolExpr->ident.strv);
 						print(" matches the provided parameters");
@@ -816,16 +947,29 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 						typidResult = TypeId::TypeError;
 						goto LEndSetTypidAndReturn;
 					}
+
+					if (canMemoizeMatch)
+					{
+						insert(&pPass->overloadMatches, overloadMatchKey, pNodeDefnclMatch);
+						isMatchKeyOwnedByMap = true;
+					}
 				}
 
+			LOverloadMatched:
 				Assert(pNodeDefnclMatch);
+
+				if (pFuncSymbolExpr->symbexprk == SYMBEXPRK_Unresolved)
+				{
+					dispose(&pFuncSymbolExpr->unresolvedData.aCandidates);
+				}
+
 				const Type * pType = nullptr;
 				if (pNodeDefnclMatch->astk == ASTK_VarDeclStmt)
 				{
 					auto * pNodeVarDeclStmt = Down(pNodeDefnclMatch, VarDeclStmt);
 					Assert(isTypeResolved(pNodeVarDeclStmt->typidDefn));
 
-					pType = lookupType(*typeTable, pNodeVarDeclStmt->typidDefn);
+					pType = lookupType(typeBuffer, pNodeVarDeclStmt->typidDefn);
 
 					pFuncSymbolExpr->symbexprk = SYMBEXPRK_Var;
 					pFuncSymbolExpr->varData.pDeclCached = pNodeVarDeclStmt;
@@ -837,10 +981,30 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 					auto * pNodeFuncDefnStmt = Down(pNodeDefnclMatch, FuncDefnStmt);
 					Assert(isTypeResolved(pNodeFuncDefnStmt->typidDefn));
 
-					pType = lookupType(*typeTable, pNodeFuncDefnStmt->typidDefn);
+					pType = lookupType(typeBuffer, pNodeFuncDefnStmt->typidDefn);
 
 					pFuncSymbolExpr->symbexprk = SYMBEXPRK_Func;
 					pFuncSymbolExpr->funcData.pDefnCached = pNodeFuncDefnStmt;
+
+					if (isExternFunc(*pNodeDefnclMatch))
+					{
+						int cByteArg;
+						int cByteReturn;
+						computeHostCallSizes(*pCtx->typeTable, pType->funcTypeData.funcType, &cByteArg, &cByteReturn);
+
+						if (cByteArg > c_cByteHostCallMax || cByteReturn > c_cByteHostCallMax)
+						{
+							pPass->hadError = true;
+							printfmt(
+								"Call to extern func '%.*s' passes %d bytes of args and %d of return, but the most either can be is %d (line %d)\n",
+								pFuncSymbolExpr->ident.strv.cCh,
+								pFuncSymbolExpr->ident.strv.pCh,
+								cByteArg,
+								cByteReturn,
+								c_cByteHostCallMax,
+								getStartLine(*pCtx, pNode->astid));
+						}
+					}
 				}
 
 				Assert(pType);
@@ -871,6 +1035,7 @@ void resolveExpr(ResolvePass * pPass, AstNode * pNode)
 			ResolvePass::FnCtx fnCtx = pop(&pPass->fnCtxStack);
 			dispose(&fnCtx.aTypidReturn);
 
+			computeFrameLayout(pCtx, pCtx->scopes[pExpr->pParamsReturnsGrp->scopeid]);
 			pop(&pPass->scopeidStack);
 		} break;
 
@@ -884,6 +1049,11 @@ LEndSetTypidAndReturn:
 
 	AstExpr * pExpr = DownExpr(pNode);
 	pExpr->typidEval = typidResult;
+
+	if (isTypidBuffered(typidResult))
+	{
+		addTypidUpdateOnFlush(&pPass->typeInsertBuffer, &pExpr->typidEval);
+	}
 }
 
 void resolveStmt(ResolvePass * pPass, AstNode * pNode)
@@ -891,7 +1061,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 	Assert(category(pNode->astk) == ASTCATK_Stmt);
 
 	MeekCtx * pCtx = pPass->pCtx;
-	TypeTable * typeTable = pCtx->typeTable;
+	const TypeInsertBuffer & typeBuffer = pPass->typeInsertBuffer;
 
 	switch (pNode->astk)
 	{
@@ -911,6 +1081,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 			if (!isLValue(pStmt->pLhsExpr->astk))
 			{
 				// TOOD: report error
+				pPass->hadError = true;
 				print("Assigning to non-lvalue\n");
 			}
 			else
@@ -920,6 +1091,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 					if (typidLhs != typidRhs)
 					{
 						// TODO: report error
+						pPass->hadError = true;
 						printfmt("Assignment type error. L: %d, R: %d\n", typidLhs, typidRhs);
 					}
 				}
@@ -931,7 +1103,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 			auto * pStmt = Down(pNode, VarDeclStmt);
 
 			AssertInfo(isTypeResolved(pStmt->typidDefn), "Inferred types are TODO");
-			const Type * pType = lookupType(*typeTable, pStmt->typidDefn);
+			const Type * pType = lookupType(typeBuffer, pStmt->typidDefn);
 
 			if (pStmt->ident.lexeme.strv.cCh > 0)
 			{
@@ -957,6 +1129,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 				if (isTypeResolved(typidInit) && typidInit != pStmt->typidDefn)
 				{
 					// TODO: report better error
+					pPass->hadError = true;
 					printfmt("Cannot initialize variable of type %d with expression of type %d\n", pStmt->typidDefn, typidInit);
 				}
 			}
@@ -990,7 +1163,11 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 				AssertInfo(aSymbInfo.cItem > 0, "We should have put this func decl in the symbol table when we parsed it...");
 			}
 #endif
+
+			ResolvePass::FnCtx fnCtx = pop(&pPass->fnCtxStack);
+			dispose(&fnCtx.aTypidReturn);
 			
+			computeFrameLayout(pCtx, pCtx->scopes[pStmt->pParamsReturnsGrp->scopeid]);
 			pop(&pPass->scopeidStack);
 		} break;
 
@@ -1009,6 +1186,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 
 			if (DownExpr(pStmt->pCondExpr)->typidEval != TypeId::Bool)
 			{
+				pPass->hadError = true;
 				print("Expression in while condition must be a bool");
 			}
 
@@ -1021,6 +1199,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 
 			if (DownExpr(pStmt->pCondExpr)->typidEval != TypeId::Bool)
 			{
+				pPass->hadError = true;
 				print("Expression in if condition must be a bool");
 			}
 		} break;
@@ -1034,10 +1213,12 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 
 			if (pFnCtx->aTypidReturn.cItem == 0 && pStmt->pExpr)
 			{
+				pPass->hadError = true;
 				print("Cannot return value from function expecting void\n");
 			}
 			else if (pFnCtx->aTypidReturn.cItem != 0 && !pStmt->pExpr)
 			{
+				pPass->hadError = true;
 				print("Function expecting a return value\n");
 			}
 
@@ -1049,6 +1230,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 
 				if (typidReturn != pFnCtx->aTypidReturn[0])
 				{
+					pPass->hadError = true;
 					print("Return type mismatch\n");
 				}
 			}
@@ -1058,6 +1240,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 		{
 			if (pPass->cNestedBreakable == 0)
 			{
+				pPass->hadError = true;
 				print("Cannot break from current context");
 			}
 			else
@@ -1070,6 +1253,7 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 		{
 			if (pPass->cNestedBreakable == 0)
 			{
+				pPass->hadError = true;
 				print("Cannot continue from current context");
 			}
 			else
@@ -1088,12 +1272,211 @@ void resolveStmt(ResolvePass * pPass, AstNode * pNode)
 	}
 }
 
-void doResolvePass(ResolvePass * pPass, AstNode * pNode)
+struct ResolveJob
+{
+	AstProgram * pProgram;
+	ResolvePass ** apPassWorker;		// Indexed by iWorker
+	String * aStrOutput;				// Indexed by top level statement
+	bool * aIsStmtHeld;					// Indexed by top level statement. Set if it waits on the flush
+	bool * aIsStmtFailed;				// Indexed by top level statement. Set if it had an error, which skips pfnStmtResolved
+
+	PFNSTMTRESOLVED pfnStmtResolved;
+	void * pContext;
+};
+
+static void resolveJob(void * pJob_, int iNode, int iWorker)
 {
+	auto * pJob = reinterpret_cast<ResolveJob *>(pJob_);
+
+	ResolvePass * pPass = pJob->apPassWorker[iWorker];
+	pPass->typeInsertBuffer.iOrderCur = iNode;
+
+	int cTypidUpdateOnFlushPrev = pPass->typeInsertBuffer.apTypidUpdateOnFlush.cItem;
+
+	// hadError covers every statement this worker has resolved so far, so clear it to see whether this one fails
+
+	bool hadErrorPrev = pPass->hadError;
+	pPass->hadError = false;
+
+	beginPrintCapture(&pJob->aStrOutput[iNode]);
+	walkAstStatic<&visitResolvePreorder, &visitResolveHook, &visitResolvePostorder>(pJob->pProgram->apNodes[iNode], pPass);
+	endPrintCapture();
+
+	pJob->aIsStmtFailed[iNode] = pPass->hadError;
+	pPass->hadError = hadErrorPrev || pPass->hadError;
+
+	// Later phases can't make anything of a statement with errors in it, and the compile fails anyway
+
+	if (!pJob->pfnStmtResolved || pJob->aIsStmtFailed[iNode])
+		return;
+
+	// Any node holding a buffered typid registered itself to be updated on flush
+
+	if (pPass->typeInsertBuffer.apTypidUpdateOnFlush.cItem != cTypidUpdateOnFlushPrev)
+	{
+		pJob->aIsStmtHeld[iNode] = true;
+	}
+	else
+	{
+		pJob->pfnStmtResolved(pJob->pContext, iNode, iWorker);
+	}
+}
+
+struct StmtResolvedJob
+{
+	int * aINodeHeld;
+
+	PFNSTMTRESOLVED pfnStmtResolved;
+	void * pContext;
+};
+
+static void stmtResolvedJob(void * pJob_, int iItem, int iWorker)
+{
+	auto * pJob = reinterpret_cast<StmtResolvedJob *>(pJob_);
+	pJob->pfnStmtResolved(pJob->pContext, pJob->aINodeHeld[iItem], iWorker);
+}
+
+void doResolvePass(ResolvePass * pPass, AstNode * pNode, PFNSTMTRESOLVED pfnStmtResolved, void * pContext)
+{
+	MeekCtx * pCtx = pPass->pCtx;
+
+	// NOTE (andrew) Auditing removes duplicates from the symbol index, which is shared by every scope, so it can't
+	//	happen while workers are looking things up. Do every scope up front instead of as each one is pushed.
+
+	beginPhase(pCtx->pReport, PHASEK_ResolveAudit);
+
+	for (int iScope = 0; iScope < pCtx->scopes.cItem; iScope++)
+	{
+		auditDuplicateSymbols(pCtx, pCtx->scopes[iScope]);
+	}
+
+	endPhase(pCtx->pReport, PHASEK_ResolveAudit);
+
 	pushAndProcessScope(pPass, SCOPEID_BuiltIn);
 	pushAndProcessScope(pPass, SCOPEID_Global);
 
-	walkAst(pPass->pCtx, pNode, &visitResolvePreorder, visitResolveHook, visitResolvePostorder, pPass);
+	// NOTE (andrew) Every type and top level symbol is resolved by now, and a top level statement only writes to its own
+	//	nodes and scopes, so they can be resolved independently. pPass is worker 0, and the other workers get a pass of
+	//	their own with the (already processed) outer scopes pushed.
+
+	auto * pProgram = Down(pNode, Program);
+	int cNode = pProgram->apNodes.cItem;
+
+	int cWorker = cWorkerMax();
+
+	DynamicArray<ResolvePass *> apPassWorker;
+	init(&apPassWorker);
+	Defer(dispose(&apPassWorker));
+	append(&apPassWorker, pPass);
+
+	for (int iWorker = 1; iWorker < cWorker; iWorker++)
+	{
+		ResolvePass * pPassWorker = new ResolvePass;
+		init(pPassWorker, pCtx);
+		push(&pPassWorker->scopeidStack, SCOPEID_BuiltIn);
+		push(&pPassWorker->scopeidStack, SCOPEID_Global);
+
+		append(&apPassWorker, pPassWorker);
+	}
+
+	DynamicArray<String> aStrOutput;
+	init(&aStrOutput);
+	Defer(dispose(&aStrOutput));
+	ensureCapacity(&aStrOutput, cNode);
+	aStrOutput.cItem = cNode;
+
+	for (int iNode = 0; iNode < cNode; iNode++)
+	{
+		init(&aStrOutput[iNode]);
+	}
+
+	DynamicArray<bool> aIsStmtHeld;
+	init(&aIsStmtHeld);
+	Defer(dispose(&aIsStmtHeld));
+	ensureCapacity(&aIsStmtHeld, cNode);
+	aIsStmtHeld.cItem = cNode;
+
+	DynamicArray<bool> aIsStmtFailed;
+	init(&aIsStmtFailed);
+	Defer(dispose(&aIsStmtFailed));
+	ensureCapacity(&aIsStmtFailed, cNode);
+	aIsStmtFailed.cItem = cNode;
+
+	for (int iNode = 0; iNode < cNode; iNode++)
+	{
+		aIsStmtHeld[iNode] = false;
+		aIsStmtFailed[iNode] = false;
+	}
+
+	ResolveJob job;
+	job.pProgram = pProgram;
+	job.apPassWorker = apPassWorker.pBuffer;
+	job.aStrOutput = aStrOutput.pBuffer;
+	job.aIsStmtHeld = aIsStmtHeld.pBuffer;
+	job.aIsStmtFailed = aIsStmtFailed.pBuffer;
+	job.pfnStmtResolved = pfnStmtResolved;
+	job.pContext = pContext;
+
+	static const int s_cNodePerWorkerMin = 16;
+
+	beginPhase(pCtx->pReport, PHASEK_ResolveStmts);
+	parallelFor(cNode, &resolveJob, &job, s_cNodePerWorkerMin);
+	endPhase(pCtx->pReport, PHASEK_ResolveStmts);
+
+	// Report in program order, same as if we had walked it on one thread
+
+	for (int iNode = 0; iNode < cNode; iNode++)
+	{
+		print(aStrOutput[iNode].pBuffer);
+		dispose(&aStrOutput[iNode]);
+	}
+
+	// Merge the workers' results
+
+	DynamicArray<TypeInsertBuffer *> apTypeInsertBuffer;
+	init(&apTypeInsertBuffer);
+	Defer(dispose(&apTypeInsertBuffer));
+
+	for (int iWorker = 0; iWorker < apPassWorker.cItem; iWorker++)
+	{
+		append(&apTypeInsertBuffer, &apPassWorker[iWorker]->typeInsertBuffer);
+	}
+
+	beginPhase(pCtx->pReport, PHASEK_ResolveFlushTypes);
+	flushTypeInsertBuffers(pCtx->typeTable, apTypeInsertBuffer.pBuffer, apTypeInsertBuffer.cItem);
+	endPhase(pCtx->pReport, PHASEK_ResolveFlushTypes);
+
+	if (pfnStmtResolved)
+	{
+		DynamicArray<int> aINodeHeld;
+		init(&aINodeHeld);
+		Defer(dispose(&aINodeHeld));
+
+		for (int iNode = 0; iNode < cNode; iNode++)
+		{
+			if (aIsStmtHeld[iNode] && !aIsStmtFailed[iNode])
+			{
+				append(&aINodeHeld, iNode);
+			}
+		}
+
+		StmtResolvedJob jobHeld;
+		jobHeld.aINodeHeld = aINodeHeld.pBuffer;
+		jobHeld.pfnStmtResolved = pfnStmtResolved;
+		jobHeld.pContext = pContext;
+
+		parallelFor(aINodeHeld.cItem, &stmtResolvedJob, &jobHeld, s_cNodePerWorkerMin);
+	}
+
+	for (int iWorker = 1; iWorker < apPassWorker.cItem; iWorker++)
+	{
+		ResolvePass * pPassWorker = apPassWorker[iWorker];
+		pPass->hadError = pPass->hadError || pPassWorker->hadError;
+		appendMultiple(&pPass->unresolvedIdents, pPassWorker->unresolvedIdents);
+
+		dispose(pPassWorker);
+		delete pPassWorker;
+	}
 }
 
 bool visitResolvePreorder(AstNode * pNode, void * pPass_)
@@ -1123,7 +1506,7 @@ bool visitResolvePreorder(AstNode * pNode, void * pPass_)
 			dispose(&fnCtx.aTypidReturn);*/
 
 			auto * pExpr = Down(pNode, FuncLiteralExpr);
-			pushAndProcessScope(pPass, pExpr->scopeid);
+			pushAndProcessScope(pPass, pExpr->pParamsReturnsGrp->scopeid);
 		} break;
 
 		case ASTK_ExprStmt:
@@ -1134,7 +1517,7 @@ bool visitResolvePreorder(AstNode * pNode, void * pPass_)
 		case ASTK_FuncDefnStmt:
 		{
 			auto * pStmt = Down(pNode, FuncDefnStmt);
-			pushAndProcessScope(pPass, pStmt->scopeid);
+			pushAndProcessScope(pPass, pStmt->pParamsReturnsGrp->scopeid);
 		} break;
 
 		case ASTK_StructDefnStmt:
@@ -5,9 +5,9 @@
 #include "als.h"
 #include "ast.h"
 #include "symbol.h"
+#include "type.h"
 
 struct Parser;
-struct TypeTable;
 
 struct ResolvePass
 {
@@ -26,6 +26,31 @@ struct ResolvePass
 	Stack<FnCtx> fnCtxStack;
 	Stack<SCOPEID> scopeidStack;
 
+	// Overload resolution caches. Every func and var type is resolved before this pass runs, so the candidates
+	//	for a name in a scope (and which of them an argument list picks) never change once computed.
+
+	struct OverloadSetKey
+	{
+		SCOPEID scopeid;
+		Lexeme lexeme;
+		bool ignoreVars;
+	};
+
+	struct OverloadMatchKey
+	{
+		OverloadSetKey overloadSetKey;
+		SmallArray<TypeId, 4> aTypidArg;
+	};
+
+	HashMap<OverloadSetKey, DynamicArray<SymbolInfo>> overloadSets;		// Candidates, in the order resolveExpr(..) expects
+	HashMap<OverloadMatchKey, AstNode *> overloadMatches;				// Only successful matches with fully resolved args
+
+	// NOTE (andrew) Top level statements are resolved in parallel, one ResolvePass per worker. Scopes, symbols and the
+	//	type table are read-only while they run, so types that don't exist yet (e.g., taking the address of something
+	//	whose pointer type is never mentioned) go in this buffer and get merged into the type table afterwards.
+
+	TypeInsertBuffer typeInsertBuffer;
+
 	// Output
 
 	DynamicArray<ScopedIdentifier> unresolvedIdents;
@@ -33,6 +58,7 @@ struct ResolvePass
 };
 
 void init(ResolvePass * pPass, MeekCtx * pCtx);
+void dispose(ResolvePass * pPass);
 void pushAndProcessScope(ResolvePass * pPass, SCOPEID scopeid);
 
 // Tree walk
@@ -43,4 +69,12 @@ void visitResolveHook(AstNode * pNode, AWHK awhk, void * pPass_);
 
 void resolveExpr(ResolvePass * pPass, AstNode * pNode);
 void resolveStmt(ResolvePass * pPass, AstNode * pNode);
-void doResolvePass(ResolvePass * pPass, AstNode * pNode);
+
+// Called with the index of each top level statement once it (and everything it refers to) is fully resolved, from
+//	whichever worker resolved it, so that later phases can start on it while other statements are still resolving.
+//	Statements that made new types are held until the type insert buffers are flushed, since their typids aren't final.
+//	Statements with errors in them are never passed along, held or not.
+
+typedef void (*PFNSTMTRESOLVED)(void * pContext, int iNode, int iWorker);
+
+void doResolvePass(ResolvePass * pPass, AstNode * pNode, PFNSTMTRESOLVED pfnStmtResolved=nullptr, void * pContext=nullptr);
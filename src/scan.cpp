@@ -1,7 +1,12 @@
 #include "scan.h"
 
+#include "report.h"
+
 #include <stdlib.h> // For strncpy and related functions
 
+#include <atomic>
+#include <thread>
+
 void init(Scanner * scanner, char * pText, uint textSize)
 {
 	ClearStruct(scanner);
@@ -12,6 +17,12 @@ void init(Scanner * scanner, char * pText, uint textSize)
 	init(&scanner->newLineIndices);
 }
 
+void dispose(Scanner * scanner)
+{
+	Assert(!scanner->pTokenQueue);
+	dispose(&scanner->newLineIndices);
+}
+
 TOKENK consumeToken(Scanner * scanner, NULLABLE Token * poToken)
 {
 	Token throwaway;
@@ -157,8 +168,174 @@ bool tryPeekToken(Scanner * scanner, const TOKENK * aTokenkMatch, int cTokenkMat
 	return false;
 }
 
+// Scanning ahead
+//
+//	A second scanner runs on its own thread, ahead of the parser, and appends every token it scans to a queue. Tokens go
+//	in fixed size blocks that never move, and there are enough block pointers up front for the most tokens the text
+//	could hold (every token but EOF eats at least one char), so reading a published token never needs a lock.
+
+struct TokenQueue
+{
+	struct Slot
+	{
+		Token token;
+		SCANEXITK scanexitk;		// Scanner's exit kind right after scanning this token, so that isFinished(..) agrees
+	};
+
+	static constexpr int s_cSlotPerBlock = 4096;
+
+	Scanner scanner;				// Only touched by the scanning thread until it is joined
+	std::thread * pThread;
+	CompileReport * pReport;
+
+	Slot ** apBlock;
+	int cBlock;
+
+	std::atomic<int> cSlotPublished;
+	std::atomic<bool> isDone;
+};
+
+static void scanAheadThread(TokenQueue * pQueue)
+{
+	Scanner * scanner = &pQueue->scanner;
+
+	beginPhase(pQueue->pReport, PHASEK_ParseScanAhead);
+
+	for (int iSlot = 0; ; iSlot++)
+	{
+		int iBlock = iSlot / TokenQueue::s_cSlotPerBlock;
+		AssertInfo(iBlock < pQueue->cBlock, "More tokens than chars?");
+
+		if (!pQueue->apBlock[iBlock])
+		{
+			pQueue->apBlock[iBlock] = new TokenQueue::Slot[TokenQueue::s_cSlotPerBlock];
+		}
+
+		TokenQueue::Slot * pSlot = &pQueue->apBlock[iBlock][iSlot % TokenQueue::s_cSlotPerBlock];
+		TOKENK tokenk = produceNextToken(scanner, &pSlot->token);
+		pSlot->scanexitk = scanner->scanexitk;
+
+		pQueue->cSlotPublished.store(iSlot + 1, std::memory_order_release);
+
+		if (tokenk == TOKENK_Eof)
+			break;
+	}
+
+	endPhase(pQueue->pReport, PHASEK_ParseScanAhead);
+
+	pQueue->isDone.store(true, std::memory_order_release);
+}
+
+void startScanAhead(Scanner * scanner, CompileReport * pReport)
+{
+	Assert(!scanner->pTokenQueue);
+	Assert(!scanner->isSpeculating);
+	AssertInfo(scanner->peekBuffer.cItem == 0, "Peeked tokens would be scanned twice");
+
+	TokenQueue * pQueue = new TokenQueue;
+	init(&pQueue->scanner, scanner->pText, scanner->textSize);
+	pQueue->scanner.iText = scanner->iText;
+	pQueue->scanner.iToken = scanner->iToken;
+
+	pQueue->cBlock = (scanner->textSize - scanner->iText) / TokenQueue::s_cSlotPerBlock + 2;
+	pQueue->apBlock = new TokenQueue::Slot *[pQueue->cBlock];
+	for (int iBlock = 0; iBlock < pQueue->cBlock; iBlock++)
+	{
+		pQueue->apBlock[iBlock] = nullptr;
+	}
+
+	pQueue->cSlotPublished.store(0, std::memory_order_relaxed);
+	pQueue->isDone.store(false, std::memory_order_relaxed);
+	pQueue->pReport = pReport;
+	pQueue->pThread = new std::thread(scanAheadThread, pQueue);
+
+	scanner->pTokenQueue = pQueue;
+	scanner->iTokenQueue = 0;
+}
+
+void finishScanAhead(Scanner * scanner)
+{
+	TokenQueue * pQueue = scanner->pTokenQueue;
+	if (!pQueue)
+		return;
+
+	Assert(!scanner->isSpeculating);
+
+	pQueue->pThread->join();
+	delete pQueue->pThread;
+
+	// Pick up where the other scanner left off, in case anybody scans past the end of the queue. Tokens it scanned
+	//	that we never read are all behind the EOF, so there is nothing to give back.
+
+	appendMultiple(&scanner->newLineIndices, pQueue->scanner.newLineIndices);
+	scanner->iText = pQueue->scanner.iText;
+	scanner->iTextTokenStart = pQueue->scanner.iTextTokenStart;
+
+	dispose(&pQueue->scanner.newLineIndices);
+
+	for (int iBlock = 0; iBlock < pQueue->cBlock; iBlock++)
+	{
+		delete[] pQueue->apBlock[iBlock];
+	}
+
+	delete[] pQueue->apBlock;
+	delete pQueue;
+
+	scanner->pTokenQueue = nullptr;
+}
+
+static TOKENK readQueuedToken(Scanner * scanner, Token * poToken)
+{
+	TokenQueue * pQueue = scanner->pTokenQueue;
+	int * piToken = scanner->isSpeculating ? &scanner->iTokenQueueSpeculative : &scanner->iTokenQueue;
+
+	// NOTE (andrew) Scanning is a lot cheaper than parsing, so we almost never get here before the token is
+	//	published. Just spin.
+
+	for (;;)
+	{
+		bool isDone = pQueue->isDone.load(std::memory_order_acquire);
+		if (*piToken < pQueue->cSlotPublished.load(std::memory_order_acquire))
+			break;
+
+		if (isDone)
+		{
+			// Read past the EOF. Speculating only cares about the tokenk, otherwise scan it ourselves like we
+			//	would have without the queue.
+
+			if (scanner->isSpeculating)
+			{
+				poToken->tokenk = TOKENK_Eof;
+				return poToken->tokenk;
+			}
+
+			finishScanAhead(scanner);
+			return produceNextToken(scanner, poToken);
+		}
+
+		std::this_thread::yield();
+	}
+
+	const TokenQueue::Slot & slot = pQueue->apBlock[*piToken / TokenQueue::s_cSlotPerBlock][*piToken % TokenQueue::s_cSlotPerBlock];
+	(*piToken)++;
+
+	*poToken = slot.token;
+
+	if (!scanner->isSpeculating)
+	{
+		forceWrite(&scanner->prevBuffer, slot.token);
+		scanner->iToken++;
+		scanner->scanexitk = slot.scanexitk;
+	}
+
+	return poToken->tokenk;
+}
+
 TOKENK produceNextToken(Scanner * scanner, Token * poToken)
 {
+	if (scanner->pTokenQueue)
+		return readQueuedToken(scanner, poToken);
+
 	onStartToken(scanner);
 	while (!checkEndOfFile(scanner))
 	{
@@ -539,20 +716,27 @@ bool isFinished(const Scanner & scanner)
 
 int lineFromI(const Scanner & scanner, int iText)
 {
-	// SLOW: Can use binary search + some heuristics to accelerate this, or mabye keep a second list that marks i for every 100th (or 1000th ?) line
-	//  that will let us just to the correct "neighborhood" faster
+	// NOTE (andrew) Bytecode emit asks for the line of every stmt, so this has to be a binary search. newLineIndices is
+	//	always sorted, since newlines are appended as they're consumed.
 
-	int line = 1;
-	for (int i = 0; i < scanner.newLineIndices.cItem; i++)
-	{
-		// '\n' itself is considered to be "on" the line that it ends
+	// Count the newlines before iText. '\n' itself is considered to be "on" the line that it ends.
 
-		if (scanner.newLineIndices[i] >= iText) break;
-
-		line++;
+	int iStart = 0;
+	int iEnd = scanner.newLineIndices.cItem;
+	while (iStart < iEnd)
+	{
+		int iMid = iStart + (iEnd - iStart) / 2;
+		if (scanner.newLineIndices[iMid] < iText)
+		{
+			iStart = iMid + 1;
+		}
+		else
+		{
+			iEnd = iMid;
+		}
 	}
 
-	return line;
+	return iStart + 1;
 }
 
 TOKENK nextTokenkSpeculative(Scanner * scanner)
@@ -561,6 +745,7 @@ TOKENK nextTokenkSpeculative(Scanner * scanner)
 	{
 		scanner->iPeekBufferSpeculative = 0;
 		scanner->iTextSpeculative = scanner->iText;
+		scanner->iTokenQueueSpeculative = scanner->iTokenQueue;
 		scanner->isSpeculating = true;
 	}
 
@@ -13,6 +13,9 @@ enum SCANEXITK
 	SCANEXITK_Nil = -1
 };
 
+struct CompileReport;
+struct TokenQueue;
+
 struct Scanner
 {
 	// Init state
@@ -47,12 +50,20 @@ struct Scanner
 	uint iPeekBufferSpeculative=  0;
 	int iTextSpeculative = 0;
 
+	// Scanning ahead on another thread, see startScanAhead(..). While set, tokens come out of the queue instead of
+	//	being scanned here.
+
+	TokenQueue * pTokenQueue = nullptr;
+	int iTokenQueue = 0;
+	int iTokenQueueSpeculative = 0;
+
 	// Exit kind
 
 	SCANEXITK	scanexitk = SCANEXITK_Nil;
 };
 
 void init(Scanner * scanner, char * pText, uint textSize);
+void dispose(Scanner * scanner);
 bool isFinished(const Scanner & scanner);
 int lineFromI(const Scanner & scanner, int iText);
 
@@ -72,6 +83,10 @@ TOKENK consumeToken(Scanner * scanner, NULLABLE Token * poToken=nullptr);
 TOKENK nextTokenkSpeculative(Scanner * scanner);
 void backtrackAfterSpeculation(Scanner * scanner);
 
+// Scanning ahead
+
+void startScanAhead(Scanner * scanner, NULLABLE CompileReport * pReport=nullptr);
+void finishScanAhead(Scanner * scanner);
 
 
 // Internal
@@ -26,16 +26,116 @@ bool scopedIdentEq(const ScopedIdentifier & ident0, const ScopedIdentifier & ide
 	return lexemeEq(ident0.lexeme, ident1.lexeme) && ident0.scopeid == ident1.scopeid;
 }
 
-void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent)
+void init(SymbolIndex * pSymbolIndex)
+{
+	init(&pSymbolIndex->symbolsDefined, lexemeHash, lexemeEq);
+}
+
+void dispose(SymbolIndex * pSymbolIndex)
+{
+	for (auto it = iter(pSymbolIndex->symbolsDefined); it.pValue; iterNext(&it))
+	{
+		dispose(it.pValue);
+	}
+
+	dispose(&pSymbolIndex->symbolsDefined);
+}
+
+// Index of the first definition in [0, iEnd) whose scope id is at least scopeid, or iEnd if there isn't one
+
+static int iScopedSymbInfoLowerBound(const SmallArray<ScopedSymbolInfo, 1> & aScopedSymbInfo, SCOPEID scopeid, int iEnd)
+{
+	int iStart = 0;
+	while (iStart < iEnd)
+	{
+		int iMid = iStart + (iEnd - iStart) / 2;
+		if (aScopedSymbInfo[iMid].pScope->id < scopeid)
+		{
+			iStart = iMid + 1;
+		}
+		else
+		{
+			iEnd = iMid;
+		}
+	}
+
+	return iStart;
+}
+
+// Returns true if this is pScope's first definition of lexeme
+
+static bool insertScopedSymbolInfo(SymbolIndex * pSymbolIndex, const Scope * pScope, const Lexeme & lexeme, const SymbolInfo & symbInfo)
+{
+	SmallArray<ScopedSymbolInfo, 1> * paScopedSymbInfo = lookup(pSymbolIndex->symbolsDefined, lexeme);
+	if (!paScopedSymbInfo)
+	{
+		paScopedSymbInfo = insertNew(&pSymbolIndex->symbolsDefined, lexeme);
+		init(paScopedSymbInfo);
+	}
+
+	// Keep sorted by scope id. Definitions almost always arrive in scope id order, so check for an append before
+	//	searching.
+
+	int iInsert = paScopedSymbInfo->cItem;
+	if (iInsert > 0 && (*paScopedSymbInfo)[iInsert - 1].pScope->id > pScope->id)
+	{
+		iInsert = iScopedSymbInfoLowerBound(*paScopedSymbInfo, SCOPEID(pScope->id + 1), iInsert);
+	}
+
+	bool isFirstInScope = (iInsert == 0 || (*paScopedSymbInfo)[iInsert - 1].pScope != pScope);
+
+	ScopedSymbolInfo scopedSymbInfo;
+	scopedSymbInfo.pScope = pScope;
+	scopedSymbInfo.symbInfo = symbInfo;
+
+	insert(paScopedSymbInfo, scopedSymbInfo, iInsert);
+
+	return isFirstInScope;
+}
+
+static void indexSymbol(Scope * pScope, const Lexeme & lexeme, const SymbolInfo & symbInfo)
+{
+	if (insertScopedSymbolInfo(pScope->pSymbolIndex, pScope, lexeme, symbInfo))
+	{
+		append(&pScope->aLexemeDefined, lexeme);
+	}
+}
+
+// Finds the contiguous run of definitions belonging to pScope, among the first iEndSearch. Returns false if there are none.
+
+static bool tryFindScopeRun(
+	const SmallArray<ScopedSymbolInfo, 1> & aScopedSymbInfo,
+	const Scope * pScope,
+	int iEndSearch,
+	int * poiStart,
+	int * poiEnd)
+{
+	int iStart = iScopedSymbInfoLowerBound(aScopedSymbInfo, pScope->id, iEndSearch);
+
+	int iEnd = iStart;
+	while (iEnd < iEndSearch && aScopedSymbInfo[iEnd].pScope == pScope)
+	{
+		iEnd++;
+	}
+
+	*poiStart = iStart;
+	*poiEnd = iEnd;
+	return iEnd > iStart;
+}
+
+void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent, SymbolIndex * pSymbolIndex)
 {
 	Assert(Iff(!pScopeParent, scopek == SCOPEK_BuiltIn));
 	Assert(Iff(scopeid == SCOPEID_BuiltIn, scopek == SCOPEK_BuiltIn));
+	Assert(pSymbolIndex);
 
 	pScope->pScopeParent = pScopeParent;
 	pScope->id = scopeid;
+	pScope->scopeidDescendantLast = SCOPEID_Max;
 	pScope->scopek = scopek;
-	
-	init(&pScope->symbolsDefined, lexemeHash, lexemeEq);
+	pScope->pSymbolIndex = pSymbolIndex;
+
+	init(&pScope->aLexemeDefined);
 
 	if (scopek == SCOPEK_BuiltIn)
 	{
@@ -48,11 +148,9 @@ void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent)
 			symbInfo.symbolk = SYMBOLK_BuiltInType;
 			symbInfo.builtInData.typid = typid;
 
-			Assert(!lookup(pScope->symbolsDefined, lexeme));
+			Assert(!lookup(pScope->pSymbolIndex->symbolsDefined, lexeme));
 
-			DynamicArray<SymbolInfo> * paSymbInfo = insertNew(&pScope->symbolsDefined, lexeme);
-			init(paSymbInfo);
-			append(paSymbInfo, symbInfo);
+			indexSymbol(pScope, lexeme, symbInfo);
 		};
 
 		// TODO: make void a symbol?
@@ -79,15 +177,13 @@ void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent)
 	}
 }
 
-void defineSymbol(MeekCtx * pCtx, Scope * pScope, const Lexeme & lexeme, const SymbolInfo & symbInfo)
+void dispose(Scope * pScope)
 {
-	DynamicArray<SymbolInfo> * paSymbInfo = lookup(pScope->symbolsDefined, lexeme);
-	if (!paSymbInfo)
-	{
-		paSymbInfo = insertNew(&pScope->symbolsDefined, lexeme);
-		init(paSymbInfo);
-	}
+	dispose(&pScope->aLexemeDefined);
+}
 
+void defineSymbol(MeekCtx * pCtx, Scope * pScope, const Lexeme & lexeme, const SymbolInfo & symbInfo)
+{
 	// NOTE (andrew) No attempt is made to detect redefinitions here. That is done seperately, per-scope,
 	//	in the resolve pass. A special exception is made for main, since it is a program-wide concern.
 
@@ -107,23 +203,75 @@ void defineSymbol(MeekCtx * pCtx, Scope * pScope, const Lexeme & lexeme, const S
 		}
 	}
 
-	append(paSymbInfo, symbInfo);
+	indexSymbol(pScope, lexeme, symbInfo);
+}
+
+void mergeSymbolIndex(MeekCtx * pCtx, Scope * pScopeGlobal, Scope * pScopeGlobalSrc)
+{
+	Assert(pScopeGlobal->scopek == SCOPEK_Global);
+	Assert(pScopeGlobalSrc->scopek == SCOPEK_Global);
+
+	SymbolIndex * pSymbolIndex = pScopeGlobal->pSymbolIndex;
+	SymbolIndex * pSymbolIndexSrc = pScopeGlobalSrc->pSymbolIndex;
+	Assert(pSymbolIndex != pSymbolIndexSrc);
+
+	// Globals are defined again, in their original order, so that they end up in pScopeGlobal's definition order
+	//	and main is noticed just like it would have been.
+
+	for (int iLexeme = 0; iLexeme < pScopeGlobalSrc->aLexemeDefined.cItem; iLexeme++)
+	{
+		Lexeme lexeme = pScopeGlobalSrc->aLexemeDefined[iLexeme];
+		SmallArray<ScopedSymbolInfo, 1> * paScopedSymbInfo = lookup(pSymbolIndexSrc->symbolsDefined, lexeme);
+		Assert(paScopedSymbInfo);
+
+		for (int iSymbInfo = 0; iSymbInfo < paScopedSymbInfo->cItem; iSymbInfo++)
+		{
+			const ScopedSymbolInfo & scopedSymbInfo = (*paScopedSymbInfo)[iSymbInfo];
+			if (scopedSymbInfo.pScope == pScopeGlobalSrc)
+			{
+				defineSymbol(pCtx, pScopeGlobal, lexeme, scopedSymbInfo.symbInfo);
+			}
+		}
+	}
+
+	// Every other scope comes along as is. Their aLexemeDefined are already right.
+
+	for (auto it = iter(pSymbolIndexSrc->symbolsDefined); it.pValue; iterNext(&it))
+	{
+		for (int iSymbInfo = 0; iSymbInfo < it.pValue->cItem; iSymbInfo++)
+		{
+			ScopedSymbolInfo scopedSymbInfo = (*it.pValue)[iSymbInfo];
+			const Scope * pScope = scopedSymbInfo.pScope;
+
+			if (pScope->scopek == SCOPEK_BuiltIn || pScope == pScopeGlobalSrc)
+				continue;
+
+			Assert(pScope->pSymbolIndex == pSymbolIndex);
+			insertScopedSymbolInfo(pSymbolIndex, pScope, *it.pKey, scopedSymbInfo.symbInfo);
+		}
+	}
 }
 
 bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope)
 {
 	bool duplicateFound = false;
-	for (auto it = iter(pScope->symbolsDefined); it.pValue; iterNext(&it))
+	for (int iLexeme = 0; iLexeme < pScope->aLexemeDefined.cItem; iLexeme++)
 	{
-		Lexeme lexeme = *it.pKey;
-		DynamicArray<SymbolInfo> * paSymbInfo = it.pValue;
+		Lexeme lexeme = pScope->aLexemeDefined[iLexeme];
+		SmallArray<ScopedSymbolInfo, 1> * paScopedSymbInfo = lookup(pScope->pSymbolIndex->symbolsDefined, lexeme);
+		Assert(paScopedSymbInfo);
+
+		int iSymbInfoStart;
+		int iSymbInfoEnd;
+		if (!tryFindScopeRun(*paScopedSymbInfo, pScope, paScopedSymbInfo->cItem, &iSymbInfoStart, &iSymbInfoEnd))
+			continue;
 
 		int cVar = 0;
 		int cType = 0;
 
-		for (int iSymbInfo = 0; iSymbInfo < paSymbInfo->cItem; iSymbInfo++)
+		for (int iSymbInfo = iSymbInfoStart; iSymbInfo < iSymbInfoEnd; iSymbInfo++)
 		{
-			SymbolInfo symbInfo = (*paSymbInfo)[iSymbInfo];
+			SymbolInfo symbInfo = (*paScopedSymbInfo)[iSymbInfo].symbInfo;
 
 			switch (symbInfo.symbolk)
 			{
@@ -141,8 +289,9 @@ bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope)
 
 						duplicateFound = true;
 
-						remove(paSymbInfo, iSymbInfo);
+						remove(paScopedSymbInfo, iSymbInfo);
 						iSymbInfo--;
+						iSymbInfoEnd--;
 					}
 				}
 
@@ -158,8 +307,9 @@ bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope)
 
 						duplicateFound = true;
 
-						remove(paSymbInfo, iSymbInfo);
+						remove(paScopedSymbInfo, iSymbInfo);
 						iSymbInfo--;
+						iSymbInfoEnd--;
 					}
 				}
 
@@ -167,9 +317,9 @@ bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope)
 				{
 					// @Slow
 
-					for (int iSymbInfoOther = iSymbInfo + 1; iSymbInfoOther < paSymbInfo->cItem; iSymbInfoOther++)
+					for (int iSymbInfoOther = iSymbInfo + 1; iSymbInfoOther < iSymbInfoEnd; iSymbInfoOther++)
 					{
-						SymbolInfo symbInfoOther = (*paSymbInfo)[iSymbInfoOther];
+						SymbolInfo symbInfoOther = (*paScopedSymbInfo)[iSymbInfoOther].symbInfo;
 						if (symbInfoOther.symbolk != SYMBOLK_Func)
 							continue;
 
@@ -183,8 +333,9 @@ bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope)
 
 							duplicateFound = true;
 
-							remove(paSymbInfo, iSymbInfo);
+							remove(paScopedSymbInfo, iSymbInfo);
 							iSymbInfo--;
+							iSymbInfoEnd--;
 						}
 					}
 				}
@@ -288,11 +439,13 @@ void computeScopedVariableOffsets(MeekCtx * pCtx, Scope * pScope)
 		case SCOPEK_FuncTopLevel:
 		{
 			pScope->funcTopLevelData.cByteLocalVariable = fakeTypeInfo.size;
+			pScope->funcTopLevelData.cByteFrame = fakeTypeInfo.size;		// Grown by computeFrameLayout(..)
 		} break;
 
 		case SCOPEK_FuncInner:
 		{
 			pScope->funcInnerData.cByteLocalVariable = fakeTypeInfo.size;
+			pScope->funcInnerData.byteOffsetFrame = 0;						// Set by computeFrameLayout(..)
 		} break;
 
 		default:
@@ -301,6 +454,44 @@ void computeScopedVariableOffsets(MeekCtx * pCtx, Scope * pScope)
 	}
 }
 
+void computeFrameLayout(MeekCtx * pCtx, Scope * pScopeFunc)
+{
+	// NOTE (andrew) Lays out every inner scope of a func in a single frame, so the func only needs one StackAlloc. An inner
+	//	scope's locals go right after its parent's locals. Sibling scopes are never live at the same time, so they start at
+	//	the same offset and share slots. The frame is as big as the deepest chain of nested scopes, not the sum of all of them.
+
+	Assert(pScopeFunc->scopek == SCOPEK_FuncTopLevel);
+	Assert(pScopeFunc->scopeidDescendantLast != SCOPEID_Max);
+
+	uintptr cByteFrame = pScopeFunc->funcTopLevelData.cByteLocalVariable;
+
+	// Scope ids are in preorder, so every scope's parent is laid out before the scope itself
+
+	SCOPEID scopeid = SCOPEID(pScopeFunc->id + 1);
+	while (scopeid <= pScopeFunc->scopeidDescendantLast)
+	{
+		Scope * pScope = pCtx->scopes[scopeid];
+
+		if (pScope->scopek != SCOPEK_FuncInner)
+		{
+			// Nested funcs get their own frame, and struct members don't live on the stack. Skip the whole subtree.
+
+			scopeid = SCOPEID(pScope->scopeidDescendantLast + 1);
+			continue;
+		}
+
+		Scope * pScopeParent = pScope->pScopeParent;
+		uintptr byteOffsetParent = (pScopeParent->scopek == SCOPEK_FuncInner) ? pScopeParent->funcInnerData.byteOffsetFrame : 0;
+
+		pScope->funcInnerData.byteOffsetFrame = byteOffsetParent + cByteLocalVars(*pScopeParent);
+		cByteFrame = Max(cByteFrame, pScope->funcInnerData.byteOffsetFrame + pScope->funcInnerData.cByteLocalVariable);
+
+		scopeid = SCOPEID(scopeid + 1);
+	}
+
+	pScopeFunc->funcTopLevelData.cByteFrame = cByteFrame;
+}
+
 int compareVarseqid(const SymbolInfo & s0, const SymbolInfo & s1)
 {
 	Assert(s0.symbolk == SYMBOLK_Var);
@@ -309,6 +500,13 @@ int compareVarseqid(const SymbolInfo & s0, const SymbolInfo & s1)
 	return s0.varData.pVarDeclStmt->varseqid - s1.varData.pVarDeclStmt->varseqid;
 }
 
+u32 varseqidKey(const SymbolInfo & symbInfo)
+{
+	Assert(symbInfo.symbolk == SYMBOLK_Var);
+
+	return symbInfo.varData.pVarDeclStmt->varseqid;
+}
+
 SCOPEID scopeidFromSymbolInfo(const SymbolInfo & symbInfo)
 {
 	switch (symbInfo.symbolk)
@@ -412,15 +610,25 @@ void lookupFuncSymbol(const Scope & scope, const Lexeme & lexeme, DynamicArray<S
 
 void lookupSymbol(const Scope & scope, const Lexeme & lexeme, DynamicArray<SymbolInfo> * poResult, GRFSYMBQ grfsymbq)
 {
-	const Scope * pScope = &scope;
-	while (pScope)
+	// NOTE (andrew) One hash probe into the index for the name, then one binary search per enclosing scope. A common
+	//	name like i or x can have thousands of definitions across the program, so don't look at all of them. Only the
+	//	query scope and its ancestors are visible, and an ancestor always has a smaller id than its descendants, so walk
+	//	up the parent chain binary searching for each one's run in what's left of the list. Innermost scope first.
+
+	SmallArray<ScopedSymbolInfo, 1> * paScopedSymbInfoMatch = lookup(scope.pSymbolIndex->symbolsDefined, lexeme);
+	if (!paScopedSymbInfoMatch)
+		return;
+
+	int iEndSearch = paScopedSymbInfoMatch->cItem;
+	for (const Scope * pScopeDefn = &scope; pScopeDefn && iEndSearch > 0; pScopeDefn = pScopeDefn->pScopeParent)
 	{
-		DynamicArray<SymbolInfo> * paSymbInfoMatch = lookup(pScope->symbolsDefined, lexeme);
-		if (paSymbInfoMatch)
+		int iSymbInfoStart;
+		int iSymbInfoEnd;
+		if (tryFindScopeRun(*paScopedSymbInfoMatch, pScopeDefn, iEndSearch, &iSymbInfoStart, &iSymbInfoEnd))
 		{
-			for (int iSymbInfoMatch = 0; iSymbInfoMatch < paSymbInfoMatch->cItem; iSymbInfoMatch++)
+			for (int iSymbInfoMatch = iSymbInfoStart; iSymbInfoMatch < iSymbInfoEnd; iSymbInfoMatch++)
 			{
-				SymbolInfo symbInfoMatch = (*paSymbInfoMatch)[iSymbInfoMatch];
+				SymbolInfo symbInfoMatch = (*paScopedSymbInfoMatch)[iSymbInfoMatch].symbInfo;
 
 				switch (symbInfoMatch.symbolk)
 				{
@@ -453,7 +661,10 @@ void lookupSymbol(const Scope & scope, const Lexeme & lexeme, DynamicArray<Symbo
 			}
 		}
 
-		pScope = (grfsymbq & FSYMBQ_IgnoreParent) ? nullptr : pScope->pScopeParent;
+		if (grfsymbq & FSYMBQ_IgnoreParent)
+			break;
+
+		iEndSearch = iSymbInfoStart;
 	}
 }
 
@@ -463,11 +674,18 @@ void lookupAllVars(const Scope & scope, DynamicArray<SymbolInfo> * poResult, GRF
 	bool shouldIgnoreParent = grfsymbq & FSYMBQ_IgnoreParent;
 	bool shouldSortByVarseqid = grfsymbq & FSYMBQ_SortVarseqid;
 
-	for (auto it = iter(scope.symbolsDefined); it.pKey; iterNext(&it))
+	for (int iLexeme = 0; iLexeme < scope.aLexemeDefined.cItem; iLexeme++)
 	{
-		for (int iSymb = 0; iSymb < it.pValue->cItem; iSymb++)
+		SmallArray<ScopedSymbolInfo, 1> * paScopedSymbInfo = lookup(scope.pSymbolIndex->symbolsDefined, scope.aLexemeDefined[iLexeme]);
+		Assert(paScopedSymbInfo);
+
+		int iSymbStart;
+		int iSymbEnd;
+		tryFindScopeRun(*paScopedSymbInfo, &scope, paScopedSymbInfo->cItem, &iSymbStart, &iSymbEnd);
+
+		for (int iSymb = iSymbStart; iSymb < iSymbEnd; iSymb++)
 		{
-			SymbolInfo symbInfo = (*it.pValue)[iSymb];
+			SymbolInfo symbInfo = (*paScopedSymbInfo)[iSymb].symbInfo;
 			if (symbInfo.symbolk != SYMBOLK_Var)
 				continue;
 
@@ -485,27 +703,25 @@ void lookupAllVars(const Scope & scope, DynamicArray<SymbolInfo> * poResult, GRF
 
 	if (shouldSortByVarseqid)
 	{
-		bubbleSort(poResult->pBuffer, poResult->cItem, &compareVarseqid);
-	}
-}
+		// NOTE (andrew) Global scope of a big program can have thousands of vars, so radix sort on the varseqid. For the
+		//	handful of vars in a typical local scope, the radix sort's fixed cost isn't worth it.
 
-void updateVarSymbolOffset(const Scope & scope, const Lexeme & lexeme, u32 cByteOffset)
-{
-	DynamicArray<SymbolInfo> * paSymbInfoMatch = lookup(scope.symbolsDefined, lexeme);
-	Assert(paSymbInfoMatch);
+		static const int s_cItemRadixSortMin = 64;
 
-	bool updated = false;
-	for (int iSymbInfoMatch = 0; iSymbInfoMatch < paSymbInfoMatch->cItem; iSymbInfoMatch++)
-	{
-		SymbolInfo * pSymbInfoMatch = &(*paSymbInfoMatch)[iSymbInfoMatch];
-		if (pSymbInfoMatch->symbolk != SYMBOLK_Var)
-			continue;
+		if (poResult->cItem >= s_cItemRadixSortMin)
+		{
+			DynamicArray<SymbolInfo> aSymbInfoScratch;
+			init(&aSymbInfoScratch);
+			Defer(dispose(&aSymbInfoScratch));
 
-		pSymbInfoMatch->varData.byteOffset = cByteOffset;
-		updated = true;
+			ensureCapacity(&aSymbInfoScratch, poResult->cItem);
+			radixSort(poResult->pBuffer, aSymbInfoScratch.pBuffer, poResult->cItem, &varseqidKey);
+		}
+		else
+		{
+			introSort(poResult->pBuffer, poResult->cItem, &compareVarseqid);
+		}
 	}
-
-	Assert(updated);
 }
 
 uintptr cByteLocalVars(const Scope & scope)
@@ -518,6 +734,11 @@ uintptr cByteLocalVars(const Scope & scope)
 	}
 }
 
+uintptr cByteFrame(const Scope & scope)
+{
+	return (scope.scopek == SCOPEK_FuncTopLevel) ? scope.funcTopLevelData.cByteFrame : 0;
+}
+
 bool isDeclarationOrderIndependent(const SymbolInfo & info)
 {
 	return isDeclarationOrderIndependent(info.symbolk);
@@ -529,3 +750,8 @@ bool isDeclarationOrderIndependent(SYMBOLK symbolk)
 		symbolk == SYMBOLK_Var ||
 		symbolk == SYMBOLK_Struct;
 }
+
+bool isScopeVisibleFrom(const Scope & scopeDefn, const Scope & scopeQuery)
+{
+	return scopeDefn.id <= scopeQuery.id && scopeQuery.id <= scopeDefn.scopeidDescendantLast;
+}
@@ -33,8 +33,10 @@ struct SymbolInfo
 	{
 		struct UVarData
 		{
+			// NOTE (andrew) Byte offset lives on the decl (AstVarDeclStmt::byteOffset) so that it can be set
+			//	without another symbol lookup.
+
 			AstVarDeclStmt * pVarDeclStmt;
-			uintptr byteOffset;
 		} varData;
 
 		struct UFuncData
@@ -66,10 +68,30 @@ enum SCOPEK : s8
 	SCOPEK_Nil = -1
 };
 
+struct Scope;
+
+struct ScopedSymbolInfo
+{
+	const Scope * pScope;
+	SymbolInfo symbInfo;
+};
+
+// Every symbol in the program, keyed only by lexeme. Each lexeme's list is sorted by the defining scope's id,
+//	and definitions from the same scope are contiguous and in definition order.
+//	Since scope ids are handed out in preorder, a scope's ancestors all have smaller ids than it does, so a
+//	lookup finds each ancestor's run by binary search in the part of the list before the last one it found.
+//	A scope's descendants are exactly the ids in [id, scopeidDescendantLast], see isScopeVisibleFrom(..).
+
+struct SymbolIndex
+{
+	HashMap<Lexeme, SmallArray<ScopedSymbolInfo, 1>> symbolsDefined;		// Overloads per lexeme. Almost always just 1.
+};
+
 struct Scope
 {
 	NULLABLE Scope * pScopeParent = nullptr;
 	SCOPEID id = SCOPEID_Nil;
+	SCOPEID scopeidDescendantLast = SCOPEID_Max;		// Set when the scope is popped. SCOPEID_Max while still open.
 	SCOPEK scopek = SCOPEK_Nil;
 
 	union
@@ -93,15 +115,18 @@ struct Scope
 		{
 			uintptr cByteLocalVariable;
 			uintptr cByteParam;
+			uintptr cByteFrame;				// Locals of this scope and every inner scope, see computeFrameLayout(..)
 		} funcTopLevelData;
 
 		struct UFuncInnerData
 		{
 			uintptr cByteLocalVariable;
+			uintptr byteOffsetFrame;		// Where this scope's locals start within the func's frame
 		} funcInnerData;
 	};
 
-	HashMap<Lexeme, DynamicArray<SymbolInfo>> symbolsDefined;
+	SymbolIndex * pSymbolIndex = nullptr;
+	DynamicArray<Lexeme> aLexemeDefined;		// Each lexeme with at least one definition in this scope, in definition order
 };
 
 struct ScopedIdentifier
@@ -129,13 +154,24 @@ enum FSYMBQ : u16
 };
 typedef u16 GRFSYMBQ;
 
-void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent);
+void init(SymbolIndex * pSymbolIndex);
+void dispose(SymbolIndex * pSymbolIndex);
+void init(Scope * pScope, SCOPEID scopeid, SCOPEK scopek, Scope * pScopeParent, SymbolIndex * pSymbolIndex);
+void dispose(Scope * pScope);
 void defineSymbol(MeekCtx * pCtx, Scope * pScope, const Lexeme & lexeme, const SymbolInfo & symbInfo);
 
+// Moves every symbol from another index (e.g., one filled in while parsing part of the program in parallel) into
+//	pScopeGlobal's. The source's user defined scopes must already be renumbered to follow ours and point at our index.
+//	Its built in scope is skipped, since every index defines the same built ins.
+
+void mergeSymbolIndex(MeekCtx * pCtx, Scope * pScopeGlobal, Scope * pScopeGlobalSrc);
+
 bool auditDuplicateSymbols(MeekCtx * pCtx, Scope * pScope);
 void computeScopedVariableOffsets(MeekCtx * pCtx, Scope * pScope);
+void computeFrameLayout(MeekCtx * pCtx, Scope * pScopeFunc);
 
 int compareVarseqid(const SymbolInfo & s0, const SymbolInfo & s1);
+u32 varseqidKey(const SymbolInfo & symbInfo);
 SCOPEID scopeidFromSymbolInfo(const SymbolInfo & symbInfo);
 SymbolInfo lookupVarSymbol(const Scope & scope, const Lexeme & lexeme, GRFSYMBQ grfsymbq = GRFSYMBQ_None);
 SymbolInfo lookupTypeSymbol(const Scope & scope, const Lexeme & lexeme, GRFSYMBQ grfsymbq = GRFSYMBQ_None);
@@ -144,8 +180,9 @@ void lookupFuncSymbol(const Scope & scope, const Lexeme & lexeme, DynamicArray<S
 void lookupSymbol(const Scope & scope, const Lexeme & lexeme, DynamicArray<SymbolInfo> * poResult, GRFSYMBQ grfsymbq=GRFSYMBQ_None);
 void lookupAllVars(const Scope & scope, DynamicArray<SymbolInfo> * poResult, GRFSYMBQ grfsymbq = GRFSYMBQ_None);
 
-void updateVarSymbolOffset(const Scope & scope, const Lexeme & lexeme, u32 cByteOffset);
 uintptr cByteLocalVars(const Scope & scope);
+uintptr cByteFrame(const Scope & scope);
 
 bool isDeclarationOrderIndependent(SYMBOLK symbolk);
 bool isDeclarationOrderIndependent(const SymbolInfo & info);
+bool isScopeVisibleFrom(const Scope & scopeDefn, const Scope & scopeQuery);
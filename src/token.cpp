@@ -53,6 +53,7 @@ const ReservedWord g_aReservedWord[] = {
 	{ "struct",		TOKENK_Struct },
 	{ "enum",		TOKENK_Enum },
 	{ "fn",         TOKENK_Fn },
+	{ "extern",		TOKENK_Extern },
 	{ "true",		TOKENK_BoolLiteral },
 	{ "false",		TOKENK_BoolLiteral },
 };
@@ -121,6 +122,7 @@ const char * g_mpTokenkStrDisplay[] = {
 	"'struct'",				// TOKENK_Struct
 	"'enum'",				// TOKENK_Enum
 	"'func'",               // TOKENK_Func
+	"'extern'",				// TOKENK_Extern
 	"<end of file>",		// TOKENK_Eof
 };
 StaticAssert(ArrayLen(g_mpTokenkStrDisplay) == TOKENK_Max);
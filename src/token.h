@@ -86,6 +86,7 @@ enum TOKENK
 	TOKENK_Struct,
 	TOKENK_Enum,
 	TOKENK_Fn,
+	TOKENK_Extern,
 						// TODO: union?
 						// TODO: char? string? mstring? (i.e., mutable string... would mainly just be a dynamic array of bytes assuming we have a dynamic array built in type!)
 
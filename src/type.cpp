@@ -1,8 +1,10 @@
 #include "ast.h"
+#include "ast_decorate.h"
 #include "error.h"
 #include "global_context.h"
 #include "literal.h"
 #include "parse.h"
+#include "print.h"
 #include "type.h"
 
 // #include "core/core.h"
@@ -11,8 +13,6 @@ void init(Type * pType, TYPEK typek)
 {
 	pType->typek = typek;
 	pType->isInferred = false;	// TODO
-	pType->info.size = Type::ComputedInfo::s_unset;
-	pType->info.alignment = Type::ComputedInfo::s_unset;
 
 	switch (pType->typek)
 	{
@@ -55,7 +55,6 @@ void initCopy(Type * pType, const Type & typeSrc)
 {
 	pType->typek = typeSrc.typek;
 	pType->isInferred = typeSrc.isInferred;
-	pType->info = typeSrc.info;
 
 	switch (pType->typek)
 	{
@@ -154,23 +153,210 @@ NULLABLE const FuncType * funcTypeFromDefnStmt(const TypeTable & typeTable, cons
 	}
 }
 
+static bool isArraySubscriptIntLiteral(const TypeModifier & typemod)
+{
+	Assert(typemod.typemodk == TYPEMODK_Array);
+
+	return typemod.pSubscriptExpr->astk == ASTK_LiteralExpr &&
+		   Down(typemod.pSubscriptExpr, LiteralExpr)->literalk == LITERALK_Int;
+}
+
+static uint pendingTypeKeyHash(const TypeTable::PendingTypeKey & key)
+{
+	uint hash = startHash(&key.typek, sizeof(key.typek));
+
+	switch (key.typek)
+	{
+		case TYPEK_Named:
+		{
+			hash = buildHash(&key.pScope, sizeof(key.pScope), hash);
+			hash = combineHash(hash, key.lexemeDealiased.hash);
+		} break;
+
+		case TYPEK_Func:
+		{
+			hash = buildHash(&key.cPendingTypidParam, sizeof(key.cPendingTypidParam), hash);
+		} break;
+
+		case TYPEK_Mod:
+		{
+			hash = buildHash(&key.typemod.typemodk, sizeof(key.typemod.typemodk), hash);
+
+			if (key.typemod.typemodk == TYPEMODK_Array)
+			{
+				if (isArraySubscriptIntLiteral(key.typemod))
+				{
+					int cElement = intValue(Down(key.typemod.pSubscriptExpr, LiteralExpr));
+					hash = buildHash(&cElement, sizeof(cElement), hash);
+				}
+				else
+				{
+					hash = buildHash(&key.typemod.pSubscriptExpr, sizeof(key.typemod.pSubscriptExpr), hash);
+				}
+			}
+		} break;
+
+		default:
+			AssertNotReached;
+			break;
+	}
+
+	return buildHash(key.aPendingTypid, key.cPendingTypid * sizeof(PendingTypeId), hash);
+}
+
+static bool pendingTypeKeyEq(const TypeTable::PendingTypeKey & key0, const TypeTable::PendingTypeKey & key1)
+{
+	if (key0.typek != key1.typek)
+		return false;
+
+	switch (key0.typek)
+	{
+		case TYPEK_Named:
+		{
+			if (key0.pScope != key1.pScope)
+				return false;
+
+			if (key0.lexemeDealiased.strv != key1.lexemeDealiased.strv)
+				return false;
+		} break;
+
+		case TYPEK_Func:
+		{
+			if (key0.cPendingTypidParam != key1.cPendingTypidParam)
+				return false;
+		} break;
+
+		case TYPEK_Mod:
+		{
+			if (key0.typemod.typemodk != key1.typemod.typemodk)
+				return false;
+
+			if (key0.typemod.typemodk == TYPEMODK_Array)
+			{
+				// NOTE (andrew) Only int literal subscripts are comparable before resolving. Anything else is only
+				//	equal to itself.
+
+				bool isIntLiteral0 = isArraySubscriptIntLiteral(key0.typemod);
+				bool isIntLiteral1 = isArraySubscriptIntLiteral(key1.typemod);
+				if (isIntLiteral0 != isIntLiteral1)
+					return false;
+
+				if (isIntLiteral0)
+				{
+					if (intValue(Down(key0.typemod.pSubscriptExpr, LiteralExpr)) != intValue(Down(key1.typemod.pSubscriptExpr, LiteralExpr)))
+						return false;
+				}
+				else if (key0.typemod.pSubscriptExpr != key1.typemod.pSubscriptExpr)
+				{
+					return false;
+				}
+			}
+		} break;
+
+		default:
+			AssertNotReached;
+			return false;
+	}
+
+	if (key0.cPendingTypid != key1.cPendingTypid)
+		return false;
+
+	for (int i = 0; i < key0.cPendingTypid; i++)
+	{
+		if (key0.aPendingTypid[i] != key1.aPendingTypid[i])
+			return false;
+	}
+
+	return true;
+}
+
+static void init(TypeTable::PendingTypeKey * pKey, TYPEK typek)
+{
+	pKey->typek = typek;
+	pKey->pScope = nullptr;
+	setLexeme(&pKey->lexemeDealiased, "");
+	pKey->typemod.typemodk = TYPEMODK_Nil;
+	pKey->typemod.pSubscriptExpr = nullptr;
+	pKey->aPendingTypid = nullptr;
+	pKey->cPendingTypid = 0;
+	pKey->cPendingTypidParam = 0;
+}
+
+// Looks up a pending type that was already registered with the same key. If there isn't one, appends a new pending type
+//	that waits on the key's pending typid's, and *ppoTypePendingNew is set to it so the caller can finish initializing it.
+
+static PendingTypeId ensurePendingType(
+	TypeTable * pTable,
+	Scope * pScope,
+	const TypeTable::PendingTypeKey & key,
+	NULLABLE TypeId * pTypidUpdateOnResolve,
+	TypeTable::TypePendingResolve ** ppoTypePendingNew)
+{
+	*ppoTypePendingNew = nullptr;
+
+	PendingTypeId * pPendingTypidExisting = lookup(pTable->pendingTypidFromKey, key);
+	if (pPendingTypidExisting)
+	{
+		if (pTypidUpdateOnResolve)
+		{
+			setPendingTypeUpdateOnResolvePtr(pTable, *pPendingTypidExisting, pTypidUpdateOnResolve);
+		}
+
+		return *pPendingTypidExisting;
+	}
+
+	PendingTypeId result = PendingTypeId(pTable->typesPendingResolution.cItem);
+
+	TypeTable::TypePendingResolve * pTypePending = allocate(&pTable->typePendingAlloc);
+	append(&pTable->typesPendingResolution, pTypePending);
+
+	init(pTypePending, pScope, key.typek);
+	appendMultiple(&pTypePending->aPendingTypidWaitingOn, key.aPendingTypid, key.cPendingTypid);
+	pTypePending->cPendingTypidWaitingOn = key.cPendingTypid;
+
+	for (int i = 0; i < key.cPendingTypid; i++)
+	{
+		Assert(key.aPendingTypid[i] < result);
+
+		TypeTable::TypePendingResolve * pTypePendingWaitingOn = pTable->typesPendingResolution[(int)key.aPendingTypid[i]];
+		append(&pTypePendingWaitingOn->aPendingTypidDependent, result);
+	}
+
+	if (pTypidUpdateOnResolve)
+	{
+		append(&pTypePending->apTypidUpdateOnResolve, pTypidUpdateOnResolve);
+	}
+
+	// NOTE (andrew) The key we store needs to point at memory that outlives the caller's
+
+	TypeTable::PendingTypeKey keyStored = key;
+	keyStored.aPendingTypid = itemBuffer(&pTypePending->aPendingTypidWaitingOn);
+	insert(&pTable->pendingTypidFromKey, keyStored, result);
+
+	*ppoTypePendingNew = pTypePending;
+	return result;
+}
+
 PendingTypeId registerPendingNamedType(
 	TypeTable * pTable,
 	Scope * pScope,
 	Lexeme ident,
+	int iTextMention,
 	NULLABLE TypeId * pTypidUpdateOnResolve)
 {
-	PendingTypeId result = PendingTypeId(pTable->typesPendingResolution.cItem);
+	TypeTable::PendingTypeKey key;
+	init(&key, TYPEK_Named);
+	key.pScope = pScope;
+	key.lexemeDealiased = getDealiasedTypeLexeme(ident);
 
-	TypeTable::TypePendingResolve * pTypePending = appendNew(&pTable->typesPendingResolution);
-	init(pTypePending, pScope, TYPEK_Named);
-	pTypePending->type.namedTypeData.ident.lexeme = ident;
-	pTypePending->type.namedTypeData.ident.scopeid = SCOPEID_Nil;		// Not yet known
+	TypeTable::TypePendingResolve * pTypePendingNew;
+	PendingTypeId result = ensurePendingType(pTable, pScope, key, pTypidUpdateOnResolve, &pTypePendingNew);
 
-	if (pTypidUpdateOnResolve)
+	if (pTypePendingNew)
 	{
-		pTypePending->apTypidUpdateOnResolve[0] = pTypidUpdateOnResolve;
-		pTypePending->cPTypidUpdateOnResolve++;
+		pTypePendingNew->type.namedTypeData.ident.lexeme = ident;
+		pTypePendingNew->type.namedTypeData.ident.scopeid = SCOPEID_Nil;		// Not yet known
+		pTypePendingNew->iTextFirstMention = iTextMention;
 	}
 
 	return result;
@@ -183,29 +369,44 @@ PendingTypeId registerPendingFuncType(
 	const DynamicArray<PendingTypeId> & aPendingTypidReturn,
 	NULLABLE TypeId * pTypidUpdateOnResolve)
 {
-	PendingTypeId result = PendingTypeId(pTable->typesPendingResolution.cItem);
+	SmallArray<PendingTypeId, 8> aPendingTypidParamReturn;
+	init(&aPendingTypidParamReturn);
+	Defer(dispose(&aPendingTypidParamReturn));
 
-	TypeTable::TypePendingResolve * pTypePending = appendNew(&pTable->typesPendingResolution);
-	init(pTypePending, pScope, TYPEK_Func);
-	
-	if (pTypidUpdateOnResolve)
-	{
-		pTypePending->apTypidUpdateOnResolve[0] = pTypidUpdateOnResolve;
-		pTypePending->cPTypidUpdateOnResolve++;
-	}
+	appendMultiple(&aPendingTypidParamReturn, aPendingTypidParam.pBuffer, aPendingTypidParam.cItem);
+	appendMultiple(&aPendingTypidParamReturn, aPendingTypidReturn.pBuffer, aPendingTypidReturn.cItem);
 
-	for (int iParam = 0; iParam < aPendingTypidParam.cItem; iParam++)
-	{
-		TypeId * pTypidParam = appendNew(&pTypePending->type.funcTypeData.funcType.paramTypids);
-		*pTypidParam = TypeId::Unresolved;
-		setPendingTypeUpdateOnResolvePtr(pTable, aPendingTypidParam[iParam], pTypidParam);
-	}
+	TypeTable::PendingTypeKey key;
+	init(&key, TYPEK_Func);
+	key.aPendingTypid = itemBuffer(&aPendingTypidParamReturn);
+	key.cPendingTypid = aPendingTypidParamReturn.cItem;
+	key.cPendingTypidParam = aPendingTypidParam.cItem;
 
-	for (int iReturn = 0; iReturn < aPendingTypidReturn.cItem; iReturn++)
+	TypeTable::TypePendingResolve * pTypePendingNew;
+	PendingTypeId result = ensurePendingType(pTable, pScope, key, pTypidUpdateOnResolve, &pTypePendingNew);
+
+	if (pTypePendingNew)
 	{
-		TypeId * pTypidReturn = appendNew(&pTypePending->type.funcTypeData.funcType.returnTypids);
-		*pTypidReturn = TypeId::Unresolved;
-		setPendingTypeUpdateOnResolvePtr(pTable, aPendingTypidReturn[iReturn], pTypidReturn);
+		FuncType * pFuncType = &pTypePendingNew->type.funcTypeData.funcType;
+
+		// Reserve up front so that the typid pointers we hand out don't move as we append
+
+		ensureCapacity(&pFuncType->paramTypids, aPendingTypidParam.cItem);
+		ensureCapacity(&pFuncType->returnTypids, aPendingTypidReturn.cItem);
+
+		for (int iParam = 0; iParam < aPendingTypidParam.cItem; iParam++)
+		{
+			TypeId * pTypidParam = appendNew(&pFuncType->paramTypids);
+			*pTypidParam = TypeId::Unresolved;
+			setPendingTypeUpdateOnResolvePtr(pTable, aPendingTypidParam[iParam], pTypidParam);
+		}
+
+		for (int iReturn = 0; iReturn < aPendingTypidReturn.cItem; iReturn++)
+		{
+			TypeId * pTypidReturn = appendNew(&pFuncType->returnTypids);
+			*pTypidReturn = TypeId::Unresolved;
+			setPendingTypeUpdateOnResolvePtr(pTable, aPendingTypidReturn[iReturn], pTypidReturn);
+		}
 	}
 
 	return result;
@@ -218,28 +419,23 @@ PendingTypeId registerPendingModType(
 	PendingTypeId pendingTypidModified,
 	NULLABLE TypeId * pTypidUpdateOnResolve)
 {
-	Assert(pendingTypidModified <  PendingTypeId(pTable->typesPendingResolution.cItem));
-	AssertInfo(pendingTypidModified == PendingTypeId(pTable->typesPendingResolution.cItem - 1), "I think this should be true if we register them in the order I think we do");
+	Assert(pendingTypidModified < PendingTypeId(pTable->typesPendingResolution.cItem));
 
-	PendingTypeId result = PendingTypeId(pTable->typesPendingResolution.cItem);
+	TypeTable::PendingTypeKey key;
+	init(&key, TYPEK_Mod);
+	key.typemod = typemod;
+	key.aPendingTypid = &pendingTypidModified;
+	key.cPendingTypid = 1;
 
-	TypeTable::TypePendingResolve * pTypePending = appendNew(&pTable->typesPendingResolution);
-	init(pTypePending, pScope, TYPEK_Mod);
-	pTypePending->type.modTypeData.typemod = typemod;
+	TypeTable::TypePendingResolve * pTypePendingNew;
+	PendingTypeId result = ensurePendingType(pTable, pScope, key, pTypidUpdateOnResolve, &pTypePendingNew);
 
-	if (pTypidUpdateOnResolve)
+	if (pTypePendingNew)
 	{
-		pTypePending->apTypidUpdateOnResolve[0] = pTypidUpdateOnResolve;
-		pTypePending->cPTypidUpdateOnResolve++;
+		pTypePendingNew->type.modTypeData.typemod = typemod;
+		setPendingTypeUpdateOnResolvePtr(pTable, pendingTypidModified, &pTypePendingNew->type.modTypeData.typidModified);
 	}
 
-	// NOTE (andrew) This relies on the fact that the modified type should always get added to the pending list (and thus resolved) first
-	// TODO (andrew) This is a bit too clever. I am tempted to rewrite how types get registered/resolved... all of this poking into a pointer
-	//	is kind of hard to track.
-
-	TypeTable::TypePendingResolve * pTypePendingModified = &pTable->typesPendingResolution[(int)pendingTypidModified];
-	pTypePendingModified->pendingTypidModifiedBy = result;
-
 	return result;
 }
 
@@ -247,11 +443,139 @@ void setPendingTypeUpdateOnResolvePtr(TypeTable * pTable, PendingTypeId pendingT
 {
 	Assert(pendingTypid < PendingTypeId(pTable->typesPendingResolution.cItem));
 
-	TypeTable::TypePendingResolve * pTypePending = &pTable->typesPendingResolution[(int)pendingTypid];
-	Assert(pTypePending->cPTypidUpdateOnResolve < TypeTable::TypePendingResolve::s_cTypidUpdateOnResolveMax);
+	TypeTable::TypePendingResolve * pTypePending = pTable->typesPendingResolution[(int)pendingTypid];
+	append(&pTypePending->apTypidUpdateOnResolve, pTypidUpdateOnResolve);
+}
+
+// Whether pTypid is one of the typids inside a pending type that depends on pTypePending, which is where registering
+//	the dependent asked for it to be poked
+
+static bool isTypidOwnedByDependent(const TypeTable & table, const TypeTable::TypePendingResolve & typePending, const TypeId * pTypid)
+{
+	for (int iDependent = 0; iDependent < typePending.aPendingTypidDependent.cItem; iDependent++)
+	{
+		const TypeTable::TypePendingResolve * pTypePendingDependent = table.typesPendingResolution[(int)typePending.aPendingTypidDependent[iDependent]];
+		const Type & typeDependent = pTypePendingDependent->type;
+
+		switch (typeDependent.typek)
+		{
+			case TYPEK_Func:
+			{
+				const FuncType & funcType = typeDependent.funcTypeData.funcType;
+				const TypeId * aTypidParam = itemBuffer(funcType.paramTypids);
+				const TypeId * aTypidReturn = itemBuffer(funcType.returnTypids);
+
+				if (pTypid >= aTypidParam && pTypid < aTypidParam + funcType.paramTypids.cItem)
+					return true;
+
+				if (pTypid >= aTypidReturn && pTypid < aTypidReturn + funcType.returnTypids.cItem)
+					return true;
+			} break;
+
+			case TYPEK_Mod:
+			{
+				if (pTypid == &typeDependent.modTypeData.typidModified)
+					return true;
+			} break;
+
+			default:
+				AssertNotReached;
+				break;
+		}
+	}
+
+	return false;
+}
+
+void mergePendingTypes(TypeTable * pTable, const TypeTable & tableSrc, Scope * pScopeGlobal)
+{
+	DynamicArray<PendingTypeId> aPendingTypidMerged;		// Indexed by the source's pending typid
+	init(&aPendingTypidMerged);
+	Defer(dispose(&aPendingTypidMerged));
+
+	append(&aPendingTypidMerged, PendingTypeId::Nil);
+
+	DynamicArray<PendingTypeId> aPendingTypidParam;
+	init(&aPendingTypidParam);
+	Defer(dispose(&aPendingTypidParam));
+
+	DynamicArray<PendingTypeId> aPendingTypidReturn;
+	init(&aPendingTypidReturn);
+	Defer(dispose(&aPendingTypidReturn));
+
+	for (int iPending = (int)PendingTypeId::mFirstValid; iPending < tableSrc.typesPendingResolution.cItem; iPending++)
+	{
+		const TypeTable::TypePendingResolve * pTypePendingSrc = tableSrc.typesPendingResolution[iPending];
+		const Type & typeSrc = pTypePendingSrc->type;
+
+		Scope * pScope = pTypePendingSrc->pScope;
+		if (pScope->scopek == SCOPEK_Global)
+		{
+			pScope = pScopeGlobal;
+		}
+		else if (pScope->scopek == SCOPEK_BuiltIn)
+		{
+			pScope = pScopeGlobal->pScopeParent;
+		}
+
+		// NOTE (andrew) Dependencies are always registered before their dependents, so whatever this waits on is
+		//	already merged.
+
+		PendingTypeId pendingTypid = PendingTypeId::Nil;
+		switch (typeSrc.typek)
+		{
+			case TYPEK_Named:
+			{
+				pendingTypid =
+					registerPendingNamedType(
+						pTable,
+						pScope,
+						typeSrc.namedTypeData.ident.lexeme,
+						pTypePendingSrc->iTextFirstMention);
+			} break;
+
+			case TYPEK_Func:
+			{
+				removeAll(&aPendingTypidParam);
+				removeAll(&aPendingTypidReturn);
+
+				int cParam = typeSrc.funcTypeData.funcType.paramTypids.cItem;
+				for (int iWaitingOn = 0; iWaitingOn < pTypePendingSrc->aPendingTypidWaitingOn.cItem; iWaitingOn++)
+				{
+					PendingTypeId pendingTypidMerged = aPendingTypidMerged[(int)pTypePendingSrc->aPendingTypidWaitingOn[iWaitingOn]];
+					append((iWaitingOn < cParam) ? &aPendingTypidParam : &aPendingTypidReturn, pendingTypidMerged);
+				}
+
+				pendingTypid = registerPendingFuncType(pTable, pScope, aPendingTypidParam, aPendingTypidReturn);
+			} break;
+
+			case TYPEK_Mod:
+			{
+				Assert(pTypePendingSrc->aPendingTypidWaitingOn.cItem == 1);
+
+				PendingTypeId pendingTypidModified = aPendingTypidMerged[(int)pTypePendingSrc->aPendingTypidWaitingOn[0]];
+				pendingTypid = registerPendingModType(pTable, pScope, typeSrc.modTypeData.typemod, pendingTypidModified);
+			} break;
+
+			default:
+				AssertNotReached;
+				break;
+		}
+
+		append(&aPendingTypidMerged, pendingTypid);
+
+		// Typids inside the source's own pending types were asked for again by registering above. The rest belong to
+		//	the AST, which we now own.
 
-	pTypePending->apTypidUpdateOnResolve[pTypePending->cPTypidUpdateOnResolve] = pTypidUpdateOnResolve;
-	pTypePending->cPTypidUpdateOnResolve++;
+		for (int iTypid = 0; iTypid < pTypePendingSrc->apTypidUpdateOnResolve.cItem; iTypid++)
+		{
+			TypeId * pTypid = pTypePendingSrc->apTypidUpdateOnResolve[iTypid];
+			if (!isTypidOwnedByDependent(tableSrc, *pTypePendingSrc, pTypid))
+			{
+				setPendingTypeUpdateOnResolvePtr(pTable, pendingTypid, pTypid);
+			}
+		}
+	}
 }
 
 Lexeme getDealiasedTypeLexeme(const Lexeme & lexeme)
@@ -320,7 +644,7 @@ bool typeEq(const Type & t0, const Type & t1)
 				AssertInfo(tmod1.pSubscriptExpr->astk == ASTK_LiteralExpr, "Parser should enforce this... for now");
 
 				auto * pIntLit0 = Down(tmod0.pSubscriptExpr, LiteralExpr);
-				auto * pIntLit1 = Down(tmod0.pSubscriptExpr, LiteralExpr);
+				auto * pIntLit1 = Down(tmod1.pSubscriptExpr, LiteralExpr);
 
 				AssertInfo(pIntLit0->literalk == LITERALK_Int, "Parser should enforce this... for now");
 				AssertInfo(pIntLit1->literalk == LITERALK_Int, "Parser should enforce this... for now");
@@ -556,19 +880,50 @@ bool areTypidListTypesEq(const DynamicArray<TypeId> & aTypid0, const DynamicArra
 //	return true;
 //}
 
+static TypeId insertType(TypeTable * pTable, const Type & type)
+{
+	Assert(pTable->apType.cItem == pTable->aTypeInfo.cItem);
+
+	Type * pTypeCopy = allocate(&pTable->typeAlloc);
+	initCopy(pTypeCopy, type);
+
+	TypeId typidInsert = TypeId(pTable->apType.cItem);
+
+	Type::ComputedInfo typeInfoUnset;
+	typeInfoUnset.size = Type::ComputedInfo::s_unset;
+	typeInfoUnset.alignment = Type::ComputedInfo::s_unset;
+
+	append(&pTable->apType, pTypeCopy);
+	append(&pTable->aTypeInfo, typeInfoUnset);
+	insert(&pTable->typidFromType, pTypeCopy, typidInsert);
+
+	return typidInsert;
+}
+
 void init(TypeTable * pTable, MeekCtx * pCtx)
 {
 	pTable->pCtx = pCtx;
 
-	init(&pTable->table,
-		typidHash,
-		typidEq,
-		typeHashPtr,
-		typeEqPtr);
+	init(&pTable->apType);
+	init(&pTable->aTypeInfo);
+	init(&pTable->typidFromType, typeHashPtr, typeEqPtr);
+
+	// Nil/unresolved/error typid's don't refer to a type
+
+	Type::ComputedInfo typeInfoUnset;
+	typeInfoUnset.size = Type::ComputedInfo::s_unset;
+	typeInfoUnset.alignment = Type::ComputedInfo::s_unset;
+
+	while (pTable->apType.cItem < static_cast<int>(TypeId::mFirstResolved))
+	{
+		append(&pTable->apType, static_cast<Type *>(nullptr));
+		append(&pTable->aTypeInfo, typeInfoUnset);
+	}
 
 	init(&pTable->typesPendingResolution);
-	TypeTable::TypePendingResolve nilPlaceholder = {};
-	append(&pTable->typesPendingResolution, nilPlaceholder);
+	init(&pTable->typePendingAlloc);
+	init(&pTable->pendingTypidFromKey, pendingTypeKeyHash, pendingTypeKeyEq);
+	append(&pTable->typesPendingResolution, static_cast<TypeTable::TypePendingResolve *>(nullptr));		// Nil placeholder
 
 	init(&pTable->typeAlloc);
 
@@ -581,15 +936,17 @@ void init(TypeTable * pTable, MeekCtx * pCtx)
 		Type type;
 		init(&type, TYPEK_Named);
 		type.namedTypeData.ident = ident;
-		type.info.size = size;
-		type.info.alignment = size;
 
 		Verify(isTypeResolved(type));
+		Assert(!lookup(pTable->typidFromType, &type));
 
-		const bool debugAssertIfAlreadyInTable = true;
-		auto ensureResult = ensureInTypeTable(pTable, &type, debugAssertIfAlreadyInTable);
-		Assert(ensureResult.typid == typidExpected);
-		Assert(ensureResult.typeInfoComputed);
+		TypeId typid = insertType(pTable, type);
+		Assert(typid == typidExpected);
+
+		Type::ComputedInfo typeInfo;
+		typeInfo.size = size;
+		typeInfo.alignment = size;
+		setTypeInfo(pTable, typid, typeInfo);
 	};
 
 	insertBuiltInType(pTable, "void", TypeId::Void, 0);
@@ -612,37 +969,57 @@ void init(TypeTable * pTable, MeekCtx * pCtx)
 	insertBuiltInType(pTable, "string", TypeId::String, 16);	// TODO: Pass actual size once I figure out the in-memory representation.
 }
 
+void dispose(TypeTable * pTable)
+{
+	// Pending types are already gone if tryResolveAllTypes(..) got as far as resolving them
+
+	if (pTable->typesPendingResolution.pBuffer)
+	{
+		for (int iPending = (int)PendingTypeId::mFirstValid; iPending < pTable->typesPendingResolution.cItem; iPending++)
+		{
+			dispose(pTable->typesPendingResolution[iPending]);
+		}
+
+		dispose(&pTable->pendingTypidFromKey);
+		dispose(&pTable->typesPendingResolution);
+		destroy(&pTable->typePendingAlloc);
+	}
+
+	for (int iType = (int)TypeId::mFirstResolved; iType < pTable->apType.cItem; iType++)
+	{
+		dispose(pTable->apType[iType]);
+	}
+
+	dispose(&pTable->apType);
+	dispose(&pTable->aTypeInfo);
+	dispose(&pTable->typidFromType);
+	destroy(&pTable->typeAlloc);
+}
+
 void init(TypeTable::TypePendingResolve * pTypePending, Scope * pScope, TYPEK typek)
 {
 	init(&pTypePending->type, typek);
 	pTypePending->pScope = pScope;
-	pTypePending->cPTypidUpdateOnResolve = 0;
-	pTypePending->pendingTypidModifiedBy = PendingTypeId::Nil;
+	init(&pTypePending->apTypidUpdateOnResolve);
+	init(&pTypePending->aPendingTypidWaitingOn);
+	init(&pTypePending->aPendingTypidDependent);
+	pTypePending->cPendingTypidWaitingOn = 0;
 }
 
 void dispose(TypeTable::TypePendingResolve * pTypePending)
 {
 	dispose(&pTypePending->type);
+	dispose(&pTypePending->apTypidUpdateOnResolve);
+	dispose(&pTypePending->aPendingTypidWaitingOn);
+	dispose(&pTypePending->aPendingTypidDependent);
 }
 
-NULLABLE const Type * lookupType(const TypeTable & table, TypeId typid)
-{
-	auto ppType = lookupByKey(table.table, typid);
-	if (!ppType)
-		return nullptr;
-
-	return *ppType;
-}
-
-void setTypeInfo(const TypeTable & table, TypeId typid, const Type::ComputedInfo & typeInfo)
+void setTypeInfo(TypeTable * pTable, TypeId typid, const Type::ComputedInfo & typeInfo)
 {
 	Assert(isTypeResolved(typid));
-	
-	auto ppType = lookupByKeyRaw(table.table, typid);
-	Assert(ppType);
-	Assert(*ppType);
+	Assert(lookupType(*pTable, typid));
 
-	(*ppType)->info = typeInfo;
+	pTable->aTypeInfo[static_cast<int>(typid)] = typeInfo;
 }
 
 EnsureInTypeTableResult ensureInTypeTable(TypeTable * pTable, Type * pType, bool debugAssertIfAlreadyInTable)
@@ -651,125 +1028,307 @@ EnsureInTypeTableResult ensureInTypeTable(TypeTable * pTable, Type * pType, bool
 
 	// SLOW: Could write a combined lookup + insertNew if not found query
 
-	const TypeId * pTypid = lookupByValue(pTable->table, pType);
+	const TypeId * pTypid = lookup(pTable->typidFromType, pType);
 	if (pTypid)
 	{
 		Assert(!debugAssertIfAlreadyInTable);
 
-		const Type * pTypeInTable = *lookupByKey(pTable->table, *pTypid);
-		Assert(pTypeInTable);
-
 		EnsureInTypeTableResult result;
 		result.typid = *pTypid;
-		result.typeInfoComputed = pTypeInTable->info.size != Type::ComputedInfo::s_unset;
+		result.typeInfoComputed = lookupTypeInfo(*pTable, *pTypid).size != Type::ComputedInfo::s_unset;
 
 		return result;
 	}
 
-	Type * pTypeCopy = allocate(&pTable->typeAlloc);
-	initCopy(pTypeCopy, *pType);
-
-	TypeId typidInsert = pTable->typidNext;
-	pTable->typidNext = TypeId((int)pTable->typidNext + 1);
+	EnsureInTypeTableResult result;
+	result.typid = insertType(pTable, *pType);
+	result.typeInfoComputed = tryComputeTypeInfo(pTable, result.typid);
 
-	Verify(insert(&pTable->table, typidInsert, pTypeCopy));
+	return result;
+}
 
-	EnsureInTypeTableResult result;
-	result.typid = typidInsert;
+void mergeTypes(TypeTable * pTable, const TypeTable & tableSrc, u32 scopeidOffset, DynamicArray<TypeId> * poaTypidMerged)
+{
+	Assert(poaTypidMerged->cItem == 0);
 
-	if (pTypeCopy->info.size == Type::ComputedInfo::s_unset)
-	{
-		result.typeInfoComputed = tryComputeTypeInfo(*pTable, typidInsert);
-	}
-	else
+	for (int iType = (int)TypeId::mFirstUserDefined; iType < tableSrc.apType.cItem; iType++)
 	{
-		result.typeInfoComputed = true;
+		// NOTE (andrew) Struct defns are the only types inserted before resolving, so everything here is named
+
+		Type type;
+		initCopy(&type, *tableSrc.apType[iType]);
+		Defer(dispose(&type));
+
+		Assert(type.typek == TYPEK_Named);
+
+		SCOPEID * pScopeid = &type.namedTypeData.ident.scopeid;
+		if (*pScopeid >= SCOPEID_UserDefinedStart)
+		{
+			*pScopeid = SCOPEID(*pScopeid + scopeidOffset);
+		}
+
+		append(poaTypidMerged, ensureInTypeTable(pTable, &type).typid);
 	}
+}
 
-	return result;
+void init(TypeInsertBuffer * pBuffer, const TypeTable * pTable)
+{
+	pBuffer->pTable = pTable;
+	pBuffer->iOrderCur = 0;
+
+	init(&pBuffer->apType);
+	init(&pBuffer->aIOrder);
+	init(&pBuffer->aTypidFlushed);
+	init(&pBuffer->typeAlloc);
+	init(&pBuffer->typidFromType, typeHashPtr, typeEqPtr);
+	init(&pBuffer->apTypidUpdateOnFlush);
 }
 
-Type::ComputedInfo tryComputeTypeInfoAndSetMemberOffsets(const MeekCtx & ctx, SCOPEID scopeid, const DynamicArray<AstNode *> & apVarDeclStmt, bool includeEndPadding)
+void dispose(TypeInsertBuffer * pBuffer)
 {
+	for (int iType = 0; iType < pBuffer->apType.cItem; iType++)
+	{
+		dispose(pBuffer->apType[iType]);
+	}
+
+	dispose(&pBuffer->apType);
+	dispose(&pBuffer->aIOrder);
+	dispose(&pBuffer->aTypidFlushed);
+	destroy(&pBuffer->typeAlloc);
+	dispose(&pBuffer->typidFromType);
+	dispose(&pBuffer->apTypidUpdateOnFlush);
+}
+
+TypeId ensureInTypeInsertBuffer(TypeInsertBuffer * pBuffer, Type * pType)
+{
+	AssertInfo(isTypeResolved(*pType), "Shouldn't be inserting an unresolved type into the type table...");
+
+	const TypeId * pTypid = lookup(pBuffer->pTable->typidFromType, pType);
+	if (pTypid)
+		return *pTypid;
+
+	pTypid = lookup(pBuffer->typidFromType, pType);
+	if (pTypid)
+		return *pTypid;
+
+	Type * pTypeCopy = allocate(&pBuffer->typeAlloc);
+	initCopy(pTypeCopy, *pType);
+
+	TypeId typidInsert = TypeId(static_cast<u32>(TypeId::mFirstBuffered) + pBuffer->apType.cItem);
+
+	append(&pBuffer->apType, pTypeCopy);
+	append(&pBuffer->aIOrder, pBuffer->iOrderCur);
+	insert(&pBuffer->typidFromType, pTypeCopy, typidInsert);
+
+	return typidInsert;
+}
+
+void addTypidUpdateOnFlush(TypeInsertBuffer * pBuffer, TypeId * pTypidUpdateOnFlush)
+{
+	Assert(isTypidBuffered(*pTypidUpdateOnFlush));
+	append(&pBuffer->apTypidUpdateOnFlush, pTypidUpdateOnFlush);
+}
+
+static TypeId typidFlushed(const TypeInsertBuffer & buffer, TypeId typid)
+{
+	if (!isTypidBuffered(typid))
+		return typid;
+
+	int iType = static_cast<int>(static_cast<u32>(typid) - static_cast<u32>(TypeId::mFirstBuffered));
+	Assert(iType < buffer.aTypidFlushed.cItem);		// Buffered types only refer to types buffered before them
+	return buffer.aTypidFlushed[iType];
+}
+
+void flushTypeInsertBuffers(TypeTable * pTable, TypeInsertBuffer * apBuffer[], int cBuffer)
+{
+	// Merge the buffers in ascending iOrder. Each buffer's aIOrder is already ascending, since its owner moves through
+	//	work items in increasing order, so this is just a k-way merge.
+
+	for (;;)
+	{
+		TypeInsertBuffer * pBufferMin = nullptr;
+		for (int iBuffer = 0; iBuffer < cBuffer; iBuffer++)
+		{
+			TypeInsertBuffer * pBuffer = apBuffer[iBuffer];
+			int iType = pBuffer->aTypidFlushed.cItem;
+			if (iType >= pBuffer->apType.cItem)
+				continue;
+
+			if (!pBufferMin || pBuffer->aIOrder[iType] < pBufferMin->aIOrder[pBufferMin->aTypidFlushed.cItem])
+			{
+				pBufferMin = pBuffer;
+			}
+		}
+
+		if (!pBufferMin)
+			break;
+
+		Type * pType = pBufferMin->apType[pBufferMin->aTypidFlushed.cItem];
+		switch (pType->typek)
+		{
+			case TYPEK_Named:
+				break;
+
+			case TYPEK_Func:
+			{
+				FuncType * pFuncType = &pType->funcTypeData.funcType;
+				for (int iParam = 0; iParam < pFuncType->paramTypids.cItem; iParam++)
+				{
+					pFuncType->paramTypids[iParam] = typidFlushed(*pBufferMin, pFuncType->paramTypids[iParam]);
+				}
+
+				for (int iReturn = 0; iReturn < pFuncType->returnTypids.cItem; iReturn++)
+				{
+					pFuncType->returnTypids[iReturn] = typidFlushed(*pBufferMin, pFuncType->returnTypids[iReturn]);
+				}
+			} break;
+
+			case TYPEK_Mod:
+			{
+				pType->modTypeData.typidModified = typidFlushed(*pBufferMin, pType->modTypeData.typidModified);
+			} break;
+
+			default:
+				AssertNotReached;
+		}
+
+		auto ensureResult = ensureInTypeTable(pTable, pType);
+		Assert(ensureResult.typeInfoComputed);
+
+		append(&pBufferMin->aTypidFlushed, ensureResult.typid);
+	}
+
+	for (int iBuffer = 0; iBuffer < cBuffer; iBuffer++)
+	{
+		TypeInsertBuffer * pBuffer = apBuffer[iBuffer];
+		for (int iTypid = 0; iTypid < pBuffer->apTypidUpdateOnFlush.cItem; iTypid++)
+		{
+			TypeId * pTypid = pBuffer->apTypidUpdateOnFlush[iTypid];
+			*pTypid = typidFlushed(*pBuffer, *pTypid);
+		}
+
+		removeAll(&pBuffer->apTypidUpdateOnFlush);
+	}
+}
+
+struct MemberLayout
+{
+	AstVarDeclStmt * pVarDeclStmt;
+	u32 size;
+	u32 alignment;
+	int iDecl;
+};
+
+static int compareMemberLayoutReordered(const MemberLayout & member0, const MemberLayout & member1)
+{
+	// Descending alignment. Sizes are always a multiple of alignment, so this leaves no interior padding. Ties keep
+	//	declaration order so that the layout is deterministic.
+
+	if (member0.alignment != member1.alignment)
+		return (member0.alignment > member1.alignment) ? -1 : 1;
+
+	return member0.iDecl - member1.iDecl;
+}
+
+Type::ComputedInfo tryComputeTypeInfoAndSetMemberOffsets(
+	const MeekCtx & ctx,
+	SCOPEID scopeid,
+	const DynamicArray<AstNode *> & apVarDeclStmt,
+	bool includeEndPadding,
+	STRUCTLAYOUTK structlayoutk)
+{
+	Assert(structlayoutk != STRUCTLAYOUTK_Nil);
+
 	Type::ComputedInfo result;
 	result.size = Type::ComputedInfo::s_unset;
 	result.alignment = Type::ComputedInfo::s_unset;
 
-	bool allMembersCounted = true;
-	u32 sizeWithPadding = 0;
-	u32 alignmentMax = 1;
+	// Gather member sizes. Every member's info must be known before any reordering.
+
+	DynamicArray<MemberLayout> aMember;
+	init(&aMember);
+	Defer(dispose(&aMember));
+	ensureCapacity(&aMember, apVarDeclStmt.cItem);
 
 	for (int iVarDeclStmt = 0; iVarDeclStmt < apVarDeclStmt.cItem; iVarDeclStmt++)
 	{
 		auto * pVarDeclStmt = Down(apVarDeclStmt[iVarDeclStmt], VarDeclStmt);
 		if (!isTypeResolved(pVarDeclStmt->typidDefn))
-		{
-			allMembersCounted = false;
-			break;
-		}
+			return result;
 
-		const Type * pTypeVarDecl = lookupType(*ctx.typeTable, pVarDeclStmt->typidDefn);
-		Assert(pTypeVarDecl);
+		Type::ComputedInfo typeInfoVarDecl = lookupTypeInfo(*ctx.typeTable, pVarDeclStmt->typidDefn);
 
-		u32 sizeMember = pTypeVarDecl->info.size;
-		u32 alignmentMember = pTypeVarDecl->info.alignment;
+		Assert(Iff(typeInfoVarDecl.size == Type::ComputedInfo::s_unset, typeInfoVarDecl.alignment == Type::ComputedInfo::s_unset));
+		if (typeInfoVarDecl.size == Type::ComputedInfo::s_unset)
+			return result;
 
-		Assert(Iff(sizeMember == Type::ComputedInfo::s_unset, alignmentMember == Type::ComputedInfo::s_unset));
-		if (sizeMember == Type::ComputedInfo::s_unset)
-		{
-			allMembersCounted = false;
-			break;
-		}
+		MemberLayout * pMember = appendNew(&aMember);
+		pMember->pVarDeclStmt = pVarDeclStmt;
+		pMember->size = typeInfoVarDecl.size;
+		pMember->alignment = (structlayoutk == STRUCTLAYOUTK_Packed) ? 1 : typeInfoVarDecl.alignment;
+		pMember->iDecl = iVarDeclStmt;
+	}
 
-		// Using C-like struct packing.
-		// http://www.catb.org/esr/structure-packing/
+	if (structlayoutk == STRUCTLAYOUTK_Reordered)
+	{
+		insertionSort(aMember.pBuffer, aMember.cItem, &compareMemberLayoutReordered);
+	}
+
+	// Using C-like struct packing.
+	// http://www.catb.org/esr/structure-packing/
+
+	u32 sizeWithPadding = 0;
+	u32 alignmentMax = 1;
 
-		if (iVarDeclStmt > 0)
+	for (int iMember = 0; iMember < aMember.cItem; iMember++)
+	{
+		const MemberLayout & member = aMember[iMember];
+
+		if (iMember > 0)
 		{
-			int bytesPastAlignment = sizeWithPadding % alignmentMember;
-			int padding = (bytesPastAlignment == 0) ? 0 : alignmentMember - bytesPastAlignment;
+			int bytesPastAlignment = sizeWithPadding % member.alignment;
+			int padding = (bytesPastAlignment == 0) ? 0 : member.alignment - bytesPastAlignment;
 			sizeWithPadding += padding;
 		}
 
-		SymbolInfo symbInfoVar = lookupVarSymbol(
-			*ctx.scopes[scopeid],
-			pVarDeclStmt->ident.lexeme,
-			FSYMBQ_IgnoreParent
-		);
+		Assert(member.pVarDeclStmt->ident.scopeid == scopeid);
+		member.pVarDeclStmt->byteOffset = sizeWithPadding;
 
-		updateVarSymbolOffset(*ctx.scopes[scopeid], pVarDeclStmt->ident.lexeme, sizeWithPadding);
-
-		sizeWithPadding += sizeMember;
-		alignmentMax = Max(alignmentMax, alignmentMember);
+		sizeWithPadding += member.size;
+		alignmentMax = Max(alignmentMax, member.alignment);
 	}
 
-	if (allMembersCounted)
+	if (structlayoutk == STRUCTLAYOUTK_CacheLine)
 	{
-		result.alignment = alignmentMax;
+		// Each element of an array of these starts on its own cache line
+
+		alignmentMax = Max(alignmentMax, gc_cByteCacheLine);
+	}
 
-		int bytesPastAlignment = sizeWithPadding % result.alignment;
+	result.alignment = alignmentMax;
 
-		if (includeEndPadding)
-		{
-			int endPadding = (bytesPastAlignment == 0) ? 0 : result.alignment - bytesPastAlignment;
-			sizeWithPadding += endPadding;
-		}
+	int bytesPastAlignment = sizeWithPadding % result.alignment;
 
-		result.size = sizeWithPadding;
+	if (includeEndPadding)
+	{
+		int endPadding = (bytesPastAlignment == 0) ? 0 : result.alignment - bytesPastAlignment;
+		sizeWithPadding += endPadding;
 	}
 
+	result.size = sizeWithPadding;
+
 	return result;
 }
 
-bool tryComputeTypeInfo(const TypeTable & typeTable, TypeId typid)
+bool tryComputeTypeInfo(TypeTable * pTable, TypeId typid)
 {
 	Assert(isTypeResolved(typid));
 
-	const Type * pType = lookupType(typeTable, typid);
+	const Type * pType = lookupType(*pTable, typid);
 	Assert(pType);
-	AssertInfo(pType->info.size == Type::ComputedInfo::s_unset, "Trying to resolve pending type info that has already been resolved?");
+	AssertInfo(lookupTypeInfo(*pTable, typid).size == Type::ComputedInfo::s_unset, "Trying to resolve pending type info that has already been resolved?");
 
-	MeekCtx * pCtx = typeTable.pCtx;
+	MeekCtx * pCtx = pTable->pCtx;
 
 	Type::ComputedInfo typeInfoResult;
 	typeInfoResult.size = Type::ComputedInfo::s_unset;
@@ -798,7 +1357,14 @@ bool tryComputeTypeInfo(const TypeTable & typeTable, TypeId typid)
 			}
 			else
 			{
-				typeInfoResult = tryComputeTypeInfoAndSetMemberOffsets(*pCtx, pStructDefn->scopeid, pStructDefn->apVarDeclStmt);
+				STRUCTLAYOUTK structlayoutk = getStructLayout(*pCtx->astDecorations, UpConst(pStructDefn)->astid);
+				if (structlayoutk == STRUCTLAYOUTK_Nil)
+				{
+					structlayoutk = pTable->structlayoutkDefault;
+				}
+
+				const bool c_includeEndPadding = true;
+				typeInfoResult = tryComputeTypeInfoAndSetMemberOffsets(*pCtx, pStructDefn->scopeid, pStructDefn->apVarDeclStmt, c_includeEndPadding, structlayoutk);
 			}
 		} break;
 
@@ -827,13 +1393,11 @@ bool tryComputeTypeInfo(const TypeTable & typeTable, TypeId typid)
 					// TODO: look up if the modified type already has its info computed, and if not add it to the set of things that
 					//	need to be computed and then return false?
 
-					const Type * pTypeModified = lookupType(typeTable, pType->modTypeData.typidModified);
-					Assert(pTypeModified);
-
-					if (pTypeModified->info.size != Type::ComputedInfo::s_unset)
+					Type::ComputedInfo typeInfoModified = lookupTypeInfo(*pTable, pType->modTypeData.typidModified);
+					if (typeInfoModified.size != Type::ComputedInfo::s_unset)
 					{
-						typeInfoResult.size = intVal * pTypeModified->info.size;
-						typeInfoResult.alignment = pTypeModified->info.alignment;
+						typeInfoResult.size = intVal * typeInfoModified.size;
+						typeInfoResult.alignment = typeInfoModified.alignment;
 					}
 					else
 					{
@@ -866,161 +1430,476 @@ bool tryComputeTypeInfo(const TypeTable & typeTable, TypeId typid)
 	if (typeInfoResult.size == Type::ComputedInfo::s_unset)
 		return false;
 
-	setTypeInfo(typeTable, typid, typeInfoResult);
+	setTypeInfo(pTable, typid, typeInfoResult);
 
 	return true;
 }
 
-bool tryResolveAllTypes(TypeTable * pTable)
+static void printTypeName(const TypeTable & table, TypeId typid)
 {
-	auto tryResolvePendingType = [](TypeTable::TypePendingResolve * pTypePending)
+	const Type * pType = lookupType(table, typid);
+	if (!pType)
+	{
+		print("<unresolved>");
+		return;
+	}
+
+	switch (pType->typek)
 	{
-		switch (pTypePending->type.typek)
+		case TYPEK_Named:
 		{
-			case TYPEK_Named:
-			{
-				SymbolInfo symbInfo = lookupTypeSymbol(*pTypePending->pScope, pTypePending->type.namedTypeData.ident.lexeme);
-				if (symbInfo.symbolk == SYMBOLK_Nil)
-					return false;
+			print(pType->namedTypeData.ident.lexeme.strv);
+		} break;
 
-				pTypePending->type.namedTypeData.ident.scopeid = scopeidFromSymbolInfo(symbInfo);
-				return true;
-			} break;
+		case TYPEK_Func:
+		{
+			const FuncType & funcType = pType->funcTypeData.funcType;
 
-			case TYPEK_Func:
+			print("fn(");
+			for (int i = 0; i < funcType.paramTypids.cItem; i++)
 			{
-				for (int i = 0; i < pTypePending->type.funcTypeData.funcType.paramTypids.cItem; i++)
+				if (i > 0) print(", ");
+				printTypeName(table, funcType.paramTypids[i]);
+			}
+			print(")");
+
+			if (funcType.returnTypids.cItem > 0)
+			{
+				print(" -> ");
+				for (int i = 0; i < funcType.returnTypids.cItem; i++)
 				{
-					if (!isTypeResolved(pTypePending->type.funcTypeData.funcType.paramTypids[i]))
-					{
-						return false;
-					}
+					if (i > 0) print(", ");
+					printTypeName(table, funcType.returnTypids[i]);
 				}
+			}
+		} break;
+
+		case TYPEK_Mod:
+		{
+			const TypeModifier & typemod = pType->modTypeData.typemod;
+			if (typemod.typemodk == TYPEMODK_Array)
+			{
+				Assert(typemod.pSubscriptExpr->astk == ASTK_LiteralExpr);
+				printfmt("[%d]", intValue(Down(typemod.pSubscriptExpr, LiteralExpr)));
+			}
+			else
+			{
+				Assert(typemod.typemodk == TYPEMODK_Pointer);
+				print("^");
+			}
+
+			printTypeName(table, pType->modTypeData.typidModified);
+		} break;
+
+		default:
+			AssertNotReached;
+			break;
+	}
+}
+
+// Appends the typid's whose infos must be computed before typid's info can be. Returns false if typid's info
+//	can never be computed because it depends on a type that failed to resolve.
+
+static bool tryAppendTypeInfoDependencies(const TypeTable & table, TypeId typid, DynamicArray<TypeId> * paTypidDependency)
+{
+	const Type * pType = lookupType(table, typid);
+	Assert(pType);
+
+	switch (pType->typek)
+	{
+		case TYPEK_Named:
+		{
+			MeekCtx * pCtx = table.pCtx;
 
-				for (int i = 0; i < pTypePending->type.funcTypeData.funcType.returnTypids.cItem; i++)
+			SymbolInfo symbInfo =
+				lookupTypeSymbol(
+					*pCtx->scopes[pType->namedTypeData.ident.scopeid],
+					pType->namedTypeData.ident.lexeme);
+
+			Assert(symbInfo.symbolk == SYMBOLK_Struct);
+
+			auto * pStructDefn = symbInfo.structData.pStructDefnStmt;
+			Assert(pStructDefn);
+
+			for (int iVarDeclStmt = 0; iVarDeclStmt < pStructDefn->apVarDeclStmt.cItem; iVarDeclStmt++)
+			{
+				auto * pVarDeclStmt = Down(pStructDefn->apVarDeclStmt[iVarDeclStmt], VarDeclStmt);
+				if (!isTypeResolved(pVarDeclStmt->typidDefn))
+					return false;
+
+				if (lookupTypeInfo(table, pVarDeclStmt->typidDefn).size == Type::ComputedInfo::s_unset)
 				{
-					if (!isTypeResolved(pTypePending->type.funcTypeData.funcType.returnTypids[i]))
-					{
-						return false;
-					}
+					append(paTypidDependency, pVarDeclStmt->typidDefn);
 				}
+			}
+		} break;
 
-				return true;
-			} break;
+		case TYPEK_Func:
+			break;
 
-			case TYPEK_Mod:
+		case TYPEK_Mod:
+		{
+			if (pType->modTypeData.typemod.typemodk == TYPEMODK_Array)
 			{
-				return isTypeResolved(pTypePending->type.modTypeData.typidModified);
-			} break;
+				TypeId typidModified = pType->modTypeData.typidModified;
+				Assert(isTypeResolved(typidModified));
 
-			default:
-				AssertNotReached;
-				return false;
-		}
-	};
+				if (lookupTypeInfo(table, typidModified).size == Type::ComputedInfo::s_unset)
+				{
+					append(paTypidDependency, typidModified);
+				}
+			}
+		} break;
 
-	MeekCtx * pCtx = pTable->pCtx;
+		default:
+			AssertNotReached;
+			break;
+	}
+
+	return true;
+}
+
+bool tryResolveAllTypes(TypeTable * pTable)
+{
+	auto tryResolvePendingNamedType = [](TypeTable::TypePendingResolve * pTypePending)
+	{
+		Assert(pTypePending->type.typek == TYPEK_Named);
 
-	// Resolve named types (and eagerly resolve type infos where we can)
+		SymbolInfo symbInfo = lookupTypeSymbol(*pTypePending->pScope, pTypePending->type.namedTypeData.ident.lexeme);
+		if (symbInfo.symbolk == SYMBOLK_Nil)
+			return false;
 
-	DynamicArray<TypeId> aTypidComputePending;
-	init(&aTypidComputePending);
-	Defer(dispose(&aTypidComputePending));
+		pTypePending->type.namedTypeData.ident.scopeid = scopeidFromSymbolInfo(symbInfo);
+		return true;
+	};
+
+	// Resolve pending types. This is a worklist over the dependency graph built while registering them. Each pending
+	//	type is resolved exactly once, as soon as everything it waits on has resolved. Named types don't wait on anything.
 
 	int cTypeUnresolved = 0;
 	{
+		DynamicArray<PendingTypeId> aPendingTypidReady;
+		init(&aPendingTypidReady);
+		Defer(dispose(&aPendingTypidReady));
+		ensureCapacity(&aPendingTypidReady, pTable->typesPendingResolution.cItem);
+
 		for (PendingTypeId iPending = PendingTypeId::mFirstValid;
-		     iPending < PendingTypeId(pTable->typesPendingResolution.cItem);
-		     iPending = PendingTypeId((int)iPending + 1))
+			 iPending < PendingTypeId(pTable->typesPendingResolution.cItem);
+			 iPending = PendingTypeId((int)iPending + 1))
 		{
-			TypeTable::TypePendingResolve * pTypePending = &pTable->typesPendingResolution[(int)iPending];
-			if (tryResolvePendingType(pTypePending))
+			if (pTable->typesPendingResolution[(int)iPending]->cPendingTypidWaitingOn == 0)
 			{
-				auto ensureResult = ensureInTypeTable(pTable, &pTypePending->type);
-				TypeId typid = ensureResult.typid;
-				for (int iTypidUpdate = 0; iTypidUpdate < pTypePending->cPTypidUpdateOnResolve; iTypidUpdate++)
-				{
-					TypeId * pTypidUpdate = pTypePending->apTypidUpdateOnResolve[iTypidUpdate];
-					*pTypidUpdate = typid;
-				}
+				append(&aPendingTypidReady, iPending);
+			}
+		}
 
-				if (pTypePending->pendingTypidModifiedBy != PendingTypeId::Nil)
-				{
-					// NOTE (andrew) This relies on the fact that the modified type should always get added to the pending list (and thus resolved) first
-					// TODO (andrew) This is a bit too clever. I am tempted to rewrite how types get registered/resolved... all of this poking into a pointer
-					//	is kind of hard to track.
+		// NOTE (andrew) Consume the ready list front to back (appending keeps growing it) so that typid's are handed out
+		//	in roughly registration order.
+
+		for (int iReady = 0; iReady < aPendingTypidReady.cItem; iReady++)
+		{
+			TypeTable::TypePendingResolve * pTypePending = pTable->typesPendingResolution[(int)aPendingTypidReady[iReady]];
+			Assert(pTypePending->cPendingTypidWaitingOn == 0);
 
-					Assert(pTypePending->pendingTypidModifiedBy < PendingTypeId(pTable->typesPendingResolution.cItem));
-					AssertInfo(pTypePending->pendingTypidModifiedBy > iPending, "This should be true due to the insertion order into this list");
+			if (pTypePending->type.typek == TYPEK_Named && !tryResolvePendingNamedType(pTypePending))
+			{
+				// NOTE (andrew) Dependents never become ready, so they don't get reported as well
+
+				beginTypeError(*pTable->pCtx, pTypePending->iTextFirstMention);
+				print("Unknown type '");
+				print(pTypePending->type.namedTypeData.ident.lexeme.strv);
+				print("'");
+				endTypeError();
+				continue;
+			}
 
-					TypeTable::TypePendingResolve * pTypePendingModifiedBy = &pTable->typesPendingResolution[(int)pTypePending->pendingTypidModifiedBy];
+			Assert(isTypeResolved(pTypePending->type));
 
-					Assert(pTypePendingModifiedBy->type.typek == TYPEK_Mod);
-					Assert(!isTypeResolved(pTypePendingModifiedBy->type.modTypeData.typidModified));
+			TypeId typid = ensureInTypeTable(pTable, &pTypePending->type).typid;
+			for (int iTypidUpdate = 0; iTypidUpdate < pTypePending->apTypidUpdateOnResolve.cItem; iTypidUpdate++)
+			{
+				TypeId * pTypidUpdate = pTypePending->apTypidUpdateOnResolve[iTypidUpdate];
+				*pTypidUpdate = typid;
+			}
 
-					pTypePendingModifiedBy->type.modTypeData.typidModified = typid;
-				}
+			for (int iDependent = 0; iDependent < pTypePending->aPendingTypidDependent.cItem; iDependent++)
+			{
+				PendingTypeId pendingTypidDependent = pTypePending->aPendingTypidDependent[iDependent];
+				TypeTable::TypePendingResolve * pTypePendingDependent = pTable->typesPendingResolution[(int)pendingTypidDependent];
+
+				Assert(pTypePendingDependent->cPendingTypidWaitingOn > 0);
+				pTypePendingDependent->cPendingTypidWaitingOn--;
 
-				if (!ensureResult.typeInfoComputed)
+				if (pTypePendingDependent->cPendingTypidWaitingOn == 0)
 				{
-					if (!tryComputeTypeInfo(*pTable, typid))
-					{
-						append(&aTypidComputePending, typid);
-					}
+					append(&aPendingTypidReady, pendingTypidDependent);
 				}
 			}
-			else
-			{
-				// TODO: print specific error
+		}
 
-				cTypeUnresolved++;
-			}
+		// NOTE (andrew) Pending types only wait on types registered before them, so they can't form cycles. Anything
+		//	left over is downstream of an unknown type name, which we reported above.
 
-			dispose(pTypePending);
+		cTypeUnresolved = (pTable->typesPendingResolution.cItem - (int)PendingTypeId::mFirstValid) - aPendingTypidReady.cItem;
+		Assert(cTypeUnresolved >= 0);
+
+		for (int iPending = (int)PendingTypeId::mFirstValid; iPending < pTable->typesPendingResolution.cItem; iPending++)
+		{
+			dispose(pTable->typesPendingResolution[iPending]);
 		}
 
+		dispose(&pTable->pendingTypidFromKey);
 		dispose(&pTable->typesPendingResolution);
+		destroy(&pTable->typePendingAlloc);
 	}
 
-	// Resolve type infos we weren't able to resolve eagerly
+	// Compute type infos we weren't able to compute eagerly. Same idea: a type's info waits on the infos of its struct
+	//	members / array element type. The graph is stored as flat edge lists indexed by typid (typid's are dense).
 
-	bool madeProgress = true;
-	while (madeProgress)
+	int cTypeInfoUncomputed = 0;
 	{
-		madeProgress = false;
+		static const int s_cWaitingOnNotInGraph = -1;
+
+		int cTypid = pTable->apType.cItem;
+
+		DynamicArray<int> mpTypidCWaitingOn;
+		init(&mpTypidCWaitingOn);
+		Defer(dispose(&mpTypidCWaitingOn));
+		ensureCapacity(&mpTypidCWaitingOn, cTypid);
+
+		DynamicArray<int> mpTypidIDependency0;		// Forward edges: typid -> the typid's it waits on
+		init(&mpTypidIDependency0);
+		Defer(dispose(&mpTypidIDependency0));
+		ensureCapacity(&mpTypidIDependency0, cTypid + 1);
+
+		DynamicArray<TypeId> aTypidDependency;
+		init(&aTypidDependency);
+		Defer(dispose(&aTypidDependency));
 
-		for (int i = aTypidComputePending.cItem - 1; i >= 0; i--)
+		for (int iTypid = 0; iTypid < cTypid; iTypid++)
 		{
-			TypeId typidInfoPending = aTypidComputePending[i];
-			Assert(isTypeResolved(typidInfoPending));
+			append(&mpTypidIDependency0, aTypidDependency.cItem);
 
-			const Type * pType = lookupType(*pTable, typidInfoPending);
-			if (pType->info.size != Type::ComputedInfo::s_unset)
+			TypeId typid = TypeId(iTypid);
+			if (!isTypeResolved(typid) || lookupTypeInfo(*pTable, typid).size != Type::ComputedInfo::s_unset)
 			{
-				// NOTE (andrew) This can happen when multiple copies of the same typid are added to
-				//	this list. This makes it kind of @Slow, we should probably use a HashSet instead
-				//	of a DynamicArray for the pending typeinfo typid's. But due to the importance
-				//	of the order of elements in that list, and the partial results that it holds, this
-				//	would be a challenge to do.
+				append(&mpTypidCWaitingOn, s_cWaitingOnNotInGraph);
+				continue;
+			}
+
+			int iDependency0 = aTypidDependency.cItem;
+			if (!tryAppendTypeInfoDependencies(*pTable, typid, &aTypidDependency))
+			{
+				// NOTE (andrew) Depends on a type that failed to resolve, which we already reported. Make this
+				//	node's dependents wait forever by never marking it ready.
 
-				unorderedRemove(&aTypidComputePending, i);
+				aTypidDependency.cItem = iDependency0;
+				append(&mpTypidCWaitingOn, 1);
+				continue;
 			}
-			else if (tryComputeTypeInfo(*pTable, typidInfoPending))
+
+			append(&mpTypidCWaitingOn, aTypidDependency.cItem - iDependency0);
+		}
+
+		append(&mpTypidIDependency0, aTypidDependency.cItem);
+
+		// Reverse edges: typid -> the typid's waiting on it. Built with a counting pass so it stays linear.
+
+		DynamicArray<int> mpTypidIDependent0;
+		init(&mpTypidIDependent0);
+		Defer(dispose(&mpTypidIDependent0));
+
+		DynamicArray<TypeId> aTypidDependent;
+		init(&aTypidDependent);
+		Defer(dispose(&aTypidDependent));
+
+		{
+			for (int iTypid = 0; iTypid <= cTypid; iTypid++)
 			{
-				madeProgress = true;
-				unorderedRemove(&aTypidComputePending, i);
+				append(&mpTypidIDependent0, 0);
 			}
-			else
+
+			for (int iEdge = 0; iEdge < aTypidDependency.cItem; iEdge++)
+			{
+				mpTypidIDependent0[(int)aTypidDependency[iEdge] + 1]++;
+			}
+
+			for (int iTypid = 0; iTypid < cTypid; iTypid++)
+			{
+				mpTypidIDependent0[iTypid + 1] += mpTypidIDependent0[iTypid];
+			}
+
+			DynamicArray<int> mpTypidIDependentNext;
+			init(&mpTypidIDependentNext);
+			Defer(dispose(&mpTypidIDependentNext));
+			appendMultiple(&mpTypidIDependentNext, mpTypidIDependent0.pBuffer, cTypid);
+
+			ensureCapacity(&aTypidDependent, aTypidDependency.cItem);
+			aTypidDependent.cItem = aTypidDependency.cItem;
+
+			for (int iTypid = 0; iTypid < cTypid; iTypid++)
 			{
-				// Still not enough info to resolve. Keep around for next iteration.
+				for (int iEdge = mpTypidIDependency0[iTypid]; iEdge < mpTypidIDependency0[iTypid + 1]; iEdge++)
+				{
+					int iTypidDependency = (int)aTypidDependency[iEdge];
+					aTypidDependent[mpTypidIDependentNext[iTypidDependency]] = TypeId(iTypid);
+					mpTypidIDependentNext[iTypidDependency]++;
+				}
 			}
 		}
-	}
 
-	// TODO: Better distinction between type resolve failing and type *info* resolve failing.
-	// TODO: Better terminology...
+		// Worklist
+
+		DynamicArray<TypeId> aTypidReady;
+		init(&aTypidReady);
+		Defer(dispose(&aTypidReady));
+
+		for (int iTypid = 0; iTypid < cTypid; iTypid++)
+		{
+			if (mpTypidCWaitingOn[iTypid] == 0)
+			{
+				append(&aTypidReady, TypeId(iTypid));
+			}
+		}
+
+		while (aTypidReady.cItem > 0)
+		{
+			TypeId typid = aTypidReady[aTypidReady.cItem - 1];
+			removeLast(&aTypidReady);
+
+			Verify(tryComputeTypeInfo(pTable, typid));
+
+			for (int iEdge = mpTypidIDependent0[(int)typid]; iEdge < mpTypidIDependent0[(int)typid + 1]; iEdge++)
+			{
+				int iTypidDependent = (int)aTypidDependent[iEdge];
+
+				Assert(mpTypidCWaitingOn[iTypidDependent] > 0);
+				mpTypidCWaitingOn[iTypidDependent]--;
+
+				if (mpTypidCWaitingOn[iTypidDependent] == 0)
+				{
+					append(&aTypidReady, TypeId(iTypidDependent));
+				}
+			}
+		}
+
+		for (int iTypid = 0; iTypid < cTypid; iTypid++)
+		{
+			if (mpTypidCWaitingOn[iTypid] > 0)
+			{
+				cTypeInfoUncomputed++;
+			}
+		}
+
+		// Anything still waiting is either in a cycle (a type that contains itself by value), downstream of one, or
+		//	downstream of a type that failed to resolve. Find and report the cycles with a DFS over the forward edges.
+
+		if (cTypeInfoUncomputed > 0)
+		{
+			enum DFSK : u8
+			{
+				DFSK_Unvisited,
+				DFSK_OnStack,
+				DFSK_Done
+			};
+
+			struct DfsFrame
+			{
+				TypeId typid;
+				int iEdge;
+			};
+
+			DynamicArray<DFSK> mpTypidDfsk;
+			init(&mpTypidDfsk);
+			Defer(dispose(&mpTypidDfsk));
+
+			for (int iTypid = 0; iTypid < cTypid; iTypid++)
+			{
+				append(&mpTypidDfsk, DFSK_Unvisited);
+			}
+
+			DynamicArray<DfsFrame> aFrame;
+			init(&aFrame);
+			Defer(dispose(&aFrame));
+
+			for (int iTypidRoot = 0; iTypidRoot < cTypid; iTypidRoot++)
+			{
+				if (mpTypidCWaitingOn[iTypidRoot] <= 0) continue;
+				if (mpTypidDfsk[iTypidRoot] != DFSK_Unvisited) continue;
+
+				mpTypidDfsk[iTypidRoot] = DFSK_OnStack;
+				append(&aFrame, DfsFrame{ TypeId(iTypidRoot), mpTypidIDependency0[iTypidRoot] });
+
+				while (aFrame.cItem > 0)
+				{
+					DfsFrame * pFrame = &aFrame[aFrame.cItem - 1];
+					int iTypid = (int)pFrame->typid;
+
+					if (pFrame->iEdge >= mpTypidIDependency0[iTypid + 1])
+					{
+						mpTypidDfsk[iTypid] = DFSK_Done;
+						removeLast(&aFrame);
+						continue;
+					}
+
+					int iTypidNext = (int)aTypidDependency[pFrame->iEdge];
+					pFrame->iEdge++;
+
+					if (mpTypidCWaitingOn[iTypidNext] <= 0) continue;
+
+					if (mpTypidDfsk[iTypidNext] == DFSK_Unvisited)
+					{
+						mpTypidDfsk[iTypidNext] = DFSK_OnStack;
+						append(&aFrame, DfsFrame{ TypeId(iTypidNext), mpTypidIDependency0[iTypidNext] });
+					}
+					else if (mpTypidDfsk[iTypidNext] == DFSK_OnStack)
+					{
+						int iFrameCycle = aFrame.cItem - 1;
+						while ((int)aFrame[iFrameCycle].typid != iTypidNext)
+						{
+							iFrameCycle--;
+							Assert(iFrameCycle >= 0);
+						}
+
+						// Only structs have members, so there's at least one in the cycle. Report it where that's declared.
+
+						int iFrameStruct = iFrameCycle;
+						while (lookupType(*pTable, aFrame[iFrameStruct].typid)->typek != TYPEK_Named)
+						{
+							iFrameStruct++;
+							Assert(iFrameStruct < aFrame.cItem);
+						}
+
+						const Type * pTypeStruct = lookupType(*pTable, aFrame[iFrameStruct].typid);
+						SymbolInfo symbInfo =
+							lookupTypeSymbol(
+								*pTable->pCtx->scopes[pTypeStruct->namedTypeData.ident.scopeid],
+								pTypeStruct->namedTypeData.ident.lexeme);
+
+						Assert(symbInfo.symbolk == SYMBOLK_Struct);
+
+						ASTID astidStruct = Up(symbInfo.structData.pStructDefnStmt)->astid;
+
+						beginTypeError(*pTable->pCtx, getStartEnd(*pTable->pCtx->astDecorations, astidStruct).iStart);
+						print("Type '");
+						printTypeName(*pTable, TypeId(iTypidNext));
+						print("' has infinite size, since it contains itself: ");
+
+						for (int iFrame = iFrameCycle; iFrame < aFrame.cItem; iFrame++)
+						{
+							printTypeName(*pTable, aFrame[iFrame].typid);
+							print(" -> ");
+						}
+
+						printTypeName(*pTable, TypeId(iTypidNext));
+						endTypeError();
+					}
+				}
+			}
+		}
+	}
 
-	return cTypeUnresolved == 0 && aTypidComputePending.cItem == 0;
+	return cTypeUnresolved == 0 && cTypeInfoUncomputed == 0;
 }
 
 TypeId typidFromLiteralk(LITERALK literalk)
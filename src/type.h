@@ -38,8 +38,8 @@ struct TypeModifier
 
 struct FuncType
 {
-	DynamicArray<TypeId> paramTypids;
-	DynamicArray<TypeId> returnTypids;		// A.k.a. output params
+	SmallArray<TypeId, 4> paramTypids;
+	SmallArray<TypeId, 2> returnTypids;		// A.k.a. output params
 };
 
 
@@ -75,9 +75,8 @@ struct Type
 
 	TYPEK typek;
 
-	// TODO: Split this out into TypeIdentInfo and TypeMetadata?
-	//	Then we can use the former while resolving names without
-	//	having to lug around this unset type info struct.
+	// NOTE (andrew) The computed info isn't stored on the type itself. It lives in the type table, parallel to
+	//	the types, so that resolving names doesn't lug it around. See lookupTypeInfo(..)
 
 	struct ComputedInfo
 	{
@@ -87,7 +86,6 @@ struct Type
 		u32 alignment;		// Bytes
 	};
 
-	ComputedInfo info;
 	bool isInferred = false;
 };
 
@@ -145,42 +143,103 @@ inline bool typidEq(const TypeId & typid0, const TypeId & typid1)
 	return typid0 == typid1;
 }
 
+// How a struct's members are laid out. Member offsets end up in AstVarDeclStmt::byteOffset, so nothing
+//	downstream needs to know which layout was picked.
+
+enum STRUCTLAYOUTK : s8
+{
+	STRUCTLAYOUTK_Declared,		// Declaration order, C-like padding
+	STRUCTLAYOUTK_Reordered,	// Descending alignment, which minimizes padding
+	STRUCTLAYOUTK_Packed,		// Declaration order, no padding at all
+	STRUCTLAYOUTK_CacheLine,	// Declaration order, struct aligned and padded to a cache line
+
+	STRUCTLAYOUTK_Nil = -1		// Not specified by the struct. Use TypeTable::structlayoutkDefault.
+};
+
+static constexpr u32 gc_cByteCacheLine = 64;
+
 struct TypeTable
 {
 	MeekCtx * pCtx;
 
+	STRUCTLAYOUTK structlayoutkDefault = STRUCTLAYOUTK_Declared;	// For structs that don't specify a layout. Set it before resolving types
+
 	struct TypePendingResolve
 	{
 		// Info we need to resolve the type
 
 		Type type;
 		Scope * pScope;
+		int iTextFirstMention = -1;		// TYPEK_Named. Where we report it if it doesn't resolve.
+
+		// Typid values to poke into corresponding AST nodes (or dependent pending types) when we succeed resolving.
+		//	Pending types are shared by every mention of the same type, so this can get long.
+
+		SmallArray<TypeId *, 4> apTypidUpdateOnResolve;
+
+		// Dependency graph edges. A func type waits on its params then its returns, and a mod type waits on the type it
+		//	modifies. When we resolve, each dependent's count is decremented, and it becomes ready once that count hits 0.
+
+		SmallArray<PendingTypeId, 4> aPendingTypidWaitingOn;
+		SmallArray<PendingTypeId, 2> aPendingTypidDependent;
+		int cPendingTypidWaitingOn = 0;
+	};
 
-		// Typid value to poke into corresponding AST node when we succeed resolving
+	// Pending types are hash-consed when registered, so each distinct type mention (as seen from a given scope) is only
+	//	resolved once. Func and mod types are keyed structurally on the pending types they wait on, which are themselves
+	//	already deduplicated. Named types are keyed on the scope they were mentioned in, since that's where lookup starts.
 
-		static const int s_cTypidUpdateOnResolveMax = 4;
-		TypeId * apTypidUpdateOnResolve[s_cTypidUpdateOnResolveMax];
-		int cPTypidUpdateOnResolve = 0;
+	struct PendingTypeKey
+	{
+		TYPEK typek;
 
-		// Are we resolving a type that then has a modifier applied to it? If so, we
-		//	need to update our typid in the pendingtype that has the modifier.
+		Scope * pScope;							// TYPEK_Named
+		Lexeme lexemeDealiased;					// TYPEK_Named
+		TypeModifier typemod;					// TYPEK_Mod
 
-		PendingTypeId pendingTypidModifiedBy = PendingTypeId::Nil;
+		const PendingTypeId * aPendingTypid;	// Same as TypePendingResolve::aPendingTypidWaitingOn
+		int cPendingTypid;
+		int cPendingTypidParam;					// TYPEK_Func
 	};
 
-	DynamicArray<TypePendingResolve> typesPendingResolution;
+	// NOTE (andrew) Pending types are pool allocated so that they don't move as more get registered. Other pending
+	//	types hold pointers into them (e.g., a func type's param typids), which may live in SmallArray inline storage.
+	//	The keys in pendingTypidFromKey also point into them.
+
+	DynamicArray<TypePendingResolve *> typesPendingResolution;
+	DynamicPoolAllocator<TypePendingResolve> typePendingAlloc;
+	HashMap<PendingTypeKey, PendingTypeId> pendingTypidFromKey;
 	DynamicPoolAllocator<Type> typeAlloc;
-	BiHashMap<TypeId, Type *> table;
 
-	TypeId typidNext = TypeId::mFirstResolved;
+	// NOTE (andrew) TypeId's are handed out sequentially, so types are stored densely and indexed by TypeId. Looking up
+	//	a type (which resolve and bytecode emission do constantly) is a single indexed load. Only the Type -> TypeId
+	//	direction is hashed, for interning.
+
+	DynamicArray<Type *> apType;						// Indexed by TypeId. nullptr below TypeId::mFirstResolved
+	DynamicArray<Type::ComputedInfo> aTypeInfo;			// Parallel to apType
+	HashMap<Type *, TypeId> typidFromType;
 };
 
 void init(TypeTable * pTable, MeekCtx * pCtx);
+void dispose(TypeTable * pTable);
 void init(TypeTable::TypePendingResolve * pTypePending, Scope * pScope, TYPEK typek);
 void dispose(TypeTable::TypePendingResolve * pTypePending);
 
-NULLABLE const Type * lookupType(const TypeTable & table, TypeId typid);
-void setTypeInfo(const TypeTable & table, TypeId typid, const Type::ComputedInfo & typeInfo);
+inline NULLABLE const Type * lookupType(const TypeTable & table, TypeId typid)
+{
+	if (static_cast<u32>(typid) >= static_cast<u32>(table.apType.cItem))
+		return nullptr;
+
+	return table.apType[static_cast<int>(typid)];
+}
+
+inline Type::ComputedInfo lookupTypeInfo(const TypeTable & table, TypeId typid)
+{
+	Assert(lookupType(table, typid));
+	return table.aTypeInfo[static_cast<int>(typid)];
+}
+
+void setTypeInfo(TypeTable * pTable, TypeId typid, const Type::ComputedInfo & typeInfo);
 
 NULLABLE const FuncType * funcTypeFromDefnStmt(const TypeTable & typeTable, const AstFuncDefnStmt & defnStmt);
 
@@ -188,6 +247,7 @@ PendingTypeId registerPendingNamedType(
 	TypeTable * pTable,
 	Scope * pScope,
 	Lexeme ident,
+	int iTextMention,
 	NULLABLE TypeId * pTypidUpdateOnResolve=nullptr);
 
 PendingTypeId registerPendingFuncType(
@@ -206,6 +266,12 @@ PendingTypeId registerPendingModType(
 
 void setPendingTypeUpdateOnResolvePtr(TypeTable * pTable, PendingTypeId pendingTypid, TypeId * pTypidUpdateOnResolve);
 
+// Registers every type pending in another table (e.g., one filled in while parsing part of the program in parallel)
+//	with ours, in the same order, so it is as if they were registered here. The source's global and built in scopes map
+//	to pScopeGlobal and its parent. Its other scopes are assumed to already be ours.
+
+void mergePendingTypes(TypeTable * pTable, const TypeTable & tableSrc, Scope * pScopeGlobal);
+
 struct EnsureInTypeTableResult
 {
 	TypeId typid = TypeId::Unresolved;
@@ -213,12 +279,64 @@ struct EnsureInTypeTableResult
 };
 EnsureInTypeTableResult ensureInTypeTable(TypeTable * pTable, Type * pType, bool debugAssertIfAlreadyInTable=false);
 
+// Inserts the user defined types of another table, in the order they were inserted there. User defined scope ids
+//	are bumped by scopeidOffset. poaTypidMerged is indexed by source typid - TypeId::mFirstUserDefined.
+
+void mergeTypes(TypeTable * pTable, const TypeTable & tableSrc, u32 scopeidOffset, DynamicArray<TypeId> * poaTypidMerged);
+
+// Lets several threads find or create types while the type table is shared and read-only. Types that aren't already in
+//	the table (e.g., a pointer to a struct that is never declared as such) get a buffer-local typid, and any TypeId
+//	that holds one must be registered with addTypidUpdateOnFlush(..). Flushing inserts the buffered types into the
+//	table and pokes the real typids into those locations.
+
+struct TypeInsertBuffer
+{
+	const TypeTable * pTable;
+
+	// NOTE (andrew) Buffers are flushed in ascending iOrder rather than buffer by buffer, so that the typids that types
+	//	end up with don't depend on which thread happened to get to them first. Callers set iOrderCur to the index of
+	//	the work item they are on.
+
+	int iOrderCur;
+
+	DynamicArray<Type *> apType;					// Indexed by typid - TypeId::mFirstBuffered
+	DynamicArray<int> aIOrder;						// Parallel to apType
+	DynamicArray<TypeId> aTypidFlushed;				// Parallel to apType, once flushed
+	DynamicPoolAllocator<Type> typeAlloc;
+	HashMap<Type *, TypeId> typidFromType;
+
+	DynamicArray<TypeId *> apTypidUpdateOnFlush;
+};
+
+void init(TypeInsertBuffer * pBuffer, const TypeTable * pTable);
+void dispose(TypeInsertBuffer * pBuffer);
+
+inline bool isTypidBuffered(TypeId typid)
+{
+	return typid >= TypeId::mFirstBuffered;
+}
+
+inline NULLABLE const Type * lookupType(const TypeInsertBuffer & buffer, TypeId typid)
+{
+	if (!isTypidBuffered(typid))
+		return lookupType(*buffer.pTable, typid);
+
+	int iType = static_cast<int>(static_cast<u32>(typid) - static_cast<u32>(TypeId::mFirstBuffered));
+	Assert(iType < buffer.apType.cItem);
+	return buffer.apType[iType];
+}
+
+TypeId ensureInTypeInsertBuffer(TypeInsertBuffer * pBuffer, Type * pType);
+void addTypidUpdateOnFlush(TypeInsertBuffer * pBuffer, TypeId * pTypidUpdateOnFlush);
+void flushTypeInsertBuffers(TypeTable * pTable, TypeInsertBuffer * apBuffer[], int cBuffer);
+
 Type::ComputedInfo tryComputeTypeInfoAndSetMemberOffsets(
 	const MeekCtx & ctx,
 	SCOPEID scopeid,
 	const DynamicArray<AstNode *> & apVarDeclStmt,
-	bool includeEndPadding = true);
-bool tryComputeTypeInfo(const TypeTable & typeTable, TypeId typid);
+	bool includeEndPadding = true,
+	STRUCTLAYOUTK structlayoutk = STRUCTLAYOUTK_Declared);
+bool tryComputeTypeInfo(TypeTable * pTable, TypeId typid);
 bool tryResolveAllTypes(TypeTable * pTable);
 
 TypeId typidFromLiteralk(LITERALK literalk);
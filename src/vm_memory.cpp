@@ -0,0 +1,260 @@
+#include "vm_memory.h"
+
+#include "error.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <mutex>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Guard pages at each end. Bigger than a page so that an op reading a few bytes past the end still lands in one.
+
+static const uintptr s_cByteGuardMin = 64 * 1024;
+
+// Committing a page at a time would fault on every page of a deep stack, so commit this much at once
+
+static const uintptr s_cByteCommitChunk = 64 * 1024;
+
+static uintptr cBytePage()
+{
+#ifdef _MSC_VER
+	static const uintptr s_cBytePage = []()
+	{
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return uintptr(info.dwPageSize);
+	}();
+#else
+	static const uintptr s_cBytePage = uintptr(sysconf(_SC_PAGESIZE));
+#endif
+
+	return s_cBytePage;
+}
+
+static uintptr cByteRoundUpToPage(uintptr cByte)
+{
+	uintptr cBytePg = cBytePage();
+	return (cByte + cBytePg - 1) / cBytePg * cBytePg;
+}
+
+static u8 * pReserve(uintptr cByte)
+{
+#ifdef _MSC_VER
+	return static_cast<u8 *>(VirtualAlloc(nullptr, cByte, MEM_RESERVE, PAGE_NOACCESS));
+#else
+	void * p = mmap(nullptr, cByte, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return (p == MAP_FAILED) ? nullptr : static_cast<u8 *>(p);
+#endif
+}
+
+static bool tryCommit(u8 * p, uintptr cByte)
+{
+#ifdef _MSC_VER
+	return VirtualAlloc(p, cByte, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+	return mprotect(p, cByte, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void release(u8 * p, uintptr cByte)
+{
+#ifdef _MSC_VER
+	VirtualFree(p, 0, MEM_RELEASE);
+#else
+	munmap(p, cByte);
+#endif
+}
+
+void init(VmMemory * pMemory, uintptr cByteGlobal, uintptr cByteStack)
+{
+	uintptr cByteGuard = cByteRoundUpToPage(s_cByteGuardMin);
+	uintptr cByteUsable = cByteRoundUpToPage(cByteGlobal + cByteStack);
+
+	pMemory->cByteReserved = cByteGuard + cByteUsable + cByteGuard;
+	pMemory->pReserved = pReserve(pMemory->cByteReserved);
+
+	if (!pMemory->pReserved)
+	{
+		reportIceAndExit("Couldn't reserve %" PRIuPTR " bytes for the interpreter", pMemory->cByteReserved);
+	}
+
+	pMemory->pBase = pMemory->pReserved + cByteGuard;
+	pMemory->pMax = pMemory->pBase + cByteUsable;
+
+	uintptr cByteCommit = Min(cByteRoundUpToPage(cByteGlobal + s_cByteCommitChunk), cByteUsable);
+	pMemory->pCommitMax = pMemory->pBase + cByteCommit;
+
+	if (!tryCommit(pMemory->pBase, cByteCommit))
+	{
+		reportIceAndExit("Couldn't commit %" PRIuPTR " bytes for the interpreter", cByteCommit);
+	}
+}
+
+void dispose(VmMemory * pMemory)
+{
+	if (pMemory->pReserved)
+	{
+		release(pMemory->pReserved, pMemory->cByteReserved);
+	}
+
+	ClearStruct(pMemory);
+}
+
+enum FAULTK
+{
+	FAULTK_Committed,			// Touched the uncommitted part, which is committed now, so just try again
+	FAULTK_Guard,
+	FAULTK_NotOurs,
+};
+
+static FAULTK faultkCommit(VmMemory * pMemory, u8 * pFault)
+{
+	if (pFault >= pMemory->pCommitMax && pFault < pMemory->pMax)
+	{
+		u8 * pCommitMaxNew = pMemory->pBase + cByteRoundUpToPage((pFault - pMemory->pBase) + s_cByteCommitChunk);
+		pCommitMaxNew = Min(pCommitMaxNew, pMemory->pMax);
+
+		if (!tryCommit(pMemory->pCommitMax, pCommitMaxNew - pMemory->pCommitMax))
+			return FAULTK_NotOurs;
+
+		pMemory->pCommitMax = pCommitMaxNew;
+		return FAULTK_Committed;
+	}
+
+	if (pFault >= pMemory->pReserved && pFault < pMemory->pReserved + pMemory->cByteReserved)
+		return FAULTK_Guard;
+
+	return FAULTK_NotOurs;
+}
+
+#ifdef _MSC_VER
+
+static LONG filterGuardedFault(EXCEPTION_POINTERS * pExcept, VmMemory * pMemory, u8 ** ppoFault)
+{
+	const EXCEPTION_RECORD & record = *pExcept->ExceptionRecord;
+	if (record.ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record.NumberParameters < 2)
+		return EXCEPTION_CONTINUE_SEARCH;
+
+	u8 * pFault = reinterpret_cast<u8 *>(record.ExceptionInformation[1]);
+
+	switch (faultkCommit(pMemory, pFault))
+	{
+		case FAULTK_Committed:
+			return EXCEPTION_CONTINUE_EXECUTION;
+
+		case FAULTK_Guard:
+			*ppoFault = pFault;
+			return EXCEPTION_EXECUTE_HANDLER;
+
+		default:
+			return EXCEPTION_CONTINUE_SEARCH;
+	}
+}
+
+bool runGuarded(VmMemory * pMemory, PFNGUARDEDJOB pfnJob, void * pContext, u8 ** ppoFault)
+{
+	*ppoFault = nullptr;
+
+	__try
+	{
+		pfnJob(pContext);
+	}
+	__except (filterGuardedFault(GetExceptionInformation(), pMemory, ppoFault))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+#else
+
+// NOTE (andrew) The handler is installed once for the process and left in place. It only does anything on a thread
+//	that's inside runGuarded(..), and only for that thread's VmMemory. Anything else goes to whoever had SIGSEGV before.
+
+struct GuardedJob
+{
+	VmMemory * pMemory;
+	u8 * pFault;
+	sigjmp_buf jmpbuf;
+};
+
+static thread_local GuardedJob * s_pGuardedJob = nullptr;
+static struct sigaction s_sigactionPrev;
+
+static void onSigsegv(int iSignal, siginfo_t * pInfo, void * pUcontext)
+{
+	GuardedJob * pJob = s_pGuardedJob;
+	u8 * pFault = static_cast<u8 *>(pInfo->si_addr);
+
+	FAULTK faultk = (pJob) ? faultkCommit(pJob->pMemory, pFault) : FAULTK_NotOurs;
+
+	if (faultk == FAULTK_Committed)
+		return;
+
+	if (faultk == FAULTK_Guard)
+	{
+		pJob->pFault = pFault;
+		siglongjmp(pJob->jmpbuf, 1);
+	}
+
+	if (s_sigactionPrev.sa_flags & SA_SIGINFO)
+	{
+		s_sigactionPrev.sa_sigaction(iSignal, pInfo, pUcontext);
+		return;
+	}
+
+	// Put back whatever was there before and return, so the fault happens again and goes to it
+
+	sigaction(SIGSEGV, &s_sigactionPrev, nullptr);
+}
+
+static void installSigsegvHandler()
+{
+	static std::once_flag s_onceInstall;
+	std::call_once(s_onceInstall, []()
+	{
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = &onSigsegv;
+		sa.sa_flags = SA_SIGINFO;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGSEGV, &sa, &s_sigactionPrev);
+	});
+}
+
+bool runGuarded(VmMemory * pMemory, PFNGUARDEDJOB pfnJob, void * pContext, u8 ** ppoFault)
+{
+	installSigsegvHandler();
+	Assert(!s_pGuardedJob);
+
+	GuardedJob job;
+	job.pMemory = pMemory;
+	job.pFault = nullptr;
+
+	if (sigsetjmp(job.jmpbuf, 1) != 0)
+	{
+		s_pGuardedJob = nullptr;
+		*ppoFault = job.pFault;
+		return false;
+	}
+
+	s_pGuardedJob = &job;
+	pfnJob(pContext);
+	s_pGuardedJob = nullptr;
+
+	*ppoFault = nullptr;
+	return true;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "als.h"
+
+// Memory for an interpreter's globals and stack. The whole range is reserved up front, but only the globals and the
+//	bottom of the stack are committed to start with, and the rest of the stack is committed as the program touches it.
+//	There are no-access guard pages below the globals and above the stack, so running off either end faults instead of
+//	scribbling over whatever comes next. Faults are only handled while inside runGuarded(..).
+//
+//	[ guard | globals | stack -> committed ... reserved | guard ]
+//	          ^ pBase                        ^ pCommitMax  ^ pMax
+
+struct VmMemory
+{
+	u8 * pReserved;				// Start of the reservation, i.e., the low guard pages
+	uintptr cByteReserved;
+
+	u8 * pBase;					// Globals, then the stack right after them
+	u8 * pCommitMax;			// [pBase, pCommitMax) is committed
+	u8 * pMax;					// End of the stack. The high guard pages start here.
+};
+
+void init(VmMemory * pMemory, uintptr cByteGlobal, uintptr cByteStack);
+void dispose(VmMemory * pMemory);
+
+typedef void (*PFNGUARDEDJOB)(void * pContext);
+
+// Calls pfnJob. If it touches the uncommitted part of pMemory, that part is committed and it carries on like nothing
+//	happened. If it touches a guard page, it's stopped right there, runGuarded returns false, and *ppoFault is the
+//	address it touched. Faults anywhere else crash like they would have anyway.
+//
+// NOTE (andrew) pfnJob can be stopped at any point, so it can't own anything that needs cleaning up (no Defer, no
+//	destructors). Only one job per thread can be running at a time.
+
+bool runGuarded(VmMemory * pMemory, PFNGUARDEDJOB pfnJob, void * pContext, u8 ** ppoFault);